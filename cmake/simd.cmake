@@ -11,6 +11,7 @@ if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
   set(AVX_FLAG "-mavx")
   set(AVX2_FLAG "-mavx2")
   set(AVX512F_FLAG "-mavx512f")
+  set(AVX512VNNI_FLAG "-mavx512f -mavx512bw -mavx512vnni")
   set(Wno_Maybe_Uninitialized "-Wno-maybe-uninitialized")
   set(FMA_FLAG "-mfma")
 elseif(MSVC)
@@ -127,6 +128,22 @@ if(AVX512F_FOUND)
   add_definitions(-DPADDLE_WITH_AVX512F)
 endif()
 
+# Check AVX512 VNNI, only whether it compiles, the kernels built with it check
+# the cpu at run time
+if(AVX512VNNI_FLAG)
+  set(CMAKE_REQUIRED_FLAGS ${AVX512VNNI_FLAG})
+  check_cxx_source_compiles(
+    "
+#include <immintrin.h>
+int main()
+{
+    __m512i a = _mm512_set1_epi32(1);
+    __m512i result = _mm512_dpbusd_epi32(a, a, a);
+    return 0;
+}"
+    AVX512VNNI_FOUND)
+endif()
+
 set(CMAKE_REQUIRED_FLAGS ${CMAKE_REQUIRED_FLAGS_RETAINED})
 mark_as_advanced(MMX_FOUND SSE2_FOUND SSE3_FOUND AVX_FOUND AVX2_FOUND
-                 AVX512F_FOUND)
+                 AVX512F_FOUND AVX512VNNI_FOUND)
@@ -808,6 +808,53 @@ PHI_DEFINE_EXPORTED_bool(use_fast_math,
                          "Whether to use fast math GPU functions.");
 #endif
 
+/**
+ * CPU convolution related FLAG
+ * Name: FLAGS_conv_cpu_native_algo
+ * Since Version: 3.0.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: Whether the CPU conv2d and depthwise_conv2d kernels pick Winograd
+ *       or a direct kernel by shape. If false, every shape runs im2col +
+ *       GEMM.
+ */
+PHI_DEFINE_EXPORTED_bool(conv_cpu_native_algo,
+                         true,
+                         "Whether CPU conv2d picks Winograd or a direct "
+                         "kernel by shape instead of im2col + GEMM.");
+
+/**
+ * CPU softmax related FLAG
+ * Name: FLAGS_softmax_cpu_exp_degree
+ * Since Version: 3.0.0
+ * Value Range: int32, default=7
+ * Example:
+ * Note: The exp used by the float CPU softmax and log_softmax kernels. 0 is
+ *       std::exp, 1 to 7 a polynomial of that degree, which is faster and
+ *       loses about a decimal digit per degree below 7. Double inputs always
+ *       use std::exp.
+ */
+PHI_DEFINE_EXPORTED_int32(softmax_cpu_exp_degree,
+                          7,
+                          "The exp of the float CPU softmax kernels, 0 for "
+                          "std::exp, 1 to 7 for a polynomial of that degree.");
+
+/**
+ * CPU rnn related FLAG
+ * Name: FLAGS_rnn_cpu_batched_inference
+ * Since Version: 3.0.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: Whether the CPU rnn kernel runs LSTM and GRU inference on length
+ *       sorted batches with packed weights and the jit gate kernels. If
+ *       false, every step runs on the whole batch and masks the finished
+ *       sequences.
+ */
+PHI_DEFINE_EXPORTED_bool(rnn_cpu_batched_inference,
+                         true,
+                         "Whether CPU LSTM / GRU inference runs on length "
+                         "sorted batches instead of masking every step.");
+
 /**
  * Distributed related FLAG
  * Name: FLAGS_get_host_by_name_time
@@ -1589,6 +1636,151 @@ PHI_DEFINE_EXPORTED_bool(enable_async_trace,
 
 PHI_DEFINE_EXPORTED_int32(async_trace_count, 5, "collective async trace count");
 
+/**
+ * ProcessGroupGloo related FLAG
+ * Name: gloo_allreduce_algo
+ * Since Version: 3.0.0
+ * Value Range: string, {auto, gloo, recursive_doubling, ring, hierarchical},
+ * default=auto
+ * Example: FLAGS_gloo_allreduce_algo=ring
+ * Note: All-reduce algorithm of gloo. auto chooses by message size and by
+ * whether several ranks share one host, gloo uses gloo::allreduce.
+ */
+PHI_DEFINE_EXPORTED_string(gloo_allreduce_algo,
+                           "auto",
+                           "All-reduce algorithm used by gloo.");
+
+/**
+ * ProcessGroupGloo related FLAG
+ * Name: gloo_allreduce_small_bytes
+ * Since Version: 3.0.0
+ * Value Range: int64, default=65536
+ * Example:
+ * Note: Messages up to this size are all-reduced by recursive doubling,
+ * larger ones by ring reduce-scatter plus all-gather.
+ */
+PHI_DEFINE_EXPORTED_int64(gloo_allreduce_small_bytes,
+                          65536,
+                          "Max bytes of gloo all-reduce using recursive "
+                          "doubling.");
+
+/**
+ * ProcessGroupGloo related FLAG
+ * Name: gloo_allreduce_use_shm
+ * Since Version: 3.0.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: Whether the auto gloo all-reduce reduces through shared memory
+ * among the ranks of one host before the inter-node exchange.
+ */
+PHI_DEFINE_EXPORTED_bool(gloo_allreduce_use_shm,
+                         true,
+                         "Whether gloo all-reduce uses shared memory within "
+                         "one host.");
+
+/**
+ * Profiler related FLAG
+ * Name: enable_sampling_recorder
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Whether to time a sample of the operators and the kernels nested in
+ * them even when the profiler is off.
+ */
+PHI_DEFINE_EXPORTED_bool(enable_sampling_recorder,
+                         false,
+                         "Whether to enable the always-on sampling recorder.");
+
+/**
+ * Profiler related FLAG
+ * Name: sampling_recorder_interval
+ * Since Version: 3.0.0
+ * Value Range: int32, default=100
+ * Example:
+ * Note: One in every N operators of a thread is timed by the sampling
+ * recorder.
+ */
+PHI_DEFINE_EXPORTED_int32(sampling_recorder_interval,
+                          100,
+                          "Sample one in every N operators of a thread.");
+
+/**
+ * Profiler related FLAG
+ * Name: sampling_recorder_buffer_size
+ * Since Version: 3.0.0
+ * Value Range: int32, default=8192
+ * Example:
+ * Note: Number of latest sampled events kept per thread.
+ */
+PHI_DEFINE_EXPORTED_int32(sampling_recorder_buffer_size,
+                          8192,
+                          "Number of sampled events kept per thread.");
+
+/**
+ * Profiler related FLAG
+ * Name: sampling_recorder_slo_us
+ * Since Version: 3.0.0
+ * Value Range: int64, default=0
+ * Example:
+ * Note: A sampled operator slower than this triggers a trace dump of the
+ * recent events, 0 disables it.
+ */
+PHI_DEFINE_EXPORTED_int64(sampling_recorder_slo_us,
+                          0,
+                          "Operator latency in us that triggers a trace dump.");
+
+/**
+ * Profiler related FLAG
+ * Name: sampling_recorder_dump_path
+ * Since Version: 3.0.0
+ * Value Range: string, default=""
+ * Example:
+ * Note: Directory of the chrome traces dumped on SLO breach, dumps are
+ * disabled when empty.
+ */
+PHI_DEFINE_EXPORTED_string(sampling_recorder_dump_path,
+                           "",
+                           "Directory of the traces dumped by the sampling "
+                           "monitor.");
+
+/**
+ * Profiler related FLAG
+ * Name: sampling_recorder_dump_seconds
+ * Since Version: 3.0.0
+ * Value Range: int32, default=10
+ * Example:
+ * Note: Seconds of history written to a trace dumped on SLO breach.
+ */
+PHI_DEFINE_EXPORTED_int32(sampling_recorder_dump_seconds,
+                          10,
+                          "Seconds of history in a dumped trace.");
+
+/**
+ * Profiler related FLAG
+ * Name: sampling_recorder_report_ms
+ * Since Version: 3.0.0
+ * Value Range: int32, default=1000
+ * Example:
+ * Note: Period of the sampling monitor publishing per-op latency stats.
+ */
+PHI_DEFINE_EXPORTED_int32(sampling_recorder_report_ms,
+                          1000,
+                          "Period in ms of the sampling monitor report.");
+
+/**
+ * Profiler related FLAG
+ * Name: enable_kernel_perf_counters
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Whether the operator info recorded by the profiler includes the
+ * cycles, instructions and cache misses of each kernel, read through
+ * perf_event_open. Only works on Linux.
+ */
+PHI_DEFINE_EXPORTED_bool(enable_kernel_perf_counters,
+                         false,
+                         "Whether to read hardware counters around kernels.");
+
 PHI_DEFINE_EXPORTED_bool(
     use_auto_growth_pinned_allocator,
     false,
@@ -13,6 +13,13 @@
 // limitations under the License.
 
 #include "paddle/fluid/distributed/collective/reducer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <future>
+
 #include "paddle/common/flags.h"
 #include "paddle/phi/api/lib/data_transform.h"
 #include "paddle/phi/backends/device_guard.h"
@@ -29,6 +36,59 @@ static bool IsStreamSafeAllocator() {
           FLAGS_use_stream_safe_cuda_allocator);
 }
 
+static double ElapsedMs(const std::chrono::steady_clock::time_point &start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+template <typename T>
+static void CastFromFloat(const float *src, int64_t numel, T *dst) {
+  for (int64_t i = 0; i < numel; ++i) {
+    dst[i] = static_cast<T>(src[i]);
+  }
+}
+
+template <typename T>
+static void CastToFloat(const T *src, int64_t numel, float *dst) {
+  for (int64_t i = 0; i < numel; ++i) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+// The task of a group reduced on the communication thread of the reducer.
+class CommThreadTask : public ProcessGroup::Task {
+ public:
+  CommThreadTask(
+      int rank,
+      std::future<std::unique_ptr<common::enforce::EnforceNotMet>> done)
+      : ProcessGroup::Task(rank, CommType::ALLREDUCE, /*sync_op=*/false),
+        done_(std::move(done)) {}
+
+  bool IsCompleted() override {
+    return !done_.valid() || done_.wait_for(std::chrono::seconds(0)) ==
+                                 std::future_status::ready;
+  }
+
+  bool Wait(std::chrono::milliseconds timeout UNUSED) override {
+    Synchronize();
+    return true;
+  }
+
+  void Synchronize() override {
+    if (done_.valid()) {
+      error_ = done_.get();
+    }
+    if (error_ != nullptr) {
+      throw *error_;
+    }
+  }
+
+ private:
+  std::future<std::unique_ptr<common::enforce::EnforceNotMet>> done_;
+  std::unique_ptr<common::enforce::EnforceNotMet> error_;
+};
+
 static Backend TransToBackend(platform::Place place) {
   static const std::map<phi::AllocationType, Backend> type_backend = {
       {phi::AllocationType::GPU, Backend::GPU},
@@ -700,6 +760,7 @@ void EagerReducer::PrepareForBackward(const std::vector<Tensor> &outputs) {
   std::for_each(groups_.begin(), groups_.end(), [](EagerGroup &group) {
     group.pending_ = group.tensor_indices_.size();
     group.sparse_contents_ = Tensor();
+    group.stat_ = EagerGroupCommStat();
   });
 
   // reinitialize vars_marked_ready_ for next iteration
@@ -784,6 +845,11 @@ void EagerReducer::AddDistHook(size_t var_index) {
   VLOG(3) << "Tensor[" << var_index << "] [" << tensors_[var_index].name()
           << "@Grad] arrived and triggered disthook";
 
+  if (!backward_started_) {
+    backward_started_ = true;
+    backward_start_ = std::chrono::steady_clock::now();
+  }
+
   local_used_vars_[var_index] = 1;
 
   if (!has_marked_unused_vars_) {
@@ -977,6 +1043,11 @@ void EagerReducer::MarkGroupReady(size_t group_index) {
        ++next_group_) {
     UNUSED auto &group = groups_[next_group_];
     if (group.is_sparse_) {
+      if (comm_pool_ != nullptr) {
+        // the collectives of the earlier groups must not interleave with
+        // the ones of the sparse group on the process group
+        comm_pool_->Run([] {}).wait();
+      }
       AllReduceSparse(&group, static_cast<int>(next_group_));
     } else {
       FusedAllReduceSchedule(&group, static_cast<int>(next_group_));
@@ -1069,13 +1140,28 @@ void EagerReducer::ProcessUnusedDenseVars() {
 void EagerReducer::FinalizeBackward() {
   groups_need_finalize_ = false;
   grad_need_hooks_ = false;
+  // the last gradient arrived, backward computation is over
+  const auto backward_end = std::chrono::steady_clock::now();
   for (auto &group : groups_) {
     if (!group.is_sparse_) {
       group.task->Synchronize();
-      if (!IsStreamSafeAllocator()) {
+      if (comm_pool_ != nullptr) {
+        const auto hidden_end = std::min(group.comm_end_, backward_end);
+        group.stat_.overlap_time =
+            hidden_end > group.comm_start_
+                ? std::chrono::duration<double, std::milli>(
+                      hidden_end - group.comm_start_)
+                      .count()
+                : 0.0;
+      }
+      if (group.need_decompress_) {
+        DecompressGroup(&group);
+      }
+      if (group.need_split_) {
         auto *default_ctx =
             platform::DeviceContextPool::Instance().Get(inner_place_);
         group.SplitTensors(*default_ctx);
+        group.need_split_ = false;
       }
     }
   }
@@ -1087,7 +1173,225 @@ void EagerReducer::FinalizeBackward() {
     VLOG(3) << "ProcessUnusedDenseVars is finished.";
   }
 
-  VLOG(3) << "In the batch, Reducer is finished.";
+  double comm_time = 0.0;
+  double overlap_time = 0.0;
+  last_group_stats_.clear();
+  last_group_stats_.reserve(groups_.size());
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    const auto &stat = groups_[i].stat_;
+    VLOG(4) << "Group[" << i << "] numel: " << stat.numel
+            << ", raw bytes: " << stat.raw_bytes
+            << ", wire bytes: " << stat.wire_bytes
+            << ", concat: " << stat.concat_time
+            << "ms, compress: " << stat.compress_time
+            << "ms, comm: " << stat.comm_time
+            << "ms, decompress: " << stat.decompress_time
+            << "ms, overlap: " << stat.overlap_time << "ms";
+    comm_time += stat.comm_time;
+    overlap_time += stat.overlap_time;
+    last_group_stats_.push_back(stat);
+  }
+  last_backward_time_ = backward_started_ ? ElapsedMs(backward_start_) : 0.0;
+  backward_started_ = false;
+
+  VLOG(3) << "In the batch, Reducer is finished. Backward time: "
+          << last_backward_time_ << "ms, communication time: " << comm_time
+          << "ms, overlapped with backward: " << overlap_time << "ms.";
+}
+
+void EagerReducer::SetGradCompressOptions(const GradCompressOptions &options) {
+  if (options.type != GradCompressType::NONE) {
+    PADDLE_ENFORCE_EQ(
+        process_group_->GetBackendName(),
+        "GLOO",
+        platform::errors::Unimplemented(
+            "Gradient compression is only supported by ProcessGroupGloo, "
+            "but the backend of the process group is %s.",
+            process_group_->GetBackendName()));
+    PADDLE_ENFORCE_EQ(platform::is_cpu_place(inner_place_),
+                      true,
+                      platform::errors::Unimplemented(
+                          "Gradient compression is only supported for CPU "
+                          "gradients, but the gradients are on place (%s).",
+                          inner_place_));
+  }
+  if (options.type == GradCompressType::TOPK) {
+    PADDLE_ENFORCE_EQ(
+        options.topk_ratio > 0.0 && options.topk_ratio <= 1.0,
+        true,
+        platform::errors::InvalidArgument(
+            "The topk_ratio of gradient compression must be in (0, 1], "
+            "but received %f.",
+            options.topk_ratio));
+  }
+  PADDLE_ENFORCE_GE(options.min_compress_numel,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The min_compress_numel of gradient compression must "
+                        "be non-negative, but received %d.",
+                        options.min_compress_numel));
+
+  compress_options_ = options;
+  // the residual of the previous setting is meaningless for the new one
+  for (auto &group : groups_) {
+    group.error_feedback_.clear();
+  }
+  if (options.type == GradCompressType::NONE) {
+    comm_pool_.reset();
+  } else if (comm_pool_ == nullptr) {
+    comm_pool_ = std::make_unique<phi::ThreadPool>(1);
+  }
+}
+
+bool EagerReducer::NeedCompress(const EagerGroup &group) const {
+  return compress_options_.type != GradCompressType::NONE &&
+         !group.is_sparse_ && group.dtype_ == phi::DataType::FLOAT32 &&
+         group.all_length_ >= compress_options_.min_compress_numel;
+}
+
+void EagerReducer::CompressedAllReduce(EagerGroup *group,
+                                       const int curr_group_index) {
+  VLOG(3) << "group [" << curr_group_index << "] start compressed allreduce.";
+
+  auto &stat = group->stat_;
+  auto *dev_ctx = static_cast<phi::CPUContext *>(
+      platform::DeviceContextPool::Instance().Get(inner_place_));
+  auto *contents =
+      std::dynamic_pointer_cast<phi::DenseTensor>(group->dense_contents_.impl())
+          .get();
+  float *grad = contents->data<float>();
+  const int64_t numel = group->all_length_;
+
+  auto start = std::chrono::steady_clock::now();
+  if (compress_options_.type == GradCompressType::FP16 ||
+      compress_options_.type == GradCompressType::BF16) {
+    auto &low_precision = group->compressed_;
+    low_precision.Resize({numel});
+    if (compress_options_.type == GradCompressType::FP16) {
+      CastFromFloat(
+          grad, numel, dev_ctx->Alloc<phi::dtype::float16>(&low_precision));
+    } else {
+      CastFromFloat(
+          grad, numel, dev_ctx->Alloc<phi::dtype::bfloat16>(&low_precision));
+    }
+    stat.wire_bytes = numel * static_cast<int64_t>(sizeof(uint16_t));
+    stat.compress_time = ElapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    distributed::AllreduceOptions opts;
+    opts.reduce_op = ReduceOp::SUM;
+    std::vector<phi::DenseTensor> in_out = {low_precision};
+    process_group_->AllReduce(in_out, in_out, opts)->Synchronize();
+    stat.comm_time = ElapsedMs(start);
+    group->need_decompress_ = true;
+    return;
+  }
+
+  // TOPK: compensate the gradient with the residual of the previous steps,
+  // send the k largest entries and keep the rest as the new residual.
+  auto &residual = group->error_feedback_;
+  if (static_cast<int64_t>(residual.size()) != numel) {
+    residual.assign(numel, 0.0f);
+  }
+  for (int64_t i = 0; i < numel; ++i) {
+    residual[i] += grad[i];
+  }
+
+  const int64_t k = std::min(
+      numel,
+      std::max(static_cast<int64_t>(1),
+               static_cast<int64_t>(std::ceil(compress_options_.topk_ratio *
+                                              static_cast<double>(numel)))));
+  std::vector<float> magnitude(numel);
+  for (int64_t i = 0; i < numel; ++i) {
+    magnitude[i] = std::fabs(residual[i]);
+  }
+  std::nth_element(magnitude.begin(),
+                   magnitude.begin() + (k - 1),
+                   magnitude.end(),
+                   std::greater<float>());
+  const float threshold = magnitude[k - 1];
+
+  phi::DenseTensor indices, values;
+  indices.Resize({k});
+  values.Resize({k});
+  auto *indices_data = dev_ctx->Alloc<int64_t>(&indices);
+  auto *values_data = dev_ctx->Alloc<float>(&values);
+  int64_t selected = 0;
+  // entries strictly above the threshold first, then ties until k is reached
+  for (int64_t i = 0; i < numel && selected < k; ++i) {
+    if (std::fabs(residual[i]) > threshold) {
+      indices_data[selected] = i;
+      values_data[selected] = residual[i];
+      residual[i] = 0.0f;
+      ++selected;
+    }
+  }
+  for (int64_t i = 0; i < numel && selected < k; ++i) {
+    if (residual[i] != 0.0f && std::fabs(residual[i]) == threshold) {
+      indices_data[selected] = i;
+      values_data[selected] = residual[i];
+      residual[i] = 0.0f;
+      ++selected;
+    }
+  }
+  // a zero threshold means fewer than k non-zero entries, pad with zeros
+  for (; selected < k; ++selected) {
+    indices_data[selected] = 0;
+    values_data[selected] = 0.0f;
+  }
+  stat.wire_bytes =
+      k * static_cast<int64_t>(sizeof(int64_t) + sizeof(float));
+  stat.compress_time = ElapsedMs(start);
+
+  start = std::chrono::steady_clock::now();
+  auto &gathered_indices = group->gathered_indices_;
+  auto &gathered_values = group->gathered_values_;
+  gathered_indices.Resize({k * nranks_});
+  gathered_values.Resize({k * nranks_});
+  dev_ctx->Alloc<int64_t>(&gathered_indices);
+  dev_ctx->Alloc<float>(&gathered_values);
+  std::vector<phi::DenseTensor> in = {indices};
+  std::vector<phi::DenseTensor> out = {gathered_indices};
+  process_group_->AllGather(in, out)->Synchronize();
+  in = {values};
+  out = {gathered_values};
+  process_group_->AllGather(in, out)->Synchronize();
+  stat.comm_time = ElapsedMs(start);
+  group->need_decompress_ = true;
+}
+
+void EagerReducer::DecompressGroup(EagerGroup *group) {
+  auto *contents =
+      std::dynamic_pointer_cast<phi::DenseTensor>(group->dense_contents_.impl())
+          .get();
+  float *grad = contents->data<float>();
+  const int64_t numel = group->all_length_;
+
+  auto start = std::chrono::steady_clock::now();
+  if (group->compressed_.initialized()) {
+    if (group->compressed_.dtype() == phi::DataType::FLOAT16) {
+      CastToFloat(group->compressed_.data<phi::dtype::float16>(), numel, grad);
+    } else {
+      CastToFloat(
+          group->compressed_.data<phi::dtype::bfloat16>(), numel, grad);
+    }
+  } else {
+    // the sum of the top-k entries of all ranks, the unsent remainder stays
+    // in the error feedback of each rank
+    std::memset(grad, 0, numel * sizeof(float));
+    const auto *all_indices = group->gathered_indices_.data<int64_t>();
+    const auto *all_values = group->gathered_values_.data<float>();
+    const int64_t gathered = group->gathered_values_.numel();
+    for (int64_t i = 0; i < gathered; ++i) {
+      grad[all_indices[i]] += all_values[i];
+    }
+  }
+  group->compressed_ = phi::DenseTensor();
+  group->gathered_indices_ = phi::DenseTensor();
+  group->gathered_values_ = phi::DenseTensor();
+  group->need_decompress_ = false;
+  group->stat_.decompress_time = ElapsedMs(start);
 }
 
 void EagerReducer::FusedAllReduceSchedule(EagerGroup *group,
@@ -1098,31 +1402,68 @@ void EagerReducer::FusedAllReduceSchedule(EagerGroup *group,
 
   VLOG(3) << "group [" << curr_group_index << "] start fused_allreduce.";
 
+  auto &stat = group->stat_;
+  stat.numel = group->all_length_;
+  stat.raw_bytes =
+      group->all_length_ * static_cast<int64_t>(phi::SizeOf(group->dtype_));
+
   // concat tensors
+  auto start = std::chrono::steady_clock::now();
   group->ConcatTensors(inner_place_);
+  stat.concat_time = ElapsedMs(start);
 
   // div nranks
   paddle::experimental::scale_(
       group->dense_contents_, 1.0 / nranks_, 0.0, false);  // NOLINT
 
-  // all_reduce
-  std::vector<Tensor> reduce_tensors = {group->dense_contents_};
-  std::vector<phi::DenseTensor> in_out;
-  in_out.reserve(reduce_tensors.size());
-  for (auto &t : reduce_tensors) {
-    in_out.push_back(*std::dynamic_pointer_cast<phi::DenseTensor>(t.impl()));
+  if (comm_pool_ != nullptr) {
+    // the gloo collectives are synchronous, run them on the communication
+    // thread and let the gradient hooks go on
+    auto done = comm_pool_->RunAndGetException(
+        [this, group, curr_group_index, opts] {
+          group->comm_start_ = std::chrono::steady_clock::now();
+          if (NeedCompress(*group)) {
+            CompressedAllReduce(group, curr_group_index);
+          } else {
+            group->stat_.wire_bytes = group->stat_.raw_bytes;
+            std::vector<phi::DenseTensor> in_out = {
+                *std::dynamic_pointer_cast<phi::DenseTensor>(
+                    group->dense_contents_.impl())};
+            process_group_->AllReduce(in_out, in_out, opts)->Synchronize();
+            group->stat_.comm_time = ElapsedMs(group->comm_start_);
+          }
+          group->comm_end_ = std::chrono::steady_clock::now();
+        });
+    group->task = std::make_shared<CommThreadTask>(process_group_->GetRank(),
+                                                   std::move(done));
+  } else {
+    // all_reduce
+    std::vector<Tensor> reduce_tensors = {group->dense_contents_};
+    std::vector<phi::DenseTensor> in_out;
+    in_out.reserve(reduce_tensors.size());
+    for (auto &t : reduce_tensors) {
+      in_out.push_back(*std::dynamic_pointer_cast<phi::DenseTensor>(t.impl()));
+    }
+    stat.wire_bytes = stat.raw_bytes;
+    // NOTE: for asynchronous process groups this only covers the launch
+    start = std::chrono::steady_clock::now();
+    group->task = process_group_->AllReduce(in_out, in_out, opts);
+    stat.comm_time = ElapsedMs(start);
   }
-  group->task = process_group_->AllReduce(in_out, in_out, opts);
 
   auto *context = process_group_->GetDeviceContext(inner_place_);
 
-  if (IsStreamSafeAllocator()) {
+  // The communication thread may still be reducing or compressing the
+  // contents, split them in FinalizeBackward after it is done.
+  if (IsStreamSafeAllocator() && comm_pool_ == nullptr) {
     // NOTE(shenliang03): The best_fit allocator strategy is multi-stream
     // insecure. In the Split operator, additional memory will be applied for
     // calculation, and if it is asynchronous, an illegal memory access may be
     // encountered.
     group->SplitTensors(*context);
     group->task->UpdateWaitChain(*context);
+  } else {
+    group->need_split_ = true;
   }
 }
 
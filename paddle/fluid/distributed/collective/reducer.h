@@ -14,7 +14,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "paddle/fluid/distributed/collective/process_group.h"
@@ -27,6 +29,7 @@
 #include "paddle/phi/api/include/fused_api.h"
 #include "paddle/phi/api/include/tensor.h"
 #include "paddle/phi/common/data_type.h"
+#include "paddle/phi/core/threadpool.h"
 #include "paddle/phi/kernels/funcs/concat_and_split_functor.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 #include "paddle/utils/string/string_helper.h"
@@ -44,6 +47,43 @@ std::vector<std::vector<size_t>> Eager_AssignGroupBySize(
     const std::vector<size_t> &group_size_limits,
     const std::vector<int64_t> &tensor_indices = {});
 
+// Gradient compression applied to dense groups before communication. It is
+// only supported for CPU tensors reduced by ProcessGroupGloo, where the
+// all-reduce is bandwidth-bound and runs on the host.
+enum class GradCompressType {
+  NONE = 0,
+  // cast the fused fp32 gradient to fp16/bf16 for the all-reduce
+  FP16 = 1,
+  BF16 = 2,
+  // keep the top-k entries by magnitude, the rest is accumulated locally
+  // as error feedback and added to the gradient of the next step
+  TOPK = 3,
+};
+
+struct GradCompressOptions {
+  GradCompressType type = GradCompressType::NONE;
+  // ratio of elements kept by TOPK, in (0, 1]
+  double topk_ratio = 0.01;
+  // groups with fewer elements than this are reduced uncompressed
+  int64_t min_compress_numel = 0;
+};
+
+// Per-step communication statistics of one group, all times are in ms.
+struct EagerGroupCommStat {
+  int64_t numel{0};
+  // bytes of the uncompressed gradient and bytes sent by this rank
+  int64_t raw_bytes{0};
+  int64_t wire_bytes{0};
+  double concat_time{0.0};
+  double compress_time{0.0};
+  double comm_time{0.0};
+  double decompress_time{0.0};
+  // part of the compression and communication that ran on the
+  // communication thread before the last gradient was produced, that is,
+  // hidden behind backward computation
+  double overlap_time{0.0};
+};
+
 class EagerGroup {
  public:
   Tensor dense_contents_;
@@ -69,6 +109,24 @@ class EagerGroup {
   // help to sync
   std::shared_ptr<ProcessGroup::Task> task;
 
+  // residual of TOPK compression, kept across steps as error feedback
+  std::vector<float> error_feedback_;
+
+  // buffers of a compressed all-reduce in flight, the fp16/bf16 gradient
+  // or the gathered top-k indices and values of all ranks
+  phi::DenseTensor compressed_;
+  phi::DenseTensor gathered_indices_;
+  phi::DenseTensor gathered_values_;
+  bool need_decompress_{false};
+  // the group is split in FinalizeBackward, once its all-reduce finished
+  // and the contents are decompressed
+  bool need_split_{false};
+
+  EagerGroupCommStat stat_;
+  // the span of the work of the group on the communication thread
+  std::chrono::steady_clock::time_point comm_start_;
+  std::chrono::steady_clock::time_point comm_end_;
+
   // context is used to select the stream for concat
   void ConcatTensors(const platform::Place &);
 
@@ -113,7 +171,26 @@ class EagerReducer {
   void ProcessUnusedDenseVars();
   bool HasGrad(size_t var_index);
 
+  void SetGradCompressOptions(const GradCompressOptions &options);
+  const GradCompressOptions &GetGradCompressOptions() const {
+    return compress_options_;
+  }
+  // Statistics of the last finished backward, one entry per group.
+  const std::vector<EagerGroupCommStat> &GetGroupCommStats() const {
+    return last_group_stats_;
+  }
+  // Wall time of the last backward, from the first gradient hook to the end
+  // of FinalizeBackward, in ms.
+  double GetBackwardTime() const { return last_backward_time_; }
+
  private:
+  bool NeedCompress(const EagerGroup &group) const;
+  // Runs on the communication thread: compresses the group, exchanges it
+  // and leaves the result for DecompressGroup.
+  void CompressedAllReduce(EagerGroup *group, const int curr_group_index);
+  // Runs in FinalizeBackward after the task of the group finished.
+  void DecompressGroup(EagerGroup *group);
+
   std::vector<Tensor> tensors_;
   std::vector<std::vector<size_t>> group_indices_;
   std::vector<bool> is_sparse_gradient_;
@@ -139,6 +216,16 @@ class EagerReducer {
   bool find_unused_vars_once_{true};
   bool groups_need_finalize_{false};
   Tensor global_used_vars_;
+
+  GradCompressOptions compress_options_;
+  std::chrono::steady_clock::time_point backward_start_;
+  bool backward_started_{false};
+  double last_backward_time_{0.0};
+  std::vector<EagerGroupCommStat> last_group_stats_;
+  // With compression, every dense group is reduced in order on this thread
+  // so that backward is not blocked by the synchronous gloo collectives.
+  // Declared last to be joined before the groups it works on are freed.
+  std::unique_ptr<phi::ThreadPool> comm_pool_;
 };
 
 }  //  namespace distributed
@@ -17,11 +17,20 @@
 #include <algorithm>
 #include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/fleet_executor/global.h"
 #include "paddle/fluid/distributed/fleet_executor/interceptor.h"
 #include "paddle/fluid/distributed/fleet_executor/message_bus.h"
 #include "paddle/fluid/distributed/fleet_executor/runtime_graph.h"
+#include "paddle/fluid/distributed/fleet_executor/task_loop.h"
 #include "paddle/fluid/distributed/fleet_executor/task_node.h"
 #include "paddle/fluid/framework/garbage_collector.h"
 #include "paddle/fluid/framework/program_desc.h"
@@ -47,6 +56,31 @@ USE_INTERCEPTOR(Sink);
 USE_INTERCEPTOR(Cond);
 USE_INTERCEPTOR(Start);
 
+namespace {
+
+// Runs first on the loop, before any message of its interceptor.
+void BindTaskLoop(TaskLoop* loop, const std::vector<int>& cores) {
+  loop->QueueInLoop([cores]() {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int core : cores) {
+      if (core >= 0 && core < CPU_SETSIZE) CPU_SET(core, &cpu_set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set)) {
+      LOG(WARNING) << "Failed to bind the task loop thread to "
+                   << cores.size() << " cpu cores.";
+    }
+#endif
+#ifdef PADDLE_WITH_MKLML
+    // for the parallel regions of the ops run on this thread
+    omp_set_num_threads(static_cast<int>(cores.size()));
+#endif
+  });
+}
+
+}  // namespace
+
 void Carrier::Init(
     int64_t rank,
     const std::unordered_map<int64_t, int64_t>& interceptor_id_to_rank) {
@@ -101,8 +135,18 @@ void Carrier::Init(
 
   // TODO(fleet_exe dev): thread pool
   thread_num_ = 1;
+  interceptor_id_to_loop_.clear();
+  for (const auto& item : interceptor_id_to_node_) {
+    if (!item.second->cpu_cores().empty()) {
+      interceptor_id_to_loop_.emplace(item.first, thread_num_++);
+    }
+  }
   thread_pool_.SetThreadNum(thread_num_);
   thread_pool_.Start();
+  for (const auto& item : interceptor_id_to_loop_) {
+    BindTaskLoop(thread_pool_.GetLoop(item.second),
+                 interceptor_id_to_node_.at(item.first)->cpu_cores());
+  }
 
   CreateInterceptors(inference_root_scope_vars);
   is_init_ = true;
@@ -260,8 +304,9 @@ Interceptor* Carrier::SetInterceptor(int64_t interceptor_id,
   interceptor->RegisterCarrier(this);
 
   // TODO(fleet_exe dev): get loop
-  auto* loop =
-      thread_pool_.GetLoop(static_cast<int>(interceptor_id % thread_num_));
+  auto loop_iter = interceptor_id_to_loop_.find(interceptor_id);
+  auto* loop = thread_pool_.GetLoop(
+      loop_iter == interceptor_id_to_loop_.end() ? 0 : loop_iter->second);
   PADDLE_ENFORCE_NOT_NULL(
       loop, platform::errors::Fatal("thread task loop must not null"));
   interceptor->RegisterTaskLoop(loop);
@@ -117,6 +117,8 @@ class Carrier final {
   std::unordered_map<int64_t, TaskNode*> interceptor_id_to_node_;
   std::unordered_map<int64_t, int64_t> interceptor_id_to_rank_;
   int thread_num_;
+  // interceptor id -> the task loop of its own, the others share loop 0
+  std::unordered_map<int64_t, int> interceptor_id_to_loop_;
   TaskLoopThreadPool thread_pool_;
   std::unordered_set<int64_t> interceptor_ids_;
 };
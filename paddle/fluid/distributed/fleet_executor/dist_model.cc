@@ -16,7 +16,9 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <chrono>  // NOLINT
+#include <thread>  // NOLINT
 
 #include "paddle/fluid/distributed/fleet_executor/fleet_executor.h"
 #include "paddle/fluid/distributed/fleet_executor/task_node.h"
@@ -477,13 +479,33 @@ bool DistModel::LoadParameters() {
 }
 
 bool DistModel::PrepareFleetExe() {
-  task_node_ = std::make_unique<TaskNode>(program_.get(), config_.local_rank);
-  // With auto cut, there is no concept of pp, no need to add dependency.
-  task_node_->SetType("Compute");
-  task_node_->Init();
+  if (config_.num_micro_batches < 1 || config_.num_pipeline_stages < 1 ||
+      config_.max_in_flight_micro_batches < 1) {
+    LOG(ERROR) << "The numbers of micro batches, pipeline stages and in "
+                  "flight micro batches of DistModel should be positive.";
+    return false;
+  }
+  std::vector<TaskNode *> task_nodes;
+  std::unordered_map<int64_t, int64_t> id_to_rank;
+  if (config_.num_pipeline_stages > 1) {
+    if (!PreparePipelineStages(&task_nodes, &id_to_rank)) {
+      return false;
+    }
+  } else {
+    // runs once for each micro batch, the node inits its ops itself
+    task_node_ = std::make_unique<TaskNode>(program_.get(),
+                                            config_.local_rank,
+                                            config_.local_rank,
+                                            config_.num_micro_batches);
+    // With auto cut, there is no concept of pp, no need to add dependency.
+    task_node_->SetType("Compute");
+    task_nodes.emplace_back(task_node_.get());
+    for (int i = 0; i < config_.nranks; ++i) {
+      id_to_rank.insert({i, i});
+    }
+  }
   executor_desc_ = FleetExecutorDesc();
   executor_desc_.set_cur_rank(config_.local_rank);
-  std::unordered_map<int64_t, int64_t> id_to_rank;
 
   for (int i = 0; i < config_.nranks; ++i) {
     RankInfo *rank_info = executor_desc_.add_cluster_info();
@@ -493,16 +515,105 @@ bool DistModel::PrepareFleetExe() {
     } else {
       rank_info->set_ip_port(config_.trainer_endpoints[i]);
     }
-    id_to_rank.insert({i, i});
+  }
+  if (config_.num_micro_batches > 1) {
+    // The feed and fetch lists are persistable, each micro batch gets lists
+    // of its own in its scope to shadow those of the root scope.
+    for (int64_t i = 0; i < config_.num_micro_batches; ++i) {
+      framework::Scope *micro_scope = &scope_->NewScope();
+      micro_scope->Var("fetch")->GetMutable<framework::FetchList>();
+      micro_scopes_.emplace_back(micro_scope);
+    }
   }
   fleet_exe = std::make_unique<FleetExecutor>(executor_desc_);
   fleet_exe->Init(carrier_id_,
                   *(program_.get()),
                   scope_.get(),
                   place_,
-                  1,
-                  {task_node_.get()},
-                  id_to_rank);
+                  config_.num_micro_batches,
+                  task_nodes,
+                  id_to_rank,
+                  {},
+                  micro_scopes_);
+  return true;
+}
+
+bool DistModel::PreparePipelineStages(
+    std::vector<TaskNode *> *task_nodes,
+    std::unordered_map<int64_t, int64_t> *id_to_rank) {
+  const int64_t num_stages = config_.num_pipeline_stages;
+  if (!platform::is_cpu_place(place_)) {
+    LOG(ERROR) << "DistModel only supports pipeline stages on CPU.";
+    return false;
+  }
+  std::vector<framework::OpDesc *> ops = program_->Block(0).AllOps();
+  int64_t num_compute_ops = 0;
+  for (auto *op : ops) {
+    if (op->Type() != "feed" && op->Type() != "fetch") ++num_compute_ops;
+  }
+  if (num_compute_ops < num_stages) {
+    LOG(ERROR) << "Cannot cut " << num_compute_ops << " ops into "
+               << num_stages << " pipeline stages.";
+    return false;
+  }
+
+  // Contiguous stages of about the same number of ops, the feed ops go to
+  // the first stage and the fetch ops to the last one.
+  std::vector<std::vector<framework::OpDesc *>> stage_ops(num_stages);
+  int64_t compute_op_idx = 0;
+  for (auto *op : ops) {
+    if (op->Type() == "feed") {
+      stage_ops.front().emplace_back(op);
+    } else if (op->Type() == "fetch") {
+      stage_ops.back().emplace_back(op);
+    } else {
+      stage_ops[compute_op_idx++ * num_stages / num_compute_ops].emplace_back(
+          op);
+    }
+  }
+
+  std::vector<int> cores = config_.cpu_cores;
+  if (cores.empty()) {
+    for (int i = 0; i < static_cast<int>(std::thread::hardware_concurrency());
+         ++i) {
+      cores.emplace_back(i);
+    }
+  }
+  if (cores.size() < static_cast<size_t>(num_stages)) {
+    LOG(WARNING) << "There are fewer cpu cores than the " << num_stages
+                 << " pipeline stages, some stages will share cores.";
+  }
+
+  for (int64_t rank = 0; rank < config_.nranks; ++rank) {
+    for (int64_t i = 0; i < num_stages; ++i) {
+      id_to_rank->insert({rank * num_stages + i, rank});
+    }
+  }
+  for (int64_t i = 0; i < num_stages; ++i) {
+    const int64_t task_id = config_.local_rank * num_stages + i;
+    auto node = std::make_shared<TaskNode>(0,
+                                           stage_ops[i],
+                                           config_.local_rank,
+                                           task_id,
+                                           config_.num_micro_batches);
+    node->SetType("Compute");
+    if (!cores.empty()) {
+      size_t begin = i * cores.size() / num_stages;
+      size_t end = std::max((i + 1) * cores.size() / num_stages, begin + 1);
+      node->SetCpuCores(
+          std::vector<int>(cores.begin() + begin, cores.begin() + end));
+    }
+    if (i > 0) {
+      // bounds the micro batches between the two stages
+      stage_nodes_.back()->AddDownstreamTask(
+          task_id, config_.max_in_flight_micro_batches);
+      node->AddUpstreamTask(task_id - 1, config_.max_in_flight_micro_batches);
+    }
+    stage_nodes_.emplace_back(node);
+    task_nodes->emplace_back(node.get());
+  }
+  VLOG(3) << "DistModel runs in " << num_stages << " pipeline stages with "
+          << config_.num_micro_batches << " micro batches.";
   return true;
 }
 
@@ -591,7 +702,25 @@ bool DistModel::FeedData(const std::vector<DistModelTensor> &input_data,
       return false;
     }
     int feed_idx = static_cast<int>(feed_names_[target_name]);
-    framework::SetFeedVariable(scope, *input_tensor, "feed", feed_idx);
+    if (micro_scopes_.empty()) {
+      framework::SetFeedVariable(scope, *input_tensor, "feed", feed_idx);
+      continue;
+    }
+    const int64_t num_micro = static_cast<int64_t>(micro_scopes_.size());
+    const int64_t rows =
+        input_tensor->dims().size() > 0 ? input_tensor->dims()[0] : 0;
+    if (!input_tensor->lod().empty() || rows < num_micro) {
+      LOG(ERROR) << "Cannot split feed var [" << target_name << "] into "
+                 << num_micro << " micro batches along the first dim.";
+      return false;
+    }
+    for (int64_t m = 0; m < num_micro; ++m) {
+      // shares the memory of the loaded tensor
+      phi::DenseTensor micro_tensor = input_tensor->Slice(
+          m * rows / num_micro, (m + 1) * rows / num_micro);
+      framework::SetFeedVariable(
+          micro_scopes_[m], micro_tensor, "feed", feed_idx);
+    }
   }
   return true;
 }
@@ -610,10 +739,19 @@ bool DistModel::FetchResults(std::vector<DistModelTensor> *output_data,
             "Fetch op's col attr(%d) should be equal to the index(%d)",
             idx,
             i));
-    framework::FetchType &fetch_var =
-        framework::GetFetchVariable(*scope, "fetch", idx);
-    auto &fetch = PADDLE_GET(phi::DenseTensor, fetch_var);
-    auto type = framework::TransToProtoVarType(fetch.dtype());
+    std::vector<const phi::DenseTensor *> fetch;
+    if (micro_scopes_.empty()) {
+      framework::FetchType &fetch_var =
+          framework::GetFetchVariable(*scope, "fetch", idx);
+      fetch.emplace_back(&PADDLE_GET(phi::DenseTensor, fetch_var));
+    } else {
+      for (auto *micro_scope : micro_scopes_) {
+        framework::FetchType &fetch_var =
+            framework::GetFetchVariable(*micro_scope, "fetch", idx);
+        fetch.emplace_back(&PADDLE_GET(phi::DenseTensor, fetch_var));
+      }
+    }
+    auto type = framework::TransToProtoVarType(fetch.front()->dtype());
     auto output = &(output_data->at(i));
     output->name = idx_to_fetches_[idx];
     bool rst = false;
@@ -643,18 +781,36 @@ bool DistModel::FetchResults(std::vector<DistModelTensor> *output_data,
 }
 
 template <typename T>
-bool DistModel::FetchResult(const phi::DenseTensor &fetch,
+bool DistModel::FetchResult(const std::vector<const phi::DenseTensor *> &fetch,
                             DistModelTensor *output_data) {
-  auto shape = common::vectorize(fetch.dims());
+  // the fetches of the micro batches are concatenated along the first dim
+  auto shape = common::vectorize(fetch.front()->dims());
+  int64_t num_elems = fetch.front()->numel();
+  for (size_t i = 1; i < fetch.size(); ++i) {
+    auto dims = common::vectorize(fetch[i]->dims());
+    if (shape.empty() || dims.size() != shape.size() ||
+        !std::equal(dims.begin() + 1, dims.end(), shape.begin() + 1)) {
+      LOG(ERROR) << "The fetches of the micro batches cannot be concatenated "
+                    "along the first dim.";
+      return false;
+    }
+    shape[0] += dims[0];
+    num_elems += fetch[i]->numel();
+  }
   output_data->shape.assign(shape.begin(), shape.end());
-  const T *data = fetch.data<T>();
-  int64_t num_elems = fetch.numel();
   output_data->data.Resize(num_elems * sizeof(T));
   // The output of fetch op is always on the cpu, no need switch on place
-  memcpy(output_data->data.data(), data, num_elems * sizeof(T));
+  char *dst = static_cast<char *>(output_data->data.data());
+  for (auto *tensor : fetch) {
+    if (tensor->numel() == 0) continue;
+    memcpy(dst, tensor->data<T>(), tensor->numel() * sizeof(T));
+    dst += tensor->numel() * sizeof(T);
+  }
   output_data->lod.clear();
-  for (auto &level : fetch.lod()) {
-    output_data->lod.emplace_back(level.begin(), level.end());
+  if (fetch.size() == 1) {
+    for (auto &level : fetch.front()->lod()) {
+      output_data->lod.emplace_back(level.begin(), level.end());
+    }
   }
   return true;
 }
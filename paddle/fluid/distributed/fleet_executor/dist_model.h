@@ -16,6 +16,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "paddle/fluid/distributed/fleet_executor/dist_model_tensor_wrapper.h"
@@ -50,6 +51,17 @@ struct DistModelConfig {
   int64_t nranks{1};
   int64_t local_rank{0};
   bool enable_timer{false};
+  // The batch of a run is split along the first dim of the feeds into this
+  // many micro batches, and the fetches of them are concatenated back.
+  int64_t num_micro_batches{1};
+  // More than one cuts the program into stages of about the same number of
+  // ops, each on a thread of its own, so that the micro batches flow through
+  // them concurrently. CPU only.
+  int64_t num_pipeline_stages{1};
+  // how many micro batches a stage may run ahead of the next one
+  int64_t max_in_flight_micro_batches{2};
+  // split into disjoint sets for the stages, all the cores if empty
+  std::vector<int> cpu_cores{};
   std::map<int64_t, std::vector<int64_t>> ring_id_to_ranks_{};
   std::map<int64_t, std::vector<int64_t>> rank_to_ring_ids_{};
 };
@@ -73,6 +85,8 @@ class DistModel {
   bool CommInit();
   bool PrepareFeedAndFetch();
   bool PrepareFleetExe();
+  bool PreparePipelineStages(std::vector<TaskNode*>* task_nodes,
+                             std::unordered_map<int64_t, int64_t>* id_to_rank);
   void InsertCommOp(std::string tmp_var_name,
                     int nranks,
                     int rank,
@@ -84,7 +98,8 @@ class DistModel {
   bool FetchResults(std::vector<DistModelTensor>* output_data,
                     framework::Scope* scope);
   template <typename T>
-  bool FetchResult(const phi::DenseTensor& fetch, DistModelTensor* output_data);
+  bool FetchResult(const std::vector<const phi::DenseTensor*>& fetches,
+                   DistModelTensor* output_data);
 
   std::string carrier_id_;
   std::vector<phi::DenseTensor> feed_tensors_;
@@ -98,6 +113,9 @@ class DistModel {
   FleetExecutorDesc executor_desc_;
   std::shared_ptr<FleetExecutor> fleet_exe;
   std::shared_ptr<TaskNode> task_node_;
+  std::vector<std::shared_ptr<TaskNode>> stage_nodes_;
+  // kids of scope_, one for each micro batch, empty without micro batches
+  std::vector<framework::Scope*> micro_scopes_;
   std::shared_ptr<framework::Scope> scope_;
   paddle::platform::Place place_;
   std::shared_ptr<framework::ProgramDesc> program_;
@@ -15,13 +15,24 @@
 #include "paddle/fluid/distributed/fleet_executor/message_bus.h"
 
 #include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
 #include <set>
+#include <sstream>
 #include <thread>
 
 #include "paddle/fluid/distributed/fleet_executor/carrier.h"
 #include "paddle/fluid/distributed/fleet_executor/global.h"
+#include "paddle/fluid/platform/flags.h"
 #include "paddle/fluid/platform/gen_comm_id_helper.h"
+PADDLE_DEFINE_EXPORTED_bool(
+    fleet_executor_shm_transport,
+    false,
+    "Send the messages between the fleet executor ranks on the same host "
+    "through shared memory instead of brpc. Each pair of ranks reserves a "
+    "ring of 8 MB in /dev/shm, the ranks whose ring cannot be reserved "
+    "send by brpc.");
 
 namespace paddle::distributed {
 
@@ -66,12 +77,14 @@ void MessageBus::Init(
 #endif
 
   ListenPort();
+  InitShmTransport();
 }
 
 bool MessageBus::IsInit() const { return is_init_; }
 
 MessageBus::~MessageBus() {
   VLOG(3) << "Message bus releases resource.";
+  shm_transport_.reset();
 #if defined(PADDLE_WITH_DISTRIBUTE) && !defined(PADDLE_WITH_PSLIB)
   server_.Stop(1000);
   server_.Join();
@@ -93,6 +106,12 @@ bool MessageBus::Send(int64_t dst_rank,
       true,
       platform::errors::PreconditionNotMet(
           "Using message bus since it has not been initialized."));
+  // the barrier stays on brpc, it is what makes sure that the rings of all
+  // the local ranks exist before the first data message
+  if (shm_transport_ && !interceptor_message.ctrl_message() &&
+      shm_transport_->Send(dst_rank, interceptor_message)) {
+    return true;
+  }
 #if defined(PADDLE_WITH_DISTRIBUTE) && !defined(PADDLE_WITH_PSLIB)
   int retry_time = 0;  // message bus will retry sending for 10 times
   while (retry_time < 10) {
@@ -206,6 +225,36 @@ void MessageBus::ListenPort() {
 #endif
 }
 
+void MessageBus::InitShmTransport() {
+#if !defined(_WIN32)
+  if (!FLAGS_fleet_executor_shm_transport || addr_.empty()) return;
+  auto host = [](const std::string& addr) {
+    return addr.substr(0, addr.rfind(':'));
+  };
+  std::map<int64_t, std::string> sorted(rank_to_addr_.begin(),
+                                        rank_to_addr_.end());
+  std::vector<int64_t> local_ranks;
+  std::string endpoints;
+  for (const auto& item : sorted) {
+    endpoints += std::to_string(item.first) + "@" + item.second + ";";
+    if (host(item.second) == host(addr_)) local_ranks.push_back(item.first);
+  }
+  if (local_ranks.size() < 2) return;
+  // the endpoints of the job tell its rings from those of other jobs
+  std::stringstream job_key;
+  job_key << std::hex << std::hash<std::string>()(endpoints);
+  shm_transport_ = std::make_unique<ShmTransport>(
+      rank_,
+      local_ranks,
+      job_key.str(),
+      [this](const InterceptorMessage& message) {
+        return DispatchMsgToCarrier(message);
+      });
+  LOG(INFO) << "Message bus sends to " << local_ranks.size() - 1
+            << " ranks on the same host through shared memory.";
+#endif
+}
+
 #if defined(PADDLE_WITH_DISTRIBUTE) && !defined(PADDLE_WITH_PSLIB)
 bool MessageBus::SendInterRank(int64_t dst_rank,
                                const InterceptorMessage& interceptor_message) {
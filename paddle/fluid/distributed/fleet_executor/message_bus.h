@@ -15,6 +15,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -27,6 +28,7 @@
 #endif
 
 #include "paddle/fluid/distributed/fleet_executor/interceptor_message.pb.h"
+#include "paddle/fluid/distributed/fleet_executor/shm_transport.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/errors.h"
 #include "paddle/fluid/platform/macros.h"
@@ -61,6 +63,10 @@ class MessageBus final {
   // function keep listen the port and handle the message
   void ListenPort();
 
+  // the ranks on the same host as this one send data messages to each other
+  // through shared memory instead of brpc
+  void InitShmTransport();
+
   const std::string& GetAddr(int64_t rank) const;
 
 #if defined(PADDLE_WITH_DISTRIBUTE) && !defined(PADDLE_WITH_PSLIB)
@@ -85,6 +91,8 @@ class MessageBus final {
   brpc::Server server_;
 #endif
 
+  std::unique_ptr<ShmTransport> shm_transport_;
+
   // for barrier
   std::mutex mutex_;
   std::condition_variable cv_;
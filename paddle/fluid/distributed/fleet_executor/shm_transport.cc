@@ -0,0 +1,336 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/fleet_executor/shm_transport.h"
+
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+// the length of a frame that tells the consumer to go on at the ring start
+constexpr uint32_t kWrapMarker = 0xFFFFFFFFu;
+
+size_t FrameSize(size_t length) {
+  return (sizeof(uint32_t) + length + 7) & ~size_t{7};
+}
+
+// spins, then yields, then sleeps, for the waits of both sides
+class Backoff {
+ public:
+  void Wait() {
+    ++count_;
+    if (count_ < 64) return;
+    if (count_ < 128) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+  void Reset() { count_ = 0; }
+
+ private:
+  int count_{0};
+};
+
+}  // namespace
+
+// on its own cache line each, the producer writes head and pushed, the
+// consumer tail and dispatched
+struct ShmRing::Header {
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+  alignas(64) std::atomic<uint64_t> pushed;
+  alignas(64) std::atomic<uint64_t> dispatched;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "The shared memory ring needs lock free 64 bit atomics.");
+
+ShmRing::ShmRing(const std::string& name,
+                 bool owner,
+                 void* base,
+                 size_t capacity)
+    : name_(name), owner_(owner), base_(base), capacity_(capacity) {}
+
+ShmRing::~ShmRing() {
+#if !defined(_WIN32)
+  munmap(base_, sizeof(Header) + capacity_);
+  if (owner_) shm_unlink(name_.c_str());
+#endif
+}
+
+ShmRing::Header* ShmRing::header() const {
+  return static_cast<Header*>(base_);
+}
+
+char* ShmRing::data() const {
+  return static_cast<char*>(base_) + sizeof(Header);
+}
+
+std::unique_ptr<ShmRing> ShmRing::Create(const std::string& name,
+                                         size_t capacity) {
+#if !defined(_WIN32)
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    LOG(WARNING) << "Cannot create the shared memory segment " << name << ".";
+    return nullptr;
+  }
+  const size_t size = sizeof(Header) + capacity;
+  auto fail = [&](const char* what) -> std::unique_ptr<ShmRing> {
+    LOG(WARNING) << "Cannot " << what << " the shared memory segment " << name
+                 << " of " << size << " bytes.";
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  };
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) return fail("resize");
+#if defined(__linux__)
+  // a sparse segment larger than what is left of /dev/shm fails with SIGBUS
+  // on the first write to a missing page, reserve the pages up front
+  if (posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0) {
+    return fail("reserve");
+  }
+#endif
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) return fail("map");
+  close(fd);
+  // a new segment is zero filled, the atomics are constructed in place
+  new (base) Header{{0}, {0}, {0}, {0}};
+  return std::unique_ptr<ShmRing>(new ShmRing(name, true, base, capacity));
+#else
+  return nullptr;
+#endif
+}
+
+std::unique_ptr<ShmRing> ShmRing::Open(const std::string& name,
+                                       size_t capacity) {
+#if !defined(_WIN32)
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) return nullptr;
+  const size_t size = sizeof(Header) + capacity;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != size) {
+    close(fd);
+    return nullptr;
+  }
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) return nullptr;
+  return std::unique_ptr<ShmRing>(new ShmRing(name, false, base, capacity));
+#else
+  return nullptr;
+#endif
+}
+
+bool ShmRing::Push(const InterceptorMessage& message,
+                   std::chrono::milliseconds timeout) {
+  const size_t length = message.ByteSizeLong();
+  const size_t frame = FrameSize(length);
+  if (frame > capacity_ / 2) return false;
+
+  auto* h = header();
+  uint64_t head = h->head.load(std::memory_order_relaxed);
+  size_t offset = head % capacity_;
+  // a frame never wraps, the end of the ring is skipped instead
+  const size_t skip = capacity_ - offset < frame ? capacity_ - offset : 0;
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  Backoff backoff;
+  while (capacity_ - (head - h->tail.load(std::memory_order_acquire)) <
+         skip + frame) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    backoff.Wait();
+  }
+  if (skip > 0) {
+    std::memcpy(data() + offset, &kWrapMarker, sizeof(uint32_t));
+    head += skip;
+    offset = 0;
+  }
+  const auto length32 = static_cast<uint32_t>(length);
+  std::memcpy(data() + offset, &length32, sizeof(uint32_t));
+  message.SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8_t*>(data() + offset + sizeof(uint32_t)));
+  h->pushed.store(h->pushed.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  h->head.store(head + frame, std::memory_order_release);
+  return true;
+}
+
+bool ShmRing::Pop(InterceptorMessage* message) {
+  auto* h = header();
+  uint64_t tail = h->tail.load(std::memory_order_relaxed);
+  if (tail == h->head.load(std::memory_order_acquire)) return false;
+  size_t offset = tail % capacity_;
+  uint32_t length = 0;
+  std::memcpy(&length, data() + offset, sizeof(uint32_t));
+  if (length == kWrapMarker) {
+    tail += capacity_ - offset;
+    offset = 0;
+    std::memcpy(&length, data(), sizeof(uint32_t));
+  }
+  PADDLE_ENFORCE_EQ(
+      message->ParseFromArray(data() + offset + sizeof(uint32_t),
+                              static_cast<int>(length)),
+      true,
+      platform::errors::InvalidArgument(
+          "Broken interceptor message in the shared memory ring %s.", name_));
+  h->tail.store(tail + FrameSize(length), std::memory_order_release);
+  return true;
+}
+
+void ShmRing::MarkDispatched() {
+  auto* h = header();
+  h->dispatched.store(h->dispatched.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+}
+
+bool ShmRing::WaitDispatched(std::chrono::milliseconds timeout) const {
+  auto* h = header();
+  const uint64_t pushed = h->pushed.load(std::memory_order_relaxed);
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  Backoff backoff;
+  while (h->dispatched.load(std::memory_order_acquire) != pushed) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    backoff.Wait();
+  }
+  return true;
+}
+
+ShmTransport::ShmTransport(int64_t rank,
+                           const std::vector<int64_t>& local_ranks,
+                           const std::string& job_key,
+                           Handler handler)
+    : rank_(rank), job_key_(job_key), handler_(std::move(handler)) {
+  for (auto src_rank : local_ranks) {
+    if (src_rank == rank_) continue;
+    // without the ring src_rank cannot open it and sends by brpc
+    auto ring = ShmRing::Create(RingName(src_rank, rank_));
+    if (ring) in_rings_.emplace(src_rank, std::move(ring));
+    out_rings_.emplace(src_rank, nullptr);
+  }
+  VLOG(3) << "Shared memory transport of rank " << rank_ << " with "
+          << in_rings_.size() << " local ranks.";
+  poll_thread_ = std::thread([this] { Poll(); });
+}
+
+ShmTransport::~ShmTransport() {
+  stop_.store(true);
+  poll_thread_.join();
+}
+
+bool ShmTransport::IsLocal(int64_t rank) const {
+  return in_rings_.count(rank) > 0;
+}
+
+bool ShmTransport::Send(int64_t dst_rank, const InterceptorMessage& message) {
+  std::lock_guard<std::mutex> guard(send_mutex_);
+  auto it = out_rings_.find(dst_rank);
+  if (it == out_rings_.end()) return false;
+  if (!it->second) {
+    // created by dst_rank before the barrier that precedes any message
+    it->second = ShmRing::Open(RingName(rank_, dst_rank));
+    if (!it->second) {
+      LOG(WARNING) << "Cannot open the shared memory ring to rank "
+                   << dst_rank << ", send by brpc.";
+      out_rings_.erase(it);
+      return false;
+    }
+  }
+  if (it->second->Push(message)) return true;
+  // the ring is drained only once its messages are with the carrier, before
+  // that the message could overtake them
+  if (!it->second->WaitDispatched()) {
+    LOG(WARNING) << "Rank " << dst_rank << " does not read its shared "
+                 << "memory ring, send by brpc from now on.";
+    out_rings_.erase(it);
+  }
+  return false;
+}
+
+std::string ShmTransport::RingName(int64_t src_rank, int64_t dst_rank) const {
+  return "/paddle_fleet_" + job_key_ + "_" + std::to_string(src_rank) + "_" +
+         std::to_string(dst_rank);
+}
+
+void ShmTransport::Poll() {
+  // a message the handler did not take, it is retried before the later
+  // messages of its ring so that they keep their order
+  struct Pending {
+    InterceptorMessage message;
+    std::chrono::steady_clock::time_point retry_time;
+    int failures{0};
+  };
+  std::unordered_map<int64_t, std::unique_ptr<Pending>> pending;
+  auto defer = [](int64_t src_rank, Pending* retry) {
+    ++retry->failures;
+    retry->retry_time =
+        std::chrono::steady_clock::now() + kDispatchRetryInterval;
+    LOG(WARNING) << "Cannot dispatch the message from rank " << src_rank
+                 << " received through shared memory, retry it in "
+                 << kDispatchRetryInterval.count() << " ms ("
+                 << retry->failures << " failures).";
+  };
+  InterceptorMessage message;
+  Backoff backoff;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    bool received = false;
+    for (auto& item : in_rings_) {
+      auto& retry = pending[item.first];
+      if (retry) {
+        if (std::chrono::steady_clock::now() < retry->retry_time) continue;
+        if (!handler_(retry->message)) {
+          defer(item.first, retry.get());
+          continue;
+        }
+        item.second->MarkDispatched();
+        retry.reset();
+        received = true;
+      }
+      while (item.second->Pop(&message)) {
+        received = true;
+        if (!handler_(message)) {
+          retry = std::make_unique<Pending>();
+          retry->message.Swap(&message);
+          defer(item.first, retry.get());
+          break;
+        }
+        item.second->MarkDispatched();
+        message.Clear();
+      }
+    }
+    if (received) {
+      backoff.Reset();
+    } else {
+      backoff.Wait();
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
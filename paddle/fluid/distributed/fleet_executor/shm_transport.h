@@ -0,0 +1,139 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/distributed/fleet_executor/interceptor_message.pb.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace distributed {
+
+// A single producer single consumer ring of messages in a shared memory
+// segment, one per (src rank, dst rank) pair of the same host. A message is
+// serialized straight into the ring and parsed from it by the consumer, so
+// the only copy of a tensor payload is the one into the segment.
+//
+// The consumer creates the segment, the producer opens it. Both map it with
+// the head (bytes produced), the tail (bytes consumed) and the counts of the
+// messages pushed and dispatched at its start.
+class ShmRing {
+ public:
+  // the ring part of a segment, a multiple of 8
+  static constexpr size_t kDefaultCapacity = size_t{8} << 20;
+  // as long as the retries of the brpc path of the message bus
+  static constexpr std::chrono::milliseconds kDefaultTimeout{10000};
+
+  ~ShmRing();
+
+  // Removes a segment of the same name left by a previous job first. The
+  // pages of the segment are reserved, nullptr if that fails, e.g. when
+  // /dev/shm is too small.
+  static std::unique_ptr<ShmRing> Create(const std::string& name,
+                                         size_t capacity = kDefaultCapacity);
+  // nullptr if the consumer has not created it
+  static std::unique_ptr<ShmRing> Open(const std::string& name,
+                                       size_t capacity = kDefaultCapacity);
+
+  // Blocks while the ring is full. Returns false without writing if the
+  // message does not fit in half of the ring or the ring stays full for
+  // timeout.
+  bool Push(const InterceptorMessage& message,
+            std::chrono::milliseconds timeout = kDefaultTimeout);
+  // Returns false if the ring is empty. The consumer calls MarkDispatched
+  // once it has handed the message on.
+  bool Pop(InterceptorMessage* message);
+  void MarkDispatched();
+
+  // Blocks until the consumer has dispatched every pushed message, false if
+  // it has not within timeout.
+  bool WaitDispatched(
+      std::chrono::milliseconds timeout = kDefaultTimeout) const;
+
+ private:
+  struct Header;
+
+  ShmRing(const std::string& name, bool owner, void* base, size_t capacity);
+
+  Header* header() const;
+  char* data() const;
+
+  std::string name_;
+  bool owner_;
+  void* base_;
+  size_t capacity_;
+
+  DISABLE_COPY_AND_ASSIGN(ShmRing);
+};
+
+// The shared memory transport of the message bus between the ranks on the
+// same host. The rings of the messages to this rank are created at
+// construction, before the barrier of the message bus, and a thread polls
+// them; the rings to the other local ranks are opened on the first send.
+// A message the handler does not take is retried, the later messages of its
+// ring wait for it.
+class ShmTransport {
+ public:
+  // false if the message could not be handed on
+  using Handler = std::function<bool(const InterceptorMessage&)>;
+  // as the retries of the brpc path of the message bus
+  static constexpr std::chrono::milliseconds kDispatchRetryInterval{1000};
+
+  // job_key tells the rings of this job from those of other jobs on the
+  // host.
+  ShmTransport(int64_t rank,
+               const std::vector<int64_t>& local_ranks,
+               const std::string& job_key,
+               Handler handler);
+  ~ShmTransport();
+
+  // whether rank sends to this rank through shared memory
+  bool IsLocal(int64_t rank) const;
+
+  // Returns false if the message has to go another way, then the messages
+  // in the ring to dst_rank have been dispatched, so that the messages keep
+  // their order. A ring dst_rank does not read from within the timeout is
+  // not used anymore, the later messages go another way as well.
+  bool Send(int64_t dst_rank, const InterceptorMessage& message);
+
+ private:
+  std::string RingName(int64_t src_rank, int64_t dst_rank) const;
+  void Poll();
+
+  int64_t rank_;
+  std::string job_key_;
+  Handler handler_;
+  std::unordered_map<int64_t, std::unique_ptr<ShmRing>> in_rings_;
+  // the interceptors of this rank are the one producer of a ring
+  std::mutex send_mutex_;
+  std::unordered_map<int64_t, std::unique_ptr<ShmRing>> out_rings_;
+  std::atomic<bool> stop_{false};
+  std::thread poll_thread_;
+
+  DISABLE_COPY_AND_ASSIGN(ShmTransport);
+};
+
+}  // namespace distributed
+}  // namespace paddle
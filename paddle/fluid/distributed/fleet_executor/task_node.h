@@ -90,6 +90,7 @@ class TaskNode final {
   const std::vector<std::string> while_block_vars() const {
     return while_block_vars_;
   }
+  const std::vector<int>& cpu_cores() const { return cpu_cores_; }
 
   void SetCondVarName(const std::string& cond_var_name) {
     cond_var_ = cond_var_name;
@@ -107,6 +108,9 @@ class TaskNode final {
   void SetWhileBlockVars(const std::vector<std::string>& vars) {
     while_block_vars_ = vars;
   }
+  // The interceptor of a node with cpu cores runs on a task loop thread of
+  // its own, bound to these cores, instead of the shared one.
+  void SetCpuCores(const std::vector<int>& cores) { cpu_cores_ = cores; }
 
   // upstream need buffs?
   bool AddUpstreamTask(int64_t task_id,
@@ -143,6 +147,7 @@ class TaskNode final {
   std::unordered_map<const OperatorBase*, std::vector<std::string>>
       unused_vars_;
   std::vector<std::string> while_block_vars_;
+  std::vector<int> cpu_cores_;
 
   int32_t role_;
   int64_t rank_;
@@ -0,0 +1,152 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/fleet_executor/shm_transport.h"
+
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(ShmTransport, SendInOrder) {
+  const std::string job_key =
+      "test" + std::to_string(std::random_device()() % 1000000);
+  std::mutex mutex;
+  std::vector<InterceptorMessage> received;
+  ShmTransport receiver(
+      1, {0, 1}, job_key, [&](const InterceptorMessage& message) {
+        std::lock_guard<std::mutex> guard(mutex);
+        received.push_back(message);
+        return true;
+      });
+  ShmTransport sender(
+      0, {0, 1}, job_key, [](const InterceptorMessage&) { return true; });
+  EXPECT_TRUE(sender.IsLocal(1));
+  EXPECT_FALSE(sender.IsLocal(2));
+
+  // enough payload to wrap around the ring a few times
+  const int num = 200;
+  const std::string payload(1 << 20, 'x');
+  for (int i = 0; i < num; ++i) {
+    InterceptorMessage message;
+    message.set_src_id(0);
+    message.set_dst_id(1);
+    message.set_message_type(DATA_WITH_VARS);
+    message.set_scope_idx(i);
+    auto* var = message.add_vars_list();
+    var->set_name("x");
+    var->set_stensor(payload.substr(0, (i * 7919) % payload.size()));
+    ASSERT_TRUE(sender.Send(1, message));
+  }
+  InterceptorMessage huge;
+  huge.add_vars_list()->set_stensor(
+      std::string(ShmRing::kDefaultCapacity / 2, 'y'));
+  EXPECT_FALSE(sender.Send(1, huge));
+
+  // a message that goes another way waits until the ring is dispatched
+  std::lock_guard<std::mutex> guard(mutex);
+  ASSERT_EQ(received.size(), static_cast<size_t>(num));
+  for (int i = 0; i < num; ++i) {
+    EXPECT_EQ(received[i].scope_idx(), i);
+    EXPECT_EQ(received[i].vars_list(0).stensor().size(),
+              (i * 7919) % payload.size());
+  }
+}
+
+// A message the handler does not take is retried, and the later messages
+// wait for it.
+TEST(ShmTransport, RetryDispatch) {
+  const std::string job_key =
+      "test" + std::to_string(std::random_device()() % 1000000);
+  std::mutex mutex;
+  std::vector<int64_t> received;
+  int failures = 0;
+  ShmTransport receiver(
+      1, {0, 1}, job_key, [&](const InterceptorMessage& message) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (message.scope_idx() == 1 && failures < 2) {
+          ++failures;
+          return false;
+        }
+        received.push_back(message.scope_idx());
+        return true;
+      });
+  ShmTransport sender(
+      0, {0, 1}, job_key, [](const InterceptorMessage&) { return true; });
+  const int num = 4;
+  for (int i = 0; i < num; ++i) {
+    InterceptorMessage message;
+    message.set_scope_idx(i);
+    ASSERT_TRUE(sender.Send(1, message));
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() +
+                        4 * ShmTransport::kDispatchRetryInterval;
+  while (std::chrono::steady_clock::now() < deadline) {
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      if (received.size() == static_cast<size_t>(num)) break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  std::lock_guard<std::mutex> guard(mutex);
+  EXPECT_EQ(failures, 2);
+  EXPECT_EQ(received, (std::vector<int64_t>{0, 1, 2, 3}));
+}
+
+// A segment that /dev/shm cannot hold is not created, the ranks send by
+// brpc instead of failing on the first write to it.
+TEST(ShmRing, CreateTooLarge) {
+  const std::string name =
+      "/paddle_fleet_test_" + std::to_string(std::random_device()() % 1000000);
+  EXPECT_EQ(ShmRing::Create(name, size_t{1} << 50), nullptr);
+  EXPECT_EQ(ShmRing::Open(name, size_t{1} << 50), nullptr);
+}
+
+// A consumer that does not read makes the producer give up instead of
+// waiting forever.
+TEST(ShmRing, PushTimeout) {
+  const std::string name =
+      "/paddle_fleet_test_" + std::to_string(std::random_device()() % 1000000);
+  const size_t capacity = 1024;
+  auto consumer = ShmRing::Create(name, capacity);
+  auto producer = ShmRing::Open(name, capacity);
+  ASSERT_NE(producer, nullptr);
+  InterceptorMessage message;
+  message.add_vars_list()->set_stensor(std::string(200, 'x'));
+  const std::chrono::milliseconds timeout(10);
+  int pushed = 0;
+  while (producer->Push(message, timeout)) ++pushed;
+  EXPECT_GT(pushed, 0);
+  EXPECT_FALSE(producer->WaitDispatched(timeout));
+
+  InterceptorMessage popped;
+  for (int i = 0; i < pushed; ++i) {
+    ASSERT_TRUE(consumer->Pop(&popped));
+    consumer->MarkDispatched();
+  }
+  EXPECT_FALSE(consumer->Pop(&popped));
+  EXPECT_TRUE(producer->WaitDispatched(timeout));
+  EXPECT_TRUE(producer->Push(message, timeout));
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -14,10 +14,12 @@
 
 #include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <string>
 
+#include "brpc/policy/snappy_compress.h"
 #include "paddle/fluid/distributed/ps/service/coordinator_client.h"
 #include "paddle/fluid/framework/archive.h"
 #include "paddle/utils/string/split.h"
@@ -82,6 +84,30 @@ PD_DEFINE_int32(pserver_sparse_table_shard_num,
                 1000,
                 "sparse table shard for save & load");
 
+PD_DEFINE_int32(pserver_sparse_cache_capacity,
+                0,
+                "max keys of the worker side cache of each sparse table, "
+                "0 disables the cache");
+
+PD_DEFINE_int32(pserver_sparse_cache_max_steps,
+                1,
+                "a cached sparse value older than this number of pulls of "
+                "the table is pulled again");
+
+PD_DEFINE_int32(pserver_sparse_cache_max_ms,
+                0,
+                "a cached sparse value older than this is pulled again, "
+                "0 means no time bound");
+
+PD_DEFINE_int32(pserver_sparse_cache_push_limit,
+                0,
+                "drop a cached sparse value after this worker pushed the key "
+                "this many times, 0 means pushes do not invalidate");
+
+PD_DEFINE_string(pserver_sparse_cache_eviction,
+                 "lru",
+                 "eviction policy of the sparse cache: lru or lfu");
+
 inline size_t get_sparse_shard(uint32_t shard_num,
                                uint32_t server_num,
                                uint64_t key) {
@@ -91,6 +117,104 @@ inline size_t get_sparse_shard(uint32_t shard_num,
   return (key % shard_num) / local_shard_num;
 }
 
+// Fills a PS_PUSH_SPARSE_TABLE request in the wire format of the table, the
+// values are update_size bytes each.
+template <typename ValueAt>
+void FillSparsePushData(const SparseWireFormat &wire,
+                        const uint64_t *keys,
+                        size_t num,
+                        size_t update_size,
+                        ValueAt value_at,
+                        PsRequestMessage *request,
+                        brpc::Controller *cntl) {
+  auto *push_data = request->mutable_data();
+  char *push_data_ptr = nullptr;
+  if (wire.delta_keys) {
+    push_data->clear();
+    EncodeSparseKeys(keys, num, push_data);
+    size_t key_bytes = push_data->size();
+    push_data->resize(key_bytes + num * update_size);
+    push_data_ptr = const_cast<char *>(push_data->data()) + key_bytes;
+  } else {
+    push_data->resize(num * (sizeof(uint64_t) + update_size));
+    push_data_ptr = const_cast<char *>(push_data->data());
+    memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
+    push_data_ptr += num * sizeof(uint64_t);
+  }
+  for (size_t i = 0; i < num; ++i) {
+    memcpy(push_data_ptr, value_at(i), update_size);
+    push_data_ptr += update_size;
+  }
+  if (!wire.IsRaw()) {
+    request->add_params(wire.Serialize());
+  }
+  if (wire.compress_threshold > 0 &&
+      push_data->size() >= wire.compress_threshold) {
+    cntl->set_request_compress_type(brpc::COMPRESS_TYPE_SNAPPY);
+  } else {
+    cntl->set_request_compress_type(
+        (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
+  }
+}
+
+// Parses a pull sparse response in a non raw wire format into the sorted
+// request kvs, see SparseWireFormat.
+int32_t ParseSparsePullResponse(
+    const SparseWireFormat &wire,
+    const butil::IOBuf &attachment,
+    size_t value_size,
+    const std::vector<std::pair<uint64_t, float *>> &request_kvs,
+    SparseValueCache *cache,
+    uint64_t cache_step) {
+  if (request_kvs.empty()) {
+    return 0;
+  }
+  char compressed = 0;
+  if (attachment.copy_to(&compressed, 1) != 1) {
+    LOG(WARNING) << "res data is lack or not in format";
+    return -1;
+  }
+  butil::IOBuf payload;
+  attachment.append_to(&payload, attachment.size() - 1, 1);
+  if (compressed) {
+    butil::IOBuf decompressed;
+    if (!brpc::policy::SnappyDecompress(payload, &decompressed)) {
+      LOG(WARNING) << "fail to decompress pull sparse response";
+      return -1;
+    }
+    payload.swap(decompressed);
+  }
+  const std::string data = payload.to_string();
+  const size_t dim = value_size / sizeof(float);
+  const size_t row_bytes =
+      EncodedValueBytes(wire.value_codec, dim, wire.stat_dim);
+  size_t offset = 0;
+  uint64_t last_key = UINT64_MAX;
+  float *last_value_data = NULL;
+  for (auto &kv_pair : request_kvs) {
+    if (kv_pair.first == last_key) {
+      memcpy(kv_pair.second, last_value_data, value_size);
+      continue;
+    }
+    if (offset + row_bytes > data.size()) {
+      LOG(WARNING) << "res data is lack or not in format";
+      return -1;
+    }
+    last_key = kv_pair.first;
+    last_value_data = kv_pair.second;
+    DecodeSparseValueRow(wire.value_codec,
+                         data.data() + offset,
+                         dim,
+                         last_value_data,
+                         wire.stat_dim);
+    offset += row_bytes;
+    if (cache != nullptr) {
+      cache->Insert(cache_step, last_key, last_value_data);
+    }
+  }
+  return 0;
+}
+
 void DownpourPsClientService::service(
     ::google::protobuf::RpcController *controller,
     const PsRequestMessage *request,
@@ -332,6 +456,33 @@ int32_t BrpcPsClient::Initialize() {
   // 启动client探听接口, 并相互建立连接
   StartClientService();
 
+  // 稀疏表的通信格式
+  const auto &server_param = _config.server_param().downpour_server_param();
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (!table_param.has_sparse_wire_param()) {
+      continue;
+    }
+    const auto &wire_param = table_param.sparse_wire_param();
+    SparseWireFormat wire;
+    wire.delta_keys = wire_param.delta_keys();
+    if (!SparseWireFormat::ParseValueCodec(wire_param.pull_value_codec(),
+                                           &wire.value_codec)) {
+      LOG(ERROR) << "unknown pull_value_codec "
+                 << wire_param.pull_value_codec() << " of table "
+                 << table_param.table_id();
+      return -1;
+    }
+    wire.compress_threshold = wire_param.compress_threshold();
+    auto *accessor = GetTableAccessor(table_param.table_id());
+    if (accessor != NULL) {
+      wire.stat_dim = accessor->GetPullStatDim();
+    }
+    if (!wire.IsRaw()) {
+      _sparse_wire_formats[table_param.table_id()] = wire;
+    }
+  }
+
   // 异步push 请求队列初始化
   const auto &worker_param = _config.worker_param().downpour_worker_param();
   for (int i = 0; i < worker_param.downpour_table_param_size(); ++i) {
@@ -345,6 +496,20 @@ int32_t BrpcPsClient::Initialize() {
       _push_sparse_task_queue_map[table_id] =
           ::paddle::framework::MakeChannel<SparseAsyncTask *>();
       _push_sparse_merge_count_map[table_id] = 0;
+      if (FLAGS_pserver_sparse_cache_capacity > 0) {
+        SparseValueCacheConfig cache_config;
+        cache_config.capacity = FLAGS_pserver_sparse_cache_capacity;
+        cache_config.value_size =
+            GetTableAccessor(table_id)->GetAccessorInfo().select_size;
+        cache_config.max_staleness_steps =
+            std::max(FLAGS_pserver_sparse_cache_max_steps, 0);
+        cache_config.max_staleness_ms = FLAGS_pserver_sparse_cache_max_ms;
+        cache_config.push_limit =
+            std::max(FLAGS_pserver_sparse_cache_push_limit, 0);
+        cache_config.eviction = SparseValueCacheConfig::ParseEviction(
+            FLAGS_pserver_sparse_cache_eviction);
+        _sparse_caches[table_id].reset(new SparseValueCache(cache_config));
+      }
     }
   }
 
@@ -722,6 +887,14 @@ void BrpcPsClient::PrintQueueSizeThread() {
 
 void BrpcPsClient::FinalizeWorker() {
   Flush();
+  for (auto &cache : _sparse_caches) {
+    auto stats = cache.second->Stats();
+    VLOG(0) << "BrpcPsClient sparse cache of table " << cache.first
+            << ": hit_rate=" << stats.HitRate() << ", hits=" << stats.hits
+            << ", misses=" << stats.misses << ", stale=" << stats.stale
+            << ", evictions=" << stats.evictions
+            << ", push_invalidations=" << stats.push_invalidations;
+  }
   VLOG(0) << "BrpcPsClient::FinalizeWorker begin join thread";
   _running = false;
   _async_push_dense_thread.join();
@@ -1011,6 +1184,9 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     size_t num,
     void *done) {
   auto *accessor = GetTableAccessor(table_id);
+  if (auto *cache = GetSparseCache(table_id)) {
+    cache->OnPush(keys, num);
+  }
   // 发送RPC请求
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -1052,19 +1228,15 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     push_request->set_table_id(table_id);
     push_request->set_client_id(_client_id);
     push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
-    auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (size_t i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], value_size);
-      push_data_ptr += value_size;
-    }
+    FillSparsePushData(
+        GetSparseWireFormat(table_id),
+        kvs.data(),
+        kv_size,
+        value_size,
+        [&value_ptr](size_t i) { return value_ptr[i]; },
+        push_request,
+        closure->cntl(shard_idx));
     PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
-    closure->cntl(shard_idx)->set_request_compress_type(
-        (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     rpc_stub.service(closure->cntl(shard_idx),
                      closure->request(shard_idx),
                      closure->response(shard_idx),
@@ -1146,6 +1318,31 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       std::make_shared<CostTimer>("pserver_client_pull_sparse_local");
   size_t request_call_num = _server_channels.size();
 
+  // serve the fresh cached keys locally, only the others are pulled
+  SparseValueCache *cache = GetSparseCache(table_id);
+  uint64_t cache_step = 0;
+  std::vector<uint64_t> miss_keys;
+  std::vector<float *> miss_values;
+  if (cache != nullptr) {
+    cache_step = cache->NextStep();
+    std::vector<size_t> miss_index;
+    cache->Lookup(cache_step, keys, select_values, num, &miss_index);
+    if (miss_index.empty()) {
+      std::promise<int32_t> promise;
+      promise.set_value(0);
+      return promise.get_future();
+    }
+    miss_keys.reserve(miss_index.size());
+    miss_values.reserve(miss_index.size());
+    for (auto idx : miss_index) {
+      miss_keys.push_back(keys[idx]);
+      miss_values.push_back(select_values[idx]);
+    }
+    keys = miss_keys.data();
+    select_values = miss_values.data();
+    num = miss_keys.size();
+  }
+
   auto shard_sorted_kvs = std::make_shared<
       std::vector<std::vector<std::pair<uint64_t, float *>>>>();
   shard_sorted_kvs->resize(request_call_num);
@@ -1168,9 +1365,11 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
   auto *accessor = GetTableAccessor(table_id);
 
   size_t value_size = accessor->GetAccessorInfo().select_size;
+  const SparseWireFormat wire = GetSparseWireFormat(table_id);
 
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
-      request_call_num, [shard_sorted_kvs, value_size](void *done) {
+      request_call_num,
+      [shard_sorted_kvs, value_size, cache, cache_step, wire](void *done) {
         int ret = 0;
         auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
         for (size_t i = 0; i < shard_sorted_kvs->size(); ++i) {
@@ -1181,6 +1380,18 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
 
           auto &request_kvs = shard_sorted_kvs->at(i);
           auto &res_io_buffer = closure->cntl(i)->response_attachment();
+          if (!wire.IsRaw()) {
+            if (ParseSparsePullResponse(wire,
+                                        res_io_buffer,
+                                        value_size,
+                                        request_kvs,
+                                        cache,
+                                        cache_step) != 0) {
+              ret = -1;
+              break;
+            }
+            continue;
+          }
           butil::IOBufBytesIterator io_buffer_itr(res_io_buffer);
           uint64_t last_key = UINT64_MAX;
           float *last_value_data = NULL;
@@ -1200,6 +1411,9 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
                 ret = -1;
                 break;
               }
+              if (cache != nullptr) {
+                cache->Insert(cache_step, last_key, last_value_data);
+              }
             }
           }
         }
@@ -1225,15 +1439,16 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
     auto &request_buffer = closure->cntl(i)->request_attachment();
 
     request_buffer.append(reinterpret_cast<void *>(&is_training), sizeof(bool));
+    std::vector<uint64_t> request_keys;
     std::vector<uint32_t> keys_counter;
+    request_keys.reserve(sorted_kv_size);
     keys_counter.reserve(sorted_kv_size);
 
     for (size_t kv_idx = 0; kv_idx < sorted_kv_size; ++kv_idx) {
       ++kv_request_count;
       uint32_t keys = 1;
       last_key = sorted_kvs[kv_idx].first;
-      request_buffer.append(reinterpret_cast<void *>(&last_key),
-                            sizeof(uint64_t));
+      request_keys.push_back(last_key);
       while (kv_idx < sorted_kv_size - 1 &&
              last_key == sorted_kvs[kv_idx + 1].first) {
         ++kv_idx;
@@ -1242,8 +1457,17 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       keys_counter.push_back(keys);
     }
 
-    request_buffer.append(reinterpret_cast<void *>(keys_counter.data()),
-                          sizeof(uint32_t) * keys_counter.size());
+    if (wire.delta_keys) {
+      std::string encoded;
+      EncodeSparseKeys(request_keys.data(), request_keys.size(), &encoded);
+      EncodeVarints(keys_counter.data(), keys_counter.size(), &encoded);
+      request_buffer.append(encoded);
+    } else {
+      request_buffer.append(reinterpret_cast<void *>(request_keys.data()),
+                            sizeof(uint64_t) * request_keys.size());
+      request_buffer.append(reinterpret_cast<void *>(keys_counter.data()),
+                            sizeof(uint32_t) * keys_counter.size());
+    }
 
     if (kv_request_count == 0) {
       closure->Run();
@@ -1253,6 +1477,9 @@ std::future<int32_t> BrpcPsClient::PullSparse(float **select_values,
       closure->request(i)->set_client_id(_client_id);
       closure->request(i)->add_params((char *)&kv_request_count,  // NOLINT
                                       sizeof(uint32_t));
+      if (!wire.IsRaw()) {
+        closure->request(i)->add_params(wire.Serialize());
+      }
       PsService_Stub rpc_stub(GetCmdChannel(i));
       closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
       rpc_stub.service(
@@ -1411,6 +1638,9 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradientPartial(
     void *done,
     int pserver_idx) {
   auto *accessor = GetTableAccessor(table_id);
+  if (auto *cache = GetSparseCache(table_id)) {
+    cache->OnPush(keys, num);
+  }
   size_t value_size = accessor->GetAccessorInfo().update_size;
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -1531,6 +1761,9 @@ std::future<int32_t> BrpcPsClient::PushSparse(size_t table_id,
                                               const float **update_values,
                                               size_t num) {
   auto push_timer = std::make_shared<CostTimer>("pserver_client_push_sparse");
+  if (auto *cache = GetSparseCache(table_id)) {
+    cache->OnPush(keys, num);
+  }
   CostTimer parse_timer("pserver_client_push_sparse_parse");
   int push_sparse_async_num = _push_sparse_task_queue_map[table_id]->Size();
   while (push_sparse_async_num > FLAGS_pserver_max_async_call_num) {
@@ -1857,25 +2090,16 @@ int BrpcPsClient::PushSparseAsyncShardPush(
   push_request->set_client_id(_client_id);
   push_request->add_params(reinterpret_cast<char *>(&merged_kv_count),
                            sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
   int update_size = accessor->GetAccessorInfo().update_size;
-  push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr,
-         merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
-  for (size_t i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
-    memcpy(push_data_ptr,
-           (float *)(task_data_ptr),  // NOLINT
-           update_size);
-    push_data_ptr += update_size;
-  }
+  FillSparsePushData(
+      GetSparseWireFormat(table_id),
+      merged_key_list.data(),
+      merged_kv_count,
+      update_size,
+      [&merged_value_list](size_t i) { return merged_value_list[i].data(); },
+      push_request,
+      closure->cntl(shard_idx));
   PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
-  closure->cntl(shard_idx)->set_request_compress_type(
-      (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
   rpc_stub.service(closure->cntl(shard_idx),
                    closure->request(shard_idx),
                    closure->response(shard_idx),
@@ -27,6 +27,8 @@
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/service/sparse_value_cache.h"
+#include "paddle/fluid/distributed/ps/service/sparse_wire_format.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -310,6 +312,21 @@ class BrpcPsClient : public PSClient {
   void PrintQueueSize();
   void PrintQueueSizeThread();
 
+  // worker side cache of PullSparse, nullptr when
+  // FLAGS_pserver_sparse_cache_capacity is 0
+  SparseValueCache *GetSparseCache(size_t table_id) {
+    auto itr = _sparse_caches.find(table_id);
+    return itr == _sparse_caches.end() ? nullptr : itr->second.get();
+  }
+
+  // wire format of the sparse pull/push rpc, raw unless the table sets
+  // sparse_wire_param
+  SparseWireFormat GetSparseWireFormat(size_t table_id) const {
+    auto itr = _sparse_wire_formats.find(table_id);
+    return itr == _sparse_wire_formats.end() ? SparseWireFormat()
+                                             : itr->second;
+  }
+
  protected:
   virtual size_t GetServerNums() { return _server_channels.size(); }
   inline brpc::Channel *GetSparseChannel(size_t server_id) {
@@ -360,6 +377,10 @@ class BrpcPsClient : public PSClient {
   std::unordered_map<uint32_t, paddle::framework::Channel<SparseAsyncTask *>>
       _push_sparse_task_queue_map;
   std::unordered_map<uint32_t, uint32_t> _push_sparse_merge_count_map;
+  // 稀疏参数的 worker 端缓存
+  std::unordered_map<uint32_t, std::unique_ptr<SparseValueCache>>
+      _sparse_caches;
+  std::unordered_map<uint32_t, SparseWireFormat> _sparse_wire_formats;
 
   std::thread _print_thread;
 
@@ -16,8 +16,10 @@
 
 #include <thread>  // NOLINT
 
+#include "brpc/policy/snappy_compress.h"
 #include "butil/object_pool.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
+#include "paddle/fluid/distributed/ps/service/sparse_wire_format.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/framework/archive.h"
@@ -526,6 +528,12 @@ int32_t BrpcPsService::PullSparse(Table *table,
   const uint32_t num =
       *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
   auto dim = table->GetValueAccessor()->GetAccessorInfo().select_dim;
+  SparseWireFormat wire;
+  if (request.params_size() > 1 &&
+      !SparseWireFormat::Parse(request.params(1), &wire)) {
+    set_response_code(response, -1, "unknown sparse wire format");
+    return 0;
+  }
 
   thread_local std::string req_buffer;
   req_buffer.reserve(req_buffer_size);
@@ -535,7 +543,31 @@ int32_t BrpcPsService::PullSparse(Table *table,
 
   auto value = PullSparseValue(num, dim);
 
-  value.DeserializeFromBytes(const_cast<void *>(data));
+  thread_local std::vector<uint64_t> pull_keys;
+  thread_local std::vector<uint32_t> pull_frequencies;
+  if (wire.delta_keys) {
+    /*
+    |---isTraining---|---varint keys---|---varint frequencies---|
+    */
+    const char *begin = reinterpret_cast<const char *>(data);
+    pull_keys.resize(num);
+    pull_frequencies.resize(num);
+    size_t pos = sizeof(bool);
+    size_t len = DecodeSparseKeys(
+        begin + pos, req_buffer_size - pos, num, pull_keys.data());
+    pos += len;
+    if (len == 0 || DecodeVarints(begin + pos,
+                                  req_buffer_size - pos,
+                                  num,
+                                  pull_frequencies.data()) == 0) {
+      set_response_code(response, -1, "pull sparse keys are not in format");
+      return 0;
+    }
+    value = PullSparseValue(pull_keys, pull_frequencies, dim);
+    value.is_training_ = reinterpret_cast<const bool *>(begin)[0];
+  } else {
+    value.DeserializeFromBytes(const_cast<void *>(data));
+  }
 
   auto res_data = butil::get_object<std::vector<float>>();
   res_data->resize(num * dim);
@@ -546,8 +578,36 @@ int32_t BrpcPsService::PullSparse(Table *table,
   table->Pull(table_context);
   // table->PullSparse(res_data->data(), value);
 
-  cntl->response_attachment().append(reinterpret_cast<char *>(res_data->data()),
-                                     res_data->size() * sizeof(float));
+  if (wire.IsRaw()) {
+    cntl->response_attachment().append(
+        reinterpret_cast<char *>(res_data->data()),
+        res_data->size() * sizeof(float));
+  } else {
+    /*
+    |---compressed(1B)---|---encoded values---|
+    */
+    thread_local std::string encoded;
+    encoded.clear();
+    EncodeSparseValues(wire.value_codec,
+                       res_data->data(),
+                       num,
+                       dim,
+                       &encoded,
+                       wire.stat_dim);
+    butil::IOBuf payload;
+    payload.append(encoded);
+    char compressed = 0;
+    if (wire.compress_threshold > 0 &&
+        encoded.size() >= wire.compress_threshold) {
+      butil::IOBuf compressed_payload;
+      if (brpc::policy::SnappyCompress(payload, &compressed_payload)) {
+        payload.swap(compressed_payload);
+        compressed = 1;
+      }
+    }
+    cntl->response_attachment().append(&compressed, 1);
+    cntl->response_attachment().append(payload);
+  }
   butil::return_object(res_data);
   return 0;
 }
@@ -581,9 +641,37 @@ int32_t BrpcPsService::PushSparse(Table *table,
   */
   TableContext table_context;
   table_context.value_type = Sparse;
-  table_context.push_context.keys = (const uint64_t *)push_data.data();
-  table_context.push_context.values =
-      (const float *)(push_data.data() + sizeof(uint64_t) * num);
+  SparseWireFormat wire;
+  if (request.params_size() > 1 &&
+      !SparseWireFormat::Parse(request.params(1), &wire)) {
+    set_response_code(response, -1, "unknown sparse wire format");
+    return 0;
+  }
+  if (wire.delta_keys) {
+    /*
+    |---varint keys---|---valuesData---|
+    */
+    thread_local std::vector<uint64_t> push_keys;
+    push_keys.resize(num);
+    size_t key_bytes = DecodeSparseKeys(
+        push_data.data(), push_data.size(), num, push_keys.data());
+    if (key_bytes == 0) {
+      set_response_code(response, -1, "push sparse keys are not in format");
+      return 0;
+    }
+    // the varint keys leave the values unaligned
+    thread_local std::vector<float> push_values;
+    push_values.resize((push_data.size() - key_bytes) / sizeof(float));
+    memcpy(push_values.data(),
+           push_data.data() + key_bytes,
+           push_values.size() * sizeof(float));
+    table_context.push_context.keys = push_keys.data();
+    table_context.push_context.values = push_values.data();
+  } else {
+    table_context.push_context.keys = (const uint64_t *)push_data.data();
+    table_context.push_context.values =
+        (const float *)(push_data.data() + sizeof(uint64_t) * num);
+  }
   table_context.num = num;
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
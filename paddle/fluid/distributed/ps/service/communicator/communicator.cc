@@ -20,6 +20,7 @@ limitations under the License. */
 #include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
 #include "paddle/fluid/distributed/ps/wrapper/fleet.h"
 #include "paddle/fluid/platform/profiler.h"
+#include "paddle/phi/kernels/funcs/hash_unique_cpu.h"
 #include "paddle/utils/string/string_helper.h"
 
 #define LEARNING_RATE_DECAY_COUNTER "@LR_DECAY_COUNTER@"
@@ -1296,7 +1297,7 @@ std::vector<int64_t> GeoCommunicator::MergeSparseIds(
                                      platform::TracerEventType::Communication,
                                      1);
   size_t merge_num = 0, wait_times = 0;
-  std::unordered_set<int64_t> sparse_ids;
+  std::vector<int64_t> sparse_ids;
   while (merge_num <
          static_cast<size_t>(max_merge_var_num_)) {  // -> geo_step: 100
     VLOG(3) << "Merge Number of " << send_varname << " = " << merge_num;
@@ -1304,9 +1305,7 @@ std::vector<int64_t> GeoCommunicator::MergeSparseIds(
       wait_times = 0;
       std::shared_ptr<std::vector<int64_t>> pop_ids = nullptr;
       sparse_id_queues_.at(send_varname)->Get(pop_ids);
-      for (auto &pop_id : *pop_ids) {
-        sparse_ids.insert(pop_id);
-      }
+      sparse_ids.insert(sparse_ids.end(), pop_ids->begin(), pop_ids->end());
       merge_num += 1;
       VLOG(3) << "sparse_id_queues_(" << send_varname << ") pushed";
     } else if (sparse_id_queues_.at(send_varname)->Size() == 0) {
@@ -1320,7 +1319,14 @@ std::vector<int64_t> GeoCommunicator::MergeSparseIds(
     }
   }
   std::vector<int64_t> res;
-  res.assign(sparse_ids.begin(), sparse_ids.end());
+  phi::funcs::HashUniqueCPU<int64_t, int64_t>(
+      sparse_ids.data(),
+      static_cast<int64_t>(sparse_ids.size()),
+      phi::funcs::HashUniqueOrder::kAny,
+      &res,
+      nullptr,
+      nullptr,
+      nullptr);
   return res;
 }
 
@@ -0,0 +1,177 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_value_cache.h"
+
+#include <cstring>
+#include <iterator>
+
+#include "butil/time.h"
+#include "glog/logging.h"
+
+namespace paddle {
+namespace distributed {
+
+SparseCacheEviction SparseValueCacheConfig::ParseEviction(
+    const std::string &name) {
+  if (name == "lfu") {
+    return SparseCacheEviction::kLFU;
+  }
+  if (name != "lru") {
+    LOG(WARNING) << "unknown sparse cache eviction policy: " << name
+                 << ", use lru";
+  }
+  return SparseCacheEviction::kLRU;
+}
+
+SparseValueCache::SparseValueCache(const SparseValueCacheConfig &config)
+    : _config(config),
+      _shard_capacity((config.capacity + kShardNum - 1) / kShardNum) {}
+
+bool SparseValueCache::IsFresh(const Entry &entry,
+                               uint64_t step,
+                               int64_t now_ms) const {
+  // entry.step is newer than step when another thread refreshed it meanwhile
+  if (step > entry.step && step - entry.step > _config.max_staleness_steps) {
+    return false;
+  }
+  return _config.max_staleness_ms <= 0 ||
+         now_ms - entry.time_ms <= _config.max_staleness_ms;
+}
+
+void SparseValueCache::Lookup(uint64_t step,
+                              const uint64_t *keys,
+                              float **values,
+                              size_t num,
+                              std::vector<size_t> *miss_index) {
+  const int64_t now_ms =
+      _config.max_staleness_ms > 0 ? butil::gettimeofday_ms() : 0;
+  uint64_t hits = 0;
+  uint64_t stale = 0;
+  for (size_t i = 0; i < num; ++i) {
+    Shard &shard = GetShard(keys[i]);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto iter = shard.entries.find(keys[i]);
+    if (iter == shard.entries.end()) {
+      miss_index->push_back(i);
+      continue;
+    }
+    Entry &entry = iter->second;
+    if (!IsFresh(entry, step, now_ms)) {
+      // keep the slot, Insert refreshes it after the pull
+      ++stale;
+      miss_index->push_back(i);
+      continue;
+    }
+    memcpy(values[i], entry.value.get(), _config.value_size);
+    ++entry.freq;
+    shard.lru.splice(shard.lru.begin(), shard.lru, entry.lru_pos);
+    ++hits;
+  }
+  _hits.fetch_add(hits, std::memory_order_relaxed);
+  _misses.fetch_add(num - hits, std::memory_order_relaxed);
+  _stale.fetch_add(stale, std::memory_order_relaxed);
+}
+
+void SparseValueCache::Insert(uint64_t step, uint64_t key, const float *value) {
+  if (_shard_capacity == 0) {
+    return;
+  }
+  const int64_t now_ms =
+      _config.max_staleness_ms > 0 ? butil::gettimeofday_ms() : 0;
+  Shard &shard = GetShard(key);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto iter = shard.entries.find(key);
+  if (iter == shard.entries.end()) {
+    if (shard.entries.size() >= _shard_capacity) {
+      EvictOne(&shard);
+    }
+    shard.lru.push_front(key);
+    iter = shard.entries.emplace(key, Entry()).first;
+    iter->second.value.reset(new char[_config.value_size]);
+    iter->second.lru_pos = shard.lru.begin();
+  } else if (iter->second.step > step) {
+    // a later pull already refreshed the entry
+    return;
+  }
+  Entry &entry = iter->second;
+  memcpy(entry.value.get(), value, _config.value_size);
+  entry.step = step;
+  entry.time_ms = now_ms;
+  entry.pushes = 0;
+}
+
+void SparseValueCache::OnPush(const uint64_t *keys, size_t num) {
+  if (_config.push_limit == 0) {
+    return;
+  }
+  uint64_t invalidated = 0;
+  for (size_t i = 0; i < num; ++i) {
+    Shard &shard = GetShard(keys[i]);
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto iter = shard.entries.find(keys[i]);
+    if (iter != shard.entries.end() &&
+        ++iter->second.pushes >= _config.push_limit) {
+      Erase(&shard, iter);
+      ++invalidated;
+    }
+  }
+  _push_invalidations.fetch_add(invalidated, std::memory_order_relaxed);
+}
+
+void SparseValueCache::EvictOne(Shard *shard) {
+  auto victim = std::prev(shard->lru.end());
+  if (_config.eviction == SparseCacheEviction::kLFU) {
+    uint32_t min_freq = UINT32_MAX;
+    auto pos = shard->lru.end();
+    for (size_t i = 0; i < kLFUSamples && pos != shard->lru.begin(); ++i) {
+      --pos;
+      uint32_t freq = shard->entries.find(*pos)->second.freq;
+      if (freq < min_freq) {
+        min_freq = freq;
+        victim = pos;
+      }
+    }
+  }
+  Erase(shard, shard->entries.find(*victim));
+  _evictions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SparseValueCache::Erase(
+    Shard *shard, std::unordered_map<uint64_t, Entry>::iterator iter) {
+  shard->lru.erase(iter->second.lru_pos);
+  shard->entries.erase(iter);
+}
+
+void SparseValueCache::Clear() {
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    shard.entries.clear();
+    shard.lru.clear();
+  }
+}
+
+SparseValueCacheStats SparseValueCache::Stats() const {
+  SparseValueCacheStats stats;
+  stats.hits = _hits.load(std::memory_order_relaxed);
+  stats.misses = _misses.load(std::memory_order_relaxed);
+  stats.stale = _stale.load(std::memory_order_relaxed);
+  stats.evictions = _evictions.load(std::memory_order_relaxed);
+  stats.push_invalidations =
+      _push_invalidations.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace distributed
+}  // namespace paddle
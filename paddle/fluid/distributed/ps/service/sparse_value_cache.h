@@ -0,0 +1,135 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+enum class SparseCacheEviction { kLRU = 0, kLFU = 1 };
+
+struct SparseValueCacheConfig {
+  // max number of cached keys, 0 disables the cache
+  size_t capacity = 0;
+  // bytes of a pulled value, accessor select_size
+  size_t value_size = 0;
+  // an entry fetched more than max_staleness_steps pulls ago is refetched,
+  // 0 means every pull goes to the server
+  uint64_t max_staleness_steps = 1;
+  // an entry older than max_staleness_ms is refetched, 0 means no time bound
+  int64_t max_staleness_ms = 0;
+  // an entry is dropped once this worker pushed the key push_limit times
+  // since it was fetched, 0 means pushes do not invalidate
+  uint32_t push_limit = 0;
+  SparseCacheEviction eviction = SparseCacheEviction::kLRU;
+
+  static SparseCacheEviction ParseEviction(const std::string &name);
+};
+
+struct SparseValueCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // misses caused by an entry beyond the staleness bound
+  uint64_t stale = 0;
+  uint64_t evictions = 0;
+  uint64_t push_invalidations = 0;
+
+  double HitRate() const {
+    uint64_t total = hits + misses;
+    return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+  }
+};
+
+// Worker side cache of pulled sparse values with bounded staleness. A step is
+// one PullSparse call on the table: Lookup fills the cached values and returns
+// the positions that must be pulled from the server, Insert caches the values
+// once the pull finished. The cache is sharded by key, each shard has its own
+// lock and LRU list; with kLFU the victim is the least frequently used of the
+// few least recently used entries.
+class SparseValueCache {
+ public:
+  explicit SparseValueCache(const SparseValueCacheConfig &config);
+
+  // Starts a new step, returns the step for Lookup and Insert.
+  uint64_t NextStep() { return ++_step; }
+
+  // Copies the fresh cached values of keys into values and appends the
+  // positions of the other keys to miss_index.
+  void Lookup(uint64_t step,
+              const uint64_t *keys,
+              float **values,
+              size_t num,
+              std::vector<size_t> *miss_index);
+
+  void Insert(uint64_t step, uint64_t key, const float *value);
+
+  // Called for the keys pushed by this worker.
+  void OnPush(const uint64_t *keys, size_t num);
+
+  void Clear();
+
+  SparseValueCacheStats Stats() const;
+
+  const SparseValueCacheConfig &config() const { return _config; }
+
+ private:
+  static constexpr size_t kShardNum = 16;
+  // candidates examined for kLFU eviction
+  static constexpr size_t kLFUSamples = 8;
+
+  struct Entry {
+    std::unique_ptr<char[]> value;
+    uint64_t step = 0;
+    int64_t time_ms = 0;
+    uint32_t pushes = 0;
+    uint32_t freq = 0;
+    std::list<uint64_t>::iterator lru_pos;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+    // most recently used first
+    std::list<uint64_t> lru;
+  };
+
+  Shard &GetShard(uint64_t key) { return _shards[key % kShardNum]; }
+  bool IsFresh(const Entry &entry, uint64_t step, int64_t now_ms) const;
+  void EvictOne(Shard *shard);
+  void Erase(Shard *shard,
+             std::unordered_map<uint64_t, Entry>::iterator iter);
+
+  SparseValueCacheConfig _config;
+  size_t _shard_capacity;
+  std::atomic<uint64_t> _step{0};
+  Shard _shards[kShardNum];
+
+  std::atomic<uint64_t> _hits{0};
+  std::atomic<uint64_t> _misses{0};
+  std::atomic<uint64_t> _stale{0};
+  std::atomic<uint64_t> _evictions{0};
+  std::atomic<uint64_t> _push_invalidations{0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,264 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/service/sparse_wire_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+namespace {
+
+inline void AppendVarint(uint64_t value, std::string *out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+// Returns the bytes consumed, 0 if data ends inside the varint.
+inline size_t ReadVarint(const char *data, size_t size, uint64_t *value) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < size && i < 10; ++i) {
+    uint8_t byte = static_cast<uint8_t>(data[i]);
+    result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+std::string SparseWireFormat::Serialize() const {
+  uint32_t fields[4] = {delta_keys ? 1U : 0U,
+                        static_cast<uint32_t>(value_codec),
+                        compress_threshold,
+                        stat_dim};
+  return std::string(reinterpret_cast<const char *>(fields), sizeof(fields));
+}
+
+bool SparseWireFormat::Parse(const std::string &data,
+                             SparseWireFormat *format) {
+  // clients from before stat_dim send 3 fields
+  uint32_t fields[4] = {0, 0, 0, 0};
+  if (data.size() != sizeof(fields) &&
+      data.size() != sizeof(fields) - sizeof(uint32_t)) {
+    return false;
+  }
+  memcpy(fields, data.data(), data.size());
+  if (fields[1] > static_cast<uint32_t>(SparseValueCodec::kINT8)) {
+    return false;
+  }
+  format->delta_keys = fields[0] != 0;
+  format->value_codec = static_cast<SparseValueCodec>(fields[1]);
+  format->compress_threshold = fields[2];
+  format->stat_dim = fields[3];
+  return true;
+}
+
+bool SparseWireFormat::ParseValueCodec(const std::string &name,
+                                       SparseValueCodec *codec) {
+  if (name == "fp32") {
+    *codec = SparseValueCodec::kFP32;
+  } else if (name == "fp16") {
+    *codec = SparseValueCodec::kFP16;
+  } else if (name == "bf16") {
+    *codec = SparseValueCodec::kBF16;
+  } else if (name == "int8") {
+    *codec = SparseValueCodec::kINT8;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void EncodeSparseKeys(const uint64_t *keys, size_t num, std::string *out) {
+  uint64_t prev = 0;
+  for (size_t i = 0; i < num; ++i) {
+    int64_t delta = static_cast<int64_t>(keys[i] - prev);
+    // zigzag, unsorted keys give negative deltas
+    AppendVarint((static_cast<uint64_t>(delta) << 1) ^
+                     static_cast<uint64_t>(delta >> 63),
+                 out);
+    prev = keys[i];
+  }
+}
+
+size_t DecodeSparseKeys(const char *data,
+                        size_t size,
+                        size_t num,
+                        uint64_t *keys) {
+  size_t pos = 0;
+  uint64_t prev = 0;
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t zigzag = 0;
+    size_t len = ReadVarint(data + pos, size - pos, &zigzag);
+    if (len == 0) {
+      return 0;
+    }
+    pos += len;
+    prev += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+    keys[i] = prev;
+  }
+  return pos;
+}
+
+void EncodeVarints(const uint32_t *values, size_t num, std::string *out) {
+  for (size_t i = 0; i < num; ++i) {
+    AppendVarint(values[i], out);
+  }
+}
+
+size_t DecodeVarints(const char *data,
+                     size_t size,
+                     size_t num,
+                     uint32_t *values) {
+  size_t pos = 0;
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t value = 0;
+    size_t len = ReadVarint(data + pos, size - pos, &value);
+    if (len == 0) {
+      return 0;
+    }
+    pos += len;
+    values[i] = static_cast<uint32_t>(value);
+  }
+  return pos;
+}
+
+size_t EncodedValueBytes(SparseValueCodec codec,
+                         size_t dim,
+                         size_t stat_dim) {
+  stat_dim = std::min(stat_dim, dim);
+  const size_t stat_bytes = stat_dim * sizeof(float);
+  switch (codec) {
+    case SparseValueCodec::kFP16:
+    case SparseValueCodec::kBF16:
+      return stat_bytes + (dim - stat_dim) * sizeof(uint16_t);
+    case SparseValueCodec::kINT8:
+      return stat_bytes + sizeof(float) + (dim - stat_dim) * sizeof(int8_t);
+    default:
+      return dim * sizeof(float);
+  }
+}
+
+void EncodeSparseValues(SparseValueCodec codec,
+                        const float *values,
+                        size_t num,
+                        size_t dim,
+                        std::string *out,
+                        size_t stat_dim) {
+  if (codec == SparseValueCodec::kFP32) {
+    stat_dim = dim;
+  }
+  stat_dim = std::min(stat_dim, dim);
+  size_t offset = out->size();
+  out->resize(offset + num * EncodedValueBytes(codec, dim, stat_dim));
+  char *ptr = &(*out)[offset];
+  for (size_t i = 0; i < num; ++i) {
+    const float *row = values + i * dim;
+    // counters such as show and click exceed the range of fp16 and would
+    // take the whole int8 scale, so they are sent as they are
+    memcpy(ptr, row, stat_dim * sizeof(float));
+    ptr += stat_dim * sizeof(float);
+    switch (codec) {
+      case SparseValueCodec::kFP16:
+        for (size_t j = stat_dim; j < dim; ++j) {
+          uint16_t bits = phi::dtype::float16(row[j]).x;
+          memcpy(ptr, &bits, sizeof(bits));
+          ptr += sizeof(bits);
+        }
+        break;
+      case SparseValueCodec::kBF16:
+        for (size_t j = stat_dim; j < dim; ++j) {
+          uint16_t bits = phi::dtype::bfloat16(row[j]).x;
+          memcpy(ptr, &bits, sizeof(bits));
+          ptr += sizeof(bits);
+        }
+        break;
+      case SparseValueCodec::kINT8: {
+        float max_abs = 0;
+        for (size_t j = stat_dim; j < dim; ++j) {
+          max_abs = std::max(max_abs, std::fabs(row[j]));
+        }
+        float scale = max_abs / 127.0f;
+        memcpy(ptr, &scale, sizeof(scale));
+        ptr += sizeof(scale);
+        for (size_t j = stat_dim; j < dim; ++j) {
+          float q = scale == 0 ? 0 : std::round(row[j] / scale);
+          *ptr++ = static_cast<char>(
+              static_cast<int8_t>(std::min(std::max(q, -127.0f), 127.0f)));
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+void DecodeSparseValueRow(SparseValueCodec codec,
+                          const char *row,
+                          size_t dim,
+                          float *out,
+                          size_t stat_dim) {
+  if (codec == SparseValueCodec::kFP32) {
+    stat_dim = dim;
+  }
+  stat_dim = std::min(stat_dim, dim);
+  memcpy(out, row, stat_dim * sizeof(float));
+  row += stat_dim * sizeof(float);
+  switch (codec) {
+    case SparseValueCodec::kFP16:
+      for (size_t j = stat_dim; j < dim; ++j) {
+        phi::dtype::float16 value;
+        memcpy(&value.x, row, sizeof(uint16_t));
+        row += sizeof(uint16_t);
+        out[j] = static_cast<float>(value);
+      }
+      break;
+    case SparseValueCodec::kBF16:
+      for (size_t j = stat_dim; j < dim; ++j) {
+        phi::dtype::bfloat16 value;
+        memcpy(&value.x, row, sizeof(uint16_t));
+        row += sizeof(uint16_t);
+        out[j] = static_cast<float>(value);
+      }
+      break;
+    case SparseValueCodec::kINT8: {
+      float scale = 0;
+      memcpy(&scale, row, sizeof(scale));
+      const int8_t *q = reinterpret_cast<const int8_t *>(row + sizeof(scale));
+      for (size_t j = stat_dim; j < dim; ++j) {
+        out[j] = q[j - stat_dim] * scale;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,103 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace paddle {
+namespace distributed {
+
+enum class SparseValueCodec : uint32_t {
+  kFP32 = 0,
+  kFP16 = 1,
+  kBF16 = 2,
+  // per value row: fp32 scale followed by int8 values
+  kINT8 = 3,
+};
+
+// Compact encoding of the sparse pull/push RPCs, configured per table by
+// TableParameter.sparse_wire_param. The client sends it as the second param
+// of the request, a request without it uses the raw format, so old clients
+// keep working with new servers.
+//
+// Pull request:  |is_training|keys|frequencies|
+// Pull response: |compressed(1B)|values|
+// Push request:  |keys|values|
+//
+// With delta_keys, keys are zigzag delta varints and the pull frequencies are
+// varints. Pulled values are encoded with value_codec, except their first
+// stat_dim columns, the show/click counters of the accessor, which stay fp32
+// like the pushed gradients. Payloads of at least compress_threshold bytes
+// are snappy compressed.
+struct SparseWireFormat {
+  bool delta_keys = false;
+  SparseValueCodec value_codec = SparseValueCodec::kFP32;
+  // bytes, 0 disables compression
+  uint32_t compress_threshold = 0;
+  // ValueAccessor::GetPullStatDim of the table
+  uint32_t stat_dim = 0;
+
+  bool IsRaw() const {
+    return !delta_keys && value_codec == SparseValueCodec::kFP32 &&
+           compress_threshold == 0;
+  }
+
+  std::string Serialize() const;
+  static bool Parse(const std::string &data, SparseWireFormat *format);
+  // fp32, fp16, bf16 or int8
+  static bool ParseValueCodec(const std::string &name,
+                              SparseValueCodec *codec);
+};
+
+// Appends the keys as zigzag delta varints, compact when the keys are sorted.
+void EncodeSparseKeys(const uint64_t *keys, size_t num, std::string *out);
+
+// Decodes num keys, returns the bytes consumed or 0 if data is malformed.
+size_t DecodeSparseKeys(const char *data,
+                        size_t size,
+                        size_t num,
+                        uint64_t *keys);
+
+void EncodeVarints(const uint32_t *values, size_t num, std::string *out);
+
+size_t DecodeVarints(const char *data,
+                     size_t size,
+                     size_t num,
+                     uint32_t *values);
+
+// Bytes of one encoded row of dim floats, the first stat_dim of which are
+// kept in fp32 and the rest encoded with codec.
+size_t EncodedValueBytes(SparseValueCodec codec,
+                         size_t dim,
+                         size_t stat_dim = 0);
+
+void EncodeSparseValues(SparseValueCodec codec,
+                        const float *values,
+                        size_t num,
+                        size_t dim,
+                        std::string *out,
+                        size_t stat_dim = 0);
+
+// Decodes one row of EncodedValueBytes(codec, dim, stat_dim) bytes, row need
+// not be aligned.
+void DecodeSparseValueRow(SparseValueCodec codec,
+                          const char *row,
+                          size_t dim,
+                          float *out,
+                          size_t stat_dim = 0);
+
+}  // namespace distributed
+}  // namespace paddle
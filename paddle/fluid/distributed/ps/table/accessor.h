@@ -91,6 +91,8 @@ class ValueAccessor {
   virtual int Initialize() = 0;
 
   virtual AccessorInfo GetAccessorInfo() { return _accessor_info; }
+  // 拉取值开头的统计列数(如show, click), 有损的稀疏通信编码对其保持fp32
+  virtual size_t GetPullStatDim() { return 0; }
 
   virtual bool NeedExtendMF(float* value UNUSED) { return false; }
   virtual bool HasMF(size_t size UNUSED) { return false; }
@@ -106,6 +106,13 @@ int32_t GraphTable::Load_to_ssd(const std::string &path,
     }
   }
 
+  std::vector<std::shared_ptr<const CsrShards>> csr_feature_shards;
+  for (size_t idx = 0; idx < csr_feature_shards_.size(); idx++) {
+    auto shards = get_csr_feature_shards(idx);
+    if (shards != nullptr) {
+      csr_feature_shards.push_back(shards);
+    }
+  }
   for (size_t i = 0; i < bags.size(); i++) {
     if (bags[i].size() > 0) {
       tasks.push_back(_cpu_worker_pool[gpu_id]->enqueue([&, i, this]() -> int {
@@ -113,9 +120,17 @@ int32_t GraphTable::Load_to_ssd(const std::string &path,
         ::paddle::framework::GpuPsFeaInfo x;
         std::vector<uint64_t> feature_ids;
         for (size_t j = 0; j < bags[i].size(); j++) {
-          Node *v = find_node(GraphTableType::FEATURE_TABLE, bags[i][j]);
           node_id = bags[i][j];
-          if (v == NULL) {
+          int64_t pos = -1;
+          const CsrGraphShard *csr = nullptr;
+          for (auto &shards : csr_feature_shards) {
+            csr = find_csr_shard(*shards, node_id, &pos);
+            if (csr != nullptr) break;
+          }
+          Node *v = csr != nullptr
+                        ? nullptr
+                        : find_node(GraphTableType::FEATURE_TABLE, node_id);
+          if (csr == nullptr && v == NULL) {
             x.feature_size = 0;
             x.feature_offset = 0;
             node_fea_info_array[i].push_back(x);
@@ -125,7 +140,11 @@ int32_t GraphTable::Load_to_ssd(const std::string &path,
             int total_feature_size = 0;
             for (int k = 0; k < slot_num; ++k) {
               auto feature_ids_size =
-                  v->get_feature_ids(k, feature_array[i], slot_id_array[i]);
+                  csr != nullptr
+                      ? csr->GetSlotFeatureIds(
+                            pos, k, &feature_array[i], &slot_id_array[i])
+                      : v->get_feature_ids(
+                            k, feature_array[i], slot_id_array[i]);
               if (slot_feature_num_map_[k] < feature_ids_size) {
                 slot_feature_num_map_[k] = feature_ids_size;
               }
@@ -277,6 +296,7 @@ GraphTable::make_gpu_ps_graph_float_fea(int gpu_id,
 
 ::paddle::framework::GpuPsCommGraph GraphTable::make_gpu_ps_graph(
     int idx, const std::vector<uint64_t> &ids) {
+  restore_csr_edge_shards(idx);
   std::vector<std::vector<uint64_t>> bags(task_pool_size_);
   for (int i = 0; i < task_pool_size_; i++) {
     auto predsize = ids.size() / task_pool_size_;
@@ -720,8 +740,12 @@ void GraphTable::release_graph_node() {
                 SSD_EMB_AND_MEM_FEATURE_GPU_GRAPH) {
       clear_feature_shard();
     } else {
+      restore_csr_feature_shards();
       merge_feature_shard();
       feature_shrink_to_fit();
+      if (use_csr_shard_) {
+        build_csr_feature_shards();
+      }
     }
   }
 }
@@ -813,6 +837,7 @@ int32_t GraphTable::load_edges_to_ssd(const std::string &path,
 
 int32_t GraphTable::dump_edges_to_ssd(int idx) {
   VLOG(2) << "calling dump edges to ssd";
+  restore_csr_edge_shards(idx);
   std::vector<std::future<int64_t>> tasks;
   auto &shards = edge_shards[idx];
   for (size_t i = 0; i < shards.size(); ++i) {
@@ -840,6 +865,7 @@ int32_t GraphTable::dump_edges_to_ssd(int idx) {
 }
 int32_t GraphTable::make_complementary_graph(int idx, int64_t byte_size) {
   VLOG(0) << "make_complementary_graph";
+  restore_csr_edge_shards(idx);
   const size_t fixed_size = byte_size / 8;
   std::vector<std::unordered_map<uint64_t, int>> count(task_pool_size_);
   std::vector<std::future<int>> tasks;
@@ -903,6 +929,11 @@ int32_t GraphTable::make_complementary_graph(int idx, int64_t byte_size) {
 }
 
 void GraphTable::graph_partition(bool is_edge) {
+  if (is_edge) {
+    restore_csr_edge_shards();
+  } else {
+    restore_csr_feature_shards();
+  }
   std::string mode = FLAGS_graph_edges_split_mode;
   if (mode == "dbh" || mode == "DBH") {
     VLOG(0) << "Graph partitioning DBH";
@@ -1393,6 +1424,7 @@ void GraphTable::fennel_graph_edge_partition() {
 }
 void GraphTable::filter_graph_edge_nodes() {
   VLOG(0) << "begin filter graph edge nodes";
+  restore_csr_edge_shards();
   // 过滤不属于自己边表信息
   std::vector<std::future<std::pair<size_t, size_t>>> shard_tasks;
   std::vector<size_t> total_edge_count(shard_num_per_server, 0);
@@ -1545,6 +1577,7 @@ void GraphTable::fennel_graph_feature_partition() {
           << ", end to process fennel feature shard";
 }
 void GraphTable::stat_graph_edge_info(int type) {
+  restore_csr_edge_shards();
   std::vector<std::future<std::pair<size_t, size_t>>> shard_tasks;
   // 获取边是否跨机统计
   std::function<size_t(Node *)> get_cross_edge_count = nullptr;
@@ -1605,6 +1638,7 @@ void GraphTable::stat_graph_edge_info(int type) {
 #endif  // PADDLE_WITH_HETERPS
 
 void GraphTable::clear_graph(int idx) {
+  std::atomic_store(&csr_edge_shards_[idx], std::shared_ptr<const CsrShards>());
   for (auto p : edge_shards[idx]) {
     p->clear();
     delete p;
@@ -1618,6 +1652,9 @@ void GraphTable::clear_graph(int idx) {
 
 void GraphTable::clear_edge_shard() {
   VLOG(0) << "begin clear edge shard";
+  for (auto &shards : csr_edge_shards_) {
+    std::atomic_store(&shards, std::shared_ptr<const CsrShards>());
+  }
   std::vector<std::future<int>> tasks;
   for (auto &type_shards : edge_shards) {
     for (auto &shard : type_shards) {
@@ -1639,6 +1676,9 @@ void GraphTable::clear_edge_shard() {
 
 void GraphTable::clear_feature_shard() {
   VLOG(0) << "begin clear feature shard";
+  for (auto &shards : csr_feature_shards_) {
+    std::atomic_store(&shards, std::shared_ptr<const CsrShards>());
+  }
   std::vector<std::future<int>> tasks;
   for (auto &type_shards : feature_shards) {
     for (auto &shard : type_shards) {
@@ -1705,6 +1745,7 @@ int32_t GraphTable::add_comm_edge(int idx, uint64_t src_id, uint64_t dst_id) {
     return -1;
   }
   size_t index = src_shard_id - shard_start;
+  restore_csr_edge_shards(idx);
   edge_shards[idx][index]->add_graph_node(src_id)->build_edges(false);
   edge_shards[idx][index]->add_neighbor(src_id, dst_id, 1.0);
   return 0;
@@ -1713,6 +1754,7 @@ int32_t GraphTable::add_graph_node(int idx,
                                    std::vector<uint64_t> &id_list,
                                    std::vector<bool> &is_weight_list) {
   auto &shards = edge_shards[idx];
+  restore_csr_edge_shards(idx);
   size_t node_size = id_list.size();
   std::vector<std::vector<std::pair<uint64_t, bool>>> batch(task_pool_size_);
   for (size_t i = 0; i < node_size; i++) {
@@ -1748,6 +1790,7 @@ int32_t GraphTable::remove_graph_node(int idx, std::vector<uint64_t> &id_list) {
     batch[get_thread_pool_index(id_list[i])].push_back(id_list[i]);
   }
   auto &shards = edge_shards[idx];
+  restore_csr_edge_shards(idx);
   std::vector<std::future<int>> tasks;
   for (size_t i = 0; i < batch.size(); ++i) {
     if (batch[i].empty()) continue;
@@ -2407,6 +2450,7 @@ std::pair<uint64_t, uint64_t> GraphTable::parse_node_file_parallel(
 int32_t GraphTable::load_nodes(const std::string &path,
                                std::string node_type,
                                bool load_slot) {
+  restore_csr_feature_shards();
   auto paths = paddle::string::split_string<std::string>(path, ";");
   uint64_t count = 0;
   uint64_t valid_count = 0;
@@ -2469,6 +2513,153 @@ int32_t GraphTable::build_sampler(int idx, std::string sample_type) {
   return 0;
 }
 
+void GraphTable::build_csr_edge_shards(int idx) {
+  std::lock_guard<std::mutex> guard(csr_mutex_);
+  auto csr_shards = std::make_shared<CsrShards>(edge_shards[idx].size());
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < csr_shards->size(); i++) {
+    tasks.push_back(
+        load_node_edge_task_pool->enqueue([&csr_shards, idx, i, this]() -> int {
+          (*csr_shards)[i].reset(new CsrGraphShard());
+          (*csr_shards)[i]->BuildEdges(edge_shards[idx][i]->get_bucket(),
+                                       is_weighted_);
+          return 0;
+        }));
+  }
+  for (auto &task : tasks) task.get();
+  std::atomic_store(&csr_edge_shards_[idx],
+                    std::shared_ptr<const CsrShards>(csr_shards));
+  // the samplers read the CSR shards from here on
+  tasks.clear();
+  for (size_t i = 0; i < csr_shards->size(); i++) {
+    tasks.push_back(load_node_edge_task_pool->enqueue([idx, i, this]() -> int {
+      for (auto *node : edge_shards[idx][i]->get_bucket()) {
+        node->release_edges();
+      }
+      return 0;
+    }));
+  }
+  for (auto &task : tasks) task.get();
+  size_t bytes = 0;
+  for (auto &shard : *csr_shards) {
+    bytes += shard->MemoryBytes();
+  }
+  VLOG(0) << "build csr shards of edge_type[" << id_to_edge[idx]
+          << "], weighted: " << is_weighted_ << ", " << bytes << " bytes";
+}
+
+void GraphTable::build_csr_feature_shards() {
+  std::lock_guard<std::mutex> guard(csr_mutex_);
+  std::vector<std::shared_ptr<CsrShards>> csr_shards;
+  std::vector<std::future<int>> tasks;
+  for (size_t idx = 0; idx < feature_shards.size(); idx++) {
+    csr_shards.push_back(
+        std::make_shared<CsrShards>(feature_shards[idx].size()));
+    auto &shards = *csr_shards.back();
+    int slot_num = static_cast<int>(feat_name[idx].size());
+    for (size_t i = 0; i < shards.size(); i++) {
+      tasks.push_back(load_node_edge_task_pool->enqueue(
+          [&shards, idx, i, slot_num, this]() -> int {
+            shards[i].reset(new CsrGraphShard());
+            shards[i]->BuildSlotFeatures(feature_shards[idx][i]->get_bucket(),
+                                         slot_num);
+            return 0;
+          }));
+    }
+  }
+  for (auto &task : tasks) task.get();
+  tasks.clear();
+  for (size_t idx = 0; idx < feature_shards.size(); idx++) {
+    std::atomic_store(&csr_feature_shards_[idx],
+                      std::shared_ptr<const CsrShards>(csr_shards[idx]));
+    int slot_num = static_cast<int>(feat_name[idx].size());
+    for (size_t i = 0; i < feature_shards[idx].size(); i++) {
+      tasks.push_back(load_node_edge_task_pool->enqueue(
+          [idx, i, slot_num, this]() -> int {
+            for (auto *node : feature_shards[idx][i]->get_bucket()) {
+              node->release_slot_features(slot_num);
+            }
+            return 0;
+          }));
+    }
+  }
+  for (auto &task : tasks) task.get();
+  VLOG(0) << "build csr shards of " << feature_shards.size()
+          << " feature types";
+}
+
+void GraphTable::restore_csr_edge_shards(int idx) {
+  if (get_csr_edge_shards(idx) == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(csr_mutex_);
+  auto csr_shards = get_csr_edge_shards(idx);
+  if (csr_shards == nullptr) {
+    return;
+  }
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < csr_shards->size(); i++) {
+    tasks.push_back(
+        load_node_edge_task_pool->enqueue([&csr_shards, idx, i, this]() -> int {
+          (*csr_shards)[i]->RestoreEdges(edge_shards[idx][i]->get_bucket());
+          return 0;
+        }));
+  }
+  for (auto &task : tasks) task.get();
+  // samplers still reading the old shards keep them alive
+  std::atomic_store(&csr_edge_shards_[idx], std::shared_ptr<const CsrShards>());
+  VLOG(0) << "restore csr shards of edge_type[" << id_to_edge[idx] << "]";
+}
+
+void GraphTable::restore_csr_feature_shards(int idx) {
+  if (get_csr_feature_shards(idx) == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(csr_mutex_);
+  auto csr_shards = get_csr_feature_shards(idx);
+  if (csr_shards == nullptr) {
+    return;
+  }
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < csr_shards->size(); i++) {
+    tasks.push_back(
+        load_node_edge_task_pool->enqueue([&csr_shards, idx, i, this]() -> int {
+          (*csr_shards)[i]->RestoreSlotFeatures(
+              feature_shards[idx][i]->get_bucket());
+          return 0;
+        }));
+  }
+  for (auto &task : tasks) task.get();
+  std::atomic_store(&csr_feature_shards_[idx],
+                    std::shared_ptr<const CsrShards>());
+  VLOG(0) << "restore csr shards of feature type[" << idx << "]";
+}
+
+void GraphTable::restore_csr_edge_shards() {
+  for (size_t idx = 0; idx < csr_edge_shards_.size(); idx++) {
+    restore_csr_edge_shards(static_cast<int>(idx));
+  }
+}
+
+void GraphTable::restore_csr_feature_shards() {
+  for (size_t idx = 0; idx < csr_feature_shards_.size(); idx++) {
+    restore_csr_feature_shards(static_cast<int>(idx));
+  }
+}
+
+const CsrGraphShard *GraphTable::find_csr_shard(const CsrShards &shards,
+                                                uint64_t id,
+                                                int64_t *pos) {
+  size_t shard_id = id % shard_num;
+  if (shards.empty() || shard_id >= shard_end || shard_id < shard_start) {
+    *pos = -1;
+    return nullptr;
+  }
+  const CsrGraphShard *shard = shards[shard_id - shard_start].get();
+  *pos = shard->Find(id);
+  return *pos < 0 ? nullptr : shard;
+}
+
 std::pair<uint64_t, uint64_t> GraphTable::parse_edge_file(
     const std::string &path, int idx, bool reverse, bool use_weight) {
   is_weighted_ = use_weight;
@@ -2569,6 +2760,8 @@ int32_t GraphTable::load_edges(const std::string &path,
     }
     idx = edge_to_id[edge_type];
   }
+  // the new edges are appended to the ones already loaded
+  restore_csr_edge_shards(idx);
 
   auto paths = ::paddle::string::split_string<std::string>(path, ";");
   uint64_t count = 0;
@@ -2617,6 +2810,9 @@ int32_t GraphTable::load_edges(const std::string &path,
     // In order not to affect the sampler function of other scenario,
     // this optimization is only performed in load_edges function.
     VLOG(0) << "run in gpugraph mode!";
+  } else if (use_csr_shard_) {
+    // the CSR shard replaces the per-node samplers
+    build_csr_edge_shards(idx);
   } else {
     std::string sample_type = "random";
     VLOG(0) << "build sampler ... ";
@@ -2778,6 +2974,8 @@ int32_t GraphTable::random_sample_neighbors(
     seq_id[index].emplace_back(idy);
     id_list[index].emplace_back(idx, node_ids[idy], sample_size, need_weight);
   }
+  // held until the tasks finish, a concurrent restore does not free it
+  auto csr_shards = get_csr_edge_shards(idx);
 
   for (size_t i = 0; i < seq_id.size(); i++) {
     if (seq_id[i].empty()) continue;
@@ -2792,6 +2990,7 @@ int32_t GraphTable::random_sample_neighbors(
       size_t index = 0;
       std::vector<SampleResult> sample_res;
       std::vector<SampleKey> sample_keys;
+      std::vector<uint32_t> csr_res;
       auto &rng = _shards_task_rng_pool[i];
       for (size_t k = 0; k < id_list[i].size(); k++) {
         if (index < r.size() &&
@@ -2800,6 +2999,40 @@ int32_t GraphTable::random_sample_neighbors(
           actual_sizes[idy] = r[index].second.actual_size;
           buffers[idy] = r[index].second.buffer;
           index++;
+        } else if (csr_shards != nullptr) {
+          node_id = id_list[i][k].node_key;
+          int idy = seq_id[i][k];
+          int &actual_size = actual_sizes[idy];
+          int64_t pos;
+          const CsrGraphShard *shard =
+              find_csr_shard(*csr_shards, node_id, &pos);
+          if (shard == nullptr) {
+            actual_size = 0;
+            continue;
+          }
+          csr_res.clear();
+          shard->SampleK(pos, sample_size, rng.get(), &csr_res);
+          actual_size = csr_res.size() *
+                        (need_weight ? (Node::id_size + Node::weight_size)
+                                     : Node::id_size);
+          char *buffer_addr = new char[actual_size];
+          if (response == LRUResponse::ok) {
+            sample_keys.emplace_back(idx, node_id, sample_size, need_weight);
+            sample_res.emplace_back(actual_size, buffer_addr);
+            buffers[idy] = sample_res.back().buffer;
+          } else {
+            buffers[idy].reset(buffer_addr, char_del);
+          }
+          for (uint32_t x : csr_res) {
+            uint64_t id = shard->NeighborId(pos, x);
+            memcpy(buffer_addr, &id, Node::id_size);
+            buffer_addr += Node::id_size;
+            if (need_weight) {
+              float weight = shard->NeighborWeight(pos, x);
+              memcpy(buffer_addr, &weight, Node::weight_size);
+              buffer_addr += Node::weight_size;
+            }
+          }
         } else {
           node_id = id_list[i][k].node_key;
           Node *node = find_node(GraphTableType::EDGE_TABLE, idx, node_id);
@@ -2926,6 +3159,8 @@ int32_t GraphTable::get_node_feat(int idx,
                                   const std::vector<std::string> &feature_names,
                                   std::vector<std::vector<std::string>> &res) {
   size_t node_num = node_ids.size();
+  // the slot features of the nodes sit in here once it is built
+  auto csr_shards = get_csr_feature_shards(idx);
   std::vector<std::future<int>> tasks;
   for (size_t idy = 0; idy < node_num; ++idy) {
     uint64_t node_id = node_ids[idy];
@@ -2936,13 +3171,20 @@ int32_t GraphTable::get_node_feat(int idx,
           if (node == nullptr) {
             return 0;
           }
+          int64_t pos = -1;
+          const CsrGraphShard *csr =
+              csr_shards == nullptr
+                  ? nullptr
+                  : find_csr_shard(*csr_shards, node_id, &pos);
           for (size_t feat_idx = 0; feat_idx < feature_names.size();
                ++feat_idx) {
             const std::string &feature_name = feature_names[feat_idx];
             if (feat_id_map[idx].find(feature_name) != feat_id_map[idx].end()) {
               // res[feat_idx][idx] =
               // node->get_feature(feat_id_map[feature_name]);
-              auto feat = node->get_feature(feat_id_map[idx][feature_name]);
+              int slot = feat_id_map[idx][feature_name];
+              auto feat = csr != nullptr ? csr->GetSlotFeature(pos, slot)
+                                         : node->get_feature(slot);
               res[feat_idx][idy] = feat;
             }
           }
@@ -2960,6 +3202,7 @@ int32_t GraphTable::set_node_feat(
     const std::vector<uint64_t> &node_ids,
     const std::vector<std::string> &feature_names,
     const std::vector<std::vector<std::string>> &res) {
+  restore_csr_feature_shards(idx);
   size_t node_num = node_ids.size();
   std::vector<std::future<int>> tasks;
   for (size_t idy = 0; idy < node_num; ++idy) {
@@ -3181,13 +3424,22 @@ int GraphTable::get_all_neighbor_id(
                             ? feature_shards
                             : node_shards;
   std::vector<std::future<size_t>> tasks;
-  for (auto &search_shard : search_shards) {
+  std::vector<std::shared_ptr<const CsrShards>> csr_shards(
+      search_shards.size());
+  for (size_t idx = 0; idx < search_shards.size(); idx++) {
+    if (table_type == GraphTableType::EDGE_TABLE) {
+      csr_shards[idx] = get_csr_edge_shards(idx);
+    }
+    auto &search_shard = search_shards[idx];
+    auto &csr_shard = csr_shards[idx];
     for (size_t j = 0; j < search_shard.size(); j++) {
       tasks.push_back(_shards_task_pool[j % task_pool_size_]->enqueue(
-          [search_shard, j, slice_num, &shard_merge]() -> size_t {
+          [search_shard, &csr_shard, j, slice_num, &shard_merge]() -> size_t {
             std::vector<std::vector<uint64_t>> shard_keys;
-            size_t num =
-                search_shard[j]->get_all_neighbor_id(&shard_keys, slice_num);
+            size_t num = search_shard[j]->get_all_neighbor_id(
+                &shard_keys,
+                slice_num,
+                csr_shard == nullptr ? nullptr : (*csr_shard)[j].get());
             // add to shard
             shard_merge.merge(shard_keys);
             return num;
@@ -3238,14 +3490,19 @@ int GraphTable::get_all_neighbor_id(
       table_type == GraphTableType::EDGE_TABLE      ? edge_shards[idx]
       : table_type == GraphTableType::FEATURE_TABLE ? feature_shards[idx]
                                                     : node_shards[idx];
+  auto csr_shards = table_type == GraphTableType::EDGE_TABLE
+                        ? get_csr_edge_shards(idx)
+                        : nullptr;
   std::vector<std::future<size_t>> tasks;
   VLOG(3) << "begin task, task_pool_size_[" << task_pool_size_ << "]";
   for (size_t i = 0; i < search_shards.size(); i++) {
     tasks.push_back(_shards_task_pool[i % task_pool_size_]->enqueue(
-        [&search_shards, i, slice_num, &shard_merge]() -> size_t {
+        [&search_shards, &csr_shards, i, slice_num, &shard_merge]() -> size_t {
           std::vector<std::vector<uint64_t>> shard_keys;
-          size_t num =
-              search_shards[i]->get_all_neighbor_id(&shard_keys, slice_num);
+          size_t num = search_shards[i]->get_all_neighbor_id(
+              &shard_keys,
+              slice_num,
+              csr_shards == nullptr ? nullptr : (*csr_shards)[i].get());
           // add to shard
           shard_merge.merge(shard_keys);
           return num;
@@ -3268,13 +3525,18 @@ int GraphTable::get_all_feature_ids(
       table_type == GraphTableType::EDGE_TABLE      ? edge_shards[idx]
       : table_type == GraphTableType::FEATURE_TABLE ? feature_shards[idx]
                                                     : node_shards[idx];
+  auto csr_shards = table_type == GraphTableType::FEATURE_TABLE
+                        ? get_csr_feature_shards(idx)
+                        : nullptr;
   std::vector<std::future<size_t>> tasks;
   for (size_t i = 0; i < search_shards.size(); i++) {
     tasks.push_back(_shards_task_pool[i % task_pool_size_]->enqueue(
-        [&search_shards, i, slice_num, &shard_merge]() -> size_t {
+        [&search_shards, &csr_shards, i, slice_num, &shard_merge]() -> size_t {
           std::vector<std::vector<uint64_t>> shard_keys;
-          size_t num =
-              search_shards[i]->get_all_feature_ids(&shard_keys, slice_num);
+          size_t num = search_shards[i]->get_all_feature_ids(
+              &shard_keys,
+              slice_num,
+              csr_shards == nullptr ? nullptr : (*csr_shards)[i].get());
           // add to shard
           shard_merge.merge(shard_keys);
           return num;
@@ -3410,6 +3672,7 @@ void GraphTable::load_node_weight(int type_id, int idx, std::string path) {
 int32_t GraphTable::Initialize(const GraphParameter &graph) {
   task_pool_size_ = graph.task_pool_size();
   build_sampler_on_cpu = graph.build_sampler_on_cpu();
+  use_csr_shard_ = graph.use_csr_shard();
 
 #ifdef PADDLE_WITH_GPU_GRAPH
   _db = NULL;
@@ -3538,6 +3801,7 @@ int32_t GraphTable::Initialize(const GraphParameter &graph) {
   VLOG(0) << "in init graph table shard idx = " << _shard_idx << " shard_start "
           << shard_start << " shard_end " << shard_end;
   edge_shards.resize(id_to_edge.size());
+  csr_edge_shards_.assign(id_to_edge.size(), nullptr);
   node_weight.resize(2);
   node_weight[0].resize(id_to_edge.size());
 #ifdef PADDLE_WITH_GPU_GRAPH
@@ -3552,6 +3816,7 @@ int32_t GraphTable::Initialize(const GraphParameter &graph) {
   }
   node_weight[1].resize(id_to_feature.size());
   feature_shards.resize(id_to_feature.size());
+  csr_feature_shards_.assign(id_to_feature.size(), nullptr);
   node_shards.resize(id_to_feature.size());
   for (size_t k = 0; k < feature_shards.size(); k++) {
     for (size_t i = 0; i < shard_num_per_server; i++) {
@@ -3581,6 +3846,7 @@ void GraphTable::build_graph_total_keys() {
 }
 
 void GraphTable::calc_edge_type_limit() {
+  restore_csr_edge_shards();
   std::vector<uint64_t> graph_type_keys_;
   std::vector<int> graph_type_keys_neighbor_size_;
   std::vector<std::vector<int>> neighbor_size_array;
@@ -41,6 +41,7 @@
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
 #include "paddle/fluid/distributed/ps/table/graph/class_macro.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 #include "paddle/fluid/distributed/ps/thirdparty/round_robin.h"
 #include "paddle/phi/core/utils/rw_lock.h"
@@ -78,8 +79,14 @@ class GraphShard {
     }
     return bucket_num;
   }
+  // csr is the CsrGraphShard the nodes released their edges or features to
   size_t get_all_neighbor_id(std::vector<std::vector<uint64_t>> *total_res,
-                             int slice_num) {
+                             int slice_num,
+                             const CsrGraphShard *csr = nullptr) {
+    if (csr != nullptr) {
+      std::vector<uint64_t> keys = csr->neighbors();
+      return dedup2shard_keys(&keys, total_res, slice_num);
+    }
     std::vector<uint64_t> keys;
     for (size_t i = 0; i < bucket.size(); i++) {
       size_t neighbor_size = bucket[i]->get_neighbor_size();
@@ -92,7 +99,12 @@ class GraphShard {
     return dedup2shard_keys(&keys, total_res, slice_num);
   }
   size_t get_all_feature_ids(std::vector<std::vector<uint64_t>> *total_res,
-                             int slice_num) {
+                             int slice_num,
+                             const CsrGraphShard *csr = nullptr) {
+    if (csr != nullptr) {
+      std::vector<uint64_t> keys = csr->slot_features();
+      return dedup2shard_keys(&keys, total_res, slice_num);
+    }
     std::vector<uint64_t> keys;
     for (size_t i = 0; i < bucket.size(); i++) {
       bucket[i]->get_feature_ids(&keys);
@@ -769,6 +781,32 @@ class GraphTable : public Table {
 #endif
   virtual int32_t add_comm_edge(int idx, uint64_t src_id, uint64_t dst_id);
   virtual int32_t build_sampler(int idx, std::string sample_type = "random");
+  using CsrShards = std::vector<std::unique_ptr<CsrGraphShard>>;
+  // Packs edge_shards[idx] into csr_edge_shards_[idx] and frees the edges of
+  // its nodes, the CSR shards then serve random_sample_neighbors until the
+  // edges change.
+  void build_csr_edge_shards(int idx);
+  // Packs the slot features of every feature type into csr_feature_shards_
+  // and frees them from the nodes.
+  void build_csr_feature_shards();
+  // Moves the CSR shards of idx back into the nodes and drops them, called
+  // before the nodes are changed or read node by node.
+  void restore_csr_edge_shards(int idx);
+  void restore_csr_feature_shards(int idx);
+  // Restores the CSR shards of every edge or feature type.
+  void restore_csr_edge_shards();
+  void restore_csr_feature_shards();
+  // Readers hold the returned shards while they use them, so a concurrent
+  // restore or clear swaps them out without freeing them under the reader.
+  std::shared_ptr<const CsrShards> get_csr_edge_shards(int idx) const {
+    return std::atomic_load(&csr_edge_shards_[idx]);
+  }
+  std::shared_ptr<const CsrShards> get_csr_feature_shards(int idx) const {
+    return std::atomic_load(&csr_feature_shards_[idx]);
+  }
+  const CsrGraphShard *find_csr_shard(const CsrShards &shards,
+                                      uint64_t id,
+                                      int64_t *pos);
   void set_slot_feature_separator(const std::string &ch);
   void set_feature_separator(const std::string &ch);
 
@@ -795,6 +833,12 @@ class GraphTable : public Table {
 
   std::vector<std::vector<GraphShard *>> edge_shards, feature_shards,
       node_shards;
+  // immutable copies of edge_shards and feature_shards, nullptr when not
+  // built, accessed with std::atomic_load and std::atomic_store
+  std::vector<std::shared_ptr<const CsrShards>> csr_edge_shards_,
+      csr_feature_shards_;
+  // serializes building and restoring the CSR shards
+  std::mutex csr_mutex_;
   size_t shard_start, shard_end, server_num, shard_num_per_server, shard_num;
   int task_pool_size_ = 64;
   int load_thread_num_ = 160;
@@ -833,6 +877,7 @@ class GraphTable : public Table {
   int cache_ttl;
   mutable std::mutex mutex_;
   bool build_sampler_on_cpu;
+  bool use_csr_shard_ = false;
   bool is_load_reverse_edge = false;
   std::shared_ptr<pthread_rwlock_t> rw_lock;
 #ifdef PADDLE_WITH_HETERPS
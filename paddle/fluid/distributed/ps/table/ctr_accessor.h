@@ -138,6 +138,8 @@ class CtrCommonAccessor : public ValueAccessor {
   virtual int Initialize();
   // 初始化AccessorInfo
   virtual void InitAccessorInfo();
+  // show, click
+  virtual size_t GetPullStatDim() { return CtrCommonPullValue::EmbedWIndex(); }
   // 判断该value是否进行shrink
   virtual bool Shrink(float* value);
   // 判断该value是否保存到ssd
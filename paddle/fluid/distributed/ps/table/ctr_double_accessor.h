@@ -162,6 +162,8 @@ class CtrDoubleAccessor : public ValueAccessor {
   virtual int Initialize();
   // 初始化AccessorInfo
   virtual void InitAccessorInfo();
+  // show, click
+  virtual size_t GetPullStatDim() { return CtrDoublePullValue::EmbedWIndex(); }
   // 判断该value是否进行shrink
   virtual bool Shrink(float* value);
   virtual bool NeedExtendMF(float* value);
@@ -197,6 +197,8 @@ class CtrDymfAccessor : public ValueAccessor {
   virtual int Initialize();
   // 初始化AccessorInfo
   virtual void InitAccessorInfo();
+  // show, click, mf_dim
+  virtual size_t GetPullStatDim() { return CtrDymfPullValue::EmbedWIndex(); }
   // 判断该value是否进行shrink
   virtual bool Shrink(float* value);
   // 判断该value是否保存到ssd
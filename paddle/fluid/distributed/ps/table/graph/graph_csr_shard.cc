@@ -0,0 +1,321 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+#include <utility>
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+
+namespace paddle::distributed {
+
+namespace {
+
+// Samples of at most this size track the picked indices in a vector.
+constexpr int kLinearSetSize = 32;
+
+class PickedSet {
+ public:
+  explicit PickedSet(int k) : small_(k <= kLinearSetSize) {
+    if (!small_) {
+      large_.reserve(k * 2);
+    }
+  }
+  // Returns false if index was already picked.
+  bool Insert(uint32_t index) {
+    if (!small_) {
+      return large_.insert(index).second;
+    }
+    if (std::find(picked_.begin(), picked_.end(), index) != picked_.end()) {
+      return false;
+    }
+    picked_.push_back(index);
+    return true;
+  }
+
+ private:
+  bool small_;
+  std::vector<uint32_t> picked_;
+  std::unordered_set<uint32_t> large_;
+};
+
+}  // namespace
+
+void CsrGraphShard::SortIds(const std::vector<Node *> &nodes,
+                            std::vector<size_t> *order) {
+  order->resize(nodes.size());
+  std::iota(order->begin(), order->end(), 0);
+  std::sort(order->begin(), order->end(), [&nodes](size_t a, size_t b) {
+    return nodes[a]->get_id() < nodes[b]->get_id();
+  });
+  ids_.resize(nodes.size());
+  for (size_t i = 0; i < order->size(); ++i) {
+    ids_[i] = nodes[(*order)[i]]->get_id();
+  }
+  ids_.shrink_to_fit();
+}
+
+void CsrGraphShard::BuildEdges(const std::vector<Node *> &nodes,
+                               bool weighted) {
+  std::vector<size_t> order;
+  SortIds(nodes, &order);
+  offsets_.assign(nodes.size() + 1, 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    offsets_[i + 1] = offsets_[i] + nodes[order[i]]->get_neighbor_size();
+  }
+  const uint64_t edge_num = offsets_.back();
+  neighbors_.resize(edge_num);
+  neighbors_.shrink_to_fit();
+  weights_.clear();
+  if (weighted) {
+    weights_.resize(edge_num);
+    alias_prob_.resize(edge_num);
+    alias_.resize(edge_num);
+  }
+  for (size_t i = 0; i < order.size(); ++i) {
+    Node *node = nodes[order[i]];
+    uint64_t begin = offsets_[i];
+    uint32_t degree = static_cast<uint32_t>(offsets_[i + 1] - begin);
+    for (uint32_t j = 0; j < degree; ++j) {
+      neighbors_[begin + j] = node->get_neighbor_id(j);
+      if (weighted) {
+        weights_[begin + j] = static_cast<float>(node->get_neighbor_weight(j));
+      }
+    }
+    if (weighted) {
+      BuildAliasTable(begin, offsets_[i + 1]);
+    }
+  }
+}
+
+void CsrGraphShard::RestoreEdges(const std::vector<Node *> &nodes) const {
+  for (Node *node : nodes) {
+    node->build_edges(is_weighted());
+    int64_t pos = Find(node->get_id());
+    if (pos >= 0) {
+      for (uint32_t j = 0; j < Degree(pos); ++j) {
+        node->add_edge(NeighborId(pos, j), NeighborWeight(pos, j));
+      }
+    }
+    node->build_sampler("random");
+  }
+}
+
+// Vose's alias method over weights_[begin, end), alias_ holds indices
+// relative to begin.
+void CsrGraphShard::BuildAliasTable(uint64_t begin, uint64_t end) {
+  const uint32_t n = static_cast<uint32_t>(end - begin);
+  double sum = 0;
+  for (uint64_t i = begin; i < end; ++i) {
+    sum += std::max(weights_[i], 0.0f);
+  }
+  std::vector<double> scaled(n);
+  std::vector<uint32_t> small, large;
+  for (uint32_t i = 0; i < n; ++i) {
+    scaled[i] = sum > 0 ? std::max(weights_[begin + i], 0.0f) * n / sum : 1.0;
+    (scaled[i] < 1.0 ? small : large).push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    uint32_t s = small.back();
+    uint32_t l = large.back();
+    small.pop_back();
+    alias_prob_[begin + s] = static_cast<float>(scaled[s]);
+    alias_[begin + s] = l;
+    scaled[l] -= 1.0 - scaled[s];
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // leftovers are 1 up to rounding
+  for (auto *rest : {&small, &large}) {
+    for (uint32_t i : *rest) {
+      alias_prob_[begin + i] = 1.0f;
+      alias_[begin + i] = i;
+    }
+  }
+}
+
+void CsrGraphShard::BuildSlotFeatures(const std::vector<Node *> &nodes,
+                                      int slot_num) {
+  std::vector<size_t> order;
+  SortIds(nodes, &order);
+  slot_num_ = slot_num;
+  slot_offsets_.assign(nodes.size() * slot_num + 1, 0);
+  slot_feas_.clear();
+  std::vector<uint64_t> feas;
+  std::vector<uint8_t> slots;
+  for (size_t i = 0; i < order.size(); ++i) {
+    for (int s = 0; s < slot_num; ++s) {
+      feas.clear();
+      nodes[order[i]]->get_feature_ids(s, feas, slots);
+      slot_feas_.insert(slot_feas_.end(), feas.begin(), feas.end());
+      slot_offsets_[i * slot_num + s + 1] = slot_feas_.size();
+    }
+    slots.clear();
+  }
+  slot_feas_.shrink_to_fit();
+}
+
+void CsrGraphShard::RestoreSlotFeatures(
+    const std::vector<Node *> &nodes) const {
+  for (Node *node : nodes) {
+    int64_t pos = Find(node->get_id());
+    if (pos < 0) {
+      continue;
+    }
+    for (int s = 0; s < slot_num_; ++s) {
+      node->set_feature(s, GetSlotFeature(pos, s));
+    }
+  }
+}
+
+int64_t CsrGraphShard::Find(uint64_t id) const {
+  auto iter = std::lower_bound(ids_.begin(), ids_.end(), id);
+  if (iter == ids_.end() || *iter != id) {
+    return -1;
+  }
+  return iter - ids_.begin();
+}
+
+void CsrGraphShard::SampleK(int64_t pos,
+                            int k,
+                            std::mt19937_64 *rng,
+                            std::vector<uint32_t> *res) const {
+  const uint32_t degree = Degree(pos);
+  if (k <= 0 || degree == 0) {
+    return;
+  }
+  if (static_cast<uint32_t>(k) >= degree) {
+    for (uint32_t i = 0; i < degree; ++i) {
+      res->push_back(i);
+    }
+    return;
+  }
+  if (is_weighted()) {
+    SampleWeighted(pos, k, rng, res);
+  } else {
+    SampleUniform(degree, k, rng, res);
+  }
+}
+
+// Floyd's algorithm, k distinct indices in [0, degree) with k draws.
+void CsrGraphShard::SampleUniform(uint32_t degree,
+                                  int k,
+                                  std::mt19937_64 *rng,
+                                  std::vector<uint32_t> *res) const {
+  PickedSet picked(k);
+  for (uint32_t j = degree - k; j < degree; ++j) {
+    uint32_t t = std::uniform_int_distribution<uint32_t>(0, j)(*rng);
+    if (!picked.Insert(t)) {
+      // j is larger than every index picked so far
+      t = j;
+      picked.Insert(j);
+    }
+    res->push_back(t);
+  }
+}
+
+// Successive weighted draws without replacement. Small samples redraw from
+// the alias table on a repeat, larger ones (or unlucky skewed small ones)
+// take the top k of the Efraimidis-Spirakis keys u^(1/w), which yields the
+// same distribution.
+void CsrGraphShard::SampleWeighted(int64_t pos,
+                                   int k,
+                                   std::mt19937_64 *rng,
+                                   std::vector<uint32_t> *res) const {
+  const uint64_t begin = offsets_[pos];
+  const uint32_t degree = Degree(pos);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  if (2 * static_cast<uint32_t>(k) <= degree) {
+    const size_t start = res->size();
+    PickedSet picked(k);
+    int max_draws = 4 * k + 16;
+    std::uniform_int_distribution<uint32_t> column(0, degree - 1);
+    while (max_draws-- > 0 && static_cast<int>(res->size() - start) < k) {
+      uint32_t i = column(*rng);
+      if (uniform(*rng) >= alias_prob_[begin + i]) {
+        i = alias_[begin + i];
+      }
+      if (picked.Insert(i)) {
+        res->push_back(i);
+      }
+    }
+    if (static_cast<int>(res->size() - start) == k) {
+      return;
+    }
+    res->resize(start);
+  }
+  std::vector<std::pair<double, uint32_t>> keys(degree);
+  for (uint32_t i = 0; i < degree; ++i) {
+    float w = weights_[begin + i];
+    // log(u) / w orders like u^(1/w) without the underflow
+    keys[i].first = w > 0 ? std::log(1.0 - uniform(*rng)) / w
+                          : -std::numeric_limits<double>::infinity();
+    keys[i].second = i;
+  }
+  std::partial_sort(keys.begin(),
+                    keys.begin() + k,
+                    keys.end(),
+                    [](const std::pair<double, uint32_t> &a,
+                       const std::pair<double, uint32_t> &b) {
+                      return a.first > b.first;
+                    });
+  for (int i = 0; i < k; ++i) {
+    res->push_back(keys[i].second);
+  }
+}
+
+int CsrGraphShard::GetSlotFeatureIds(int64_t pos,
+                                     int slot,
+                                     std::vector<uint64_t> *feature_ids,
+                                     std::vector<uint8_t> *slot_ids) const {
+  if (slot >= slot_num_) {
+    return 0;
+  }
+  uint64_t begin = slot_offsets_[pos * slot_num_ + slot];
+  uint64_t end = slot_offsets_[pos * slot_num_ + slot + 1];
+  feature_ids->insert(
+      feature_ids->end(), slot_feas_.begin() + begin, slot_feas_.begin() + end);
+  slot_ids->insert(slot_ids->end(), end - begin, static_cast<uint8_t>(slot));
+  return static_cast<int>(end - begin);
+}
+
+std::string CsrGraphShard::GetSlotFeature(int64_t pos, int slot) const {
+  if (slot >= slot_num_) {
+    return std::string();
+  }
+  uint64_t begin = slot_offsets_[pos * slot_num_ + slot];
+  uint64_t end = slot_offsets_[pos * slot_num_ + slot + 1];
+  return std::string(reinterpret_cast<const char *>(slot_feas_.data() + begin),
+                     (end - begin) * sizeof(uint64_t));
+}
+
+size_t CsrGraphShard::MemoryBytes() const {
+  return ids_.capacity() * sizeof(uint64_t) +
+         offsets_.capacity() * sizeof(uint64_t) +
+         neighbors_.capacity() * sizeof(uint64_t) +
+         weights_.capacity() * sizeof(float) +
+         alias_prob_.capacity() * sizeof(float) +
+         alias_.capacity() * sizeof(uint32_t) +
+         slot_offsets_.capacity() * sizeof(uint64_t) +
+         slot_feas_.capacity() * sizeof(uint64_t);
+}
+
+}  // namespace paddle::distributed
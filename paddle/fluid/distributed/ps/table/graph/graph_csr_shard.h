@@ -0,0 +1,112 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+class Node;
+
+// Immutable CSR copy of a GraphShard, built once the graph is loaded.
+//
+// Nodes are sorted by id and found by binary search, the neighbors of the
+// node at pos are neighbors_[offsets_[pos], offsets_[pos + 1]). Weighted
+// shards keep the edge weights and a per-node alias table over them, so a
+// weighted draw is O(1) instead of a walk down a per-node sampler tree.
+//
+// A shard built from feature nodes instead packs their uint64 slot features
+// into one arena, slot s of the node at pos is
+// slot_feas_[slot_offsets_[pos * slot_num + s], slot_offsets_[.. + 1]).
+//
+// The source nodes release their copy once the shard is built, and get it
+// back through RestoreEdges or RestoreSlotFeatures before they change.
+class CsrGraphShard {
+ public:
+  CsrGraphShard() {}
+
+  void BuildEdges(const std::vector<Node *> &nodes, bool weighted);
+  void BuildSlotFeatures(const std::vector<Node *> &nodes, int slot_num);
+  // Adds the edges back to nodes, with a random sampler each.
+  void RestoreEdges(const std::vector<Node *> &nodes) const;
+  void RestoreSlotFeatures(const std::vector<Node *> &nodes) const;
+
+  // Position of id in the shard, -1 if absent.
+  int64_t Find(uint64_t id) const;
+  size_t size() const { return ids_.size(); }
+  bool is_weighted() const { return !weights_.empty(); }
+
+  uint32_t Degree(int64_t pos) const {
+    return static_cast<uint32_t>(offsets_[pos + 1] - offsets_[pos]);
+  }
+  uint64_t NeighborId(int64_t pos, uint32_t i) const {
+    return neighbors_[offsets_[pos] + i];
+  }
+  float NeighborWeight(int64_t pos, uint32_t i) const {
+    return weights_.empty() ? 1.0f : weights_[offsets_[pos] + i];
+  }
+
+  // Appends min(k, degree) distinct neighbor indices of the node at pos,
+  // drawn proportionally to the edge weights on weighted shards.
+  void SampleK(int64_t pos,
+               int k,
+               std::mt19937_64 *rng,
+               std::vector<uint32_t> *res) const;
+
+  // Appends the features of one slot and their slot ids, returns the count.
+  int GetSlotFeatureIds(int64_t pos,
+                        int slot,
+                        std::vector<uint64_t> *feature_ids,
+                        std::vector<uint8_t> *slot_ids) const;
+  // The features of one slot packed as FeatureNode::get_feature returns them.
+  std::string GetSlotFeature(int64_t pos, int slot) const;
+
+  // every neighbor and every slot feature of the shard, with repeats
+  const std::vector<uint64_t> &neighbors() const { return neighbors_; }
+  const std::vector<uint64_t> &slot_features() const { return slot_feas_; }
+
+  size_t MemoryBytes() const;
+
+ private:
+  void SortIds(const std::vector<Node *> &nodes, std::vector<size_t> *order);
+  void BuildAliasTable(uint64_t begin, uint64_t end);
+  void SampleUniform(uint32_t degree,
+                     int k,
+                     std::mt19937_64 *rng,
+                     std::vector<uint32_t> *res) const;
+  void SampleWeighted(int64_t pos,
+                      int k,
+                      std::mt19937_64 *rng,
+                      std::vector<uint32_t> *res) const;
+
+  std::vector<uint64_t> ids_;
+  std::vector<uint64_t> offsets_;
+  std::vector<uint64_t> neighbors_;
+  // empty on unweighted shards
+  std::vector<float> weights_;
+  std::vector<float> alias_prob_;
+  std::vector<uint32_t> alias_;
+
+  int slot_num_ = 0;
+  std::vector<uint64_t> slot_offsets_;
+  std::vector<uint64_t> slot_feas_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
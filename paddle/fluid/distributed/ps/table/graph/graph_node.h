@@ -16,6 +16,7 @@
 #ifdef PADDLE_WITH_CUDA
 #include <cuda_fp16.h>
 #endif
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -43,6 +44,10 @@ class Node {
 
   virtual void build_edges(bool is_weighted UNUSED) {}
   virtual void build_sampler(std::string sample_type UNUSED) {}
+  // frees the edges and the sampler once a CsrGraphShard holds them
+  virtual void release_edges() {}
+  // frees the first slot_num slot features once a CsrGraphShard holds them
+  virtual void release_slot_features(int slot_num UNUSED) {}
   virtual void add_edge(uint64_t id UNUSED, float weight UNUSED) {}
   virtual std::vector<int> sample_k(
       int k UNUSED, const std::shared_ptr<std::mt19937_64> rng UNUSED) {
@@ -110,7 +115,15 @@ class GraphNode : public Node {
 #else
   virtual float get_neighbor_weight(int idx) { return edges->get_weight(idx); }
 #endif
-  virtual size_t get_neighbor_size() { return edges->size(); }
+  virtual size_t get_neighbor_size() {
+    return edges == nullptr ? 0 : edges->size();
+  }
+  virtual void release_edges() {
+    delete sampler;
+    sampler = nullptr;
+    delete edges;
+    edges = nullptr;
+  }
 
  protected:
   Sampler *sampler;
@@ -230,6 +243,12 @@ class FeatureNode : public Node {
     this->feature[idx] = str;
   }
   virtual void set_feature_size(int size) { this->feature.resize(size); }
+  virtual void release_slot_features(int slot_num) {
+    int num = std::min(slot_num, static_cast<int>(this->feature.size()));
+    for (int i = 0; i < num; ++i) {
+      std::string().swap(this->feature[i]);
+    }
+  }
   virtual void set_float_feature_size(int size) {}
   virtual int get_feature_size() { return this->feature.size(); }
   virtual int get_float_feature_size() { return 0; }
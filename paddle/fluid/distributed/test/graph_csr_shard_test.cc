@@ -0,0 +1,227 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_shard.h"
+
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+
+namespace paddle::distributed {
+
+namespace {
+
+// Node i has neighbors i * 100 + j with weight j + 1 for j < degree(i).
+std::vector<std::unique_ptr<GraphNode>> MakeNodes(
+    const std::vector<std::pair<uint64_t, int>> &degrees, bool weighted) {
+  std::vector<std::unique_ptr<GraphNode>> nodes;
+  for (auto &p : degrees) {
+    nodes.emplace_back(new GraphNode(p.first));
+    nodes.back()->build_edges(weighted);
+    for (int j = 0; j < p.second; ++j) {
+      nodes.back()->add_edge(p.first * 100 + j, j + 1.0f);
+    }
+  }
+  return nodes;
+}
+
+std::vector<Node *> Raw(const std::vector<std::unique_ptr<GraphNode>> &nodes) {
+  std::vector<Node *> res;
+  for (auto &node : nodes) {
+    res.push_back(node.get());
+  }
+  return res;
+}
+
+}  // namespace
+
+TEST(CsrGraphShard, UniformSample) {
+  auto nodes = MakeNodes({{7, 3}, {2, 0}, {5, 40}}, false);
+  CsrGraphShard shard;
+  shard.BuildEdges(Raw(nodes), false);
+  ASSERT_EQ(shard.size(), 3UL);
+  EXPECT_FALSE(shard.is_weighted());
+  EXPECT_EQ(shard.Find(4), -1);
+
+  int64_t pos = shard.Find(7);
+  ASSERT_GE(pos, 0);
+  ASSERT_EQ(shard.Degree(pos), 3U);
+  EXPECT_EQ(shard.NeighborId(pos, 2), 702UL);
+  EXPECT_FLOAT_EQ(shard.NeighborWeight(pos, 2), 1.0f);
+
+  std::mt19937_64 rng(0);
+  std::vector<uint32_t> res;
+  shard.SampleK(pos, 10, &rng, &res);
+  EXPECT_EQ(res, std::vector<uint32_t>({0, 1, 2}));
+  res.clear();
+  shard.SampleK(shard.Find(2), 10, &rng, &res);
+  EXPECT_TRUE(res.empty());
+
+  pos = shard.Find(5);
+  for (int k : {1, 5, 39}) {
+    res.clear();
+    shard.SampleK(pos, k, &rng, &res);
+    ASSERT_EQ(res.size(), static_cast<size_t>(k));
+    std::set<uint32_t> unique(res.begin(), res.end());
+    EXPECT_EQ(unique.size(), res.size());
+    EXPECT_LT(*unique.rbegin(), 40U);
+  }
+}
+
+TEST(CsrGraphShard, WeightedSample) {
+  auto nodes = MakeNodes({{1, 4}, {3, 64}}, true);
+  CsrGraphShard shard;
+  shard.BuildEdges(Raw(nodes), true);
+  ASSERT_TRUE(shard.is_weighted());
+
+  // weights 1 2 3 4, one draw per sample
+  int64_t pos = shard.Find(1);
+  EXPECT_FLOAT_EQ(shard.NeighborWeight(pos, 3), 4.0f);
+  std::mt19937_64 rng(0);
+  std::vector<int> count(4, 0);
+  const int trials = 100000;
+  std::vector<uint32_t> res;
+  for (int i = 0; i < trials; ++i) {
+    res.clear();
+    shard.SampleK(pos, 1, &rng, &res);
+    count[res[0]]++;
+  }
+  for (int j = 0; j < 4; ++j) {
+    EXPECT_NEAR(count[j] / static_cast<double>(trials), (j + 1) / 10.0, 0.01);
+  }
+
+  // both the alias path and the key path return distinct neighbors
+  pos = shard.Find(3);
+  for (int k : {8, 48}) {
+    res.clear();
+    shard.SampleK(pos, k, &rng, &res);
+    ASSERT_EQ(res.size(), static_cast<size_t>(k));
+    std::set<uint32_t> unique(res.begin(), res.end());
+    EXPECT_EQ(unique.size(), res.size());
+  }
+}
+
+TEST(CsrGraphShard, SlotFeatures) {
+  std::vector<std::unique_ptr<FeatureNode>> nodes;
+  std::vector<Node *> raw;
+  for (uint64_t id : {9, 4}) {
+    nodes.emplace_back(new FeatureNode(id));
+    nodes.back()->set_feature_size(2);
+    std::vector<uint64_t> slot0 = {id, id + 1};
+    nodes.back()->set_feature(
+        0,
+        std::string(reinterpret_cast<const char *>(slot0.data()),
+                    slot0.size() * sizeof(uint64_t)));
+    raw.push_back(nodes.back().get());
+  }
+  CsrGraphShard shard;
+  shard.BuildSlotFeatures(raw, 3);
+
+  std::vector<uint64_t> feas;
+  std::vector<uint8_t> slots;
+  int64_t pos = shard.Find(9);
+  EXPECT_EQ(shard.GetSlotFeatureIds(pos, 0, &feas, &slots), 2);
+  EXPECT_EQ(shard.GetSlotFeatureIds(pos, 1, &feas, &slots), 0);
+  EXPECT_EQ(shard.GetSlotFeatureIds(pos, 5, &feas, &slots), 0);
+  EXPECT_EQ(feas, std::vector<uint64_t>({9, 10}));
+  EXPECT_EQ(slots, std::vector<uint8_t>({0, 0}));
+}
+
+// The nodes free their edges and features once the shard holds them, and
+// get them back before the graph changes.
+TEST(CsrGraphShard, ReleaseAndRestore) {
+  auto nodes = MakeNodes({{7, 3}, {2, 0}, {5, 40}}, true);
+  CsrGraphShard shard;
+  shard.BuildEdges(Raw(nodes), true);
+  for (auto &node : nodes) {
+    node->release_edges();
+    EXPECT_EQ(node->get_neighbor_size(), 0UL);
+  }
+  shard.RestoreEdges(Raw(nodes));
+  ASSERT_EQ(nodes[2]->get_neighbor_size(), 40UL);
+  EXPECT_EQ(nodes[0]->get_neighbor_size(), 3UL);
+  EXPECT_EQ(nodes[1]->get_neighbor_size(), 0UL);
+  EXPECT_EQ(nodes[2]->get_neighbor_id(39), 539UL);
+  EXPECT_FLOAT_EQ(static_cast<float>(nodes[2]->get_neighbor_weight(39)), 40);
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  EXPECT_EQ(nodes[2]->sample_k(5, rng).size(), 5UL);
+
+  FeatureNode feature_node(9);
+  feature_node.set_feature_size(2);
+  std::vector<uint64_t> slot1 = {3, 1, 4};
+  const std::string packed(reinterpret_cast<const char *>(slot1.data()),
+                           slot1.size() * sizeof(uint64_t));
+  feature_node.set_feature(1, packed);
+  std::vector<Node *> raw = {&feature_node};
+  CsrGraphShard feature_shard;
+  feature_shard.BuildSlotFeatures(raw, 2);
+  feature_node.release_slot_features(2);
+  EXPECT_TRUE(feature_node.get_feature(1).empty());
+  EXPECT_EQ(feature_shard.GetSlotFeature(0, 1), packed);
+  EXPECT_EQ(feature_shard.slot_features(), slot1);
+  feature_shard.RestoreSlotFeatures(raw);
+  EXPECT_EQ(feature_node.get_feature(1), packed);
+}
+
+// Sampling throughput against the per-node samplers, logged rather than
+// asserted on.
+TEST(CsrGraphShard, SampleThroughput) {
+  std::vector<std::pair<uint64_t, int>> degrees;
+  for (uint64_t id = 0; id < 20000; ++id) {
+    degrees.emplace_back(id, 1 + id % 200);
+  }
+  auto nodes = MakeNodes(degrees, false);
+  for (auto &node : nodes) {
+    node->build_sampler("random");
+  }
+  CsrGraphShard shard;
+  shard.BuildEdges(Raw(nodes), false);
+
+  auto rng = std::make_shared<std::mt19937_64>(0);
+  const int sample_size = 10;
+  uint64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto &node : nodes) {
+    for (int x : node->sample_k(sample_size, rng)) {
+      checksum += node->get_neighbor_id(x);
+    }
+  }
+  auto node_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::vector<uint32_t> res;
+  start = std::chrono::steady_clock::now();
+  for (auto &node : nodes) {
+    int64_t pos = shard.Find(node->get_id());
+    res.clear();
+    shard.SampleK(pos, sample_size, rng.get(), &res);
+    for (uint32_t x : res) {
+      checksum += shard.NeighborId(pos, x);
+    }
+  }
+  auto csr_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  LOG(INFO) << "sample " << nodes.size() << " nodes: per-node samplers "
+            << node_us << " us, csr " << csr_us << " us, csr bytes "
+            << shard.MemoryBytes() << ", checksum " << checksum;
+}
+
+}  // namespace paddle::distributed
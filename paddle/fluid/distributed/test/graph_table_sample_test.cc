@@ -83,3 +83,51 @@ void testGraphSample() {
 }
 
 TEST(testGraphSample, Run) { testGraphSample(); }
+
+uint32_t CsrDegree(distributed::GraphTable *graph_table, uint64_t id) {
+  auto shards = graph_table->get_csr_edge_shards(0);
+  EXPECT_NE(shards, nullptr);
+  if (shards == nullptr) return 0;
+  int64_t pos = -1;
+  auto *shard = graph_table->find_csr_shard(*shards, id, &pos);
+  return shard == nullptr ? 0 : shard->Degree(pos);
+}
+
+// A second load appends to the edges packed into the CSR shards by the
+// first one.
+TEST(testGraphSample, CsrShardLoadTwice) {
+  ::paddle::distributed::GraphParameter graph;
+  graph.set_task_pool_size(4);
+  graph.set_shard_num(8);
+  graph.set_use_csr_shard(true);
+  graph.add_edge_types("u2i");
+  graph.add_node_types("user");
+  graph.add_graph_feature();
+  distributed::GraphTable graph_table;
+  graph_table.Initialize(graph);
+
+  char first_file[] = "csr_edges_first.txt";    // NOLINT
+  char second_file[] = "csr_edges_second.txt";  // NOLINT
+  prepare_file(first_file,
+               std::vector<std::string>(edges.begin(), edges.begin() + 6));
+  ASSERT_EQ(graph_table.load_edges(first_file, false, "u2i"), 0);
+  EXPECT_EQ(CsrDegree(&graph_table, 37), 3u);
+  EXPECT_EQ(CsrDegree(&graph_table, 96), 3u);
+
+  prepare_file(second_file, {"37\t46\t0.5", "59\t45\t0.34"});
+  ASSERT_EQ(graph_table.load_edges(second_file, false, "u2i"), 0);
+  EXPECT_EQ(CsrDegree(&graph_table, 37), 4u);
+  EXPECT_EQ(CsrDegree(&graph_table, 96), 3u);
+  EXPECT_EQ(CsrDegree(&graph_table, 59), 1u);
+
+  // the nodes read by the partition and stat paths see the same degrees
+  graph_table.restore_csr_edge_shards();
+  EXPECT_EQ(graph_table.get_csr_edge_shards(0), nullptr);
+  auto *node =
+      graph_table.find_node(distributed::GraphTableType::EDGE_TABLE, 0, 37);
+  ASSERT_NE(node, nullptr);
+  EXPECT_EQ(node->get_neighbor_size(), 4u);
+  node = graph_table.find_node(distributed::GraphTableType::EDGE_TABLE, 0, 96);
+  ASSERT_NE(node, nullptr);
+  EXPECT_EQ(node->get_neighbor_size(), 3u);
+}
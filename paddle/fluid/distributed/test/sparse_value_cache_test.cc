@@ -0,0 +1,122 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_value_cache.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle::distributed {
+
+namespace {
+
+constexpr size_t kDim = 4;
+
+SparseValueCacheConfig MakeConfig(size_t capacity) {
+  SparseValueCacheConfig config;
+  config.capacity = capacity;
+  config.value_size = kDim * sizeof(float);
+  return config;
+}
+
+// Pulls keys through the cache, the misses are "pulled" as key + 0.5.
+std::vector<size_t> Pull(SparseValueCache* cache,
+                         const std::vector<uint64_t>& keys,
+                         std::vector<std::vector<float>>* values) {
+  uint64_t step = cache->NextStep();
+  values->assign(keys.size(), std::vector<float>(kDim, 0));
+  std::vector<float*> ptrs;
+  for (auto& value : *values) {
+    ptrs.push_back(value.data());
+  }
+  std::vector<size_t> miss_index;
+  cache->Lookup(step, keys.data(), ptrs.data(), keys.size(), &miss_index);
+  for (auto idx : miss_index) {
+    std::vector<float> pulled(kDim, keys[idx] + 0.5f);
+    (*values)[idx] = pulled;
+    cache->Insert(step, keys[idx], pulled.data());
+  }
+  return miss_index;
+}
+
+}  // namespace
+
+TEST(SparseValueCache, HitAndStaleness) {
+  auto config = MakeConfig(64);
+  config.max_staleness_steps = 2;
+  SparseValueCache cache(config);
+  std::vector<std::vector<float>> values;
+
+  EXPECT_EQ(Pull(&cache, {1, 2, 3}, &values).size(), 3UL);
+  // fetched at step 1, fresh at steps 2 and 3
+  EXPECT_TRUE(Pull(&cache, {1, 2}, &values).empty());
+  ASSERT_FLOAT_EQ(values[0][0], 1.5);
+  ASSERT_FLOAT_EQ(values[1][kDim - 1], 2.5);
+  EXPECT_TRUE(Pull(&cache, {3}, &values).empty());
+  // step 4 is beyond the bound
+  auto misses = Pull(&cache, {1, 4}, &values);
+  ASSERT_EQ(misses.size(), 2UL);
+
+  auto stats = cache.Stats();
+  EXPECT_EQ(stats.hits, 3UL);
+  EXPECT_EQ(stats.misses, 5UL);
+  EXPECT_EQ(stats.stale, 1UL);
+  EXPECT_DOUBLE_EQ(stats.HitRate(), 3.0 / 8.0);
+}
+
+TEST(SparseValueCache, PushInvalidation) {
+  auto config = MakeConfig(64);
+  config.max_staleness_steps = 100;
+  config.push_limit = 2;
+  SparseValueCache cache(config);
+  std::vector<std::vector<float>> values;
+
+  Pull(&cache, {7, 8}, &values);
+  uint64_t pushed[] = {7};
+  cache.OnPush(pushed, 1);
+  EXPECT_TRUE(Pull(&cache, {7, 8}, &values).empty());
+  cache.OnPush(pushed, 1);
+  auto misses = Pull(&cache, {7, 8}, &values);
+  ASSERT_EQ(misses.size(), 1UL);
+  EXPECT_EQ(misses[0], 0UL);
+  EXPECT_EQ(cache.Stats().push_invalidations, 1UL);
+}
+
+TEST(SparseValueCache, Eviction) {
+  // 16 shards of one entry, keys 0 and 16 share a shard
+  auto config = MakeConfig(16);
+  config.max_staleness_steps = 100;
+  SparseValueCache lru(config);
+  std::vector<std::vector<float>> values;
+  Pull(&lru, {0}, &values);
+  Pull(&lru, {16}, &values);
+  EXPECT_EQ(Pull(&lru, {0}, &values).size(), 1UL);
+  EXPECT_EQ(lru.Stats().evictions, 2UL);
+
+  config.capacity = 32;
+  config.eviction = SparseCacheEviction::kLFU;
+  SparseValueCache lfu(config);
+  Pull(&lfu, {0, 16}, &values);
+  for (int i = 0; i < 3; ++i) {
+    Pull(&lfu, {0}, &values);
+  }
+  Pull(&lfu, {16}, &values);
+  // 16 is the most recent but the least frequent
+  Pull(&lfu, {32}, &values);
+  EXPECT_TRUE(Pull(&lfu, {0}, &values).empty());
+  EXPECT_EQ(Pull(&lfu, {16}, &values).size(), 1UL);
+}
+
+}  // namespace paddle::distributed
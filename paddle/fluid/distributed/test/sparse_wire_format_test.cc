@@ -0,0 +1,219 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/service/sparse_wire_format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/ctr_accessor.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+namespace paddle::distributed {
+
+TEST(SparseWireFormat, SerializeAndParse) {
+  SparseWireFormat wire;
+  EXPECT_TRUE(wire.IsRaw());
+  wire.delta_keys = true;
+  ASSERT_TRUE(SparseWireFormat::ParseValueCodec("bf16", &wire.value_codec));
+  wire.compress_threshold = 4096;
+  wire.stat_dim = 2;
+  EXPECT_FALSE(wire.IsRaw());
+
+  SparseWireFormat parsed;
+  ASSERT_TRUE(SparseWireFormat::Parse(wire.Serialize(), &parsed));
+  EXPECT_TRUE(parsed.delta_keys);
+  EXPECT_EQ(parsed.value_codec, SparseValueCodec::kBF16);
+  EXPECT_EQ(parsed.compress_threshold, 4096U);
+  EXPECT_EQ(parsed.stat_dim, 2U);
+  // without stat_dim, as sent by older clients
+  ASSERT_TRUE(SparseWireFormat::Parse(
+      wire.Serialize().substr(0, 3 * sizeof(uint32_t)), &parsed));
+  EXPECT_EQ(parsed.stat_dim, 0U);
+  EXPECT_FALSE(SparseWireFormat::Parse("bad", &parsed));
+  EXPECT_FALSE(SparseWireFormat::ParseValueCodec("fp8", &wire.value_codec));
+}
+
+TEST(SparseWireFormat, Keys) {
+  // sorted keys, unsorted keys and the extremes
+  std::vector<uint64_t> keys = {1, 5, 6, 1000, UINT64_MAX, 0, 42, 41};
+  std::vector<uint32_t> counts = {1, 2, 300, 70000, 1, 1, 5, 9};
+  std::string encoded;
+  EncodeSparseKeys(keys.data(), keys.size(), &encoded);
+  size_t key_bytes = encoded.size();
+  EncodeVarints(counts.data(), counts.size(), &encoded);
+
+  std::vector<uint64_t> decoded_keys(keys.size());
+  std::vector<uint32_t> decoded_counts(counts.size());
+  ASSERT_EQ(DecodeSparseKeys(encoded.data(),
+                             encoded.size(),
+                             keys.size(),
+                             decoded_keys.data()),
+            key_bytes);
+  ASSERT_GT(DecodeVarints(encoded.data() + key_bytes,
+                          encoded.size() - key_bytes,
+                          counts.size(),
+                          decoded_counts.data()),
+            0UL);
+  EXPECT_EQ(decoded_keys, keys);
+  EXPECT_EQ(decoded_counts, counts);
+  // truncated input
+  EXPECT_EQ(DecodeSparseKeys(encoded.data(), 3, keys.size(), keys.data()),
+            0UL);
+}
+
+TEST(SparseWireFormat, Values) {
+  const size_t num = 16;
+  const size_t dim = 11;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> values(num * dim);
+  for (auto &v : values) {
+    v = dist(rng);
+  }
+  struct Case {
+    SparseValueCodec codec;
+    float tolerance;
+  };
+  for (auto c : {Case{SparseValueCodec::kFP32, 0.0f},
+                 Case{SparseValueCodec::kFP16, 1e-3f},
+                 Case{SparseValueCodec::kBF16, 1e-2f},
+                 Case{SparseValueCodec::kINT8, 1.0f / 127}}) {
+    std::string encoded;
+    EncodeSparseValues(c.codec, values.data(), num, dim, &encoded);
+    const size_t row_bytes = EncodedValueBytes(c.codec, dim);
+    ASSERT_EQ(encoded.size(), num * row_bytes);
+    std::vector<float> row(dim);
+    for (size_t i = 0; i < num; ++i) {
+      DecodeSparseValueRow(
+          c.codec, encoded.data() + i * row_bytes, dim, row.data());
+      for (size_t j = 0; j < dim; ++j) {
+        EXPECT_NEAR(row[j], values[i * dim + j], c.tolerance);
+      }
+    }
+  }
+}
+
+// A pulled CtrCommonAccessor row |show|click|embed_w|embedx|: the large
+// counters come back exact, read from an unaligned offset as they are after
+// the varint keys, and do not take the int8 scale of the embedding.
+TEST(SparseWireFormat, CtrCommonPullValue) {
+  TableAccessorParameter param;
+  param.set_accessor_class("CtrCommonAccessor");
+  param.set_fea_dim(11);
+  param.set_embedx_dim(8);
+  param.mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  param.mutable_embed_sgd_param()->mutable_naive()->set_initial_range(0.3);
+  param.mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  param.mutable_embedx_sgd_param()->mutable_naive()->set_initial_range(0.3);
+  CtrCommonAccessor accessor;
+  ASSERT_EQ(accessor.Configure(param), 0);
+  ASSERT_EQ(accessor.Initialize(), 0);
+  const size_t stat_dim = accessor.GetPullStatDim();
+  ASSERT_EQ(stat_dim, 2UL);
+
+  const size_t num = 4;
+  const size_t dim = accessor.GetAccessorInfo().select_dim;
+  const size_t value_dim = accessor.GetAccessorInfo().dim;
+  std::vector<float> values(num * value_dim);
+  std::vector<float *> value_ptrs, select_ptrs;
+  std::vector<float> pulled(num * dim);
+  for (size_t i = 0; i < num; ++i) {
+    value_ptrs.push_back(values.data() + i * value_dim);
+    select_ptrs.push_back(pulled.data() + i * dim);
+  }
+  ASSERT_EQ(accessor.Create(value_ptrs.data(), num), 0);
+  auto &feature = accessor.common_feature_value;
+  for (size_t i = 0; i < num; ++i) {
+    feature.Show(value_ptrs[i]) = 3e6f + static_cast<float>(i) * 7;
+    feature.Click(value_ptrs[i]) = 123457.0f;
+    feature.EmbedW(value_ptrs[i]) = 0.25f;
+  }
+  auto **const_values = const_cast<const float **>(value_ptrs.data());
+  ASSERT_EQ(accessor.Select(select_ptrs.data(), const_values, num), 0);
+
+  struct Case {
+    SparseValueCodec codec;
+    float tolerance;
+  };
+  for (auto c : {Case{SparseValueCodec::kFP16, 1e-3f},
+                 Case{SparseValueCodec::kBF16, 1e-2f},
+                 Case{SparseValueCodec::kINT8, 0.3f / 127}}) {
+    std::string encoded(1, '\0');
+    EncodeSparseValues(c.codec, pulled.data(), num, dim, &encoded, stat_dim);
+    const size_t row_bytes = EncodedValueBytes(c.codec, dim, stat_dim);
+    ASSERT_EQ(encoded.size(), 1 + num * row_bytes);
+    std::vector<float> row(dim);
+    for (size_t i = 0; i < num; ++i) {
+      DecodeSparseValueRow(c.codec,
+                           encoded.data() + 1 + i * row_bytes,
+                           dim,
+                           row.data(),
+                           stat_dim);
+      const float *expected = select_ptrs[i];
+      EXPECT_EQ(CtrCommonAccessor::CtrCommonPullValue::Show(row.data()),
+                3e6f + static_cast<float>(i) * 7);
+      EXPECT_EQ(CtrCommonAccessor::CtrCommonPullValue::Click(row.data()),
+                123457.0f);
+      for (size_t j = stat_dim; j < dim; ++j) {
+        EXPECT_NEAR(row[j], expected[j], c.tolerance)
+            << "codec " << static_cast<int>(c.codec) << ", column " << j;
+      }
+    }
+  }
+}
+
+// Wire bytes of a pull of a batch of sorted hot keys in each format, the
+// numbers are logged for comparison rather than asserted on.
+TEST(SparseWireFormat, PullBandwidth) {
+  const size_t num = 100000;
+  const size_t dim = 11;
+  std::mt19937_64 rng(0);
+  std::vector<uint64_t> keys(num);
+  for (auto &key : keys) {
+    key = rng() % (num * 64);
+  }
+  std::sort(keys.begin(), keys.end());
+  std::vector<uint32_t> counts(num, 1);
+  std::vector<float> values(num * dim, 0.5f);
+
+  const size_t raw_bytes = num * (sizeof(uint64_t) + sizeof(uint32_t)) +
+                           num * dim * sizeof(float);
+  for (auto codec : {SparseValueCodec::kFP32,
+                     SparseValueCodec::kFP16,
+                     SparseValueCodec::kBF16,
+                     SparseValueCodec::kINT8}) {
+    auto start = std::chrono::steady_clock::now();
+    std::string request;
+    EncodeSparseKeys(keys.data(), num, &request);
+    EncodeVarints(counts.data(), num, &request);
+    std::string response;
+    EncodeSparseValues(codec, values.data(), num, dim, &response);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    size_t bytes = request.size() + response.size();
+    LOG(INFO) << "codec " << static_cast<int>(codec) << ": " << bytes
+              << " bytes, raw " << raw_bytes << " bytes, encode " << elapsed
+              << " us";
+    EXPECT_LT(bytes, raw_bytes);
+  }
+}
+
+}  // namespace paddle::distributed
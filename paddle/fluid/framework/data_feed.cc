@@ -257,8 +257,16 @@ void DataFeed::CheckStart() {
 
 void DataFeed::AssignFeedVar(const Scope& scope) {
   CheckInit();
+  // the slots are fixed after init, intern their names once
+  if (use_slot_ids_.size() != use_slots_.size()) {
+    use_slot_ids_.clear();
+    for (auto& slot : use_slots_) {
+      use_slot_ids_.push_back(Scope::InternVarName(slot));
+    }
+  }
   for (size_t i = 0; i < use_slots_.size(); ++i) {
-    feed_vec_[i] = scope.FindVar(use_slots_[i])->GetMutable<phi::DenseTensor>();
+    feed_vec_[i] =
+        scope.FindVar(use_slot_ids_[i])->GetMutable<phi::DenseTensor>();
   }
 }
 
@@ -2542,9 +2550,15 @@ void SlotRecordInMemoryDataFeed::AssignFeedVar(const Scope& scope) {
         scope.FindVar(used_slots_info_[i].slot)->GetMutable<phi::DenseTensor>();
   }
 #else
+  if (use_slot_ids_.size() != static_cast<size_t>(use_slot_size_)) {
+    use_slot_ids_.clear();
+    for (int i = 0; i < use_slot_size_; ++i) {
+      use_slot_ids_.push_back(Scope::InternVarName(used_slots_info_[i].slot));
+    }
+  }
   for (int i = 0; i < use_slot_size_; ++i) {
     feed_vec_[i] =
-        scope.FindVar(used_slots_info_[i].slot)->GetMutable<phi::DenseTensor>();
+        scope.FindVar(use_slot_ids_[i])->GetMutable<phi::DenseTensor>();
   }
 #endif
 }
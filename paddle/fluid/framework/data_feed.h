@@ -39,6 +39,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/reader.h"
+#include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/platform/timer.h"
 #include "paddle/utils/string/string_helper.h"
@@ -1371,6 +1372,8 @@ class DataFeed {
   // the alias of used slots, and its order is determined by
   // data_feed_desc(proto object)
   std::vector<std::string> use_slots_;
+  // the interned names of the used slots, resolved by AssignFeedVar
+  std::vector<VarNameId> use_slot_ids_;
   std::vector<bool> use_slots_is_dense_;
 
   // the alias of all slots, and its order is determined by data_feed_desc(proto
@@ -25,6 +25,7 @@
 #include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
+#include "paddle/phi/kernels/funcs/hash_unique_cpu.h"
 
 #ifdef PADDLE_WITH_PSCORE
 #include "paddle/fluid/distributed/ps/wrapper/fleet.h"
@@ -1476,6 +1477,20 @@ void MultiSlotDataset::GenerateLocalTablesUnlock(int table_id,
       }
     }
 
+    // deduplicate here, in parallel over the read threads, so the single
+    // consume thread of a shard only probes its table once per feasign
+    for (int shard_id = 0; shard_id < shard_num; shard_id++) {
+      std::vector<uint64_t> unique_keys;
+      phi::funcs::HashUniqueCPU<uint64_t, int64_t>(
+          task_keys[shard_id].data(),
+          static_cast<int64_t>(task_keys[shard_id].size()),
+          phi::funcs::HashUniqueOrder::kAny,
+          &unique_keys,
+          nullptr,
+          nullptr,
+          nullptr);
+      task_keys[shard_id].swap(unique_keys);
+    }
     for (int shard_id = 0; shard_id < shard_num; shard_id++) {
       task_futures.emplace_back(consume_task_pool_[shard_id]->enqueue(
           consume_func, shard_id, feadim, task_keys[shard_id]));
@@ -98,6 +98,9 @@ class NaiveExecutor {
   void RegisterOutputHook(const PirHookFunc& hookfunc);
   void RegisterInputHook(const PirHookFunc& hookfunc);
 
+  const std::vector<HookFunc>& OutputHooks() const { return output_hookfuncs_; }
+  const std::vector<HookFunc>& InputHooks() const { return input_hookfuncs_; }
+
  private:
   void CreateOps(const ProgramDesc& desc, int block_id);
 
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/instruction/phi_kernel_instruction.h"
 
+#include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/new_executor/interpreter/interpreter_util.h"
 #include "paddle/fluid/framework/new_executor/interpreter/stream_analyzer.h"
 #include "paddle/fluid/framework/new_executor/pir_adaptor/pir_adaptor_util.h"
@@ -24,6 +25,8 @@
 #include "paddle/fluid/pir/dialect/operator/utils/op_yaml_info_parser.h"
 #include "paddle/fluid/platform/collective_helper.h"
 #include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/profiler/perf_counter.h"
+#include "paddle/fluid/platform/profiler/supplement_tracing.h"
 #include "paddle/phi/core/infermeta_utils.h"
 #include "paddle/phi/core/meta_tensor.h"
 #include "paddle/phi/core/type_defs.h"
@@ -33,9 +36,66 @@
 #include "paddle/pir/include/core/value.h"
 
 #include "paddle/fluid/framework/new_executor/instruction/instruction_util.h"
+
+COMMON_DECLARE_bool(enable_host_event_recorder_hook);
+
 namespace paddle {
 namespace framework {
 
+namespace {
+
+// Keep the scalar and integer array attributes, enough for the FLOPs
+// estimation in paddle.utils.flops.
+AttributeMap ToProfileAttributes(
+    const std::unordered_map<std::string, pir::Attribute>& attributes) {
+  AttributeMap attrs;
+  for (auto& item : attributes) {
+    const pir::Attribute& val = item.second;
+    if (val.isa<pir::BoolAttribute>()) {
+      attrs[item.first] = val.dyn_cast<pir::BoolAttribute>().data();
+    } else if (val.isa<pir::Int32Attribute>()) {
+      attrs[item.first] = val.dyn_cast<pir::Int32Attribute>().data();
+    } else if (val.isa<pir::Int64Attribute>()) {
+      attrs[item.first] = val.dyn_cast<pir::Int64Attribute>().data();
+    } else if (val.isa<pir::FloatAttribute>()) {
+      attrs[item.first] = val.dyn_cast<pir::FloatAttribute>().data();
+    } else if (val.isa<pir::DoubleAttribute>()) {
+      attrs[item.first] = val.dyn_cast<pir::DoubleAttribute>().data();
+    } else if (val.isa<pir::ArrayAttribute>()) {
+      auto array_list = val.dyn_cast<pir::ArrayAttribute>().AsVector();
+      if (array_list.empty()) {
+        continue;
+      }
+      if (array_list[0].isa<pir::Int32Attribute>()) {
+        std::vector<int> vec_int;
+        for (auto attribute : array_list) {
+          vec_int.push_back(attribute.dyn_cast<pir::Int32Attribute>().data());
+        }
+        attrs[item.first] = vec_int;
+      } else if (array_list[0].isa<pir::Int64Attribute>()) {
+        std::vector<int64_t> vec_int64;
+        for (auto attribute : array_list) {
+          vec_int64.push_back(
+              attribute.dyn_cast<pir::Int64Attribute>().data());  // NOLINT
+        }
+        attrs[item.first] = vec_int64;
+      }
+    }
+  }
+  return attrs;
+}
+
+uint64_t TensorBytes(const phi::TensorBase* tensor) {
+  if (tensor == nullptr || tensor->dtype() == phi::DataType::UNDEFINED ||
+      tensor->numel() <= 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(tensor->numel()) *
+         phi::SizeOf(tensor->dtype());
+}
+
+}  // namespace
+
 PhiKernelInstruction::PhiKernelInstruction(
     size_t id,
     const platform::Place& place,
@@ -117,6 +177,9 @@ PhiKernelInstruction::PhiKernelInstruction(
       paddle::dialect::IsLegacyOp(op_name));
   VLOG(6) << "finish process yaml_info_parser";
 
+  kernel_input_names_ = yaml_info_parser.TensorParams(true);
+  profile_attrs_ = ToProfileAttributes(op_attributes);
+
   if (infer_meta_interface_) {
     BuildPhiContext<
         phi::InferMetaContext,
@@ -182,9 +245,43 @@ void PhiKernelInstruction::Run() {
   }
   VLOG(6) << "End run op " << phi_op_name_ << " infer meta.";
   VLOG(6) << "Begin run op " << phi_op_name_ << " kernel.";
+  const bool record_op_info = FLAGS_enable_host_event_recorder_hook &&
+                              platform::RecordOpInfoSupplement::IsEnabled();
+  platform::KernelCounterScope kernel_counters(record_op_info);
   (*(phi_kernel_))(&(kernel_context_));
+  if (record_op_info) {
+    platform::KernelCost counters;
+    kernel_counters.Stop(&counters);
+    RecordOpInfo(counters);
+  }
   VLOG(6) << "End run op " << phi_op_name_ << " kernel.";
 }
 
+void PhiKernelInstruction::RecordOpInfo(const platform::KernelCost& counters) {
+  std::map<std::string, std::vector<DDim>> input_shapes;
+  std::map<std::string, std::vector<proto::VarType::Type>> dtypes;
+  for (size_t i = 0; i < kernel_input_names_.size(); ++i) {
+    const auto& range = kernel_context_.InputRangeAt(i);
+    for (int j = range.first; j < range.second; ++j) {
+      const phi::TensorBase* input = kernel_context_.MutableIutputAt(j);
+      if (input == nullptr || input->dtype() == phi::DataType::UNDEFINED) {
+        continue;
+      }
+      input_shapes[kernel_input_names_[i]].push_back(input->dims());
+      dtypes[kernel_input_names_[i]].push_back(
+          TransToProtoVarType(input->dtype()));
+    }
+  }
+  platform::KernelCost cost = counters;
+  for (size_t i = 0; i < kernel_context_.InputsSize(); ++i) {
+    cost.bytes += TensorBytes(kernel_context_.MutableIutputAt(i));
+  }
+  for (size_t i = 0; i < kernel_context_.OutputsSize(); ++i) {
+    cost.bytes += TensorBytes(kernel_context_.MutableOutputAt(i));
+  }
+  platform::RecordOpInfoSupplement(
+      phi_op_name_, profile_attrs_, input_shapes, dtypes, cost);
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -15,6 +15,8 @@
 #pragma once
 
 #include "paddle/fluid/framework/new_executor/instruction/instruction_base.h"
+#include "paddle/fluid/framework/type_defs.h"
+#include "paddle/fluid/platform/profiler/trace_event.h"
 
 namespace pir {
 class Operation;
@@ -53,6 +55,10 @@ class PhiKernelInstruction : public InstructionBase {
   const std::string& Name() const override { return phi_op_name_; }
 
  private:
+  // Record the shapes, the bytes moved and the hardware counters of the
+  // kernel for the profiler.
+  void RecordOpInfo(const platform::KernelCost& counters);
+
   paddle::dialect::InferMetaInterface::Concept* infer_meta_interface_{
       nullptr};  // not owned
 
@@ -64,6 +70,12 @@ class PhiKernelInstruction : public InstructionBase {
 
   std::string phi_op_name_;
 
+  // names of the kernel inputs, in the order of kernel_context_
+  std::vector<std::string> kernel_input_names_;
+
+  // op attributes readable by the FLOPs estimation of the profiler
+  AttributeMap profile_attrs_;
+
   ::pir::Operation* op_{nullptr};  // not owned
 
   const ValueExecutionInfo* value_exec_info_;  // not owned
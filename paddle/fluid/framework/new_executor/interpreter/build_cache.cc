@@ -0,0 +1,213 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/build_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#include "glog/logging.h"
+
+namespace paddle::framework::interpreter {
+
+namespace {
+
+// "PDEXBLD" and the format version in the last byte
+constexpr uint64_t kBuildCacheMagic = 0x50444558424C4401ULL;
+constexpr uint64_t kMaxOpNum = uint64_t{1} << 24;
+
+class CacheWriter {
+ public:
+  explicit CacheWriter(std::ofstream* out) : out_(out) {}
+
+  void Write(uint64_t value) {
+    out_->write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void WriteSet(const std::set<size_t>& values) {
+    Write(values.size());
+    for (auto value : values) Write(value);
+  }
+
+  void WriteMap(const std::map<size_t, std::set<size_t>>& map) {
+    Write(map.size());
+    for (auto& item : map) {
+      Write(item.first);
+      WriteSet(item.second);
+    }
+  }
+
+ private:
+  std::ofstream* out_;
+};
+
+class CacheReader {
+ public:
+  explicit CacheReader(std::ifstream* in) : in_(in) {}
+
+  bool Read(uint64_t* value) {
+    in_->read(reinterpret_cast<char*>(value), sizeof(*value));
+    return static_cast<bool>(*in_);
+  }
+
+  // a size that is larger than the ops or vars can be is a broken file
+  bool ReadSize(size_t limit, size_t* size) {
+    uint64_t value = 0;
+    if (!Read(&value) || value > limit) return false;
+    *size = static_cast<size_t>(value);
+    return true;
+  }
+
+  // an index into limit ops or vars, so at most limit - 1
+  bool ReadIndex(size_t limit, size_t* index) {
+    uint64_t value = 0;
+    if (!Read(&value) || value >= limit) return false;
+    *index = static_cast<size_t>(value);
+    return true;
+  }
+
+  bool ReadSet(size_t limit, std::set<size_t>* values) {
+    size_t num = 0;
+    if (!ReadSize(limit, &num)) return false;
+    for (size_t i = 0; i < num; ++i) {
+      size_t value = 0;
+      if (!ReadIndex(limit, &value)) return false;
+      values->insert(value);
+    }
+    return true;
+  }
+
+  bool ReadMap(size_t limit, std::map<size_t, std::set<size_t>>* map) {
+    size_t num = 0;
+    if (!ReadSize(limit, &num)) return false;
+    for (size_t i = 0; i < num; ++i) {
+      size_t key = 0;
+      if (!ReadIndex(limit, &key) || !ReadSet(limit, &(*map)[key])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::ifstream* in_;
+};
+
+}  // namespace
+
+void BuildSignatureHasher::Update(const void* data, size_t size) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    value_ ^= bytes[i];
+    value_ *= 1099511628211ULL;
+  }
+}
+
+void BuildSignatureHasher::Update(const std::string& str) {
+  Update(static_cast<uint64_t>(str.size()));
+  Update(str.data(), str.size());
+}
+
+bool ProgramBuildCache::Save(const std::string& path) const {
+  const std::string tmp_path =
+      path + ".tmp" + std::to_string(std::random_device()());
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      LOG(WARNING) << "Cannot write the executor build cache " << tmp_path;
+      return false;
+    }
+    CacheWriter writer(&out);
+    writer.Write(kBuildCacheMagic);
+    writer.Write(signature);
+    writer.Write(op_num);
+    writer.WriteMap(op_downstream_map);
+    // op_num x op_num bits, packed by 64
+    for (auto& row : op_happens_before) {
+      for (size_t begin = 0; begin < op_num; begin += 64) {
+        uint64_t bits = 0;
+        for (size_t j = begin; j < std::min(begin + 64, op_num); ++j) {
+          if (row[j]) bits |= uint64_t{1} << (j - begin);
+        }
+        writer.Write(bits);
+      }
+    }
+    writer.WriteMap(last_live_ops);
+    writer.Write(inplace_pairs.size());
+    for (auto& pair : inplace_pairs) {
+      for (auto id : pair) writer.Write(id);
+    }
+    writer.Write(trace_execute_order.size());
+    for (auto id : trace_execute_order) writer.Write(id);
+    if (!out) {
+      LOG(WARNING) << "Failed to write the executor build cache " << tmp_path;
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ProgramBuildCache::Load(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  CacheReader reader(&in);
+  uint64_t magic = 0;
+  if (!reader.Read(&magic) || magic != kBuildCacheMagic) return false;
+  uint64_t op_num_value = 0;
+  if (!reader.Read(&signature) || !reader.Read(&op_num_value) ||
+      op_num_value > kMaxOpNum) {
+    return false;
+  }
+  op_num = static_cast<size_t>(op_num_value);
+  // ids are below op_num for ops and below any sane var count for vars
+  const size_t limit = std::max<size_t>(op_num, size_t{1} << 32);
+
+  op_downstream_map.clear();
+  if (!reader.ReadMap(op_num, &op_downstream_map)) return false;
+  op_happens_before.assign(op_num, std::vector<bool>(op_num, false));
+  for (auto& row : op_happens_before) {
+    for (size_t begin = 0; begin < op_num; begin += 64) {
+      uint64_t bits = 0;
+      if (!reader.Read(&bits)) return false;
+      for (size_t j = begin; j < std::min(begin + 64, op_num); ++j) {
+        row[j] = (bits >> (j - begin)) & 1;
+      }
+    }
+  }
+  last_live_ops.clear();
+  if (!reader.ReadMap(limit, &last_live_ops)) return false;
+  size_t num = 0;
+  if (!reader.ReadSize(kMaxOpNum, &num)) return false;
+  inplace_pairs.assign(num, {});
+  for (auto& pair : inplace_pairs) {
+    for (auto& id : pair) {
+      if (!reader.ReadIndex(limit, &id)) return false;
+    }
+  }
+  if (!reader.ReadSize(op_num, &num)) return false;
+  trace_execute_order.assign(num, 0);
+  for (auto& id : trace_execute_order) {
+    if (!reader.ReadIndex(op_num, &id)) return false;
+  }
+  return true;
+}
+
+}  // namespace paddle::framework::interpreter
@@ -0,0 +1,70 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// FNV-1a, stable across processes unlike std::hash, used for the signature
+// a build cache is validated with.
+class BuildSignatureHasher {
+ public:
+  void Update(const void* data, size_t size);
+  void Update(const std::string& str);
+  void Update(uint64_t value) { Update(&value, sizeof(value)); }
+
+  uint64_t Value() const { return value_; }
+
+ private:
+  uint64_t value_{14695981039346656037ULL};
+};
+
+// The analysis results of ProgramInterpreter::Convert that only depend on the
+// instruction list: op dependencies, the gc plan, the inplace var pairs and
+// the trace order. An inference predictor saves them next to its optimized
+// model, and the next predictor that builds the same instruction list, as
+// told by the signature, loads them instead of running the analysis again.
+struct ProgramBuildCache {
+  uint64_t signature{0};
+  size_t op_num{0};
+
+  std::map<size_t, std::set<size_t>> op_downstream_map;
+  std::vector<std::vector<bool>> op_happens_before;
+  // var id -> the ops after which the var is checked for gc
+  std::map<size_t, std::set<size_t>> last_live_ops;
+  // {instruction id, in var id, out var id}
+  std::vector<std::array<size_t, 3>> inplace_pairs;
+  std::vector<size_t> trace_execute_order;
+
+  // Written to a temporary file and renamed, so that predictors starting
+  // together never read a partial cache. Returns false on io errors.
+  bool Save(const std::string& path) const;
+
+  // Returns false if the file does not exist, is of another version or is
+  // truncated, the caller then builds as usual.
+  bool Load(const std::string& path);
+};
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
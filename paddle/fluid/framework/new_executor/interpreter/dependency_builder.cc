@@ -142,6 +142,19 @@ void DependencyBuilder::ShareDependencyFrom(const DependencyBuilder& src) {
   is_build_ = true;
 }
 
+void DependencyBuilder::RestoreDependency(
+    const std::vector<Instruction>& instructions,
+    std::map<size_t, std::set<size_t>> op_downstream_map,
+    std::vector<std::vector<bool>> op_happens_before) {
+  instructions_ = &instructions;
+  op_num_ = instructions.size();
+  op_downstream_map_ = std::make_shared<std::map<size_t, std::set<size_t>>>(
+      std::move(op_downstream_map));
+  op_happens_before_ = std::make_shared<std::vector<std::vector<bool>>>(
+      std::move(op_happens_before));
+  is_build_ = true;
+}
+
 const std::string& DependencyBuilder::GetInstructionName(size_t op_idx) const {
   return (*instructions_)[op_idx].OpBase()->Type();
 }
@@ -58,6 +58,11 @@ class DependencyBuilder {
 
   void ShareDependencyFrom(const DependencyBuilder& src);
 
+  // take the results of Build from a ProgramBuildCache instead of building
+  void RestoreDependency(const std::vector<Instruction>& instructions,
+                         std::map<size_t, std::set<size_t>> op_downstream_map,
+                         std::vector<std::vector<bool>> op_happens_before);
+
   bool IsSameDeviceContext(size_t op1, size_t op2) const {
     return &((*instructions_)[op1].DeviceContext()) ==
            &((*instructions_)[op2].DeviceContext());
@@ -38,6 +38,10 @@ struct ExecutionConfig {
   std::set<std::string> jit_input_vars;
   std::set<std::string> skip_gc_vars;
 
+  // if not empty, the build results of ProgramInterpreter are loaded from
+  // this file when it matches the program, and saved to it otherwise
+  std::string build_cache_path;
+
   void AnalyzeThreadPoolConfig(const phi::Place& place, size_t op_num);
   void Log(int log_level);
 };
@@ -34,6 +34,10 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope,
                             true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(new_executor_cpu_replay,
+                            false,
+                            "Replay a CPU inference program from the kernels "
+                            "and kernel contexts recorded in its first run");
 
 namespace paddle::framework {
 
@@ -364,6 +364,7 @@ class VarRefInfo {
   explicit VarRefInfo(size_t ref, Variable* var)
       : static_ref_(ref), dynamic_ref_(ref), var_(var) {}
   size_t DynamicRef() { return dynamic_ref_; }
+  size_t StaticRef() const { return static_ref_; }
   Variable* Var() { return var_; }
   void ResetDynamicRef() {
     if (static_ref_ != 1) {
@@ -86,6 +86,8 @@ COMMON_DECLARE_bool(dynamic_static_unified_comm);
 COMMON_DECLARE_bool(enable_pir_in_executor);
 COMMON_DECLARE_bool(enable_pir_in_executor_trace_run);
 COMMON_DECLARE_int32(low_precision_op_list);
+COMMON_DECLARE_bool(save_static_runtime_data);
+PD_DECLARE_bool(log_memory_stats);
 
 #define CREATE_INSTR(instr_name)                                   \
   vec_instruction_base_.emplace_back(std::make_unique<instr_name>( \
@@ -765,6 +767,7 @@ void PirInterpreter::AnalyseExecuteOrderForTrace(
 
 void PirInterpreter::BuildInstruction() {
   VLOG(6) << "Build Instructions for pir ... ";
+  ClearCpuReplay();
   vec_instruction_base_.clear();
   size_t op_idx = 0;
   for (auto& op : *ir_block_) {
@@ -1596,11 +1599,100 @@ void PirInterpreter::TraceRunImpl() {
     gc_ = CreateInterpreterCoreGarbageCollector(place_, vec_instruction_base_);
   }
 
+  const bool use_cpu_replay = CanUseCpuReplay();
+  if (use_cpu_replay && cpu_replay_built_) {
+    VLOG(4) << "Replaying Instruction List";
+    CpuReplayInstructionList();
+    return;
+  }
+
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
   VLOG(4) << "Tracing Instruction List";
 
   TraceRunInstructionList(vec_instruction_base_);
   VLOG(4) << "Done TraceRunInstructionList";
+  if (use_cpu_replay) {
+    BuildCpuReplay();
+  }
+}
+
+// Note: CPU replay
+// The instructions of pir already hold their kernel contexts, what a traced
+// run still pays for per instruction is RunInstructionBase and CheckGC: the
+// atomics of refs_, and the name lookups that keep parameters from being
+// collected. BuildCpuReplay records trace_execute_order_ after a trace run
+// together with the variables each instruction releases, see the note on
+// ProgramInterpreter::BuildCpuReplay, and a replayed run only calls Run of
+// each instruction and hands those variables to the gc. As in
+// ProgramInterpreter, hooks, profiling and debug flags fall back to the
+// traced run.
+bool PirInterpreter::CanUseCpuReplay() const {
+  return FLAGS_new_executor_cpu_replay && platform::is_cpu_place(place_) &&
+         execution_config_.used_for_inference &&
+         !enable_job_schedule_profiler_ && pir_input_hookfuncs_.empty() &&
+         pir_output_hookfuncs_.empty() && !FLAGS_benchmark &&
+         !FLAGS_check_nan_inf && !FLAGS_low_precision_op_list &&
+         !FLAGS_save_static_runtime_data && !FLAGS_log_memory_stats &&
+         !platform::RecordOpInfoSupplement::IsEnabled();
+}
+
+void PirInterpreter::ClearCpuReplay() {
+  cpu_replay_steps_.clear();
+  cpu_replay_built_ = false;
+}
+
+void PirInterpreter::BuildCpuReplay() {
+  ClearCpuReplay();
+  std::vector<size_t> remaining_refs(refs_.size());
+  for (size_t i = 0; i < refs_.size(); ++i) {
+    remaining_refs[i] = refs_[i]->StaticRef();
+  }
+  cpu_replay_steps_.reserve(trace_execute_order_.size());
+  for (auto instr_id : trace_execute_order_) {
+    InstructionBase* instr = vec_instruction_base_.at(instr_id).get();
+    if (instr->IsArtificial()) {
+      continue;
+    }
+    CpuReplayStep step;
+    step.instr = instr;
+    // same as VarRefInfo::CheckAndDecrease in CheckGC
+    for (auto var_id : instr->GCCheckVars()) {
+      const bool static_ref_one = refs_[var_id]->StaticRef() == 1;
+      const bool is_ready = static_ref_one || remaining_refs[var_id]-- == 1;
+      if (is_ready &&
+          !parameter_var_names_.count(
+              value_exe_info_->GetNameById(static_cast<int>(var_id)))) {
+        step.gc_var_ids.push_back(var_id);
+      }
+    }
+    cpu_replay_steps_.emplace_back(std::move(step));
+  }
+  cpu_replay_built_ = true;
+  VLOG(4) << "Build cpu replay of " << cpu_replay_steps_.size() << " steps";
+}
+
+void PirInterpreter::CpuReplayInstructionList() {
+  for (auto& step : cpu_replay_steps_) {
+    InstructionBase* instr = step.instr;
+    platform::RecordEvent instruction_event(
+        instr->Name(), platform::TracerEventType::Operator, 1);
+    try {
+      instr->Run();
+    } catch (platform::EnforceNotMet& ex) {
+      auto* op = instr->Operation();
+      const std::vector<std::string> op_callstack_attr =
+          interpreter::GetInstructionCallStack(op->name(), op->attributes());
+      framework::InsertCallStackInfo(op->name(), op_callstack_attr, &ex);
+      throw;
+    }
+    for (auto var_id : step.gc_var_ids) {
+      gc_->Add(refs_[var_id]->Var(), instr);
+    }
+    for (auto var : instr->EagerGCVars()) {
+      gc_->Add(var, instr);
+    }
+    instr->ClearEagerGCVars();
+  }
 }
 
 void PirInterpreter::MultiThreadRunImpl() {
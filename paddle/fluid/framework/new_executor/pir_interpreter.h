@@ -207,6 +207,15 @@ class PirInterpreter : public InterpreterBaseImpl {
   std::vector<PirHookFunc> pir_output_hookfuncs_;
   std::vector<PirHookFunc> pir_input_hookfuncs_;
 
+  // used for cpu replay, one step per instruction of trace_execute_order_
+  struct CpuReplayStep {
+    InstructionBase* instr{nullptr};
+    // the variables whose last reference is this step, parameters excluded
+    std::vector<size_t> gc_var_ids;
+  };
+  std::vector<CpuReplayStep> cpu_replay_steps_;
+  bool cpu_replay_built_{false};
+
   /// ======================== ///
   ///        For new ir        ///
   /// ======================== ///
@@ -229,6 +238,14 @@ class PirInterpreter : public InterpreterBaseImpl {
   void TraceRunInstructionList(
       const std::vector<std::unique_ptr<InstructionBase>>& vec_instr);
 
+  bool CanUseCpuReplay() const;
+
+  void BuildCpuReplay();
+
+  void ClearCpuReplay();
+
+  void CpuReplayInstructionList();
+
   void MultiThreadRunImpl();
 
   void MultiThreadRunInstructionList(
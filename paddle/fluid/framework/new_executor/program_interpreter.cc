@@ -23,6 +23,7 @@
 #include "paddle/fluid/platform/device/gpu/gpu_info.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
+#include "paddle/fluid/platform/profiler/perf_counter.h"
 #include "paddle/fluid/platform/profiler/supplement_tracing.h"
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/kernel_context.h"
@@ -45,6 +46,7 @@ PHI_DECLARE_bool(enable_host_event_recorder_hook);
 PD_DECLARE_bool(log_memory_stats);
 COMMON_DECLARE_string(static_runtime_data_save_path);
 COMMON_DECLARE_bool(save_static_runtime_data);
+PD_DECLARE_bool(add_dependency_for_communication_op);
 namespace paddle {
 namespace framework {
 
@@ -145,6 +147,13 @@ void ProgramInterpreter::RunImpl() {
     gc_ = CreateInterpreterCoreGarbageCollector(place_, vec_instruction_);
   }
 
+  const bool use_cpu_replay = CanUseCpuReplay();
+  if (use_cpu_replay && cpu_replay_built_) {
+    VLOG(4) << "Replaying Instruction List";
+    CpuReplayInstructionList();
+    return;
+  }
+
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
 
   if (is_in_op_profiling_mode_ || execution_config_.used_for_inference ||
@@ -152,6 +161,9 @@ void ProgramInterpreter::RunImpl() {
        (sync_op_num_ == 0))) {
     VLOG(4) << "Tracing Instruction List";
     TraceInstructionList(vec_instruction_);
+    if (use_cpu_replay) {
+      BuildCpuReplay();
+    }
   } else {
     VLOG(4) << "Non-tracing";
     // For the program that only run once, it is no need to
@@ -361,6 +373,8 @@ void ProgramInterpreter::reset_scope(Scope* new_scope) {
   for (auto& ins : vec_instruction_) {
     BuildAndCacheInstructionCtx(&ins);
   }
+  // the recorded kernel contexts point into the old scope
+  ClearCpuReplay();
 }
 
 const Scope* ProgramInterpreter::local_scope() const { return local_scope_; }
@@ -624,7 +638,8 @@ void ProgramInterpreter::CheckCUDAGraphBeforeRun(
 #endif
 }
 
-void ProgramInterpreter::BuildOperatorDependences() {
+void ProgramInterpreter::BuildOperatorDependences(
+    const interpreter::ProgramBuildCache* build_cache) {
   // analysis the dependences between ops, add next_instr_list to each instr,
   // and set the dependency_count_
   size_t instr_num = vec_instruction_.size();
@@ -633,6 +648,11 @@ void ProgramInterpreter::BuildOperatorDependences() {
     dependency_count_->assign(instr_num, 0);
   }
 
+  if (build_cache) {
+    dependency_builder_.RestoreDependency(vec_instruction_,
+                                          build_cache->op_downstream_map,
+                                          build_cache->op_happens_before);
+  }
   auto downstream_map = dependency_builder_.Build(vec_instruction_);
 
   for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
@@ -703,6 +723,7 @@ void ProgramInterpreter::Convert(
   auto& vec_meta_info = var_scope_.MutableVecMetaInfo();
   auto nodes = *op_func_nodes;
   auto op_nums = nodes.size();
+  ClearCpuReplay();
   vec_instruction_.clear();
   vec_instruction_.reserve(op_nums);
   for (size_t op_idx = 0; op_idx < op_nums; ++op_idx) {
@@ -738,7 +759,16 @@ void ProgramInterpreter::Convert(
 #endif
   }
 
-  BuildOperatorDependences();
+  // the build cache is not used when the dependencies are shared from
+  // another interpreter
+  interpreter::ProgramBuildCache build_cache;
+  const bool save_build_cache = !execution_config_.build_cache_path.empty() &&
+                                !is_shared_results_build_;
+  const uint64_t build_signature =
+      save_build_cache ? BuildCacheSignature() : 0;
+  const bool use_build_cache =
+      save_build_cache && LoadBuildCache(build_signature, &build_cache);
+  BuildOperatorDependences(use_build_cache ? &build_cache : nullptr);
 
   // NOTE(Ruibiao): For cross-step stream synchronization, an event may be
   // recorded in the first step and waited in the second step. So, in the first
@@ -772,7 +802,200 @@ void ProgramInterpreter::Convert(
     }
   }
 
-  // calculate last_live_ops_
+  // calculate last_live_ops_, the cached one is already shrunk below
+  if (use_build_cache) {
+    last_live_ops_ = build_cache.last_live_ops;
+  } else {
+    CalculateLastLiveOps();
+  }
+
+  // shrink, find the downstream op that has no other op in the
+  // downstream list happens before it
+  // For example,
+  // b = op1(a)
+  // c = op2(a, b)
+  // in this case, a is the input of op1 and op2, we only need to check
+  // a after op2, because op2 always uses a after op1.
+  for (size_t i = 0; i < last_live_ops_.size(); ++i) {
+    std::set<size_t> minumum_last_live_ops;
+    for (size_t item : last_live_ops_[i]) {
+      bool not_before_any = true;
+      // find the op that is not executed before any
+      for (size_t other_item : last_live_ops_[i]) {
+        if (dependency_builder_.OpHappensBefore(item, other_item)) {
+          VLOG(8) << "happens_before: " << item << "->" << other_item
+                  << ", so skip " << item;
+          not_before_any = false;
+          break;
+        }
+      }
+      if (not_before_any) {
+        VLOG(8) << "last live op of var " << i << " "
+                << var_scope_.GetNameById(static_cast<int>(i)) << " : " << item
+                << " " << vec_instruction_[item].OpBase()->Type();
+        minumum_last_live_ops.insert(item);
+        if (!(var_scope_.VarDesc(static_cast<int>(i)) &&
+              var_scope_.VarDesc(static_cast<int>(i))->Persistable())) {
+          vec_instruction_[item].AddGCCheckVar(i);
+        }
+      }
+    }
+    last_live_ops_[i] = minumum_last_live_ops;
+    vec_meta_info[i].var_ref_count_ =
+        static_cast<int>(last_live_ops_[i].size());
+  }
+
+  for (auto& ins : vec_instruction_) {
+    BuildAndCacheInstructionCtx(&ins);
+  }
+
+  bool inplaced = false;
+  for (const Instruction& inst : vec_instruction_) {
+    if (inst.OpBase()->Type() == "share_buffer" ||
+        inst.OpBase()->Type() == "share_data") {
+      VLOG(4) << "Already inplaced, skip inplace now.";
+      inplaced = true;
+    }
+  }
+
+  if (FLAGS_new_executor_use_inplace && !inplaced) {
+    if (use_build_cache) {
+      for (auto& pair : build_cache.inplace_pairs) {
+        vec_instruction_.at(pair[0]).AddInplace(
+            var_scope_.VarRef(static_cast<int>(pair[1])),
+            var_scope_.VarRef(static_cast<int>(pair[2])));
+      }
+    } else {
+      BuildInplace();
+    }
+  }
+
+  for (auto& dep : *dependency_count_) {
+    deps_.emplace_back(std::make_shared<interpreter::OpDepInfo>(dep));
+  }
+  for (size_t i = 0; i < vec_meta_info.size(); ++i) {
+    refs_.emplace_back(std::make_shared<interpreter::VarRefInfo>(
+        vec_meta_info[i].var_ref_count_,
+        var_scope_.VarRef(static_cast<int>(i))));
+  }
+
+  if (use_build_cache) {
+    trace_execute_order_ = build_cache.trace_execute_order;
+    VLOG(4) << "Load the build results from "
+            << execution_config_.build_cache_path;
+  } else {
+    AnalyseExecuteOrderForTrace();
+    if (save_build_cache) {
+      SaveBuildCache(build_signature);
+    }
+  }
+}
+
+// The build cache holds what Convert works out from the instruction list, so
+// it must only be used for the same instructions on the same variables: the
+// signature covers the ops with their kernel types and var ids, the vars
+// with the properties the gc and inplace analyses look at, and the flags
+// and config that change the results.
+uint64_t ProgramInterpreter::BuildCacheSignature() const {
+  interpreter::BuildSignatureHasher hasher;
+  hasher.Update(place_.DebugString());
+  hasher.Update(static_cast<uint64_t>(FLAGS_new_executor_use_inplace));
+  hasher.Update(static_cast<uint64_t>(FLAGS_new_executor_sequential_run));
+  hasher.Update(
+      static_cast<uint64_t>(FLAGS_add_dependency_for_communication_op));
+  for (const std::string& skip_gc_var : execution_config_.skip_gc_vars) {
+    hasher.Update(skip_gc_var);
+  }
+
+  Scope* inner_scope =
+      HasLocalScope() ? local_scope_ : var_scope_.GetMutableScope();
+  for (size_t i = 0; i < var_scope_.VarSize(); ++i) {
+    const int var_id = static_cast<int>(i);
+    const std::string& var_name = var_scope_.GetNameById(var_id);
+    auto* var = inner_scope->FindVar(var_name);
+    auto* var_desc = var_scope_.VarDesc(var_id);
+    hasher.Update(var_name);
+    hasher.Update(var ? static_cast<uint64_t>(var->Type()) : ~uint64_t{0});
+    hasher.Update(static_cast<uint64_t>(var_desc && var_desc->Persistable()));
+    hasher.Update(static_cast<uint64_t>(var_scope_.GetVarSkipInplace(var_id)));
+    hasher.Update(static_cast<uint64_t>(block_.HasVar(var_name)));
+  }
+
+  for (const Instruction& instr : vec_instruction_) {
+    hasher.Update(instr.OpBase()->Type());
+    hasher.Update(static_cast<uint64_t>(instr.KernelType()));
+    hasher.Update(instr.DeviceContext().GetPlace().DebugString());
+    for (auto* var_map : {&instr.Inputs(), &instr.Outputs()}) {
+      hasher.Update(static_cast<uint64_t>(var_map->size()));
+      for (auto& item : *var_map) {
+        hasher.Update(item.first);
+        hasher.Update(static_cast<uint64_t>(item.second.size()));
+        for (int var_id : item.second) {
+          hasher.Update(static_cast<uint64_t>(var_id));
+        }
+      }
+    }
+  }
+  return hasher.Value();
+}
+
+bool ProgramInterpreter::LoadBuildCache(
+    uint64_t signature, interpreter::ProgramBuildCache* build_cache) const {
+  const std::string& path = execution_config_.build_cache_path;
+  if (!build_cache->Load(path)) {
+    VLOG(4) << "No usable build cache in " << path;
+    return false;
+  }
+  if (build_cache->signature != signature ||
+      build_cache->op_num != vec_instruction_.size()) {
+    VLOG(4) << "The build cache in " << path << " is of another program";
+    return false;
+  }
+  for (auto& pair : build_cache->inplace_pairs) {
+    if (pair[0] >= vec_instruction_.size() ||
+        pair[1] >= var_scope_.VarSize() || pair[2] >= var_scope_.VarSize()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ProgramInterpreter::SaveBuildCache(uint64_t signature) const {
+  interpreter::ProgramBuildCache build_cache;
+  build_cache.signature = signature;
+  build_cache.op_num = vec_instruction_.size();
+  build_cache.op_downstream_map = dependency_builder_.OpDownstreamMap();
+  build_cache.op_happens_before =
+      *std::get<1>(dependency_builder_.GetDependency());
+  build_cache.last_live_ops = last_live_ops_;
+
+  std::unordered_map<const Variable*, size_t> var_ids;
+  for (size_t i = 0; i < var_scope_.VarSize(); ++i) {
+    var_ids.emplace(var_scope_.VarRef(static_cast<int>(i)), i);
+  }
+  for (const Instruction& instr : vec_instruction_) {
+    for (auto& pair : instr.InplaceInfo()) {
+      auto in = var_ids.find(pair.first);
+      auto out = var_ids.find(pair.second);
+      if (in == var_ids.end() || out == var_ids.end()) {
+        VLOG(4) << "Inplace vars out of the variable scope, skip saving the "
+                   "build cache";
+        return;
+      }
+      build_cache.inplace_pairs.push_back(
+          {instr.Id(), in->second, out->second});
+    }
+  }
+  build_cache.trace_execute_order = trace_execute_order_;
+
+  if (build_cache.Save(execution_config_.build_cache_path)) {
+    VLOG(4) << "Save the build results to "
+            << execution_config_.build_cache_path;
+  }
+}
+
+void ProgramInterpreter::CalculateLastLiveOps() {
+  size_t op_nums = vec_instruction_.size();
   for (size_t op_idx = 0; op_idx < op_nums; ++op_idx) {
     Instruction& instr = vec_instruction_[op_idx];
     OpInOutInfo info;
@@ -843,70 +1066,6 @@ void ProgramInterpreter::Convert(
       VLOG(8) << "Skip gc for var: " << skip_gc_var;
     }
   }
-
-  // shrink, find the downstream op that has no other op in the
-  // downstream list happens before it
-  // For example,
-  // b = op1(a)
-  // c = op2(a, b)
-  // in this case, a is the input of op1 and op2, we only need to check
-  // a after op2, because op2 always uses a after op1.
-  for (size_t i = 0; i < last_live_ops_.size(); ++i) {
-    std::set<size_t> minumum_last_live_ops;
-    for (size_t item : last_live_ops_[i]) {
-      bool not_before_any = true;
-      // find the op that is not executed before any
-      for (size_t other_item : last_live_ops_[i]) {
-        if (dependency_builder_.OpHappensBefore(item, other_item)) {
-          VLOG(8) << "happens_before: " << item << "->" << other_item
-                  << ", so skip " << item;
-          not_before_any = false;
-          break;
-        }
-      }
-      if (not_before_any) {
-        VLOG(8) << "last live op of var " << i << " "
-                << var_scope_.GetNameById(static_cast<int>(i)) << " : " << item
-                << " " << vec_instruction_[item].OpBase()->Type();
-        minumum_last_live_ops.insert(item);
-        if (!(var_scope_.VarDesc(static_cast<int>(i)) &&
-              var_scope_.VarDesc(static_cast<int>(i))->Persistable())) {
-          vec_instruction_[item].AddGCCheckVar(i);
-        }
-      }
-    }
-    last_live_ops_[i] = minumum_last_live_ops;
-    vec_meta_info[i].var_ref_count_ =
-        static_cast<int>(last_live_ops_[i].size());
-  }
-
-  for (auto& ins : vec_instruction_) {
-    BuildAndCacheInstructionCtx(&ins);
-  }
-
-  bool inplaced = false;
-  for (const Instruction& inst : vec_instruction_) {
-    if (inst.OpBase()->Type() == "share_buffer" ||
-        inst.OpBase()->Type() == "share_data") {
-      VLOG(4) << "Already inplaced, skip inplace now.";
-      inplaced = true;
-    }
-  }
-
-  if (FLAGS_new_executor_use_inplace && !inplaced) {
-    BuildInplace();
-  }
-
-  for (auto& dep : *dependency_count_) {
-    deps_.emplace_back(std::make_shared<interpreter::OpDepInfo>(dep));
-  }
-  for (size_t i = 0; i < vec_meta_info.size(); ++i) {
-    refs_.emplace_back(std::make_shared<interpreter::VarRefInfo>(
-        vec_meta_info[i].var_ref_count_,
-        var_scope_.VarRef(static_cast<int>(i))));
-  }
-
-  AnalyseExecuteOrderForTrace();
 }
 
 void ProgramInterpreter::BuildSkipShareLoDInfo() {
@@ -975,13 +1134,6 @@ void ProgramInterpreter::RunOperator(const Instruction& instr_node) {
               instr_node.InnerInferShapeContext().get());
         }
       }
-      if (FLAGS_enable_host_event_recorder_hook) {
-        platform::RecordOpInfoSupplement(op->Type(),
-                                         op->Attrs(),
-                                         *(instr_node.InnerInferShapeContext()),
-                                         *(instr_node.InnerRuntimeContext()),
-                                         op->Id());
-      }
     }
   }
   if (op_with_kernel != nullptr && FLAGS_new_executor_use_inplace) {
@@ -1014,6 +1166,13 @@ void ProgramInterpreter::RunOperator(const Instruction& instr_node) {
     }
 #endif
 
+    // the op info is recorded after the kernel, so that the bytes of the
+    // outputs and the hardware counters of the kernel are known
+    const bool record_op_info = op_with_kernel != nullptr &&
+                                FLAGS_enable_host_event_recorder_hook &&
+                                platform::RecordOpInfoSupplement::IsEnabled();
+    platform::KernelCounterScope kernel_counters(record_op_info);
+
     if (op_with_kernel == nullptr) {  // operator base
       instr_node.OpBase()->Run(*local_scope, place_);
     } else {
@@ -1040,6 +1199,17 @@ void ProgramInterpreter::RunOperator(const Instruction& instr_node) {
       }
     }
 
+    if (record_op_info) {
+      platform::KernelCost kernel_cost;
+      kernel_counters.Stop(&kernel_cost);
+      platform::RecordOpInfoSupplement(op->Type(),
+                                       op->Attrs(),
+                                       *(instr_node.InnerInferShapeContext()),
+                                       *(instr_node.InnerRuntimeContext()),
+                                       op->Id(),
+                                       kernel_cost);
+    }
+
     if (is_in_op_profiling_mode_ && op->Id() != UINT64_MAX) {
       OperatorDistAttr* op_dist_attr = block_.Op(op->Id())->MutableDistAttr();
       platform::Timer op_timer;
@@ -1656,6 +1826,148 @@ void ProgramInterpreter::TraceInstructionList(
   }
 }
 
+// Note: CPU replay
+// Once a CPU inference program has been traced, the order of its
+// instructions and the variables each of them releases are fixed, and the
+// tensors a phi function kernel reads and writes live in the same variables
+// from run to run. BuildCpuReplay records trace_execute_order_ as a flat
+// list of steps, binding the KernelContext of such kernels once and working
+// out from the static reference counts which variables to collect after
+// each step. A replayed run then calls the kernels directly, without
+// rebuilding kernel contexts or touching the atomics of deps_ and refs_.
+// Steps that cannot be bound once, e.g. structure or fluid kernels, kernels
+// taking tensor attributes and ops that use LoDTensorArray or other non
+// tensor variables, run through RunOperator as in trace mode. Like trace
+// mode it is single threaded, so it is only used when the program is traced
+// anyway, and not when hooks, profiling or debug flags need RunInstruction.
+bool ProgramInterpreter::CanUseCpuReplay() const {
+  return FLAGS_new_executor_cpu_replay && platform::is_cpu_place(place_) &&
+         execution_config_.used_for_inference && !is_in_op_profiling_mode_ &&
+         input_hookfuncs_.empty() && output_hookfuncs_.empty() &&
+         !FLAGS_benchmark && !FLAGS_check_nan_inf &&
+         !FLAGS_save_static_runtime_data && !FLAGS_log_memory_stats &&
+         !platform::RecordOpInfoSupplement::IsEnabled();
+}
+
+void ProgramInterpreter::ClearCpuReplay() {
+  cpu_replay_steps_.clear();
+  cpu_replay_built_ = false;
+}
+
+void ProgramInterpreter::BuildCpuReplay() {
+  ClearCpuReplay();
+  auto can_bind_once = [](const Instruction& instr) {
+    auto* op = dynamic_cast<const OperatorWithKernel*>(instr.OpBase());
+    phi::Kernel* kernel = instr.PhiKernel();
+    if (op == nullptr || kernel == nullptr || !kernel->IsValid() ||
+        kernel->GetKernelRegisteredType() !=
+            phi::KernelRegisteredType::FUNCTION ||
+        op->PhiKernelSignature() == nullptr ||
+        !instr.InplaceBackMap().empty()) {
+      return false;
+    }
+    const RuntimeContext& runtime_ctx = *instr.InnerRuntimeContext();
+    // a tensor attribute is read into the context when it is built
+    for (auto& attr_name : op->PhiKernelSignature()->attr_names) {
+      if (runtime_ctx.inputs.count(attr_name)) {
+        return false;
+      }
+    }
+    for (auto* var_map : {&runtime_ctx.inputs, &runtime_ctx.outputs}) {
+      for (auto& name_and_vars : *var_map) {
+        for (auto* var : name_and_vars.second) {
+          if (var != nullptr && !var->IsType<phi::DenseTensor>() &&
+              !var->IsType<phi::SelectedRows>()) {
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  };
+
+  std::vector<size_t> remaining_refs(refs_.size());
+  for (size_t i = 0; i < refs_.size(); ++i) {
+    remaining_refs[i] = refs_[i]->StaticRef();
+  }
+  size_t bound_num = 0;
+  cpu_replay_steps_.reserve(trace_execute_order_.size());
+  for (auto instr_id : trace_execute_order_) {
+    const Instruction& instr = vec_instruction_.at(instr_id);
+    if (instr.IsArtificial()) {
+      continue;
+    }
+    CpuReplayStep step;
+    step.instr = &instr;
+    if (can_bind_once(instr)) {
+      auto* op = static_cast<const OperatorWithKernel*>(instr.OpBase());
+      step.kernel = instr.PhiKernel();
+      step.kernel_ctx = std::make_unique<phi::KernelContext>();
+      op->BuildPhiKernelContext(
+          *instr.InnerRuntimeContext(),
+          const_cast<platform::DeviceContext*>(&instr.DeviceContext()),
+          step.kernel_ctx.get());
+      // see OperatorWithKernel::RunImpl in operator.cc for why
+      if (!(op->HasAttr(kAllKernelsMustComputeRuntimeShape) &&
+            op->Attr<bool>(kAllKernelsMustComputeRuntimeShape))) {
+        step.infer_meta = instr.can_use_infermeta_ctx_;
+        step.infer_shape = !instr.can_use_infermeta_ctx_;
+      }
+      ++bound_num;
+    }
+    // same as VarRefInfo::CheckAndDecrease in CheckGC
+    for (auto var_id : instr.GCCheckVars()) {
+      const bool static_ref_one = refs_[var_id]->StaticRef() == 1;
+      if (static_ref_one || remaining_refs[var_id]-- == 1) {
+        step.gc_var_ids.push_back(var_id);
+      }
+    }
+    cpu_replay_steps_.emplace_back(std::move(step));
+  }
+  cpu_replay_built_ = true;
+  VLOG(4) << "Build cpu replay of " << cpu_replay_steps_.size()
+          << " steps, kernel contexts of " << bound_num << " are bound once";
+}
+
+void ProgramInterpreter::CpuReplayInstructionList() {
+  for (auto& step : cpu_replay_steps_) {
+    const Instruction& instr = *step.instr;
+    auto* op = instr.OpBase();
+    platform::RecordEvent instruction_event(
+        op->Type(), platform::TracerEventType::Operator, 1);
+    try {
+      if (step.kernel == nullptr) {
+        RunOperator(instr);
+      } else {
+        auto* op_with_kernel = static_cast<const OperatorWithKernel*>(op);
+        if (step.infer_meta) {
+          op_with_kernel->Info().infer_meta_(const_cast<phi::InferMetaContext*>(
+              instr.InnerCompatInferMetaContext()));
+        } else if (step.infer_shape) {
+          op_with_kernel->Info().infer_shape_(
+              instr.InnerInferShapeContext().get());
+        }
+        if (FLAGS_new_executor_use_inplace) {
+          for (auto& pair : instr.InplaceInfo()) {
+            const auto& in = details::GetTensorFromVar(pair.first);
+            auto* out = details::GetMutableTensorFromVar(pair.second);
+            if (in.dims() == out->dims()) {
+              out->ShareBufferWith(in);
+            }
+          }
+        }
+        (*step.kernel)(step.kernel_ctx.get());
+      }
+    } catch (platform::EnforceNotMet& ex) {
+      framework::InsertCallStackInfo(op->Type(), op->Attrs(), &ex);
+      throw;
+    }
+    for (auto var_id : step.gc_var_ids) {
+      gc_->Add(refs_[var_id]->Var(), instr);
+    }
+  }
+}
+
 void ProgramInterpreter::RecordMemcpyD2H(const Instruction& instr_node) {
   // NOTE(zhiqiu): hot fix for jit input var
   if (instr_node.OpBase()->Type() == interpreter::kMemcpyD2H) {
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "paddle/fluid/framework/new_executor/interpreter/build_cache.h"
 #include "paddle/fluid/framework/new_executor/interpreter_base_impl.h"
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
@@ -126,12 +127,20 @@ class ProgramInterpreter : public InterpreterBaseImpl {
  private:
   // build graph
   void Convert(std::vector<paddle::framework::OpFuncNode>* op_func_nodes);
-  void BuildOperatorDependences();
+  void BuildOperatorDependences(
+      const interpreter::ProgramBuildCache* build_cache);
+  void CalculateLastLiveOps();
   void BuildAndCacheInstructionCtx(Instruction* instr_node);
   void BuildSkipShareLoDInfo();
   void UpdateSyncOpNum();
   void AnalyseExecuteOrderForTrace();
 
+  // build cache, see ExecutionConfig::build_cache_path
+  uint64_t BuildCacheSignature() const;
+  bool LoadBuildCache(uint64_t signature,
+                      interpreter::ProgramBuildCache* build_cache) const;
+  void SaveBuildCache(uint64_t signature) const;
+
   // inplace
   void BuildInplace();
   bool BuildInplaceCheckVarIsOnlyInput(
@@ -153,6 +162,12 @@ class ProgramInterpreter : public InterpreterBaseImpl {
   // Trace
   void TraceInstructionList(const std::vector<Instruction>& vec_instr);
 
+  // cpu replay
+  bool CanUseCpuReplay() const;
+  void BuildCpuReplay();
+  void ClearCpuReplay();
+  void CpuReplayInstructionList();
+
   // only used when program contains no feed op
   void Prepare(const std::vector<std::string>& feed_names,
                const std::vector<phi::DenseTensor>& feed_tensors,
@@ -236,6 +251,20 @@ class ProgramInterpreter : public InterpreterBaseImpl {
   int64_t sync_op_num_{-1};
   std::vector<size_t> trace_execute_order_;
 
+  // used for cpu replay, one step per instruction of trace_execute_order_
+  struct CpuReplayStep {
+    const Instruction* instr{nullptr};
+    // null if the step runs through RunOperator
+    phi::Kernel* kernel{nullptr};
+    std::unique_ptr<phi::KernelContext> kernel_ctx;
+    bool infer_meta{false};
+    bool infer_shape{false};
+    // the variables whose last reference is this step
+    std::vector<size_t> gc_var_ids;
+  };
+  std::vector<CpuReplayStep> cpu_replay_steps_;
+  bool cpu_replay_built_{false};
+
   InstructionSchedulingPriorityLess instruction_scheduling_priority_less;
 
   std::vector<HookFunc> output_hookfuncs_;
@@ -228,6 +228,42 @@ RuntimeContext::RuntimeContext(const VariableNameMap& innames,
   }
 }
 
+VariableNameIds::VariableNameIds(const VariableNameMap& innames,
+                                 const VariableNameMap& outnames) {
+  for (auto& var_name_item : innames) {
+    std::vector<VarNameId>& ids = inputs[var_name_item.first];
+    ids.reserve(var_name_item.second.size());
+    for (auto& var_name : var_name_item.second) {
+      ids.push_back(Scope::InternVarName(var_name));
+    }
+  }
+  for (auto& var_name_item : outnames) {
+    std::vector<VarNameId>& ids = outputs[var_name_item.first];
+    ids.reserve(var_name_item.second.size());
+    for (auto& var_name : var_name_item.second) {
+      ids.push_back(Scope::InternVarName(var_name));
+    }
+  }
+}
+
+RuntimeContext::RuntimeContext(const VariableNameIds& ids,
+                               const Scope& scope) {
+  for (auto& var_id_item : ids.inputs) {
+    std::vector<Variable*>& input_vars = inputs[var_id_item.first];
+    input_vars.reserve(var_id_item.second.size());
+    for (auto id : var_id_item.second) {
+      input_vars.push_back(scope.FindVar(id));
+    }
+  }
+  for (auto& var_id_item : ids.outputs) {
+    std::vector<Variable*>& output_vars = outputs[var_id_item.first];
+    output_vars.reserve(var_id_item.second.size());
+    for (auto id : var_id_item.second) {
+      output_vars.push_back(scope.FindVar(id));
+    }
+  }
+}
+
 RuntimeInferShapeContext::RuntimeInferShapeContext(const OperatorBase& op,
                                                    const RuntimeContext& ctx)
     : op_(op), ctx_(ctx) {}
@@ -849,6 +885,16 @@ void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
   }
 }
 
+std::shared_ptr<const VariableNameIds> OperatorBase::VarNameIds() const {
+  auto ids = std::atomic_load(&var_name_ids_);
+  if (ids == nullptr) {
+    // racing callers intern the same ids
+    ids = std::make_shared<const VariableNameIds>(inputs_, outputs_);
+    std::atomic_store(&var_name_ids_, ids);
+  }
+  return ids;
+}
+
 bool OperatorBase::HasInputs(const std::string& name) const {
   return inputs_.find(name) != inputs_.end();
 }
@@ -1731,7 +1777,7 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   }
 #endif
   if (!enable_cache_runtime_context_) {
-    RuntimeContext ctx(Inputs(), Outputs(), scope);
+    RuntimeContext ctx(*VarNameIds(), scope);
     RunImpl(scope, place, &ctx);
   } else if (run_phi_kernel_ && impl_ != nullptr && !need_prepare_data_ &&
              !need_prepare_phi_data_) {
@@ -1743,8 +1789,7 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
     if (runtime_ctx_.get() == nullptr || pre_scope_ != cur_scope) {
       std::lock_guard<std::mutex> lock(cache_update_mutex_);
       if (runtime_ctx_.get() == nullptr || pre_scope_ != cur_scope) {
-        runtime_ctx_ =
-            std::make_unique<RuntimeContext>(Inputs(), Outputs(), scope);
+        runtime_ctx_ = std::make_unique<RuntimeContext>(*VarNameIds(), scope);
         pre_scope_ = cur_scope;
       }
     }
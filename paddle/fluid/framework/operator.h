@@ -137,12 +137,25 @@ phi::DenseTensor* GetMutableLoDTensorOrSelectedRowsValueFromVar(Variable* var);
 class ExecutionContext;
 class OperatorBase;
 
+// The interned ids of the variable names of an op, by the same keys as its
+// inputs and outputs.
+struct VariableNameIds {
+  VariableNameIds(const VariableNameMap& innames,
+                  const VariableNameMap& outnames);
+
+  std::map<std::string, std::vector<VarNameId>> inputs;
+  std::map<std::string, std::vector<VarNameId>> outputs;
+};
+
 class RuntimeContext {
  public:
   RuntimeContext(const VariableNameMap& innames,
                  const VariableNameMap& outnames,
                  const Scope& scope);
 
+  // Looks the vars up by the interned ids, without hashing the names.
+  RuntimeContext(const VariableNameIds& ids, const Scope& scope);
+
   RuntimeContext(const VariableValueMap& invars,
                  const VariableValueMap& outvars)
       : inputs(invars), outputs(outvars) {}
@@ -331,8 +344,18 @@ class TEST_API OperatorBase {
 
   const VariableNameMap& Inputs() const { return inputs_; }
   const VariableNameMap& Outputs() const { return outputs_; }
-  VariableNameMap& Inputs() { return inputs_; }
-  VariableNameMap& Outputs() { return outputs_; }
+  // The names may be changed through these, drop the interned ids.
+  VariableNameMap& Inputs() {
+    std::atomic_store(&var_name_ids_, {});
+    return inputs_;
+  }
+  VariableNameMap& Outputs() {
+    std::atomic_store(&var_name_ids_, {});
+    return outputs_;
+  }
+
+  // The interned ids of Inputs() and Outputs(), built on the first call.
+  std::shared_ptr<const VariableNameIds> VarNameIds() const;
 
   const OpInfo& Info() const {
     PADDLE_ENFORCE_NOT_NULL(
@@ -416,6 +439,9 @@ class TEST_API OperatorBase {
   std::vector<HookFunc> input_hookfuncs_;
 
  private:
+  // accessed with std::atomic_load and std::atomic_store
+  mutable std::shared_ptr<const VariableNameIds> var_name_ids_;
+
   void GenerateTemporaryNames();
   void CheckAllInputOutputSet() const;
   virtual void RunImpl(const Scope& scope,
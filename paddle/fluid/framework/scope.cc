@@ -14,6 +14,9 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/scope.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "glog/logging.h"
 #include "paddle/common/flags.h"
 #include "paddle/fluid/framework/threadpool.h"
@@ -27,6 +30,86 @@ COMMON_DECLARE_bool(eager_delete_scope);
 #define SCOPE_VARS_WRITER_LOCK phi::AutoWRLock auto_lock(&vars_lock_);
 
 namespace paddle::framework {
+
+namespace {
+
+constexpr VarNameId kInvalidVarNameId = std::numeric_limits<VarNameId>::max();
+
+// The names interned by Scope::InternVarName, never removed, so that an id
+// stays valid for the process. The names are kept in chunks that double in
+// size and never move, so a name is read without the lock.
+class VarNameTable {
+ public:
+  static VarNameTable& Instance() {
+    static VarNameTable* table = new VarNameTable();
+    return *table;
+  }
+
+  VarNameId Intern(const std::string& name) {
+    {
+      phi::AutoRDLock lock(&lock_);
+      auto it = ids_.find(name);
+      if (it != ids_.end()) return it->second;
+    }
+    phi::AutoWRLock lock(&lock_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    const size_t size = size_.load(std::memory_order_relaxed);
+    PADDLE_ENFORCE_LT(size,
+                      kInvalidVarNameId,
+                      platform::errors::ResourceExhausted(
+                          "Too many variable names are interned."));
+    auto id = static_cast<VarNameId>(size);
+    size_t chunk = 0, offset = 0;
+    Locate(id, &chunk, &offset);
+    if (chunks_[chunk] == nullptr) {
+      chunks_[chunk] = new std::string[kFirstChunkSize << chunk];
+    }
+    chunks_[chunk][offset] = name;
+    ids_.emplace(name, id);
+    size_.store(size + 1, std::memory_order_release);
+    return id;
+  }
+
+  const std::string& Name(VarNameId id) {
+    PADDLE_ENFORCE_LT(id,
+                      size_.load(std::memory_order_acquire),
+                      platform::errors::InvalidArgument(
+                          "The variable name id %d is not interned.", id));
+    size_t chunk = 0, offset = 0;
+    Locate(id, &chunk, &offset);
+    return chunks_[chunk][offset];
+  }
+
+ private:
+  static constexpr size_t kFirstChunkSize = 1024;
+  // enough chunks for every id below kInvalidVarNameId
+  static constexpr size_t kNumChunks = 23;
+
+  // chunk k holds kFirstChunkSize << k names, from id
+  // kFirstChunkSize * (2^k - 1) on
+  static void Locate(VarNameId id, size_t* chunk, size_t* offset) {
+    size_t blocks = id / kFirstChunkSize + 1;
+    *chunk = 0;
+    while (blocks >>= 1) ++*chunk;
+    *offset = id - kFirstChunkSize * ((size_t{1} << *chunk) - 1);
+  }
+
+  phi::RWLock lock_;
+  std::unordered_map<std::string, VarNameId> ids_;
+  // written with lock_ held, a chunk is set before the size covers it
+  std::string* chunks_[kNumChunks] = {};
+  std::atomic<size_t> size_{0};
+};
+
+// the slot value of an id that is not in the scope
+Variable* NoVarInScope() {
+  static Variable* no_var = new Variable();
+  return no_var;
+}
+
+}  // namespace
+
 Scope::Scope() : vars_(), kids_() {}
 Scope::~Scope() { DropKids(); }  // NOLINT
 
@@ -74,6 +157,22 @@ Variable* Scope::FindVar(const std::string& name) const {
   return FindVarInternal(name);
 }
 
+VarNameId Scope::InternVarName(const std::string& name) {
+  return VarNameTable::Instance().Intern(name);
+}
+
+const std::string& Scope::VarName(VarNameId id) {
+  return VarNameTable::Instance().Name(id);
+}
+
+Variable* Scope::FindVar(VarNameId id) const {
+  for (const Scope* scope = this; scope != nullptr; scope = scope->parent_) {
+    Variable* var = scope->FindVarLocally(id);
+    if (var != nullptr) return var;
+  }
+  return nullptr;
+}
+
 Variable* Scope::GetVar(const std::string& name) const {
   auto* var = FindVar(name);
   PADDLE_ENFORCE_NOT_NULL(
@@ -169,6 +268,7 @@ void Scope::EraseVars(const std::vector<std::string>& var_names) {
     SCOPE_VARS_WRITER_LOCK
     for (auto it = vars_.begin(); it != vars_.end();) {
       if (var_set.find(it->first) != var_set.end()) {
+        UpdateVarSlot(it->first, nullptr);
         it = vars_.erase(it);
       } else {
         ++it;
@@ -199,6 +299,7 @@ Variable* Scope::VarInternal(const std::string& name) {
   if (v != nullptr) return v;
   v = new Variable();
   vars_.emplace(name, std::unique_ptr<Variable>(v));
+  UpdateVarSlot(name, v);
   VLOG(3) << "Create variable " << name;
   return v;
 }
@@ -234,8 +335,11 @@ void Scope::RenameInternal(const std::string& origin_name,
       vars_.end(),
       platform::errors::AlreadyExists(
           "The variable with name %s already exists in the scope.", new_name));
-  vars_[new_name].reset(origin_it->second.release());
+  Variable* var = origin_it->second.release();
+  UpdateVarSlot(origin_name, nullptr);
   vars_.erase(origin_it);
+  vars_[new_name].reset(var);
+  UpdateVarSlot(new_name, var);
 }
 
 Variable* Scope::FindVarInternal(const std::string& name) const {
@@ -254,12 +358,78 @@ Variable* Scope::FindVarLocally(const std::string& name) const {
   return nullptr;
 }
 
+Variable* Scope::FindVarLocally(VarNameId id) const {
+  VarSlots* table = var_slots_.load(std::memory_order_acquire);
+  if (table != nullptr) {
+    size_t i = table->Probe(id);
+    if (table->ids[i].load(std::memory_order_relaxed) == id) {
+      Variable* var = table->vars[i].load(std::memory_order_acquire);
+      return var == NoVarInScope() ? nullptr : var;
+    }
+  }
+  // The first lookup of the id in this scope. Only takes the lock and
+  // records the var or its absence.
+  const std::string& name = VarName(id);
+  SCOPE_VARS_WRITER_LOCK
+  Variable* var = FindVarLocally(name);
+  RecordVarSlot(id, name, var);
+  return var;
+}
+
+void Scope::RecordVarSlot(VarNameId id,
+                          const std::string& name,
+                          Variable* var) const {
+  if (var == nullptr) var = NoVarInScope();
+  VarSlots* table = var_slots_.load(std::memory_order_relaxed);
+  if (table != nullptr) {
+    size_t i = table->Probe(id);
+    if (table->ids[i].load(std::memory_order_relaxed) == id) {
+      table->vars[i].store(var, std::memory_order_release);
+      return;
+    }
+  }
+  // at most 3/4 full, a table of twice the size replaces a full one
+  if (table == nullptr || (table->size + 1) * 4 > (table->mask + 1) * 3) {
+    const size_t capacity = table == nullptr ? 16 : (table->mask + 1) * 2;
+    auto new_table = std::make_unique<VarSlots>(capacity);
+    for (size_t i = 0; table != nullptr && i <= table->mask; ++i) {
+      VarNameId slot_id = table->ids[i].load(std::memory_order_relaxed);
+      if (slot_id == VarSlots::kEmpty) continue;
+      size_t j = new_table->Probe(slot_id);
+      new_table->vars[j].store(table->vars[i].load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+      new_table->ids[j].store(slot_id, std::memory_order_relaxed);
+    }
+    new_table->size = table == nullptr ? 0 : table->size;
+    table = new_table.get();
+    var_slots_tables_.emplace_back(std::move(new_table));
+    var_slots_.store(table, std::memory_order_release);
+  }
+  size_t i = table->Probe(id);
+  table->vars[i].store(var, std::memory_order_relaxed);
+  table->ids[i].store(id, std::memory_order_release);
+  ++table->size;
+  var_slot_ids_.emplace(name, id);
+}
+
+void Scope::UpdateVarSlot(const std::string& name, Variable* var) const {
+  // a scope without lookups by id skips the name lookup
+  VarSlots* table = var_slots_.load(std::memory_order_relaxed);
+  if (table == nullptr) return;
+  auto it = var_slot_ids_.find(name);
+  if (it == var_slot_ids_.end()) return;
+  size_t i = table->Probe(it->second);
+  table->vars[i].store(var == nullptr ? NoVarInScope() : var,
+                       std::memory_order_release);
+}
+
 void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
   SCOPE_VARS_WRITER_LOCK
   for (auto iter = vars_.begin(); iter != vars_.end();) {
     if (vars.count(iter->second.get()) != 0) {
       ++iter;
     } else {
+      UpdateVarSlot(iter->first, nullptr);
       vars_.erase(iter++);
     }
   }
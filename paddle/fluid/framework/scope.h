@@ -18,6 +18,9 @@ extern "C" {
 #include <xxhash.h>
 }
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
@@ -39,6 +42,10 @@ class Variable;
 
 namespace paddle {
 namespace framework {
+
+/// The interned id of a variable name, see Scope::InternVarName.
+using VarNameId = uint32_t;
+
 /**
  * @brief Scope that manage all variables.
  *
@@ -79,6 +86,20 @@ class TEST_API Scope {
   /// Caller doesn't own the returned Variable.
   Variable* FindVar(const std::string& name) const;
 
+  /// Intern a variable name, the same name gets the same id in the whole
+  /// process. A hot path resolves its names once and then looks them up with
+  /// FindVar(VarNameId), which neither hashes the name nor takes a lock once
+  /// the id has been looked up in each scope of the chain.
+  static VarNameId InternVarName(const std::string& name);
+
+  /// The name of an interned id.
+  static const std::string& VarName(VarNameId id);
+
+  /// Find a variable of an interned name in the scope or any of its
+  /// ancestors. Returns nullptr if cannot find.
+  /// Caller doesn't own the returned Variable.
+  Variable* FindVar(VarNameId id) const;
+
   // Get a variable in the scope or any of its ancestors. Enforce
   /// the returned Variable is not nullptr
   Variable* GetVar(const std::string& name) const;
@@ -162,6 +183,53 @@ class TEST_API Scope {
   // Called by FindVarInternal and Var.
   Variable* FindVarLocally(const std::string& name) const;
 
+  // Called by FindVar(VarNameId) for each scope of the chain.
+  Variable* FindVarLocally(VarNameId id) const;
+
+  // Called with vars_lock_ held when the var of a name changes.
+  void UpdateVarSlot(const std::string& name, Variable* var) const;
+
+  // Called with vars_lock_ held, records the var of an id in var_slots_.
+  void RecordVarSlot(VarNameId id,
+                     const std::string& name,
+                     Variable* var) const;
+
+  // An open addressing table of the ids looked up in this scope, published
+  // RCU style: a slot holds an id and its var in this scope, or a sentinel
+  // if it is not in this scope. It is only written with vars_lock_ held and
+  // read without any lock. An id is stored after its var, so a reader that
+  // sees the id sees the var as well.
+  struct VarSlots {
+    static constexpr VarNameId kEmpty = std::numeric_limits<VarNameId>::max();
+
+    explicit VarSlots(size_t capacity)
+        : mask(capacity - 1),
+          ids(new std::atomic<VarNameId>[capacity]),
+          vars(new std::atomic<Variable*>[capacity]()) {
+      for (size_t i = 0; i < capacity; ++i) ids[i].store(kEmpty);
+    }
+    // the slot of id, or the empty slot it would go to
+    size_t Probe(VarNameId id) const {
+      size_t i = (id * size_t{2654435761u}) & mask;
+      while (true) {
+        VarNameId slot_id = ids[i].load(std::memory_order_acquire);
+        if (slot_id == id || slot_id == kEmpty) return i;
+        i = (i + 1) & mask;
+      }
+    }
+    size_t mask;
+    size_t size{0};
+    std::unique_ptr<std::atomic<VarNameId>[]> ids;
+    std::unique_ptr<std::atomic<Variable*>[]> vars;
+  };
+  mutable std::atomic<VarSlots*> var_slots_{nullptr};
+  // The current table and the smaller ones it replaced, which readers may
+  // still be on, are freed with the scope.
+  mutable std::vector<std::unique_ptr<VarSlots>> var_slots_tables_;
+  // the ids in var_slots_ by name, so that a changed var finds its slot
+  // without the process-wide name table
+  mutable std::unordered_map<std::string, VarNameId> var_slot_ids_;
+
   // Scope in `kids_` are owned by this class.
   mutable std::list<Scope*> kids_;
   const Scope* parent_{nullptr};
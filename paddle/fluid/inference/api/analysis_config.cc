@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -511,6 +512,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(bfloat16_enabled_op_types_);
   // Quantization related.
   CP_MEMBER(use_mkldnn_int8_);
+  CP_MEMBER(use_cpu_int8_quant_linear_);
+  CP_MEMBER(quant_linear_pass_inserted_);
   CP_MEMBER(quantize_enabled_op_types_);
   CP_MEMBER(quantize_excluded_op_ids_);
   CP_MEMBER(use_mkldnn_quantizer_);
@@ -574,6 +577,15 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(skip_load_params_);
 
   CP_MEMBER(use_new_executor_);
+  CP_MEMBER(use_shape_bucket_);
+  CP_MEMBER(shape_bucket_boundaries_);
+  CP_MEMBER(shape_bucket_axis_);
+  CP_MEMBER(shape_bucket_capacity_);
+  CP_MEMBER(use_subgraph_memo_);
+  CP_MEMBER(subgraph_memo_outputs_);
+  CP_MEMBER(subgraph_memo_capacity_);
+  CP_MEMBER(subgraph_memo_ttl_ms_);
+  CP_MEMBER(use_shared_weights_);
   CP_MEMBER(use_pir_);
   CP_MEMBER(custom_passes_);
   CP_MEMBER(custom_pass_only_);
@@ -664,6 +676,58 @@ void AnalysisConfig::DisableMKLDNN() {
   Update();
 }
 
+void AnalysisConfig::EnableShapeBucket(const std::vector<int64_t> &boundaries,
+                                       int axis,
+                                       int capacity) {
+  PADDLE_ENFORCE_GE(axis,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The shape bucket axis should not be negative, but "
+                        "received %d.",
+                        axis));
+  PADDLE_ENFORCE_GT(capacity,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The shape bucket capacity should be positive, but "
+                        "received %d.",
+                        capacity));
+  PADDLE_ENFORCE_EQ(std::is_sorted(boundaries.begin(), boundaries.end()),
+                    true,
+                    platform::errors::InvalidArgument(
+                        "The shape bucket boundaries should be in ascending "
+                        "order."));
+  use_shape_bucket_ = true;
+  shape_bucket_boundaries_ = boundaries;
+  shape_bucket_axis_ = axis;
+  shape_bucket_capacity_ = capacity;
+}
+
+void AnalysisConfig::EnableSubgraphMemoization(
+    const std::vector<std::string> &output_names,
+    int capacity,
+    int64_t ttl_ms) {
+  PADDLE_ENFORCE_EQ(output_names.empty(),
+                    false,
+                    platform::errors::InvalidArgument(
+                        "The outputs of the memoized subgraph are empty."));
+  PADDLE_ENFORCE_GT(capacity,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The subgraph memoization capacity should be "
+                        "positive, but received %d.",
+                        capacity));
+  PADDLE_ENFORCE_GE(ttl_ms,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The subgraph memoization ttl should not be "
+                        "negative, but received %d.",
+                        ttl_ms));
+  use_subgraph_memo_ = true;
+  subgraph_memo_outputs_ = output_names;
+  subgraph_memo_capacity_ = capacity;
+  subgraph_memo_ttl_ms_ = ttl_ms;
+}
+
 void AnalysisConfig::SetMkldnnCacheCapacity(int capacity) {
 #ifdef PADDLE_WITH_DNNL
   mkldnn_cache_capacity_ = capacity;
@@ -732,6 +796,11 @@ void AnalysisConfig::EnableMkldnnInt8(
   Update();
 }
 
+void AnalysisConfig::EnableCpuInt8QuantLinear(bool x) {
+  use_cpu_int8_quant_linear_ = x;
+  Update();
+}
+
 MkldnnQuantizerConfig *AnalysisConfig::mkldnn_quantizer_config() const {
   PADDLE_ENFORCE_NOT_NULL(mkldnn_quantizer_config_,
                           platform::errors::PreconditionNotMet(
@@ -940,7 +1009,8 @@ void AnalysisConfig::Update() {
     } else {
       pass_builder_ = std::make_unique<CpuPassStrategy>();
     }
-
+    // the passes of the new builder are its defaults
+    quant_linear_pass_inserted_ = false;
   } else {
     if (use_gpu()) {
       pass_builder_ = std::make_unique<GpuPassStrategy>(
@@ -1074,6 +1144,35 @@ void AnalysisConfig::Update() {
 #endif
   }
 
+  // the int8 matmul + bias of quantized models, before the matmul passes.
+  // The passes are kept across the updates, only the pass inserted here is
+  // removed again, one added by the user stays.
+  const size_t quant_linear_idx =
+      pass_builder()->GetPassIndex("quant_linear_fuse_pass");
+  const bool has_quant_linear = quant_linear_idx != static_cast<size_t>(-1);
+  if (!has_quant_linear) quant_linear_pass_inserted_ = false;
+  bool cpu_int8_quant_linear = use_cpu_int8_quant_linear_;
+  if (cpu_int8_quant_linear && !enable_ir_optim_) {
+    LOG(ERROR) << "EnableCpuInt8QuantLinear() only works when IR "
+                  "optimization is enabled.";
+    cpu_int8_quant_linear = false;
+  } else if (cpu_int8_quant_linear &&
+             (use_gpu() || use_xpu() || use_ipu() || use_mkldnn_int8_)) {
+    LOG(ERROR) << "EnableCpuInt8QuantLinear() only works on CPU without "
+                  "OneDNN int8.";
+    cpu_int8_quant_linear = false;
+  }
+  if (cpu_int8_quant_linear && !has_quant_linear) {
+    const size_t idx =
+        pass_builder()->GetPassIndex("simplify_with_basic_ops_pass");
+    pass_builder()->InsertPass(idx == static_cast<size_t>(-1) ? 0 : idx + 1,
+                               "quant_linear_fuse_pass");
+    quant_linear_pass_inserted_ = true;
+  } else if (!cpu_int8_quant_linear && quant_linear_pass_inserted_) {
+    pass_builder()->DeletePass(quant_linear_idx);
+    quant_linear_pass_inserted_ = false;
+  }
+
   if (disable_mkldnn_fc_passes_) {
 #ifdef PADDLE_WITH_DNNL
     pass_builder()->DisableMkldnnFcPasses();
@@ -1168,6 +1267,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << use_mkldnn_bfloat16_;
   for (auto &item : bfloat16_enabled_op_types_) ss << item;
   ss << use_mkldnn_int8_;
+  ss << use_cpu_int8_quant_linear_;
   for (auto &item : quantize_enabled_op_types_) ss << item;
   for (auto &item : quantize_excluded_op_ids_) ss << item;
   ss << ";";
@@ -17,11 +17,14 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -36,6 +39,7 @@
 #include "paddle/fluid/framework/op_proto_maker.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/transfer_scope_cache.h"
 #include "paddle/fluid/framework/var_type_traits.h"
 #include "paddle/fluid/framework/version.h"
@@ -49,11 +53,13 @@
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
 #include "paddle/fluid/inference/api/resource_manager.h"
+#include "paddle/fluid/inference/api/shared_weight_store.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
 #include "paddle/fluid/inference/utils/model_utils.h"
 #include "paddle/fluid/inference/utils/singleton.h"
 #include "paddle/fluid/memory/memcpy.h"
 #include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/denormal.h"
 #include "paddle/fluid/platform/device/gpu/gpu_info.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/place.h"
@@ -802,6 +808,14 @@ bool AnalysisPredictor::PrepareProgram(
     } else {
       OptimizeInferenceProgram();
     }
+    if (config_.shared_weights_enabled()) {
+      size_t freed = SharedWeightStore::Instance().Deduplicate(
+          *inference_program_, scope_.get());
+      if (!config_.glog_info_disabled()) {
+        LOG(INFO) << "Shared weights free " << freed
+                  << " bytes of the predictor";
+      }
+    }
   } else {
     // If the program is passed from external, no need to optimize it, this
     // logic is used in the clone scenario.
@@ -1054,9 +1068,31 @@ bool AnalysisPredictor::PrepareExecutor() {
 
       executor_->PrepareInterpreterCore(
           sub_scope_, *pir_program_, execution_config);
+      if (config_.shape_bucket_enabled()) {
+        LOG(WARNING) << "Shape buckets are not supported with PIR, the "
+                        "inputs are run with their own shapes.";
+      }
+      if (config_.subgraph_memoization_enabled()) {
+        LOG(WARNING) << "Subgraph memoization is not supported with PIR.";
+      }
     } else {
-      executor_->PrepareInterpreterCore(
-          sub_scope_, *inference_program_, execution_config);
+      // the build results of the interpreter are kept next to the optimized
+      // model, a later predictor of the same model skips analysing them
+      if (config_.save_optimized_model_ || config_.use_optimized_model_) {
+        execution_config.build_cache_path =
+            GetOptimizedModelPath() + "/" + "_optimized.executor_build";
+      }
+      if (config_.subgraph_memoization_enabled() &&
+          PrepareSubgraphMemo(&execution_config)) {
+        executor_->PrepareInterpreterCore(
+            sub_scope_, *subgraph_memo_rest_program_, execution_config);
+      } else {
+        executor_->PrepareInterpreterCore(
+            sub_scope_, *inference_program_, execution_config);
+      }
+      if (config_.shape_bucket_enabled()) {
+        PrepareShapeBucket(execution_config);
+      }
     }
   }
 
@@ -1072,6 +1108,341 @@ bool AnalysisPredictor::PrepareExecutor() {
   return true;
 }
 
+AnalysisPredictor::ShapeBucketState::~ShapeBucketState() {
+  core.reset();
+  if (scope) parent->DeleteScope(scope);
+}
+
+void AnalysisPredictor::PrepareShapeBucket(
+    const framework::interpreter::ExecutionConfig &execution_config) {
+  if (!platform::is_cpu_place(place_)) {
+    LOG(WARNING) << "Shape buckets are only supported on CPU, the inputs "
+                    "are run with their own shapes.";
+    return;
+  }
+  // the buffers of a bucket are not collected, the next request of the
+  // bucket finds them in place
+  shape_bucket_execution_config_ = execution_config;
+  for (auto *var : inference_program_->Block(0).AllVars()) {
+    if (!var->Persistable()) {
+      shape_bucket_execution_config_.skip_gc_vars.insert(var->Name());
+    }
+  }
+  // only the inputs declared with a dynamic axis are padded
+  const int axis = config_.shape_bucket_axis_;
+  shape_bucket_padded_.clear();
+  for (auto &item : idx2feeds_) {
+    auto *var = inference_program_->Block(0).FindVar(item.second);
+    auto shape = var ? var->GetShape() : std::vector<int64_t>();
+    shape_bucket_padded_.push_back(static_cast<int>(shape.size()) > axis &&
+                                   shape[axis] < 0);
+  }
+  shape_bucket_policy_ = std::make_unique<details::ShapeBucketPolicy>(
+      config_.shape_bucket_boundaries_);
+  shape_bucket_states_ = std::make_unique<
+      details::LruCache<std::vector<int64_t>,
+                        std::unique_ptr<ShapeBucketState>>>(
+      config_.shape_bucket_capacity_);
+}
+
+namespace {
+
+// Copies src to dst of the padded dims, the tail of the padded axis is
+// filled with zeros. The LoD describes axis 0, which is only padded for
+// inputs without LoD.
+void PadToShapeBucket(const phi::DenseTensor &src,
+                      const phi::DDim &dims,
+                      int axis,
+                      phi::DenseTensor *dst) {
+  dst->Resize(dims);
+  dst->set_lod(src.lod());
+  auto *out = static_cast<uint8_t *>(
+      dst->mutable_data(platform::CPUPlace(), src.dtype()));
+  const auto *in = static_cast<const uint8_t *>(src.data());
+  const size_t size = phi::SizeOf(src.dtype());
+  if (dims.size() <= axis || dims == src.dims()) {
+    std::memcpy(out, in, src.numel() * size);
+    return;
+  }
+  const int64_t outer = common::product(common::slice_ddim(dims, 0, axis));
+  const size_t inner =
+      common::product(common::slice_ddim(dims, axis + 1, dims.size())) * size;
+  const size_t src_row = src.dims()[axis] * inner;
+  const size_t dst_row = dims[axis] * inner;
+  for (int64_t i = 0; i < outer; ++i) {
+    std::memcpy(out + i * dst_row, in + i * src_row, src_row);
+    std::memset(out + i * dst_row + src_row, 0, dst_row - src_row);
+  }
+}
+
+}  // namespace
+
+void AnalysisPredictor::RunShapeBucket(bool switch_stream) {
+  const int axis = config_.shape_bucket_axis_;
+  std::vector<const phi::DenseTensor *> inputs;
+  int64_t length = 0;
+  for (auto &item : idx2feeds_) {
+    auto *var = sub_scope_->FindVar(item.second);
+    PADDLE_ENFORCE_NOT_NULL(
+        var,
+        platform::errors::PreconditionNotMet("The input %s is not set.",
+                                             item.second));
+    inputs.push_back(&var->Get<phi::DenseTensor>());
+    if (shape_bucket_padded_[inputs.size() - 1] &&
+        inputs.back()->dims().size() > axis) {
+      length = std::max(length, inputs.back()->dims()[axis]);
+    }
+  }
+  const int64_t bucket = shape_bucket_policy_->Bucket(length);
+
+  // a state is prepared for the padded shapes of all the inputs
+  std::vector<phi::DDim> padded_dims;
+  std::vector<int64_t> key;
+  size_t i = 0;
+  for (auto &item : idx2feeds_) {
+    auto dims = inputs[i]->dims();
+    if (shape_bucket_padded_[i] && dims.size() > axis) dims[axis] = bucket;
+    PADDLE_ENFORCE_EQ(
+        axis != 0 || inputs[i]->lod().empty() || dims == inputs[i]->dims(),
+        true,
+        platform::errors::Unimplemented(
+            "The input %s has LoD, it can not be padded along axis 0 to the "
+            "shape bucket %d.",
+            item.second,
+            bucket));
+    padded_dims.push_back(dims);
+    key.push_back(dims.size());
+    for (int d = 0; d < dims.size(); ++d) key.push_back(dims[d]);
+    ++i;
+  }
+  ShapeBucketState *state = nullptr;
+  if (auto *cached = shape_bucket_states_->Get(key)) {
+    state = cached->get();
+  } else {
+    VLOG(3) << "Prepare the shape bucket " << bucket << " of length "
+            << length;
+    auto created = std::make_unique<ShapeBucketState>();
+    created->parent = sub_scope_;
+    created->scope = &sub_scope_->NewScope();
+    created->core = std::make_unique<framework::InterpreterCore>(
+        place_,
+        inference_program_->Block(0),
+        created->scope,
+        shape_bucket_execution_config_);
+    state = shape_bucket_states_->Put(key, std::move(created))->get();
+  }
+  // hooks registered on the predictor see the ops of the buckets as well
+  if (state->input_hooks != executor_->InputHooks().size()) {
+    state->core->SetInputHooks(executor_->InputHooks());
+    state->input_hooks = executor_->InputHooks().size();
+  }
+  if (state->output_hooks != executor_->OutputHooks().size()) {
+    state->core->SetOutputHooks(executor_->OutputHooks());
+    state->output_hooks = executor_->OutputHooks().size();
+  }
+
+  i = 0;
+  for (auto &item : idx2feeds_) {
+    PadToShapeBucket(
+        *inputs[i],
+        padded_dims[i],
+        axis,
+        state->scope->Var(item.second)->GetMutable<phi::DenseTensor>());
+    ++i;
+  }
+  {
+    platform::ScopedFlushDenormal flush;
+    state->core->Run({}, false, false, false, switch_stream);
+  }
+  for (auto &item : idx2fetches_) {
+    auto &output = state->scope->FindVar(item.second)->Get<phi::DenseTensor>();
+    auto *fetch = sub_scope_->Var(item.second)->GetMutable<phi::DenseTensor>();
+    fetch->ShareDataWith(output);
+    fetch->set_lod(output.lod());
+  }
+}
+
+bool AnalysisPredictor::PrepareSubgraphMemo(
+    framework::interpreter::ExecutionConfig *execution_config) {
+  if (!platform::is_cpu_place(place_) || config_.shape_bucket_enabled() ||
+      inference_program_->Size() > 1) {
+    LOG(WARNING) << "Subgraph memoization is only supported on CPU, without "
+                    "shape buckets and control flow blocks, disabled.";
+    return false;
+  }
+  auto &block = inference_program_->Block(0);
+  auto ops = block.AllOps();
+  auto is_data = [&](const std::string &name) {
+    auto *var = block.FindVar(name);
+    return name != framework::kEmptyVarName &&
+           !(var && var->Persistable());
+  };
+  for (auto &name : config_.subgraph_memo_outputs_) {
+    PADDLE_ENFORCE_NOT_NULL(
+        block.FindVar(name),
+        platform::errors::NotFound(
+            "The output %s of the memoized subgraph is not in the program.",
+            name));
+  }
+
+  // the ops the outputs depend on, from the last op backwards
+  std::vector<bool> in_subgraph(ops.size(), false);
+  std::unordered_set<std::string> needed(
+      config_.subgraph_memo_outputs_.begin(),
+      config_.subgraph_memo_outputs_.end());
+  for (size_t i = ops.size(); i-- > 0;) {
+    if (ops[i]->Type() == "feed" || ops[i]->Type() == "fetch") continue;
+    auto outputs = ops[i]->OutputArgumentNames();
+    if (std::none_of(outputs.begin(), outputs.end(), [&](auto &name) {
+          return needed.count(name) > 0;
+        })) {
+      continue;
+    }
+    in_subgraph[i] = true;
+    for (auto &name : ops[i]->InputArgumentNames()) needed.insert(name);
+  }
+
+  // the subgraph reads what no op of it writes, and its results are the
+  // outputs plus whatever else the rest of the ops read from it
+  std::unordered_set<std::string> produced, inputs;
+  subgraph_memo_weights_.clear();
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (!in_subgraph[i]) continue;
+    for (auto &name : ops[i]->InputArgumentNames()) {
+      if (!is_data(name)) {
+        if (name != framework::kEmptyVarName) {
+          subgraph_memo_weights_.insert(name);
+        }
+      } else if (!produced.count(name)) {
+        inputs.insert(name);
+      }
+    }
+    for (auto &name : ops[i]->OutputArgumentNames()) produced.insert(name);
+  }
+  std::set<std::string> outputs(config_.subgraph_memo_outputs_.begin(),
+                                config_.subgraph_memo_outputs_.end());
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (in_subgraph[i]) continue;
+    for (auto &name : ops[i]->InputArgumentNames()) {
+      if (is_data(name) && produced.count(name)) outputs.insert(name);
+    }
+  }
+  if (std::count(in_subgraph.begin(), in_subgraph.end(), true) == 0) {
+    LOG(WARNING) << "No op computes the outputs of the memoized subgraph, "
+                    "disabled.";
+    return false;
+  }
+  subgraph_memo_inputs_.assign(inputs.begin(), inputs.end());
+  std::sort(subgraph_memo_inputs_.begin(), subgraph_memo_inputs_.end());
+  subgraph_memo_outputs_.assign(outputs.begin(), outputs.end());
+
+  subgraph_memo_program_ =
+      std::make_unique<framework::ProgramDesc>(*inference_program_);
+  subgraph_memo_rest_program_ =
+      std::make_unique<framework::ProgramDesc>(*inference_program_);
+  for (size_t i = ops.size(); i-- > 0;) {
+    auto *program = in_subgraph[i] ? subgraph_memo_rest_program_.get()
+                                   : subgraph_memo_program_.get();
+    program->MutableBlock(0)->RemoveOp(i, i + 1);
+  }
+  VLOG(3) << "Memoize a subgraph of "
+          << subgraph_memo_program_->Block(0).OpSize() << " ops, "
+          << subgraph_memo_inputs_.size() << " inputs and "
+          << subgraph_memo_outputs_.size() << " outputs";
+
+  // both sides keep the outputs, the copies of a hit go to the same buffers
+  execution_config->skip_gc_vars.insert(subgraph_memo_outputs_.begin(),
+                                        subgraph_memo_outputs_.end());
+  auto subgraph_config = *execution_config;
+  subgraph_config.build_cache_path.clear();
+  subgraph_memo_core_ = std::make_unique<framework::InterpreterCore>(
+      place_, subgraph_memo_program_->Block(0), sub_scope_, subgraph_config);
+  subgraph_memo_cache_ = std::make_unique<
+      details::LruCache<uint64_t, SubgraphMemoEntry>>(
+      config_.subgraph_memo_capacity_);
+  return true;
+}
+
+void AnalysisPredictor::RunSubgraphMemo(bool switch_stream) {
+  uint64_t key = 0;
+  std::vector<const phi::DenseTensor *> inputs;
+  inputs.reserve(subgraph_memo_inputs_.size());
+  for (auto &name : subgraph_memo_inputs_) {
+    auto *var = sub_scope_->FindVar(name);
+    PADDLE_ENFORCE_EQ(
+        var && var->IsInitialized(),
+        true,
+        platform::errors::PreconditionNotMet(
+            "The input %s of the memoized subgraph is not set.", name));
+    auto &tensor = var->Get<phi::DenseTensor>();
+    inputs.push_back(&tensor);
+    auto dims = common::vectorize(tensor.dims());
+    auto dtype = static_cast<int>(tensor.dtype());
+    key = XXH64(dims.data(), dims.size() * sizeof(int64_t), key);
+    key = XXH64(&dtype, sizeof(dtype), key);
+    for (auto &level : tensor.lod()) {
+      key = XXH64(level.data(), level.size() * sizeof(size_t), key);
+    }
+    if (tensor.numel() > 0) {
+      key = XXH64(tensor.data(),
+                  tensor.numel() * phi::SizeOf(tensor.dtype()),
+                  key);
+    }
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  const auto ttl = std::chrono::milliseconds(config_.subgraph_memo_ttl_ms_);
+  auto *entry = subgraph_memo_cache_->Get(key);
+  // a hash is not proof, the inputs are compared before reusing the outputs
+  auto same_inputs = [&] {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      auto &cached = entry->inputs[i];
+      if (cached.dtype() != inputs[i]->dtype() ||
+          cached.dims() != inputs[i]->dims() ||
+          cached.lod() != inputs[i]->lod()) {
+        return false;
+      }
+      if (cached.numel() > 0 &&
+          std::memcmp(cached.data(),
+                      inputs[i]->data(),
+                      cached.numel() * phi::SizeOf(cached.dtype())) != 0) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (entry && (ttl.count() == 0 || now - entry->time < ttl) &&
+      same_inputs()) {
+    for (size_t i = 0; i < subgraph_memo_outputs_.size(); ++i) {
+      auto *output = sub_scope_->Var(subgraph_memo_outputs_[i])
+                         ->GetMutable<phi::DenseTensor>();
+      framework::TensorCopySync(entry->outputs[i], place_, output);
+      output->set_lod(entry->outputs[i].lod());
+    }
+    return;
+  }
+
+  {
+    platform::ScopedFlushDenormal flush;
+    subgraph_memo_core_->Run({}, false, false, false, switch_stream);
+  }
+  SubgraphMemoEntry created;
+  created.time = now;
+  created.inputs.resize(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    framework::TensorCopySync(*inputs[i], place_, &created.inputs[i]);
+    created.inputs[i].set_lod(inputs[i]->lod());
+  }
+  created.outputs.resize(subgraph_memo_outputs_.size());
+  for (size_t i = 0; i < subgraph_memo_outputs_.size(); ++i) {
+    auto &output = sub_scope_->FindVar(subgraph_memo_outputs_[i])
+                       ->Get<phi::DenseTensor>();
+    framework::TensorCopySync(output, place_, &created.outputs[i]);
+    created.outputs[i].set_lod(output.lod());
+  }
+  subgraph_memo_cache_->Put(key, std::move(created));
+}
+
 #if defined(PADDLE_WITH_DISTRIBUTE) && defined(PADDLE_WITH_PSCORE)
 bool AnalysisPredictor::PrepareFleetExecutor() {
   VLOG(3) << "AnalysisPredictor::PrepareFleetExecutor()";
@@ -2384,6 +2755,10 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetInputTensor(
       platform::errors::PreconditionNotMet(
           "The variable named %s is not found in the scope of the executor.",
           name));
+  // the handle may write a weight the memoized results were computed with
+  if (subgraph_memo_cache_ && subgraph_memo_weights_.count(name)) {
+    subgraph_memo_cache_->Clear();
+  }
   std::unique_ptr<ZeroCopyTensor> res(new ZeroCopyTensor(
       static_cast<void *>(scope), this->GetDeviceContexts()));
   res->input_or_output_ = true;
@@ -2515,7 +2890,10 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
   }
 #endif
 
-  if (config_.new_executor_enabled()) {  // NOLINT
+  if (shape_bucket_states_) {
+    RunShapeBucket(switch_stream);
+  } else if (config_.new_executor_enabled()) {  // NOLINT
+    if (subgraph_memo_cache_) RunSubgraphMemo(switch_stream);
     executor_->RunInterpreterCore({}, false, switch_stream);
   } else {
     executor_->Run();
@@ -2981,6 +3359,8 @@ AnalysisPredictor::~AnalysisPredictor() {  // NOLINT
     platform::CudaProfilerStop();
   }
 #endif
+  // the bucket scopes are kids of sub_scope_
+  shape_bucket_states_.reset();
   if (sub_scope_) {
     if (framework::global_transfer_scope_key().find(sub_scope_) !=
         framework::global_transfer_scope_key().end()) {
@@ -3488,6 +3868,16 @@ void Predictor::RegisterInputHook(const InputTensorHookFunc &hookfunc) {
 
 void *Predictor::GetExecStream() const { return predictor_->GetExecStream(); }
 
+SharedWeightsStats GetSharedWeightsStats() {
+  auto stats = paddle::SharedWeightStore::Instance().GetStats();
+  SharedWeightsStats result;
+  result.tensors = stats.tensors;
+  result.bytes = stats.bytes;
+  result.shared_tensors = stats.shared_tensors;
+  result.saved_bytes = stats.saved_bytes;
+  return result;
+}
+
 int GetNumBytesOfDataType(DataType dtype) {
   switch (dtype) {
     case DataType::FLOAT32:
@@ -15,15 +15,18 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "paddle/fluid/framework/naive_executor.h"
 #include "paddle/fluid/framework/op_compatible_info.h"
 #include "paddle/fluid/inference/analysis/analyzer.h"
 #include "paddle/fluid/inference/api/api_impl.h"
+#include "paddle/fluid/inference/api/details/shape_bucket.h"
 #include "paddle/fluid/inference/api/details/reset_tensor_array.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
@@ -495,6 +498,12 @@ class AnalysisPredictor : public PaddlePredictor {
  private:
   void StatisticShapeRangeInfo();
   void HookCollectShapeRangeInfo();
+  void PrepareShapeBucket(
+      const framework::interpreter::ExecutionConfig &execution_config);
+  void RunShapeBucket(bool switch_stream);
+  bool PrepareSubgraphMemo(
+      framework::interpreter::ExecutionConfig *execution_config);
+  void RunSubgraphMemo(bool switch_stream);
   void InitPlace();
   void InitDeviceContexts();
   void InitResourceManager(void *stream);
@@ -567,6 +576,47 @@ class AnalysisPredictor : public PaddlePredictor {
   std::vector<framework::OpDesc *> fetches_;
   std::map<size_t, std::string> idx2fetches_;
 
+  // The prepared state of one shape bucket, see
+  // AnalysisConfig::EnableShapeBucket. Its scope is a kid of sub_scope_, so
+  // that the weights are shared, and keeps the buffers of the bucket.
+  struct ShapeBucketState {
+    framework::Scope *parent{nullptr};
+    framework::Scope *scope{nullptr};
+    std::unique_ptr<framework::InterpreterCore> core;
+    // the numbers of hooks of executor_ set on core
+    size_t input_hooks{0};
+    size_t output_hooks{0};
+    ~ShapeBucketState();
+  };
+  framework::interpreter::ExecutionConfig shape_bucket_execution_config_;
+  std::unique_ptr<details::ShapeBucketPolicy> shape_bucket_policy_;
+  // of the inputs in idx2feeds_ order, whether the axis is dynamic
+  std::vector<bool> shape_bucket_padded_;
+  // padded input shapes -> state
+  std::unique_ptr<details::LruCache<std::vector<int64_t>,
+                                    std::unique_ptr<ShapeBucketState>>>
+      shape_bucket_states_;
+
+  // The results of the memoized subgraph for one input hash and the inputs
+  // they were computed from, see AnalysisConfig::EnableSubgraphMemoization.
+  struct SubgraphMemoEntry {
+    std::chrono::steady_clock::time_point time;
+    std::vector<phi::DenseTensor> inputs;
+    std::vector<phi::DenseTensor> outputs;
+  };
+  // the ops of block 0 split into the memoized subgraph and the rest, the
+  // rest is what executor_ runs
+  std::unique_ptr<framework::ProgramDesc> subgraph_memo_program_;
+  std::unique_ptr<framework::ProgramDesc> subgraph_memo_rest_program_;
+  std::unique_ptr<framework::InterpreterCore> subgraph_memo_core_;
+  std::vector<std::string> subgraph_memo_inputs_;
+  std::vector<std::string> subgraph_memo_outputs_;
+  // the persistable vars the subgraph reads, writing one through an input
+  // handle drops the memoized results
+  std::unordered_set<std::string> subgraph_memo_weights_;
+  std::unique_ptr<details::LruCache<uint64_t, SubgraphMemoEntry>>
+      subgraph_memo_cache_;
+
   phi::DataType model_precision_{phi::DataType::FLOAT32};
 
 #if PADDLE_WITH_DNNL
@@ -0,0 +1,88 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/inference/api/paddle_continuous_batching.h"
+#include "paddle/phi/core/enforce.h"
+
+namespace paddle_infer {
+namespace details {
+
+// The position of every token of `batch`, counted from the position of the
+// first token of its row.
+inline std::vector<int64_t> DecodePositionIds(const DecodeBatch& batch) {
+  std::vector<int64_t> position_ids(batch.token_ids.size());
+  for (size_t i = 0; i < batch.rows(); ++i) {
+    for (int t = batch.token_offsets[i]; t < batch.token_offsets[i + 1];
+         ++t) {
+      position_ids[t] = batch.positions[i] + t - batch.token_offsets[i];
+    }
+  }
+  return position_ids;
+}
+
+// Reads the next token of every row of `batch` from the decoding output
+// `output`, either int64 next tokens of [rows], or float logits of
+// [rows, vocab] or [tokens, vocab] decoded greedily at the last token of
+// each row. `Output` is a paddle_infer::Tensor or alike.
+template <typename Output>
+void ReadNextTokens(const DecodeBatch& batch,
+                    const std::string& name,
+                    Output* output,
+                    std::vector<int64_t>* next_tokens) {
+  const int rows = static_cast<int>(batch.rows());
+  const int tokens = static_cast<int>(batch.token_ids.size());
+  const auto shape = output->shape();
+  int64_t numel = 1;
+  for (int dim : shape) numel *= dim;
+  next_tokens->resize(rows);
+  if (output->type() == DataType::INT64) {
+    PADDLE_ENFORCE_EQ(numel,
+                      rows,
+                      phi::errors::InvalidArgument(
+                          "The next tokens %s should have one token per "
+                          "row, %d rows in the step.",
+                          name,
+                          rows));
+    output->CopyToCpu(next_tokens->data());
+    return;
+  }
+  PADDLE_ENFORCE_EQ(
+      output->type() == DataType::FLOAT32 && shape.size() == 2 &&
+          (shape[0] == rows || shape[0] == tokens),
+      true,
+      phi::errors::InvalidArgument(
+          "The decoding output %s should be int64 next tokens or float "
+          "logits of [rows or tokens, vocab].",
+          name));
+  std::vector<float> logits(numel);
+  output->CopyToCpu(logits.data());
+  const int vocab = shape[1];
+  for (int i = 0; i < rows; ++i) {
+    // with as many rows as tokens every row has one token, and both
+    // layouts agree
+    const int64_t last = shape[0] == rows ? i : batch.token_offsets[i + 1] - 1;
+    const float* row = logits.data() + last * vocab;
+    (*next_tokens)[i] = std::max_element(row, row + vocab) - row;
+  }
+}
+
+}  // namespace details
+}  // namespace paddle_infer
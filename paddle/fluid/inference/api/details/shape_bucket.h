@@ -0,0 +1,149 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "paddle/phi/core/enforce.h"
+
+namespace paddle {
+namespace details {
+
+// Maps a dynamic length to the length it is padded to.
+//
+// With configured boundaries a length goes to the smallest boundary that is
+// not below it. Without them the first `learn_samples` lengths are rounded
+// up to powers of two while they are recorded, then `bucket_num` boundaries
+// are placed at evenly spaced quantiles of them, so that the buckets follow
+// the traffic. Lengths above the last boundary are rounded up to a power of
+// two as well.
+class ShapeBucketPolicy {
+ public:
+  explicit ShapeBucketPolicy(std::vector<int64_t> boundaries,
+                             size_t bucket_num = 8,
+                             size_t learn_samples = 256)
+      : boundaries_(std::move(boundaries)),
+        bucket_num_(bucket_num),
+        learn_samples_(learn_samples),
+        learned_(!boundaries_.empty()) {
+    PADDLE_ENFORCE_EQ(
+        std::is_sorted(boundaries_.begin(), boundaries_.end()),
+        true,
+        phi::errors::InvalidArgument(
+            "The shape bucket boundaries should be in ascending order."));
+    PADDLE_ENFORCE_GT(bucket_num_,
+                      0UL,
+                      phi::errors::InvalidArgument(
+                          "The number of shape buckets should be positive."));
+    boundaries_.erase(std::unique(boundaries_.begin(), boundaries_.end()),
+                      boundaries_.end());
+  }
+
+  int64_t Bucket(int64_t length) {
+    if (!learned_) {
+      samples_.push_back(length);
+      if (samples_.size() >= learn_samples_) Learn();
+      return RoundUpPow2(length);
+    }
+    auto it = std::lower_bound(boundaries_.begin(), boundaries_.end(), length);
+    return it == boundaries_.end() ? RoundUpPow2(length) : *it;
+  }
+
+  bool learned() const { return learned_; }
+  const std::vector<int64_t>& boundaries() const { return boundaries_; }
+
+  static int64_t RoundUpPow2(int64_t length) {
+    int64_t bucket = 1;
+    while (bucket < length) bucket <<= 1;
+    return bucket;
+  }
+
+ private:
+  void Learn() {
+    std::sort(samples_.begin(), samples_.end());
+    for (size_t i = 1; i <= bucket_num_; ++i) {
+      size_t pos = (samples_.size() * i + bucket_num_ - 1) / bucket_num_;
+      boundaries_.push_back(samples_[std::min(pos, samples_.size()) - 1]);
+    }
+    boundaries_.erase(std::unique(boundaries_.begin(), boundaries_.end()),
+                      boundaries_.end());
+    samples_.clear();
+    samples_.shrink_to_fit();
+    learned_ = true;
+  }
+
+  std::vector<int64_t> boundaries_;
+  size_t bucket_num_;
+  size_t learn_samples_;
+  bool learned_;
+  std::vector<int64_t> samples_;
+};
+
+// A fixed capacity cache that drops the least recently used value when a new
+// key comes in full.
+template <typename Key, typename Value>
+class LruCache {
+ public:
+  explicit LruCache(size_t capacity) : capacity_(capacity) {
+    PADDLE_ENFORCE_GT(capacity_,
+                      0UL,
+                      phi::errors::InvalidArgument(
+                          "The capacity of the LRU cache should be positive."));
+  }
+
+  // nullptr when missing, a hit becomes the most recently used
+  Value* Get(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) return nullptr;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  Value* Put(const Key& key, Value value) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return &it->second->second;
+    }
+    if (entries_.size() >= capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::move(value));
+    index_[key] = entries_.begin();
+    return &entries_.front().second;
+  }
+
+  size_t size() const { return entries_.size(); }
+
+  void Clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+ private:
+  size_t capacity_;
+  std::list<std::pair<Key, Value>> entries_;
+  std::map<Key, typename std::list<std::pair<Key, Value>>::iterator> index_;
+};
+
+}  // namespace details
+}  // namespace paddle
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/details/shape_bucket.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace details {
+
+TEST(ShapeBucketPolicy, configured) {
+  ShapeBucketPolicy policy({16, 32, 64});
+  EXPECT_TRUE(policy.learned());
+  EXPECT_EQ(policy.Bucket(1), 16);
+  EXPECT_EQ(policy.Bucket(16), 16);
+  EXPECT_EQ(policy.Bucket(17), 32);
+  EXPECT_EQ(policy.Bucket(64), 64);
+  EXPECT_EQ(policy.Bucket(65), 128);
+  EXPECT_EQ(policy.Bucket(300), 512);
+}
+
+TEST(ShapeBucketPolicy, learned) {
+  ShapeBucketPolicy policy({}, 4, 100);
+  for (int64_t i = 1; i < 100; ++i) {
+    EXPECT_EQ(policy.Bucket(i), ShapeBucketPolicy::RoundUpPow2(i));
+    EXPECT_FALSE(policy.learned());
+  }
+  policy.Bucket(100);
+  ASSERT_TRUE(policy.learned());
+  EXPECT_EQ(policy.boundaries(), (std::vector<int64_t>{25, 50, 75, 100}));
+  EXPECT_EQ(policy.Bucket(26), 50);
+  EXPECT_EQ(policy.Bucket(101), 128);
+}
+
+TEST(ShapeBucketPolicy, unsorted) {
+  EXPECT_ANY_THROW(ShapeBucketPolicy({32, 16}));
+}
+
+TEST(LruCache, evict) {
+  LruCache<int, std::unique_ptr<std::string>> cache(2);
+  cache.Put(1, std::make_unique<std::string>("a"));
+  cache.Put(2, std::make_unique<std::string>("b"));
+  ASSERT_NE(cache.Get(1), nullptr);
+  cache.Put(3, std::make_unique<std::string>("c"));
+  EXPECT_EQ(cache.size(), 2UL);
+  EXPECT_EQ(cache.Get(2), nullptr);
+  EXPECT_EQ(**cache.Get(1), "a");
+  EXPECT_EQ(**cache.Get(3), "c");
+  cache.Put(3, std::make_unique<std::string>("d"));
+  EXPECT_EQ(**cache.Get(3), "d");
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0UL);
+}
+
+}  // namespace details
+}  // namespace paddle
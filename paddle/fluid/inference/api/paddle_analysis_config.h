@@ -874,6 +874,58 @@ struct PD_INFER_DECL AnalysisConfig {
 
   bool new_executor_enabled() const { return use_new_executor_; }
 
+  ///
+  /// \brief Run the new executor on inputs padded to shape buckets along a
+  /// dynamic axis, such as the sequence length of NLP models. Each bucket
+  /// keeps its own prepared interpreter and buffers, the `capacity` most
+  /// recently used ones are kept. Only for CPU and the legacy program, and
+  /// only for models whose results do not depend on the zero padding (for
+  /// example with an attention mask input). Outputs keep the padded length.
+  /// Inputs with LoD can not be padded along axis 0.
+  ///
+  /// \param boundaries the ascending bucket lengths, learned from the first
+  /// requests when empty.
+  /// \param axis the padded axis of the inputs.
+  /// \param capacity the number of buckets kept prepared.
+  ///
+  void EnableShapeBucket(const std::vector<int64_t>& boundaries = {},
+                         int axis = 1,
+                         int capacity = 4);
+
+  bool shape_bucket_enabled() const { return use_shape_bucket_; }
+
+  ///
+  /// \brief Memoize the part of the model that computes `output_names`
+  /// with the new executor, keyed by a hash of the inputs of that part. The
+  /// part is skipped when the same inputs come again, as the user tower of a
+  /// recommendation model does for every candidate batch of a session. Only
+  /// for CPU and the legacy program without control flow blocks. A hit
+  /// compares the inputs with the ones the results were computed from. The
+  /// weights are not part of the key, taking an input handle of a weight the
+  /// part reads drops the memoized results.
+  ///
+  /// \param output_names the vars the memoized part ends at.
+  /// \param capacity the number of input hashes kept.
+  /// \param ttl_ms how long a result is kept in ms, no limit when 0.
+  ///
+  void EnableSubgraphMemoization(const std::vector<std::string>& output_names,
+                                 int capacity = 64,
+                                 int64_t ttl_ms = 0);
+
+  bool subgraph_memoization_enabled() const { return use_subgraph_memo_; }
+
+  ///
+  /// \brief Keep the weights in a process-wide store addressed by their
+  /// content, a weight equal to one loaded by another predictor, even of
+  /// another model, shares its memory. The predictors must not write their
+  /// weights afterwards. See GetSharedWeightsStats.
+  ///
+  /// \param x whether to share the weights.
+  ///
+  void EnableSharedWeights(bool x = true) { use_shared_weights_ = x; }
+
+  bool shared_weights_enabled() const { return use_shared_weights_; }
+
   /// \brief A boolean state telling whether to use new IR.
   ///
   /// \return bool whether to use new IR.
@@ -990,6 +1042,26 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool mkldnn_int8_enabled() const { return use_mkldnn_int8_; }
 
+  ///
+  /// \brief Run the linear layers of a quantized model in int8 with the
+  /// native CPU quant_linear kernel instead of dequantizing them to fp32.
+  /// Only for CPU without OneDNN int8, which lowers them itself. The int8
+  /// results differ from the fp32 ones within the quantization error.
+  ///
+  /// \param x Whether to fuse the quantized linear layers.
+  ///
+  void EnableCpuInt8QuantLinear(bool x = true);
+
+  ///
+  /// \brief A boolean state telling whether the quantized linear layers run
+  /// with the native CPU int8 kernel.
+  ///
+  /// \return bool Whether the quantized linear layers run in int8.
+  ///
+  bool cpu_int8_quant_linear_enabled() const {
+    return use_cpu_int8_quant_linear_;
+  }
+
   ///
   /// \brief Turn on OneDNN bfloat16.
   ///
@@ -1332,6 +1404,18 @@ struct PD_INFER_DECL AnalysisConfig {
 
   bool use_new_executor_{false};
 
+  bool use_shape_bucket_{false};
+  std::vector<int64_t> shape_bucket_boundaries_;
+  int shape_bucket_axis_{1};
+  int shape_bucket_capacity_{4};
+
+  bool use_subgraph_memo_{false};
+  std::vector<std::string> subgraph_memo_outputs_;
+  int subgraph_memo_capacity_{64};
+  int64_t subgraph_memo_ttl_ms_{0};
+
+  bool use_shared_weights_{false};
+
   bool specify_input_name_{false};
 
   int cpu_math_library_num_threads_{1};
@@ -1359,6 +1443,9 @@ struct PD_INFER_DECL AnalysisConfig {
   bool use_mkldnn_bfloat16_{false};
   std::unordered_set<std::string> bfloat16_enabled_op_types_;
   bool use_mkldnn_int8_{false};
+  bool use_cpu_int8_quant_linear_{false};
+  // whether Update inserted the quant_linear_fuse_pass of the option above
+  bool quant_linear_pass_inserted_{false};
   std::unordered_set<int> quantize_excluded_op_ids_{};
   std::unordered_set<std::string> quantize_enabled_op_types_{};
 
@@ -0,0 +1,384 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/paddle_continuous_batching.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/details/continuous_batching.h"
+#include "paddle/phi/core/enforce.h"
+
+namespace paddle_infer {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ElapsedMs(Clock::time_point start, Clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+}  // namespace
+
+struct ContinuousBatchingScheduler::Impl {
+  struct Sequence {
+    GenerationRequest request;
+    std::promise<GenerationResult> promise;
+    Clock::time_point submit_time;
+    GenerationResult result;
+    int32_t cache_slot{-1};
+    bool prefilled{false};
+  };
+
+  Impl(const ContinuousBatchingConfig& config, DecodeStepFunc step)
+      : config(config), step(std::move(step)) {
+    for (int slot = config.max_batch_size - 1; slot >= 0; --slot) {
+      free_slots.push_back(slot);
+    }
+  }
+
+  // Moves the waiting requests that fit into the active batch.
+  void Admit();
+  // Fails the requests of `sequences` with `error` and frees their slots.
+  void Fail(std::vector<std::unique_ptr<Sequence>>* sequences,
+            std::exception_ptr error);
+
+  const ContinuousBatchingConfig config;
+  const DecodeStepFunc step;
+
+  mutable std::mutex mutex;
+  std::condition_variable cv;
+  // guarded by mutex
+  std::deque<std::unique_ptr<Sequence>> waiting;
+  size_t active_num{0};
+  bool stop{false};
+  ContinuousBatchingStats stats;
+  uint64_t rows_sum{0};
+  double ttft_sum_ms{0};
+  Clock::time_point first_step_start;
+  Clock::time_point last_step_end;
+
+  // one stepping thread at a time, the state below is its own
+  std::mutex step_mutex;
+  std::vector<std::unique_ptr<Sequence>> active;
+  std::vector<int32_t> free_slots;
+
+  std::thread loop;
+};
+
+void ContinuousBatchingScheduler::Impl::Admit() {
+  std::lock_guard<std::mutex> guard(mutex);
+  // the sequences already in decode take a token each
+  int64_t budget =
+      config.max_step_tokens - static_cast<int64_t>(active.size());
+  // in order, so a long prompt is not starved by the short ones behind it
+  while (!waiting.empty() && !free_slots.empty()) {
+    const int64_t prompt_len =
+        static_cast<int64_t>(waiting.front()->request.prompt.size());
+    if (prompt_len > budget && !active.empty()) break;
+    budget -= prompt_len;
+    waiting.front()->cache_slot = free_slots.back();
+    free_slots.pop_back();
+    active.push_back(std::move(waiting.front()));
+    waiting.pop_front();
+  }
+  active_num = active.size();
+}
+
+void ContinuousBatchingScheduler::Impl::Fail(
+    std::vector<std::unique_ptr<Sequence>>* sequences,
+    std::exception_ptr error) {
+  for (auto& seq : *sequences) {
+    if (seq->cache_slot >= 0) free_slots.push_back(seq->cache_slot);
+    seq->promise.set_exception(error);
+  }
+  sequences->clear();
+}
+
+ContinuousBatchingScheduler::ContinuousBatchingScheduler(
+    const ContinuousBatchingConfig& config, DecodeStepFunc step) {
+  PADDLE_ENFORCE_GT(
+      config.max_batch_size,
+      0,
+      phi::errors::InvalidArgument(
+          "The max_batch_size of continuous batching should be positive."));
+  PADDLE_ENFORCE_GT(
+      config.max_step_tokens,
+      0,
+      phi::errors::InvalidArgument(
+          "The max_step_tokens of continuous batching should be positive."));
+  PADDLE_ENFORCE_GT(
+      config.max_seq_len,
+      1,
+      phi::errors::InvalidArgument(
+          "The max_seq_len of continuous batching should be at least 2."));
+  PADDLE_ENFORCE_EQ(static_cast<bool>(step),
+                    true,
+                    phi::errors::InvalidArgument(
+                        "The step function of continuous batching is empty."));
+  impl_ = std::make_unique<Impl>(config, std::move(step));
+}
+
+ContinuousBatchingScheduler::~ContinuousBatchingScheduler() {
+  Stop();
+  auto error = std::make_exception_ptr(std::runtime_error(
+      "The continuous batching scheduler was destroyed before the request "
+      "finished."));
+  std::lock_guard<std::mutex> step_guard(impl_->step_mutex);
+  impl_->Fail(&impl_->active, error);
+  std::lock_guard<std::mutex> guard(impl_->mutex);
+  for (auto& seq : impl_->waiting) seq->promise.set_exception(error);
+  impl_->waiting.clear();
+}
+
+std::future<GenerationResult> ContinuousBatchingScheduler::Submit(
+    GenerationRequest request) {
+  const auto& config = impl_->config;
+  const int64_t prompt_len = static_cast<int64_t>(request.prompt.size());
+  PADDLE_ENFORCE_GT(prompt_len,
+                    0,
+                    phi::errors::InvalidArgument(
+                        "The prompt of a generation request is empty."));
+  PADDLE_ENFORCE_LE(
+      prompt_len,
+      std::min(config.max_step_tokens, config.max_seq_len - 1),
+      phi::errors::InvalidArgument(
+          "The prompt of %d tokens is longer than a step (%d tokens) or "
+          "leaves no room to generate in max_seq_len (%d).",
+          prompt_len,
+          config.max_step_tokens,
+          config.max_seq_len));
+  PADDLE_ENFORCE_GT(request.max_new_tokens,
+                    0,
+                    phi::errors::InvalidArgument(
+                        "The max_new_tokens of a generation request should "
+                        "be positive."));
+
+  auto seq = std::make_unique<Impl::Sequence>();
+  seq->request = std::move(request);
+  seq->submit_time = Clock::now();
+  auto future = seq->promise.get_future();
+  {
+    std::lock_guard<std::mutex> guard(impl_->mutex);
+    impl_->waiting.push_back(std::move(seq));
+  }
+  impl_->cv.notify_one();
+  return future;
+}
+
+bool ContinuousBatchingScheduler::Step() {
+  std::lock_guard<std::mutex> step_guard(impl_->step_mutex);
+  impl_->Admit();
+  auto& active = impl_->active;
+  if (active.empty()) return false;
+
+  DecodeBatch batch;
+  batch.token_offsets.reserve(active.size() + 1);
+  batch.positions.reserve(active.size());
+  batch.cache_slots.reserve(active.size());
+  batch.token_offsets.push_back(0);
+  for (auto& seq : active) {
+    const auto& prompt = seq->request.prompt;
+    if (seq->prefilled) {
+      batch.token_ids.push_back(seq->result.tokens.back());
+      batch.positions.push_back(static_cast<int64_t>(
+          prompt.size() + seq->result.tokens.size() - 1));
+    } else {
+      batch.token_ids.insert(
+          batch.token_ids.end(), prompt.begin(), prompt.end());
+      batch.positions.push_back(0);
+    }
+    batch.token_offsets.push_back(
+        static_cast<int32_t>(batch.token_ids.size()));
+    batch.cache_slots.push_back(seq->cache_slot);
+  }
+
+  std::vector<int64_t> next_tokens;
+  const auto start = Clock::now();
+  try {
+    impl_->step(batch, &next_tokens);
+    PADDLE_ENFORCE_EQ(
+        next_tokens.size(),
+        active.size(),
+        phi::errors::InvalidArgument(
+            "The decoding step gave %d tokens for a batch of %d rows.",
+            next_tokens.size(),
+            active.size()));
+  } catch (...) {
+    LOG(ERROR) << "A continuous batching step failed, its "
+               << active.size() << " requests retire with the error.";
+    impl_->Fail(&active, std::current_exception());
+    std::lock_guard<std::mutex> guard(impl_->mutex);
+    impl_->active_num = 0;
+    return true;
+  }
+  const auto end = Clock::now();
+
+  std::vector<std::unique_ptr<Impl::Sequence>> finished;
+  size_t kept = 0;
+  uint64_t prompt_tokens = 0;
+  for (size_t i = 0; i < active.size(); ++i) {
+    auto& seq = active[i];
+    auto& result = seq->result;
+    if (!seq->prefilled) {
+      seq->prefilled = true;
+      prompt_tokens += seq->request.prompt.size();
+      result.time_to_first_token_ms = ElapsedMs(seq->submit_time, end);
+    }
+    result.tokens.push_back(next_tokens[i]);
+    const size_t seq_len = seq->request.prompt.size() + result.tokens.size();
+    if (next_tokens[i] == seq->request.eos_token_id ||
+        static_cast<int>(result.tokens.size()) >= seq->request.max_new_tokens ||
+        seq_len >= static_cast<size_t>(impl_->config.max_seq_len)) {
+      result.latency_ms = ElapsedMs(seq->submit_time, end);
+      impl_->free_slots.push_back(seq->cache_slot);
+      finished.push_back(std::move(seq));
+    } else {
+      active[kept++] = std::move(seq);
+    }
+  }
+  const size_t rows = active.size();
+  active.resize(kept);
+
+  {
+    std::lock_guard<std::mutex> guard(impl_->mutex);
+    auto& stats = impl_->stats;
+    if (stats.steps == 0) impl_->first_step_start = start;
+    impl_->last_step_end = end;
+    ++stats.steps;
+    impl_->rows_sum += rows;
+    stats.step_time_ms += ElapsedMs(start, end);
+    stats.prompt_tokens += prompt_tokens;
+    stats.generated_tokens += rows;
+    stats.finished_requests += finished.size();
+    for (auto& seq : finished) {
+      const double ttft = seq->result.time_to_first_token_ms;
+      impl_->ttft_sum_ms += ttft;
+      stats.max_time_to_first_token_ms =
+          std::max(stats.max_time_to_first_token_ms, ttft);
+    }
+    impl_->active_num = kept;
+  }
+  for (auto& seq : finished) {
+    seq->promise.set_value(std::move(seq->result));
+  }
+  return true;
+}
+
+void ContinuousBatchingScheduler::Start() {
+  PADDLE_ENFORCE_EQ(impl_->loop.joinable(),
+                    false,
+                    phi::errors::PreconditionNotMet(
+                        "The continuous batching loop is already running."));
+  {
+    std::lock_guard<std::mutex> guard(impl_->mutex);
+    impl_->stop = false;
+  }
+  impl_->loop = std::thread([this] {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(impl_->mutex);
+        impl_->cv.wait(lock, [this] {
+          return impl_->stop || !impl_->waiting.empty() ||
+                 impl_->active_num > 0;
+        });
+        if (impl_->stop) break;
+      }
+      Step();
+    }
+  });
+}
+
+void ContinuousBatchingScheduler::Stop() {
+  {
+    std::lock_guard<std::mutex> guard(impl_->mutex);
+    impl_->stop = true;
+  }
+  impl_->cv.notify_all();
+  if (impl_->loop.joinable()) impl_->loop.join();
+}
+
+size_t ContinuousBatchingScheduler::NumActive() const {
+  std::lock_guard<std::mutex> guard(impl_->mutex);
+  return impl_->active_num;
+}
+
+size_t ContinuousBatchingScheduler::NumWaiting() const {
+  std::lock_guard<std::mutex> guard(impl_->mutex);
+  return impl_->waiting.size();
+}
+
+ContinuousBatchingStats ContinuousBatchingScheduler::GetStats() const {
+  std::lock_guard<std::mutex> guard(impl_->mutex);
+  ContinuousBatchingStats stats = impl_->stats;
+  if (stats.steps == 0) return stats;
+  stats.mean_batch_size =
+      static_cast<double>(impl_->rows_sum) / static_cast<double>(stats.steps);
+  const double wall_ms =
+      ElapsedMs(impl_->first_step_start, impl_->last_step_end);
+  if (wall_ms > 0) {
+    stats.tokens_per_second =
+        static_cast<double>(stats.generated_tokens) * 1000.0 / wall_ms;
+  }
+  if (stats.step_time_ms > 0) {
+    stats.step_tokens_per_second = static_cast<double>(stats.generated_tokens) *
+                                   1000.0 / stats.step_time_ms;
+  }
+  if (stats.finished_requests > 0) {
+    stats.mean_time_to_first_token_ms =
+        impl_->ttft_sum_ms / static_cast<double>(stats.finished_requests);
+  }
+  return stats;
+}
+
+DecodeStepFunc MakePredictorDecodeStep(Predictor* predictor,
+                                       const DecodeStepIoNames& names) {
+  PADDLE_ENFORCE_NOT_NULL(
+      predictor,
+      phi::errors::InvalidArgument("The predictor to decode with is null."));
+  return [predictor, names](const DecodeBatch& batch,
+                            std::vector<int64_t>* next_tokens) {
+    const int rows = static_cast<int>(batch.rows());
+    const int tokens = static_cast<int>(batch.token_ids.size());
+    const auto position_ids = details::DecodePositionIds(batch);
+    auto feed = [predictor](const std::string& name, int numel, auto* data) {
+      if (name.empty()) return;
+      auto tensor = predictor->GetInputHandle(name);
+      tensor->Reshape({numel});
+      tensor->CopyFromCpu(data);
+    };
+    feed(names.token_ids, tokens, batch.token_ids.data());
+    feed(names.token_offsets, rows + 1, batch.token_offsets.data());
+    feed(names.position_ids, tokens, position_ids.data());
+    feed(names.cache_slots, rows, batch.cache_slots.data());
+    PADDLE_ENFORCE_EQ(
+        predictor->Run(),
+        true,
+        phi::errors::Fatal("The predictor failed to run a decoding step."));
+
+    auto output = predictor->GetOutputHandle(names.output);
+    details::ReadNextTokens(batch, names.output, output.get(), next_tokens);
+  };
+}
+
+}  // namespace paddle_infer
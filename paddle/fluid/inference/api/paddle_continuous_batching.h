@@ -0,0 +1,176 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle_inference_api.h"  // NOLINT
+
+///
+/// \file paddle_continuous_batching.h
+///
+/// \brief A serving loop for generative decoding that admits and retires
+/// sequences between decoding steps, instead of running a whole batch until
+/// its longest sequence finishes.
+///
+
+namespace paddle_infer {
+
+///
+/// \brief A generation request.
+///
+struct PD_INFER_DECL GenerationRequest {
+  std::vector<int64_t> prompt;  ///< the prompt token ids, not empty
+  int max_new_tokens{16};       ///< the generated tokens at most
+  int64_t eos_token_id{-1};     ///< stops after this token, -1 for none
+};
+
+///
+/// \brief The tokens of a finished request and its timings.
+///
+struct PD_INFER_DECL GenerationResult {
+  std::vector<int64_t> tokens;       ///< the generated tokens, eos included
+  double time_to_first_token_ms{0};  ///< from Submit to the first token
+  double latency_ms{0};              ///< from Submit to the last token
+};
+
+///
+/// \brief The rows of one decoding step, packed from the active sequences.
+///
+/// Row i feeds the tokens [token_offsets[i], token_offsets[i + 1]) of
+/// token_ids, at the positions from positions[i] on: the whole prompt on the
+/// first step of a sequence (prefill, positions[i] == 0) and its last token
+/// afterwards. The keys and values of a row go to the KV cache slot
+/// cache_slots[i], which belongs to the sequence until it retires, so a
+/// model keeps its cache as [max_batch_size, ...] and indexes it by slot.
+///
+struct PD_INFER_DECL DecodeBatch {
+  std::vector<int64_t> token_ids;
+  std::vector<int32_t> token_offsets;  ///< rows + 1 offsets
+  std::vector<int64_t> positions;
+  std::vector<int32_t> cache_slots;
+
+  size_t rows() const { return cache_slots.size(); }
+};
+
+///
+/// \brief Runs one decoding step and writes the next token of every row.
+///
+using DecodeStepFunc = std::function<void(const DecodeBatch& batch,
+                                          std::vector<int64_t>* next_tokens)>;
+
+struct PD_INFER_DECL ContinuousBatchingConfig {
+  int max_batch_size{8};  ///< the KV cache slots, the rows of a step at most
+  /// the tokens of a step at most, which bounds the prompts admitted
+  /// together and the longest prompt
+  int max_step_tokens{2048};
+  int max_seq_len{2048};  ///< the prompt and generated tokens at most
+};
+
+struct PD_INFER_DECL ContinuousBatchingStats {
+  uint64_t steps{0};
+  uint64_t finished_requests{0};
+  uint64_t prompt_tokens{0};
+  uint64_t generated_tokens{0};
+  double mean_batch_size{0};  ///< rows per step
+  double step_time_ms{0};     ///< spent in the step function
+  /// generated tokens per second of wall time, from the start of the first
+  /// step to the end of the last one
+  double tokens_per_second{0};
+  /// generated tokens per second spent in the step function
+  double step_tokens_per_second{0};
+  double mean_time_to_first_token_ms{0};
+  double max_time_to_first_token_ms{0};
+};
+
+///
+/// \class ContinuousBatchingScheduler
+///
+/// \brief Interleaves the decoding of the submitted requests.
+///
+/// Before every step the waiting requests are admitted in order while there
+/// is a free KV cache slot and their prompts fit in the token budget of the
+/// step; after it the sequences that hit eos, max_new_tokens or max_seq_len
+/// retire, fulfil their futures and free their slots. So a short request
+/// does not wait for the longest sequence of a batch.
+///
+/// Step() runs one step on the calling thread; Start() runs steps on a
+/// thread of its own while there is work. Submit() may be called from any
+/// thread.
+///
+/// \code{cpp}
+///   ContinuousBatchingScheduler scheduler(
+///       config, MakePredictorDecodeStep(predictor.get()));
+///   scheduler.Start();
+///   auto result = scheduler.Submit(request).get();
+/// \endcode
+///
+class PD_INFER_DECL ContinuousBatchingScheduler {
+ public:
+  ContinuousBatchingScheduler(const ContinuousBatchingConfig& config,
+                              DecodeStepFunc step);
+  /// Stops the loop, the unfinished requests get an exception.
+  ~ContinuousBatchingScheduler();
+
+  std::future<GenerationResult> Submit(GenerationRequest request);
+
+  ///
+  /// \brief Admits, runs one step and retires.
+  ///
+  /// An exception of the step function goes to the requests of that step,
+  /// which retire. \return false if there was nothing to run
+  ///
+  bool Step();
+
+  void Start();
+  void Stop();
+
+  size_t NumActive() const;
+  size_t NumWaiting() const;
+  ContinuousBatchingStats GetStats() const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+///
+/// \brief The input and output names of a decoding model. An empty input
+/// name is not fed.
+///
+struct PD_INFER_DECL DecodeStepIoNames {
+  std::string token_ids{"input_ids"};        ///< int64 [tokens]
+  std::string token_offsets{"seq_offsets"};  ///< int32 [rows + 1]
+  std::string position_ids{"position_ids"};  ///< int64 [tokens]
+  std::string cache_slots{"cache_slots"};    ///< int32 [rows]
+  /// int64 [rows] next tokens, or float logits [rows or tokens, vocab] of
+  /// which the last token of each row is decoded greedily
+  std::string output{"next_tokens"};
+};
+
+///
+/// \brief A DecodeStepFunc that feeds a DecodeBatch to `predictor` and runs
+/// it. The predictor must outlive the function.
+///
+PD_INFER_DECL DecodeStepFunc
+MakePredictorDecodeStep(Predictor* predictor,
+                        const DecodeStepIoNames& names = DecodeStepIoNames());
+
+}  // namespace paddle_infer
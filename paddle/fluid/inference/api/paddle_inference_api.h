@@ -232,6 +232,22 @@ PD_INFER_DECL std::shared_ptr<Predictor> CreatePredictor(
 
 PD_INFER_DECL int GetNumBytesOfDataType(DataType dtype);
 
+///
+/// \brief The weights kept in the process-wide store of
+/// Config::EnableSharedWeights.
+///
+struct PD_INFER_DECL SharedWeightsStats {
+  /// distinct weights alive in the store and their bytes
+  size_t tensors{0};
+  size_t bytes{0};
+  /// weights of predictors that share the memory of another predictor's
+  /// weight, and the bytes that saves
+  size_t shared_tensors{0};
+  size_t saved_bytes{0};
+};
+
+PD_INFER_DECL SharedWeightsStats GetSharedWeightsStats();
+
 PD_INFER_DECL std::string GetVersion();
 PD_INFER_DECL std::tuple<int, int, int> GetTrtCompileVersion();
 PD_INFER_DECL std::tuple<int, int, int> GetTrtRuntimeVersion();
@@ -0,0 +1,128 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/shared_weight_store.h"
+
+#include <xxhash.h>
+
+#include <cstring>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/tensor_util.h"
+
+namespace paddle {
+
+namespace {
+
+size_t NumBytes(const phi::DenseTensor& tensor) {
+  return tensor.numel() * phi::SizeOf(tensor.dtype());
+}
+
+// The bytes of a tensor, copied to host memory when they are elsewhere.
+const void* HostData(const phi::DenseTensor& tensor, phi::DenseTensor* host) {
+  if (platform::is_cpu_place(tensor.place())) return tensor.data();
+  framework::TensorCopySync(tensor, platform::CPUPlace(), host);
+  return host->data();
+}
+
+}  // namespace
+
+SharedWeightStore& SharedWeightStore::Instance() {
+  static SharedWeightStore* store = new SharedWeightStore;
+  return *store;
+}
+
+bool SharedWeightStore::Deduplicate(phi::DenseTensor* tensor) {
+  if (!tensor->initialized() || tensor->numel() == 0 ||
+      tensor->meta().offset != 0 || !tensor->meta().is_contiguous()) {
+    return false;
+  }
+  const size_t bytes = NumBytes(*tensor);
+  phi::DenseTensor host;
+  const void* data = HostData(*tensor, &host);
+  const uint64_t key =
+      XXH64(data, bytes, static_cast<uint64_t>(tensor->dtype()));
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto range = entries_.equal_range(key);
+  for (auto it = range.first; it != range.second;) {
+    auto holder = it->second.holder.lock();
+    if (!holder) {
+      it = entries_.erase(it);
+      continue;
+    }
+    if (holder == tensor->Holder()) return false;
+    if (it->second.meta == tensor->meta() &&
+        it->second.place == tensor->place()) {
+      // a hash is not proof, the bytes are compared before sharing
+      phi::DenseTensor shared(holder, it->second.meta);
+      phi::DenseTensor shared_host;
+      if (std::memcmp(HostData(shared, &shared_host), data, bytes) == 0) {
+        tensor->ShareDataWith(shared);
+        return true;
+      }
+    }
+    ++it;
+  }
+  entries_.emplace(key,
+                   Entry{tensor->Holder(), tensor->meta(), tensor->place()});
+  return false;
+}
+
+size_t SharedWeightStore::Deduplicate(const framework::ProgramDesc& program,
+                                      framework::Scope* scope) {
+  size_t freed = 0;
+  for (auto* var_desc : program.Block(0).AllVars()) {
+    if (!var_desc->Persistable() ||
+        var_desc->GetType() != framework::proto::VarType::LOD_TENSOR) {
+      continue;
+    }
+    auto* var = scope->FindVar(var_desc->Name());
+    if (!var || !var->IsType<phi::DenseTensor>()) continue;
+    auto* tensor = var->GetMutable<phi::DenseTensor>();
+    if (Deduplicate(tensor)) {
+      VLOG(3) << "Share the weight " << var_desc->Name();
+      freed += NumBytes(*tensor);
+    }
+  }
+  return freed;
+}
+
+SharedWeightStore::Stats SharedWeightStore::GetStats() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  Stats stats;
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto holder = it->second.holder.lock();
+    if (!holder) {
+      it = entries_.erase(it);
+      continue;
+    }
+    const size_t bytes = common::product(it->second.meta.dims) *
+                         phi::SizeOf(it->second.meta.dtype);
+    ++stats.tensors;
+    stats.bytes += bytes;
+    // the tensors holding the buffer, besides the first one and the lock
+    const auto sharers = holder.use_count() - 2;
+    if (sharers > 0) {
+      stats.shared_tensors += sharers;
+      stats.saved_bytes += sharers * bytes;
+    }
+    ++it;
+  }
+  return stats;
+}
+
+}  // namespace paddle
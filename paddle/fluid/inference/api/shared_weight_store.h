@@ -0,0 +1,74 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/utils/test_macros.h"
+
+namespace paddle {
+namespace framework {
+class ProgramDesc;
+class Scope;
+}  // namespace framework
+
+// A process-wide store of the weights of the predictors, addressed by their
+// content, so that predictors of different models that hold the same tensor
+// (the backbone of A/B arms or per-tenant heads) keep one copy of it.
+//
+// The store only keeps weak references: a weight lives as long as one of
+// the predictors sharing it, and the entries of released weights are dropped
+// lazily. The shared weights must not be written afterwards.
+class SharedWeightStore {
+ public:
+  struct Stats {
+    // distinct weights alive in the store and their bytes
+    size_t tensors{0};
+    size_t bytes{0};
+    // weights of predictors that point to the copy of another predictor,
+    // and the bytes that saves
+    size_t shared_tensors{0};
+    size_t saved_bytes{0};
+  };
+
+  SharedWeightStore() = default;
+  TEST_API static SharedWeightStore& Instance();
+
+  // Makes the persistable dense tensors of block 0 of `program`, found in
+  // `scope`, share the buffer of an identical weight in the store, and adds
+  // the others to it. Returns the number of bytes freed.
+  TEST_API size_t Deduplicate(const framework::ProgramDesc& program,
+                              framework::Scope* scope);
+
+  // The same for one tensor, returns whether it now shares a buffer.
+  TEST_API bool Deduplicate(phi::DenseTensor* tensor);
+
+  TEST_API Stats GetStats();
+
+ private:
+  struct Entry {
+    std::weak_ptr<phi::Allocation> holder;
+    phi::DenseTensorMeta meta;
+    phi::Place place;
+  };
+
+  std::mutex mutex_;
+  std::unordered_multimap<uint64_t, Entry> entries_;
+};
+
+}  // namespace paddle
@@ -69,12 +69,33 @@ RecordInstantEvent::RecordInstantEvent(const char *name,
       name, start_end_ns, start_end_ns, EventRole::kOrdinary, type);
 }
 
+namespace {
+
+uint64_t TensorBytes(const std::vector<framework::Variable *> &vars) {
+  uint64_t bytes = 0;
+  for (const auto *var : vars) {
+    if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+      continue;
+    }
+    const auto &tensor = var->Get<phi::DenseTensor>();
+    if (tensor.dtype() == phi::DataType::UNDEFINED || tensor.numel() <= 0) {
+      continue;
+    }
+    bytes +=
+        static_cast<uint64_t>(tensor.numel()) * phi::SizeOf(tensor.dtype());
+  }
+  return bytes;
+}
+
+}  // namespace
+
 RecordOpInfoSupplement::RecordOpInfoSupplement(
     const std::string &type,
     const framework::AttributeMap &attrs,
     const framework::InferShapeContext &shape_ctx,
     const framework::RuntimeContext &ctx,
-    uint64_t op_id) {
+    uint64_t op_id,
+    const KernelCost &cost) {
   if (FLAGS_enable_host_event_recorder_hook == false) {
     return;
   }
@@ -87,9 +108,16 @@ RecordOpInfoSupplement::RecordOpInfoSupplement(
     input_shapes[input.first] = shape_ctx.GetInputsDim(input.first);
     dtypes[input.first] = shape_ctx.GetInputsVarType(input.first);
   }
+  KernelCost kernel_cost = cost;
+  for (const auto &input : ctx.inputs) {
+    kernel_cost.bytes += TensorBytes(input.second);
+  }
+  for (const auto &output : ctx.outputs) {
+    kernel_cost.bytes += TensorBytes(output.second);
+  }
 
   HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance().RecordEvent(
-      PosixInNsec(), type, input_shapes, dtypes, attrs, op_id);
+      PosixInNsec(), type, input_shapes, dtypes, attrs, op_id, kernel_cost);
 }
 
 RecordOpInfoSupplement::RecordOpInfoSupplement(
@@ -117,6 +145,24 @@ RecordOpInfoSupplement::RecordOpInfoSupplement(
       PosixInNsec(), type, input_shapes, dtypes, attrs, op_id);
 }
 
+RecordOpInfoSupplement::RecordOpInfoSupplement(
+    const std::string &type,
+    const framework::AttributeMap &attrs,
+    const std::map<std::string, std::vector<framework::DDim>> &input_shapes,
+    const std::map<std::string, std::vector<framework::proto::VarType::Type>>
+        &dtypes,
+    const KernelCost &cost) {
+  if (FLAGS_enable_host_event_recorder_hook == false) {
+    return;
+  }
+  if (IsEnabled() == false) {
+    return;
+  }
+  uint64_t op_id = 0;
+  HostEventRecorder<OperatorSupplementOriginEvent>::GetInstance().RecordEvent(
+      PosixInNsec(), type, input_shapes, dtypes, attrs, op_id, cost);
+}
+
 bool RecordMemEvent::IsEnabled() { return FLAGS_enable_record_memory; }
 
 std::map<const char *, std::map<uint64_t, std::vector<uint64_t>>>
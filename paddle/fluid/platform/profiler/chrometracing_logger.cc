@@ -166,11 +166,13 @@ void ChromeTracingLogger::LogHostTraceEventNode(
   std::map<std::string, std::vector<std::vector<int64_t>>> input_shapes;
   std::map<std::string, std::vector<std::string>> input_dtypes;
   std::string callstack;
+  KernelCost cost;
   OperatorSupplementEventNode* op_supplement_node =
       host_node.GetOperatorSupplementEventNode();
   if (op_supplement_node != nullptr) {
     input_shapes = op_supplement_node->InputShapes();
     input_dtypes = op_supplement_node->Dtypes();
+    cost = op_supplement_node->Cost();
     callstack = op_supplement_node->CallStack();
     callstack = std::regex_replace(callstack, std::regex("\""), "\'");
     callstack = std::regex_replace(callstack, std::regex("\n"), "\\n");
@@ -225,6 +227,10 @@ void ChromeTracingLogger::LogHostTraceEventNode(
       "end_time": "%.3f us",
       "input_shapes": %s,
       "input_dtypes": %s,
+      "bytes": %llu,
+      "cycles": %llu,
+      "instructions": %llu,
+      "cache_misses": %llu,
       "callstack": "%s"
     }
   },
@@ -240,6 +246,10 @@ void ChromeTracingLogger::LogHostTraceEventNode(
           nsToUsFloat(host_node.EndNs(), start_time_),
           json_dict(input_shapes).c_str(),
           json_dict(input_dtypes).c_str(),
+          cost.bytes,
+          cost.cycles,
+          cost.instructions,
+          cost.cache_misses,
           callstack.c_str());
       break;
     case TracerEventType::CudaRuntime:
@@ -40,12 +40,14 @@ struct OperatorSupplementOriginEvent {
       const std::map<std::string, std::vector<framework::proto::VarType::Type>>
           &dtypes,
       const framework::AttributeMap &attributes,
-      uint64_t op_id)
+      uint64_t op_id,
+      const KernelCost &cost = KernelCost())
       : timestamp_ns(timestamp_ns),
         input_shapes(input_shapes),
         dtypes(dtypes),
         attributes(attributes),
-        op_id(op_id) {
+        op_id(op_id),
+        cost(cost) {
     auto buf = static_cast<char *>(arena_allocator(type_name.length() + 1));
     strncpy(buf, type_name.c_str(), type_name.length() + 1);
     op_type = buf;
@@ -60,6 +62,8 @@ struct OperatorSupplementOriginEvent {
   framework::AttributeMap attributes;
   // op id
   uint64_t op_id;
+  // bytes moved and hardware counters of the kernel
+  KernelCost cost;
 };
 
 }  // namespace platform
@@ -279,6 +279,12 @@ DeserializationReader::RestoreOperatorSupplementEventNode(
   op_supplement_event.op_id = op_supplement_event_proto.op_id();
   op_supplement_event.process_id = op_supplement_event_proto.process_id();
   op_supplement_event.thread_id = op_supplement_event_proto.thread_id();
+  op_supplement_event.cost.bytes = op_supplement_event_proto.bytes();
+  op_supplement_event.cost.cycles = op_supplement_event_proto.cycles();
+  op_supplement_event.cost.instructions =
+      op_supplement_event_proto.instructions();
+  op_supplement_event.cost.cache_misses =
+      op_supplement_event_proto.cache_misses();
   std::map<std::string, std::vector<std::vector<int64_t>>> input_shapes;
   std::map<std::string, std::vector<std::string>> dtypes;
   auto input_shape_proto = op_supplement_event_proto.input_shapes();
@@ -186,6 +186,11 @@ void SerializationLogger::LogHostTraceEventNode(
     op_supplement_event_proto->set_callstack(
         op_supplement_event_node->CallStack());
     op_supplement_event_proto->set_op_id(op_supplement_event_node->OpId());
+    const KernelCost& cost = op_supplement_event_node->Cost();
+    op_supplement_event_proto->set_bytes(cost.bytes);
+    op_supplement_event_proto->set_cycles(cost.cycles);
+    op_supplement_event_proto->set_instructions(cost.instructions);
+    op_supplement_event_proto->set_cache_misses(cost.cache_misses);
 
     OperatorSupplementEventProto::input_shape_proto* input_shape_proto =
         op_supplement_event_proto->mutable_input_shapes();
@@ -80,6 +80,7 @@ class OperatorSupplementEventNode {
     return op_supplement_event_.attributes;
   }
   uint64_t OpId() const { return op_supplement_event_.op_id; }
+  const KernelCost& Cost() const { return op_supplement_event_.cost; }
   uint64_t ProcessId() const { return op_supplement_event_.process_id; }
   uint64_t ThreadId() const { return op_supplement_event_.thread_id; }
 
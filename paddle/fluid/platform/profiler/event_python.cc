@@ -123,6 +123,11 @@ HostPythonNode* ProfilerResult::CopyTree(HostTraceEventNode* root) {
     host_python_node->callstack = op_supplement_node->CallStack();
     host_python_node->attributes = op_supplement_node->Attributes();
     host_python_node->op_id = op_supplement_node->OpId();
+    const KernelCost& cost = op_supplement_node->Cost();
+    host_python_node->bytes = cost.bytes;
+    host_python_node->cycles = cost.cycles;
+    host_python_node->instructions = cost.instructions;
+    host_python_node->cache_misses = cost.cache_misses;
   }
   return host_python_node;
 }
@@ -125,6 +125,11 @@ struct HostPythonNode {
   framework::AttributeMap attributes;
   // op id
   uint64_t op_id;
+  // bytes moved by the kernel and hardware counters read around it
+  uint64_t bytes = 0;
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cache_misses = 0;
   // children node
   std::vector<HostPythonNode*> children_node_ptrs;
   // runtime node
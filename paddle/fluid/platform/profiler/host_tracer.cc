@@ -123,6 +123,7 @@ void ProcessOperatorSupplementEvents(
       event.callstack = result_string.str();
       event.attributes = evt.attributes;
       event.op_id = evt.op_id;
+      event.cost = evt.cost;
       event.process_id = op_supplement_events.process_id;
       event.thread_id = tid;
       collector->AddOperatorSupplementEvent(std::move(event));
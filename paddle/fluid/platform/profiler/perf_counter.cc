@@ -0,0 +1,132 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/profiler/perf_counter.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+#include "glog/logging.h"
+#include "paddle/common/flags.h"
+
+COMMON_DECLARE_bool(enable_kernel_perf_counters);
+
+namespace paddle {
+namespace platform {
+
+bool PerfCounters::IsEnabled() { return FLAGS_enable_kernel_perf_counters; }
+
+PerfCounters& PerfCounters::ThisThread() {
+  thread_local PerfCounters counters;
+  return counters;
+}
+
+PerfCounters::PerfCounters() {
+  for (int i = 0; i < kNumCounters; ++i) {
+    fds_[i] = -1;
+    slots_[i] = -1;
+  }
+#ifdef __linux__
+  const uint64_t configs[kNumCounters] = {PERF_COUNT_HW_CPU_CYCLES,
+                                          PERF_COUNT_HW_INSTRUCTIONS,
+                                          PERF_COUNT_HW_CACHE_MISSES};
+  for (int i = 0; i < kNumCounters; ++i) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int group_fd = num_fds_ == 0 ? -1 : fds_[0];
+    int fd = static_cast<int>(
+        syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+    if (fd < 0) {
+      // the leader is required, the other counters are optional
+      if (i == 0) {
+        break;
+      }
+      continue;
+    }
+    fds_[num_fds_] = fd;
+    slots_[num_fds_] = i;
+    ++num_fds_;
+  }
+  if (num_fds_ == 0) {
+    LOG_FIRST_N(WARNING, 1)
+        << "perf_event_open failed, kernel hardware counters are disabled. "
+           "Check /proc/sys/kernel/perf_event_paranoid.";
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (int i = 0; i < num_fds_; ++i) {
+    close(fds_[i]);
+  }
+#endif
+}
+
+PerfCounterValues PerfCounters::Read() const {
+  PerfCounterValues values;
+#ifdef __linux__
+  if (num_fds_ == 0) {
+    return values;
+  }
+  // layout of PERF_FORMAT_GROUP: nr, then one value per counter
+  uint64_t buf[1 + kNumCounters] = {0};
+  if (read(fds_[0], buf, sizeof(buf)) <= 0) {
+    return values;
+  }
+  uint64_t* fields[kNumCounters] = {
+      &values.cycles, &values.instructions, &values.cache_misses};
+  for (uint64_t i = 0; i < buf[0] && i < static_cast<uint64_t>(num_fds_);
+       ++i) {
+    *fields[slots_[i]] = buf[1 + i];
+  }
+#endif
+  return values;
+}
+
+KernelCounterScope::KernelCounterScope(bool enable) {
+  if (!enable || !PerfCounters::IsEnabled()) {
+    return;
+  }
+  PerfCounters& counters = PerfCounters::ThisThread();
+  if (counters.Available()) {
+    counters_ = &counters;
+    start_ = counters.Read();
+  }
+}
+
+void KernelCounterScope::Stop(KernelCost* cost) {
+  if (counters_ == nullptr) {
+    return;
+  }
+  PerfCounterValues end = counters_->Read();
+  cost->cycles += end.cycles - start_.cycles;
+  cost->instructions += end.instructions - start_.instructions;
+  cost->cache_misses += end.cache_misses - start_.cache_misses;
+  counters_ = nullptr;
+}
+
+}  // namespace platform
+}  // namespace paddle
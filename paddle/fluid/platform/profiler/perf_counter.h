@@ -0,0 +1,74 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/profiler/trace_event.h"
+
+namespace paddle {
+namespace platform {
+
+struct PerfCounterValues {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cache_misses = 0;
+};
+
+// User space hardware counters of the calling thread, read through
+// perf_event_open on Linux. The counters are opened on first use and keep
+// running, callers take the difference of two reads. On other platforms, or
+// when perf events are not permitted (see perf_event_paranoid), Available()
+// is false and Read() returns zeros.
+class PerfCounters {
+ public:
+  // FLAGS_enable_kernel_perf_counters
+  static bool IsEnabled();
+
+  static PerfCounters& ThisThread();
+
+  ~PerfCounters();
+
+  bool Available() const { return num_fds_ > 0; }
+
+  PerfCounterValues Read() const;
+
+ private:
+  PerfCounters();
+  DISABLE_COPY_AND_ASSIGN(PerfCounters);
+
+  static constexpr int kNumCounters = 3;
+  // fds_[0] is the group leader, slots_[i] is the counter read by fds_[i]
+  int fds_[kNumCounters];
+  int slots_[kNumCounters];
+  int num_fds_{0};
+};
+
+// Reads the counters of the calling thread around a kernel and adds the
+// difference to a KernelCost.
+class KernelCounterScope {
+ public:
+  explicit KernelCounterScope(bool enable);
+
+  void Stop(KernelCost* cost);
+
+ private:
+  PerfCounters* counters_{nullptr};
+  PerfCounterValues start_;
+};
+
+}  // namespace platform
+}  // namespace paddle
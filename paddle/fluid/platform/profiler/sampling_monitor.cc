@@ -0,0 +1,207 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/profiler/sampling_monitor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <list>
+
+#include "glog/logging.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/platform/profiler/chrometracing_logger.h"
+#include "paddle/fluid/platform/profiler/event_node.h"
+#include "paddle/fluid/platform/profiler/profiler.h"
+#include "paddle/phi/api/profiler/sampling_recorder.h"
+#include "paddle/phi/core/os_info.h"
+
+COMMON_DECLARE_string(sampling_recorder_dump_path);
+COMMON_DECLARE_int32(sampling_recorder_dump_seconds);
+COMMON_DECLARE_int32(sampling_recorder_report_ms);
+
+namespace paddle {
+namespace platform {
+
+namespace {
+
+constexpr uint64_t kNsPerSecond = 1000000000ULL;
+
+// Percentile of an unsorted vector, reorders the vector.
+uint64_t Percentile(std::vector<uint64_t>* values, double ratio) {
+  size_t k = static_cast<size_t>(ratio * (values->size() - 1));
+  std::nth_element(values->begin(), values->begin() + k, values->end());
+  return (*values)[k];
+}
+
+std::string StatName(const std::string& op) {
+  std::string name = "STAT_sampled_" + op;
+  std::replace_if(
+      name.begin(),
+      name.end(),
+      [](char c) {
+        return !(std::isalnum(static_cast<unsigned char>(c)) || c == '_');
+      },
+      '_');
+  return name;
+}
+
+}  // namespace
+
+SamplingMonitor& SamplingMonitor::GetInstance() {
+  // never destroyed, StatRegistry holds pointers to stats_ until exit
+  static SamplingMonitor* instance = new SamplingMonitor();
+  return *instance;
+}
+
+void SamplingMonitor::Start() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (running_) {
+    return;
+  }
+  running_ = true;
+  thread_ = std::make_unique<std::thread>([this] { Loop(); });
+  VLOG(3) << "SamplingMonitor started, report every "
+          << FLAGS_sampling_recorder_report_ms << " ms";
+}
+
+void SamplingMonitor::Stop() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+  }
+  cv_.notify_all();
+  thread_->join();
+  thread_.reset();
+}
+
+void SamplingMonitor::Loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    cv_.wait_for(lock,
+                 std::chrono::milliseconds(
+                     std::max(FLAGS_sampling_recorder_report_ms, 1)));
+    if (!running_) {
+      break;
+    }
+    lock.unlock();
+    Aggregate();
+    auto& recorder = phi::SamplingRecorder::GetInstance();
+    if (recorder.TakeSloBreach() &&
+        !FLAGS_sampling_recorder_dump_path.empty()) {
+      // at most one dump per dump window, the next one would mostly repeat
+      // the same events
+      uint64_t now = phi::PosixInNsec();
+      uint64_t window =
+          static_cast<uint64_t>(FLAGS_sampling_recorder_dump_seconds) *
+          kNsPerSecond;
+      if (last_dump_ns_ == 0 || now - last_dump_ns_ >= window) {
+        last_dump_ns_ = now;
+        std::string path = FLAGS_sampling_recorder_dump_path +
+                           "/sampled_trace_" +
+                           std::to_string(phi::GetProcessId()) + "_" +
+                           std::to_string(now) + ".json";
+        DumpChromeTrace(path, FLAGS_sampling_recorder_dump_seconds);
+        LOG(WARNING) << "Sampled operator latency exceeded the SLO, trace "
+                     << "dumped to " << path;
+      }
+    }
+    lock.lock();
+  }
+}
+
+void SamplingMonitor::Publish(const std::string& key, int64_t value) {
+  auto it = stats_.find(key);
+  if (it == stats_.end()) {
+    auto* registered = StatRegistry<int64_t>::Instance().get(key);
+    if (registered != nullptr) {
+      registered->reset(value);
+      return;
+    }
+    it = stats_.emplace(key, std::make_unique<StatValue<int64_t>>(key)).first;
+  }
+  it->second->reset(value);
+}
+
+std::vector<SampledOpLatency> SamplingMonitor::Aggregate() {
+  std::lock_guard<std::mutex> guard(aggregate_mutex_);
+  auto& recorder = phi::SamplingRecorder::GetInstance();
+  std::vector<phi::SampledEvent> events = recorder.Consume();
+
+  std::unordered_map<std::string, std::vector<uint64_t>> latencies;
+  for (auto& event : events) {
+    latencies[event.name].push_back((event.end_ns - event.start_ns) / 1000);
+  }
+
+  std::vector<SampledOpLatency> result;
+  result.reserve(latencies.size());
+  for (auto& item : latencies) {
+    auto& values = item.second;
+    SampledOpLatency latency;
+    latency.name = item.first;
+    latency.count = values.size();
+    latency.max_us = *std::max_element(values.begin(), values.end());
+    latency.p99_us = Percentile(&values, 0.99);
+    latency.p50_us = Percentile(&values, 0.5);
+    result.emplace_back(std::move(latency));
+  }
+  std::sort(result.begin(),
+            result.end(),
+            [](const SampledOpLatency& a, const SampledOpLatency& b) {
+              return a.name < b.name;
+            });
+
+  for (auto& latency : result) {
+    std::string prefix = StatName(latency.name);
+    Publish(prefix + "_p50_us", static_cast<int64_t>(latency.p50_us));
+    Publish(prefix + "_p99_us", static_cast<int64_t>(latency.p99_us));
+  }
+  Publish("STAT_sampled_dropped_events",
+          static_cast<int64_t>(recorder.DroppedCount()));
+  return result;
+}
+
+void SamplingMonitor::DumpChromeTrace(const std::string& path, int seconds) {
+  uint64_t now = phi::PosixInNsec();
+  uint64_t span = static_cast<uint64_t>(std::max(seconds, 0)) * kNsPerSecond;
+  uint64_t since = now > span ? now - span : 0;
+  uint64_t pid = phi::GetProcessId();
+
+  std::list<HostTraceEvent> host_events;
+  for (auto& thread_events :
+       phi::SamplingRecorder::GetInstance().Snapshot(since)) {
+    for (auto& event : thread_events.events) {
+      host_events.emplace_back(event.name,
+                               event.type,
+                               event.start_ns,
+                               event.end_ns,
+                               pid,
+                               thread_events.thread_id);
+    }
+  }
+  NodeTrees tree(host_events,
+                 std::list<RuntimeTraceEvent>(),
+                 std::list<DeviceTraceEvent>(),
+                 std::list<MemTraceEvent>(),
+                 std::list<OperatorSupplementEvent>());
+  ChromeTracingLogger logger(path);
+  logger.LogMetaInfo(std::string(Profiler::version), 0);
+  tree.LogMe(&logger);
+}
+
+}  // namespace platform
+}  // namespace paddle
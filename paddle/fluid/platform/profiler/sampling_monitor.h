@@ -0,0 +1,84 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/monitor.h"
+
+namespace paddle {
+namespace platform {
+
+struct SampledOpLatency {
+  std::string name;
+  uint64_t count{0};
+  uint64_t p50_us{0};
+  uint64_t p99_us{0};
+  uint64_t max_us{0};
+};
+
+// Background consumer of phi::SamplingRecorder. Every
+// FLAGS_sampling_recorder_report_ms it aggregates the sampled events into
+// per-op latency percentiles, published as STAT_sampled_<op>_{p50,p99}_us in
+// StatRegistry<int64_t>, and dumps a chrome trace of the recent events when a
+// sampled operator breaks FLAGS_sampling_recorder_slo_us.
+class SamplingMonitor {
+ public:
+  static SamplingMonitor& GetInstance();
+
+  // Start the background thread, no-op if it is running.
+  void Start();
+
+  void Stop();
+
+  bool IsRunning() const { return running_; }
+
+  // Aggregate the events recorded since the previous call. Called by the
+  // background thread, exposed for tests and for synchronous reporting.
+  // Concurrent calls are serialized, each event is reported by one of them.
+  std::vector<SampledOpLatency> Aggregate();
+
+  // Write the events of the last seconds as a chrome trace.
+  void DumpChromeTrace(const std::string& path, int seconds);
+
+ private:
+  SamplingMonitor() = default;
+  DISABLE_COPY_AND_ASSIGN(SamplingMonitor);
+
+  void Loop();
+  void Publish(const std::string& key, int64_t value);
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<bool> running_{false};
+  // guards the single consumer side of the recorder and stats_
+  std::mutex aggregate_mutex_;
+  std::unique_ptr<std::thread> thread_;
+  uint64_t last_dump_ns_{0};
+  // StatRegistry keeps raw pointers, the values live as long as the process
+  std::unordered_map<std::string, std::unique_ptr<StatValue<int64_t>>> stats_;
+};
+
+}  // namespace platform
+}  // namespace paddle
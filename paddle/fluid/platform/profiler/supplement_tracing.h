@@ -38,12 +38,15 @@ class RecordOpInfoSupplement : public phi::RecordOpInfoSupplement {
    * @param attrs: Attribute map of op.
    * @param shape_ctx: Infershape context object.
    * @param ctx: Runtime context object.
+   * @param cost: Hardware counters of the kernel, the bytes moved are
+   *              computed from the tensors of ctx.
    */
   explicit RecordOpInfoSupplement(const std::string& type,
                                   const framework::AttributeMap& attrs,
                                   const framework::InferShapeContext& shape_ctx,
                                   const framework::RuntimeContext& ctx,
-                                  uint64_t op_id);
+                                  uint64_t op_id,
+                                  const KernelCost& cost = KernelCost());
   /**
    * @param type:  Operator type name.
    * @param attrs: Attribute map of op.
@@ -54,6 +57,21 @@ class RecordOpInfoSupplement : public phi::RecordOpInfoSupplement {
                                   const framework::AttributeMap& attrs,
                                   const framework::InferShapeContext& shape_ctx,
                                   const phi::KernelSignature& kernel_signature);
+  /**
+   * @param type:  Operator type name.
+   * @param attrs: Attribute map of op.
+   * @param input_shapes: Shapes of the kernel inputs.
+   * @param dtypes: Data types of the kernel inputs.
+   * @param cost: Bytes moved and hardware counters of the kernel, used by
+   *              the executor of PIR.
+   */
+  explicit RecordOpInfoSupplement(
+      const std::string& type,
+      const framework::AttributeMap& attrs,
+      const std::map<std::string, std::vector<framework::DDim>>& input_shapes,
+      const std::map<std::string,
+                     std::vector<framework::proto::VarType::Type>>& dtypes,
+      const KernelCost& cost);
 };
 
 }  // namespace platform
@@ -0,0 +1,106 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/platform/profiler/sampling_monitor.h"
+#include "paddle/phi/api/profiler/event_tracing.h"
+#include "paddle/phi/api/profiler/sampling_recorder.h"
+
+COMMON_DECLARE_bool(enable_sampling_recorder);
+COMMON_DECLARE_int32(sampling_recorder_interval);
+
+using paddle::platform::SampledOpLatency;
+using paddle::platform::SamplingMonitor;
+using phi::SampledEvent;
+using phi::SampledEventRing;
+using phi::TracerEventType;
+
+TEST(SampledEventRingTest, WrapAround) {
+  SampledEventRing ring(1, 4);
+  for (uint64_t i = 0; i < 6; ++i) {
+    SampledEvent event;
+    event.name = "op";
+    event.start_ns = i;
+    event.end_ns = i + 1;
+    ring.Push(event);
+  }
+  EXPECT_EQ(ring.end(), 6UL);
+  std::vector<SampledEvent> events;
+  // the two oldest events are overwritten
+  EXPECT_EQ(ring.CopySince(0, &events), 6UL);
+  ASSERT_EQ(events.size(), 4UL);
+  EXPECT_EQ(events.front().start_ns, 2UL);
+  EXPECT_EQ(events.back().start_ns, 5UL);
+
+  events.clear();
+  EXPECT_EQ(ring.CopySince(5, &events), 6UL);
+  ASSERT_EQ(events.size(), 1UL);
+  EXPECT_EQ(events.front().start_ns, 5UL);
+}
+
+TEST(SamplingRecorderTest, SampleOneInN) {
+  FLAGS_enable_sampling_recorder = true;
+  FLAGS_sampling_recorder_interval = 4;
+  SamplingMonitor::GetInstance().Aggregate();
+  for (int i = 0; i < 16; ++i) {
+    phi::RecordEvent op("sampled_op", TracerEventType::Operator, 1);
+    phi::RecordEvent kernel(
+        "sampled_kernel", TracerEventType::OperatorInner, 1);
+  }
+  FLAGS_enable_sampling_recorder = false;
+
+  std::vector<SampledOpLatency> result =
+      SamplingMonitor::GetInstance().Aggregate();
+  ASSERT_EQ(result.size(), 2UL);
+  EXPECT_EQ(result[0].name, "sampled_kernel");
+  EXPECT_EQ(result[0].count, 4UL);
+  EXPECT_EQ(result[1].name, "sampled_op");
+  EXPECT_EQ(result[1].count, 4UL);
+  EXPECT_LE(result[1].p50_us, result[1].p99_us);
+  EXPECT_NE(paddle::platform::StatRegistry<int64_t>::Instance().get(
+                "STAT_sampled_sampled_op_p99_us"),
+            nullptr);
+}
+
+TEST(SamplingRecorderTest, ConcurrentAggregate) {
+  FLAGS_enable_sampling_recorder = true;
+  FLAGS_sampling_recorder_interval = 1;
+  SamplingMonitor::GetInstance().Aggregate();
+  for (int i = 0; i < 64; ++i) {
+    phi::RecordEvent op("concurrent_op", TracerEventType::Operator, 1);
+  }
+  FLAGS_enable_sampling_recorder = false;
+
+  // every event is reported by exactly one of the callers
+  std::vector<uint64_t> counts(4, 0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < counts.size(); ++t) {
+    threads.emplace_back([&counts, t] {
+      for (auto& latency : SamplingMonitor::GetInstance().Aggregate()) {
+        counts[t] += latency.count;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  uint64_t total = 0;
+  for (auto count : counts) {
+    total += count;
+  }
+  EXPECT_EQ(total, 64UL);
+}
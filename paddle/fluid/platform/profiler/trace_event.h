@@ -34,6 +34,16 @@ using RuntimeTraceEvent = phi::RuntimeTraceEvent;
 using DeviceTraceEvent = phi::DeviceTraceEvent;
 using MemTraceEvent = phi::MemTraceEvent;
 
+// Cost of one kernel launch of an operator. bytes is the size of the inputs
+// and outputs given their InferMeta shapes, the hardware counters are read
+// around the kernel and stay 0 when perf counters are unavailable.
+struct KernelCost {
+  uint64_t bytes = 0;
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cache_misses = 0;
+};
+
 struct OperatorSupplementEvent {
   OperatorSupplementEvent() = default;
   OperatorSupplementEvent(
@@ -73,6 +83,8 @@ struct OperatorSupplementEvent {
   uint64_t process_id;
   // thread id of the record
   uint64_t thread_id;
+  // bytes moved and hardware counters of the kernel
+  KernelCost cost;
 };
 
 }  // namespace platform
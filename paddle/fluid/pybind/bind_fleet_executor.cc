@@ -203,7 +203,13 @@ void BindFleetExecutor(py::module* m) {
       .def_readwrite("local_rank", &DistModelConfig::local_rank)
       .def_readwrite("ring_id_to_ranks", &DistModelConfig::ring_id_to_ranks_)
       .def_readwrite("rank_to_ring_ids", &DistModelConfig::rank_to_ring_ids_)
-      .def_readwrite("enable_timer", &DistModelConfig::enable_timer);
+      .def_readwrite("enable_timer", &DistModelConfig::enable_timer)
+      .def_readwrite("num_micro_batches", &DistModelConfig::num_micro_batches)
+      .def_readwrite("num_pipeline_stages",
+                     &DistModelConfig::num_pipeline_stages)
+      .def_readwrite("max_in_flight_micro_batches",
+                     &DistModelConfig::max_in_flight_micro_batches)
+      .def_readwrite("cpu_cores", &DistModelConfig::cpu_cores);
 
   py::class_<DistModel>(*m, "DistModel")
       .def(py::init<const DistModelConfig&>())
@@ -1339,6 +1339,34 @@ void BindDistributed(py::module *m) {
       py::arg("tensor_indices") = std::vector<int64_t>{},
       py::call_guard<py::gil_scoped_release>());
 
+  py::enum_<distributed::GradCompressType>(*m, "GradCompressType")
+      .value("NONE", distributed::GradCompressType::NONE)
+      .value("FP16", distributed::GradCompressType::FP16)
+      .value("BF16", distributed::GradCompressType::BF16)
+      .value("TOPK", distributed::GradCompressType::TOPK);
+
+  py::class_<distributed::GradCompressOptions>(*m, "GradCompressOptions")
+      .def(py::init<>())
+      .def_readwrite("type", &distributed::GradCompressOptions::type)
+      .def_readwrite("topk_ratio",
+                     &distributed::GradCompressOptions::topk_ratio)
+      .def_readwrite("min_compress_numel",
+                     &distributed::GradCompressOptions::min_compress_numel);
+
+  py::class_<distributed::EagerGroupCommStat>(*m, "EagerGroupCommStat")
+      .def_readonly("numel", &distributed::EagerGroupCommStat::numel)
+      .def_readonly("raw_bytes", &distributed::EagerGroupCommStat::raw_bytes)
+      .def_readonly("wire_bytes", &distributed::EagerGroupCommStat::wire_bytes)
+      .def_readonly("concat_time",
+                    &distributed::EagerGroupCommStat::concat_time)
+      .def_readonly("compress_time",
+                    &distributed::EagerGroupCommStat::compress_time)
+      .def_readonly("comm_time", &distributed::EagerGroupCommStat::comm_time)
+      .def_readonly("decompress_time",
+                    &distributed::EagerGroupCommStat::decompress_time)
+      .def_readonly("overlap_time",
+                    &distributed::EagerGroupCommStat::overlap_time);
+
   py::class_<distributed::EagerReducer,
              std::shared_ptr<distributed::EagerReducer>>(
       *m, "EagerReducer", R"DOC()DOC")
@@ -1350,7 +1378,16 @@ void BindDistributed(py::module *m) {
             self.PrepareForBackward(params);
           },
           py::arg("tensors"),
-          py::call_guard<py::gil_scoped_release>());
+          py::call_guard<py::gil_scoped_release>())
+      .def("set_grad_compress_options",
+           &distributed::EagerReducer::SetGradCompressOptions,
+           py::arg("options"),
+           py::call_guard<py::gil_scoped_release>())
+      .def("get_grad_compress_options",
+           &distributed::EagerReducer::GetGradCompressOptions)
+      .def("get_group_comm_stats",
+           &distributed::EagerReducer::GetGroupCommStats)
+      .def("get_backward_time", &distributed::EagerReducer::GetBackwardTime);
 
   py::class_<distributed::ProcessGroupIdMap,
              std::shared_ptr<distributed::ProcessGroupIdMap>>(
@@ -1008,6 +1008,11 @@ void BindAnalysisConfig(py::module *m) {
            py::arg("mkldnn_int8_enabled_op_types") =
                std::unordered_set<std::string>({}))
       .def("mkldnn_int8_enabled", &AnalysisConfig::mkldnn_int8_enabled)
+      .def("enable_cpu_int8_quant_linear",
+           &AnalysisConfig::EnableCpuInt8QuantLinear,
+           py::arg("x") = true)
+      .def("cpu_int8_quant_linear_enabled",
+           &AnalysisConfig::cpu_int8_quant_linear_enabled)
       .def("disable_mkldnn_fc_passes",
            &AnalysisConfig::DisableMkldnnFcPasses,
            R"DOC(
@@ -100,6 +100,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/profiler/event_python.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
 #include "paddle/fluid/platform/profiler/profiler.h"
+#include "paddle/fluid/platform/profiler/sampling_monitor.h"
 #include "paddle/fluid/pybind/auto_parallel_py.h"
 #include "paddle/fluid/pybind/bind_cost_model.h"
 #include "paddle/fluid/pybind/bind_fleet_executor.h"
@@ -2870,6 +2871,12 @@ All parameter, weight, gradient are variables in Paddle.
       .def_readwrite("attributes",
                      &paddle::platform::HostPythonNode::attributes)
       .def_readwrite("op_id", &paddle::platform::HostPythonNode::op_id)
+      .def_readwrite("bytes", &paddle::platform::HostPythonNode::bytes)
+      .def_readwrite("cycles", &paddle::platform::HostPythonNode::cycles)
+      .def_readwrite("instructions",
+                     &paddle::platform::HostPythonNode::instructions)
+      .def_readwrite("cache_misses",
+                     &paddle::platform::HostPythonNode::cache_misses)
       .def_readwrite("children_node",
                      &paddle::platform::HostPythonNode::children_node_ptrs)
       .def_readwrite("runtime_node",
@@ -2946,6 +2953,22 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("disable_memory_recorder", &paddle::platform::DisableMemoryRecorder);
   m.def("enable_op_info_recorder", &phi::EnableOpInfoRecorder);
   m.def("disable_op_info_recorder", &phi::DisableOpInfoRecorder);
+  m.def("start_sampling_monitor", []() {
+    paddle::platform::SamplingMonitor::GetInstance().Start();
+  });
+  m.def("stop_sampling_monitor", []() {
+    pybind11::gil_scoped_release release;
+    paddle::platform::SamplingMonitor::GetInstance().Stop();
+  });
+  m.def(
+      "dump_sampled_trace",
+      [](const std::string &path, int seconds) {
+        pybind11::gil_scoped_release release;
+        paddle::platform::SamplingMonitor::GetInstance().DumpChromeTrace(
+            path, seconds);
+      },
+      py::arg("path"),
+      py::arg("seconds") = 10);
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   m.def("set_cublas_switch", phi::SetAllowTF32Cublas);
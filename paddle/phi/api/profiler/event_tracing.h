@@ -79,6 +79,9 @@ class TEST_API RecordEvent {
                          const EventRole role,
                          const std::string& attr);
 
+  void SampleConstruct(const char* name, TracerEventType type);
+  void SampleConstruct(const std::string& name, TracerEventType type);
+
   bool is_enabled_{false};
   bool is_pushed_{false};
   // Event name
@@ -92,6 +95,11 @@ class TEST_API RecordEvent {
   TracerEventType type_{TracerEventType::UserDefined};
   std::string* attr_{nullptr};
   bool finished_{false};
+  // Timing kept by SamplingRecorder, independent of the profiler state
+  bool is_sampled_{false};
+  const char* sampled_name_{nullptr};
+  TracerEventType sampled_type_{TracerEventType::UserDefined};
+  uint64_t sampled_start_ns_{0};
 };
 
 }  // namespace phi
@@ -27,6 +27,7 @@ limitations under the License. */
 #include "paddle/phi/api/profiler/host_event_recorder.h"
 #include "paddle/phi/api/profiler/host_tracer.h"
 #include "paddle/phi/api/profiler/profiler_helper.h"
+#include "paddle/phi/api/profiler/sampling_recorder.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/core/os_info.h"
 #ifdef PADDLE_WITH_CUDA
@@ -108,6 +109,9 @@ RecordEvent::RecordEvent(const char *name,
   }
 #endif
 #endif
+  if (UNLIKELY(SamplingRecorder::IsEnabled())) {
+    SampleConstruct(name, type);
+  }
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
     return;
   }
@@ -142,6 +146,9 @@ RecordEvent::RecordEvent(const std::string &name,
   }
 #endif
 #endif
+  if (UNLIKELY(SamplingRecorder::IsEnabled())) {
+    SampleConstruct(name, type);
+  }
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
     return;
   }
@@ -176,6 +183,9 @@ RecordEvent::RecordEvent(const std::string &name,
 #endif
 #endif
 
+  if (UNLIKELY(SamplingRecorder::IsEnabled())) {
+    SampleConstruct(name, type);
+  }
   if (UNLIKELY(HostTraceLevel::GetInstance().NeedTrace(level) == false)) {
     return;
   }
@@ -215,6 +225,27 @@ void RecordEvent::OriginalConstruct(const std::string &name,
   *name_ = e->name();
 }
 
+void RecordEvent::SampleConstruct(const char *name, TracerEventType type) {
+  auto &recorder = SamplingRecorder::GetInstance();
+  if (recorder.BeginSample(type)) {
+    is_sampled_ = true;
+    sampled_name_ = name;
+    sampled_type_ = type;
+    sampled_start_ns_ = PosixInNsec();
+  }
+}
+
+void RecordEvent::SampleConstruct(const std::string &name,
+                                  TracerEventType type) {
+  auto &recorder = SamplingRecorder::GetInstance();
+  if (recorder.BeginSample(type)) {
+    is_sampled_ = true;
+    sampled_name_ = recorder.Intern(name);
+    sampled_type_ = type;
+    sampled_start_ns_ = PosixInNsec();
+  }
+}
+
 void RecordEvent::End() {
 #ifndef _WIN32
 #ifdef PADDLE_WITH_CUDA
@@ -224,6 +255,12 @@ void RecordEvent::End() {
   }
 #endif
 #endif
+  if (UNLIKELY(is_sampled_)) {
+    SamplingRecorder::GetInstance().EndSample(
+        sampled_name_, sampled_type_, sampled_start_ns_, PosixInNsec());
+    // use this flag to avoid double End();
+    is_sampled_ = false;
+  }
   if (LIKELY(FLAGS_enable_host_event_recorder_hook && is_enabled_)) {
     uint64_t end_ns = PosixInNsec();
     if (LIKELY(shallow_copy_name_ != nullptr)) {
@@ -267,6 +304,7 @@ void RecordEvent::End() {
 
 bool RecordEvent::IsEnabled() {
   return FLAGS_enable_host_event_recorder_hook ||
+         SamplingRecorder::IsEnabled() ||
          ProfilerHelper::g_enable_nvprof_hook ||
          ProfilerHelper::g_state != ProfilerState::kDisabled;
 }
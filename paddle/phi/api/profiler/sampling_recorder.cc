@@ -0,0 +1,192 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/api/profiler/sampling_recorder.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "paddle/common/flags.h"
+#include "paddle/phi/core/os_info.h"
+
+COMMON_DECLARE_bool(enable_sampling_recorder);
+COMMON_DECLARE_int32(sampling_recorder_interval);
+COMMON_DECLARE_int32(sampling_recorder_buffer_size);
+COMMON_DECLARE_int64(sampling_recorder_slo_us);
+
+namespace phi {
+
+SampledEventRing::SampledEventRing(uint64_t thread_id, size_t capacity)
+    : thread_id_(thread_id),
+      capacity_(capacity),
+      slots_(new Slot[capacity]) {}
+
+void SampledEventRing::Push(const SampledEvent& event) {
+  const uint64_t seq = head_.load(std::memory_order_relaxed);
+  Slot& slot = slots_[seq % capacity_];
+  // odd while writing, 2 * (seq + 1) once the event of seq is complete
+  slot.seq.store(2 * seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.event = event;
+  slot.seq.store(2 * seq + 2, std::memory_order_release);
+  head_.store(seq + 1, std::memory_order_release);
+}
+
+uint64_t SampledEventRing::CopySince(uint64_t begin,
+                                     std::vector<SampledEvent>* out) const {
+  const uint64_t end = head_.load(std::memory_order_acquire);
+  if (end > capacity_ && begin < end - capacity_) {
+    begin = end - capacity_;
+  }
+  for (uint64_t seq = begin; seq < end; ++seq) {
+    const Slot& slot = slots_[seq % capacity_];
+    const uint64_t before = slot.seq.load(std::memory_order_acquire);
+    SampledEvent event = slot.event;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t after = slot.seq.load(std::memory_order_relaxed);
+    if (before == 2 * seq + 2 && after == before) {
+      out->push_back(event);
+    }
+  }
+  return end;
+}
+
+namespace {
+
+struct SamplingThreadState {
+  int32_t counter{0};
+  // depth of sampled operators on this thread, the OperatorInner events are
+  // only recorded inside a sampled operator to keep the trace consistent
+  int32_t sampled_depth{0};
+  SampledEventRing* ring{nullptr};
+  std::unordered_map<std::string, const char*> interned;
+};
+
+SamplingThreadState& ThreadState() {
+  thread_local SamplingThreadState state;
+  return state;
+}
+
+}  // namespace
+
+SamplingRecorder& SamplingRecorder::GetInstance() {
+  static SamplingRecorder instance;
+  return instance;
+}
+
+bool SamplingRecorder::IsEnabled() { return FLAGS_enable_sampling_recorder; }
+
+bool SamplingRecorder::BeginSample(TracerEventType type) {
+  auto& state = ThreadState();
+  if (type == TracerEventType::Operator) {
+    if (++state.counter < FLAGS_sampling_recorder_interval) {
+      return false;
+    }
+    state.counter = 0;
+    ++state.sampled_depth;
+    return true;
+  }
+  return type == TracerEventType::OperatorInner && state.sampled_depth > 0;
+}
+
+void SamplingRecorder::EndSample(const char* name,
+                                 TracerEventType type,
+                                 uint64_t start_ns,
+                                 uint64_t end_ns) {
+  auto& state = ThreadState();
+  if (type == TracerEventType::Operator) {
+    --state.sampled_depth;
+    if (FLAGS_sampling_recorder_slo_us > 0 &&
+        end_ns - start_ns >
+            static_cast<uint64_t>(FLAGS_sampling_recorder_slo_us) * 1000) {
+      slo_breached_.store(true, std::memory_order_release);
+    }
+  }
+  if (UNLIKELY(state.ring == nullptr)) {
+    state.ring = CurrentThreadRing();
+  }
+  SampledEvent event;
+  event.name = name;
+  event.type = type;
+  event.start_ns = start_ns;
+  event.end_ns = end_ns;
+  state.ring->Push(event);
+}
+
+const char* SamplingRecorder::Intern(const std::string& name) {
+  auto& interned = ThreadState().interned;
+  auto it = interned.find(name);
+  if (it != interned.end()) {
+    return it->second;
+  }
+  const char* ptr = nullptr;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ptr = names_.insert(name).first->c_str();
+  }
+  interned.emplace(name, ptr);
+  return ptr;
+}
+
+SampledEventRing* SamplingRecorder::CurrentThreadRing() {
+  auto ring = std::make_shared<SampledEventRing>(
+      GetCurrentThreadSysId(),
+      static_cast<size_t>(std::max(FLAGS_sampling_recorder_buffer_size, 1)));
+  std::lock_guard<std::mutex> guard(mutex_);
+  // the registry keeps the ring alive after the thread exits
+  rings_.push_back(ring);
+  consumed_.push_back(0);
+  return ring.get();
+}
+
+std::vector<SampledThreadEvents> SamplingRecorder::Snapshot(uint64_t since_ns) {
+  std::vector<std::shared_ptr<SampledEventRing>> rings;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    rings = rings_;
+  }
+  std::vector<SampledThreadEvents> result;
+  result.reserve(rings.size());
+  for (auto& ring : rings) {
+    SampledThreadEvents thread_events;
+    thread_events.thread_id = ring->thread_id();
+    std::vector<SampledEvent> events;
+    ring->CopySince(0, &events);
+    for (auto& event : events) {
+      if (event.end_ns >= since_ns) {
+        thread_events.events.push_back(event);
+      }
+    }
+    result.emplace_back(std::move(thread_events));
+  }
+  return result;
+}
+
+std::vector<SampledEvent> SamplingRecorder::Consume() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  std::vector<SampledEvent> events;
+  for (size_t i = 0; i < rings_.size(); ++i) {
+    const size_t before = events.size();
+    const uint64_t begin = consumed_[i];
+    const uint64_t end = rings_[i]->CopySince(begin, &events);
+    const uint64_t copied = events.size() - before;
+    if (end - begin > copied) {
+      dropped_.fetch_add(end - begin - copied, std::memory_order_relaxed);
+    }
+    consumed_[i] = end;
+  }
+  return events;
+}
+
+}  // namespace phi
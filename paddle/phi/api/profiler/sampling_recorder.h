@@ -0,0 +1,125 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/common/macros.h"
+#include "paddle/phi/api/profiler/trace_event.h"
+#include "paddle/utils/test_macros.h"
+
+namespace phi {
+
+struct SampledEvent {
+  // interned by SamplingRecorder, never freed
+  const char* name{nullptr};
+  TracerEventType type{TracerEventType::Operator};
+  uint64_t start_ns{0};
+  uint64_t end_ns{0};
+};
+
+struct SampledThreadEvents {
+  uint64_t thread_id{0};
+  std::vector<SampledEvent> events;
+};
+
+// A fixed size ring of the latest sampled events of one thread. Only the
+// owner thread writes; readers copy slots without locking and drop the ones
+// overwritten while they were read (a per-slot sequence lock).
+class SampledEventRing {
+ public:
+  SampledEventRing(uint64_t thread_id, size_t capacity);
+
+  void Push(const SampledEvent& event);
+
+  // Copy the events with a sequence number in [begin, end()), oldest first.
+  // Events already overwritten are skipped. Returns the next sequence number.
+  uint64_t CopySince(uint64_t begin, std::vector<SampledEvent>* out) const;
+
+  uint64_t end() const { return head_.load(std::memory_order_acquire); }
+  uint64_t thread_id() const { return thread_id_; }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> seq{0};
+    SampledEvent event;
+  };
+
+  uint64_t thread_id_;
+  size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> head_{0};
+};
+
+// Always-on, low overhead recorder of operator and kernel timings. Every
+// FLAGS_sampling_recorder_interval-th operator of a thread is timed together
+// with the OperatorInner events (infer meta, kernel compute, ...) nested in
+// it. Events are kept in per-thread rings and consumed by a monitor which
+// aggregates latencies and dumps traces.
+class TEST_API SamplingRecorder {
+ public:
+  static SamplingRecorder& GetInstance();
+
+  static bool IsEnabled();
+
+  // Called when an event begins, returns whether it is sampled.
+  bool BeginSample(TracerEventType type);
+
+  // Called when a sampled event ends.
+  void EndSample(const char* name,
+                 TracerEventType type,
+                 uint64_t start_ns,
+                 uint64_t end_ns);
+
+  // Returns a copy of name whose lifetime is the process.
+  const char* Intern(const std::string& name);
+
+  // Events of all threads that ended at or after since_ns.
+  std::vector<SampledThreadEvents> Snapshot(uint64_t since_ns);
+
+  // Events recorded since the previous call. Only one consumer is supported.
+  std::vector<SampledEvent> Consume();
+
+  // Number of events lost by Consume because a ring wrapped around.
+  uint64_t DroppedCount() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  // Whether a sampled operator exceeded FLAGS_sampling_recorder_slo_us since
+  // the previous call.
+  bool TakeSloBreach() {
+    return slo_breached_.exchange(false, std::memory_order_acq_rel);
+  }
+
+ private:
+  SamplingRecorder() = default;
+  DISABLE_COPY_AND_ASSIGN(SamplingRecorder);
+
+  SampledEventRing* CurrentThreadRing();
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<SampledEventRing>> rings_;
+  std::vector<uint64_t> consumed_;
+  std::unordered_set<std::string> names_;
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> slo_breached_{false};
+};
+
+}  // namespace phi
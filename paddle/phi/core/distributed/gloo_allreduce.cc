@@ -0,0 +1,563 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/core/distributed/gloo_allreduce.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <gloo/common/utils.h>
+#include <gloo/math.h>
+#include <gloo/transport/unbound_buffer.h>
+#include <gloo/types.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+
+#include "paddle/common/flags.h"
+#include "paddle/phi/common/reduce_type.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/distributed/gloo_utils.h"
+#include "paddle/phi/core/enforce.h"
+
+COMMON_DECLARE_int64(gloo_allreduce_small_bytes);
+COMMON_DECLARE_bool(gloo_allreduce_use_shm);
+
+namespace phi {
+namespace distributed {
+
+constexpr uint8_t kAllReduceSlotPrefix = 0x09;
+constexpr uint8_t kLocalBarrierSlotPrefix = 0x0a;
+
+GlooAllReduceAlgo StringToGlooAllReduceAlgo(const std::string& name) {
+  if (name == "auto") {
+    return GlooAllReduceAlgo::kAuto;
+  } else if (name == "gloo") {
+    return GlooAllReduceAlgo::kGloo;
+  } else if (name == "recursive_doubling") {
+    return GlooAllReduceAlgo::kRecursiveDoubling;
+  } else if (name == "ring") {
+    return GlooAllReduceAlgo::kRing;
+  } else if (name == "hierarchical") {
+    return GlooAllReduceAlgo::kHierarchical;
+  }
+  PADDLE_THROW(errors::InvalidArgument(
+      "Unsupported gloo allreduce algorithm: %s, it should be one of auto, "
+      "gloo, recursive_doubling, ring and hierarchical.",
+      name));
+}
+
+const char* GlooAllReduceAlgoToString(GlooAllReduceAlgo algo) {
+  switch (algo) {
+    case GlooAllReduceAlgo::kAuto:
+      return "auto";
+    case GlooAllReduceAlgo::kGloo:
+      return "gloo";
+    case GlooAllReduceAlgo::kRecursiveDoubling:
+      return "recursive_doubling";
+    case GlooAllReduceAlgo::kRing:
+      return "ring";
+    case GlooAllReduceAlgo::kHierarchical:
+      return "hierarchical";
+  }
+  return "unknown";
+}
+
+template <typename T>
+static GlooReduceFunc GetReduceFunc(int reduce_type) {
+  switch (static_cast<ReduceType>(reduce_type)) {
+    case ReduceType::kRedSum:
+      return static_cast<GlooReduceFunc>(&gloo::sum<T>);
+    case ReduceType::kRedMax:
+      return static_cast<GlooReduceFunc>(&gloo::max<T>);
+    case ReduceType::kRedMin:
+      return static_cast<GlooReduceFunc>(&gloo::min<T>);
+    case ReduceType::kRedProd:
+      return static_cast<GlooReduceFunc>(&gloo::product<T>);
+    default:
+      return nullptr;
+  }
+}
+
+static bool IsSupportedReduceType(int reduce_type) {
+  auto type = static_cast<ReduceType>(reduce_type);
+  return type == ReduceType::kRedSum || type == ReduceType::kRedMax ||
+         type == ReduceType::kRedMin || type == ReduceType::kRedProd;
+}
+
+GlooTopology BuildGlooTopology(int rank,
+                               int size,
+                               gloo::rendezvous::Store* store) {
+  const std::string host_prefix = "gloo_topology/host/";
+  const std::string shm_prefix = "gloo_topology/shm/";
+
+  std::array<char, HOST_NAME_MAX> hostname = {};
+  PADDLE_ENFORCE_EQ(
+      ::gethostname(hostname.data(), HOST_NAME_MAX),
+      0,
+      errors::Fatal("Get hostname error when building gloo topology."));
+  std::string local_host(hostname.data());
+  store->set(host_prefix + std::to_string(rank),
+             std::vector<char>(local_host.begin(), local_host.end()));
+
+  std::vector<std::string> keys;
+  keys.reserve(size);
+  for (int i = 0; i < size; ++i) {
+    keys.emplace_back(host_prefix + std::to_string(i));
+  }
+  store->wait(keys);
+
+  GlooTopology topology;
+  std::vector<std::string> leader_hosts;
+  for (int i = 0; i < size; ++i) {
+    auto value = store->get(keys[i]);
+    std::string host(value.begin(), value.end());
+    if (host == local_host) {
+      if (i == rank) {
+        topology.local_rank = static_cast<int>(topology.local_ranks.size());
+      }
+      topology.local_ranks.push_back(i);
+    }
+    if (std::find(leader_hosts.begin(), leader_hosts.end(), host) ==
+        leader_hosts.end()) {
+      leader_hosts.push_back(host);
+      topology.leaders.push_back(i);
+    }
+  }
+  topology.num_nodes = static_cast<int>(topology.leaders.size());
+
+  // the first local rank names the shared memory of this host
+  const int local_leader = topology.local_ranks.front();
+  const std::string shm_key = shm_prefix + std::to_string(local_leader);
+  if (rank == local_leader) {
+    static std::atomic<int> shm_counter{0};
+#ifndef _WIN32
+    std::string name = "/paddle_gloo_" + std::to_string(::getpid()) + "_" +
+                       std::to_string(shm_counter++);
+#else
+    // shared memory is never used on Windows
+    std::string name = "paddle_gloo_" + std::to_string(shm_counter++);
+#endif
+    store->set(shm_key, std::vector<char>(name.begin(), name.end()));
+    topology.shm_prefix = name;
+  } else {
+    store->wait({shm_key});
+    auto value = store->get(shm_key);
+    topology.shm_prefix = std::string(value.begin(), value.end());
+  }
+
+  VLOG(3) << "Gloo topology of rank " << rank << ": " << topology.num_nodes
+          << " nodes, " << topology.local_ranks.size()
+          << " local ranks, local rank " << topology.local_rank;
+  return topology;
+}
+
+// A POSIX shared memory segment mapped by all ranks of one host.
+class GlooShmSegment {
+ public:
+  GlooShmSegment(const std::string& name, size_t size, bool create)
+      : name_(name), size_(size) {
+#ifndef _WIN32
+    int flags = create ? (O_CREAT | O_RDWR | O_TRUNC) : O_RDWR;
+    int fd = ::shm_open(name_.c_str(), flags, S_IRUSR | S_IWUSR);
+    PADDLE_ENFORCE_NE(fd,
+                      -1,
+                      errors::Unavailable("Failed to open shared memory %s: %s",
+                                          name_,
+                                          std::strerror(errno)));
+    if (create) {
+      PADDLE_ENFORCE_EQ(
+          ::ftruncate(fd, static_cast<off_t>(size_)),
+          0,
+          errors::Unavailable("Failed to resize shared memory %s to %d: %s",
+                              name_,
+                              size_,
+                              std::strerror(errno)));
+    }
+    void* ptr =
+        ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    PADDLE_ENFORCE_NE(ptr,
+                      MAP_FAILED,
+                      errors::Unavailable("Failed to map shared memory %s: %s",
+                                          name_,
+                                          std::strerror(errno)));
+    data_ = static_cast<char*>(ptr);
+#else
+    PADDLE_THROW(
+        errors::Unimplemented("Gloo shared memory is not supported on "
+                              "Windows."));
+#endif
+  }
+
+  ~GlooShmSegment() {
+#ifndef _WIN32
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+    }
+#endif
+  }
+
+  // The segment stays alive until every rank unmaps it.
+  void Unlink() {
+#ifndef _WIN32
+    ::shm_unlink(name_.c_str());
+#endif
+  }
+
+  char* data() { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  std::string name_;
+  size_t size_;
+  char* data_{nullptr};
+};
+
+GlooAllReducer::GlooAllReducer(std::shared_ptr<gloo::Context> context,
+                               GlooTopology topology)
+    : context_(std::move(context)), topology_(std::move(topology)) {}
+
+GlooAllReducer::~GlooAllReducer() = default;
+
+GlooAllReduceAlgo GlooAllReducer::Select(GlooAllReduceAlgo requested,
+                                         int reduce_type,
+                                         size_t bytes) const {
+  if (requested == GlooAllReduceAlgo::kGloo || context_->size == 1 ||
+      !IsSupportedReduceType(reduce_type)) {
+    return GlooAllReduceAlgo::kGloo;
+  }
+  const bool small =
+      bytes <= static_cast<size_t>(FLAGS_gloo_allreduce_small_bytes);
+#ifdef _WIN32
+  const bool can_use_shm = false;
+#else
+  const bool can_use_shm = topology_.local_ranks.size() > 1;
+#endif
+  if (requested == GlooAllReduceAlgo::kHierarchical && !can_use_shm) {
+    return small ? GlooAllReduceAlgo::kRecursiveDoubling
+                 : GlooAllReduceAlgo::kRing;
+  }
+  if (requested != GlooAllReduceAlgo::kAuto) {
+    return requested;
+  }
+  if (can_use_shm && FLAGS_gloo_allreduce_use_shm) {
+    return GlooAllReduceAlgo::kHierarchical;
+  }
+  return small ? GlooAllReduceAlgo::kRecursiveDoubling
+               : GlooAllReduceAlgo::kRing;
+}
+
+void GlooAllReducer::Run(GlooAllReduceAlgo algo,
+                         phi::DenseTensor* out_tensor,
+                         const phi::DenseTensor& in_tensor,
+                         int reduce_type,
+                         uint32_t tag) {
+  VLOG(4) << "Gloo allreduce with algorithm " << GlooAllReduceAlgoToString(algo)
+          << ", numel: " << in_tensor.numel();
+  const auto& dtype = in_tensor.dtype();
+  GENERATE_FUNC(dtype, RunImpl, algo, out_tensor, in_tensor, reduce_type, tag);
+}
+
+template <typename T>
+void GlooAllReducer::RunImpl(GlooAllReduceAlgo algo,
+                             phi::DenseTensor* out_tensor,
+                             const phi::DenseTensor& in_tensor,
+                             int reduce_type,
+                             uint32_t tag) {
+  auto reduce_func = GetReduceFunc<T>(reduce_type);
+  PADDLE_ENFORCE_NOT_NULL(
+      reduce_func,
+      errors::InvalidArgument("Unsupported reduce type: %d.", reduce_type));
+  PADDLE_ENFORCE_EQ(
+      out_tensor->numel(),
+      in_tensor.numel(),
+      errors::InvalidArgument("The output and input of allreduce must have "
+                              "the same number of elements."));
+
+  const size_t count = static_cast<size_t>(in_tensor.numel());
+  char* data = reinterpret_cast<char*>(out_tensor->data());
+  const char* input = reinterpret_cast<const char*>(in_tensor.data());
+  if (data != input) {
+    std::memcpy(data, input, count * sizeof(T));
+  }
+
+  switch (algo) {
+    case GlooAllReduceAlgo::kRecursiveDoubling: {
+      std::vector<int> ranks(context_->size);
+      std::iota(ranks.begin(), ranks.end(), 0);
+      RecursiveDoubling(ranks, data, count, sizeof(T), reduce_func, tag);
+      break;
+    }
+    case GlooAllReduceAlgo::kRing: {
+      std::vector<int> ranks(context_->size);
+      std::iota(ranks.begin(), ranks.end(), 0);
+      Ring(ranks, data, count, sizeof(T), reduce_func, tag);
+      break;
+    }
+    case GlooAllReduceAlgo::kHierarchical:
+      Hierarchical(data, count, sizeof(T), reduce_func, tag);
+      break;
+    default:
+      PADDLE_THROW(errors::InvalidArgument(
+          "Gloo allreduce algorithm %s can not be run by GlooAllReducer.",
+          GlooAllReduceAlgoToString(algo)));
+  }
+}
+
+char* GlooAllReducer::Scratch(size_t bytes) {
+  if (scratch_.size() < bytes) {
+    scratch_.resize(bytes);
+  }
+  return scratch_.data();
+}
+
+void GlooAllReducer::RecursiveDoubling(const std::vector<int>& ranks,
+                                       char* data,
+                                       size_t count,
+                                       size_t elem_size,
+                                       GlooReduceFunc reduce_func,
+                                       uint32_t tag) {
+  const int nranks = static_cast<int>(ranks.size());
+  const int pos = static_cast<int>(
+      std::find(ranks.begin(), ranks.end(), context_->rank) - ranks.begin());
+  if (nranks == 1 || count == 0) {
+    return;
+  }
+
+  const size_t bytes = count * elem_size;
+  const auto slot = gloo::Slot::build(kAllReduceSlotPrefix, tag);
+  const auto timeout = context_->getTimeout();
+  char* recv = Scratch(bytes);
+  auto data_buf = context_->createUnboundBuffer(data, bytes);
+  auto recv_buf = context_->createUnboundBuffer(recv, bytes);
+
+  // Fold the ranks beyond the largest power of two: each even rank among
+  // the first 2 * rest ones hands its data to the next odd rank and waits
+  // for the result.
+  int pow2 = 1;
+  while (pow2 * 2 <= nranks) {
+    pow2 *= 2;
+  }
+  const int rest = nranks - pow2;
+  int new_pos = pos - rest;
+  if (pos < 2 * rest) {
+    if (pos % 2 == 0) {
+      data_buf->send(ranks[pos + 1], slot);
+      data_buf->waitSend(timeout);
+      new_pos = -1;
+    } else {
+      recv_buf->recv(ranks[pos - 1], slot);
+      recv_buf->waitRecv(timeout);
+      reduce_func(data, data, recv, count);
+      new_pos = pos / 2;
+    }
+  }
+
+  if (new_pos >= 0) {
+    for (int mask = 1; mask < pow2; mask <<= 1) {
+      const int peer_new_pos = new_pos ^ mask;
+      const int peer = peer_new_pos < rest ? ranks[peer_new_pos * 2 + 1]
+                                           : ranks[peer_new_pos + rest];
+      recv_buf->recv(peer, slot);
+      data_buf->send(peer, slot);
+      data_buf->waitSend(timeout);
+      recv_buf->waitRecv(timeout);
+      reduce_func(data, data, recv, count);
+    }
+  }
+
+  if (pos < 2 * rest) {
+    if (pos % 2 == 1) {
+      data_buf->send(ranks[pos - 1], slot);
+      data_buf->waitSend(timeout);
+    } else {
+      data_buf->recv(ranks[pos + 1], slot);
+      data_buf->waitRecv(timeout);
+    }
+  }
+}
+
+void GlooAllReducer::Ring(const std::vector<int>& ranks,
+                          char* data,
+                          size_t count,
+                          size_t elem_size,
+                          GlooReduceFunc reduce_func,
+                          uint32_t tag) {
+  const size_t nranks = ranks.size();
+  if (nranks == 1 || count == 0) {
+    return;
+  }
+  if (count < nranks) {
+    // not enough elements to give every rank a chunk
+    RecursiveDoubling(ranks, data, count, elem_size, reduce_func, tag);
+    return;
+  }
+  const size_t pos = static_cast<size_t>(
+      std::find(ranks.begin(), ranks.end(), context_->rank) - ranks.begin());
+
+  const size_t base = count / nranks;
+  const size_t extra = count % nranks;
+  auto chunk_offset = [&](size_t i) { return i * base + std::min(i, extra); };
+  auto chunk_numel = [&](size_t i) { return base + (i < extra ? 1 : 0); };
+
+  const auto slot = gloo::Slot::build(kAllReduceSlotPrefix, tag);
+  const auto timeout = context_->getTimeout();
+  char* recv = Scratch((base + 1) * elem_size);
+  auto data_buf = context_->createUnboundBuffer(data, count * elem_size);
+  auto recv_buf = context_->createUnboundBuffer(recv, (base + 1) * elem_size);
+  const int next = ranks[(pos + 1) % nranks];
+  const int prev = ranks[(pos + nranks - 1) % nranks];
+
+  // reduce-scatter: after nranks - 1 steps, chunk (pos + 1) is complete
+  for (size_t step = 0; step + 1 < nranks; ++step) {
+    const size_t send_chunk = (pos + nranks - step) % nranks;
+    const size_t recv_chunk = (pos + 2 * nranks - step - 1) % nranks;
+    recv_buf->recv(prev, slot, 0, chunk_numel(recv_chunk) * elem_size);
+    data_buf->send(next,
+                   slot,
+                   chunk_offset(send_chunk) * elem_size,
+                   chunk_numel(send_chunk) * elem_size);
+    data_buf->waitSend(timeout);
+    recv_buf->waitRecv(timeout);
+    char* dst = data + chunk_offset(recv_chunk) * elem_size;
+    reduce_func(dst, dst, recv, chunk_numel(recv_chunk));
+  }
+
+  // all-gather: pass the complete chunks around the ring
+  for (size_t step = 0; step + 1 < nranks; ++step) {
+    const size_t send_chunk = (pos + 1 + nranks - step) % nranks;
+    const size_t recv_chunk = (pos + nranks - step) % nranks;
+    data_buf->recv(prev,
+                   slot,
+                   chunk_offset(recv_chunk) * elem_size,
+                   chunk_numel(recv_chunk) * elem_size);
+    data_buf->send(next,
+                   slot,
+                   chunk_offset(send_chunk) * elem_size,
+                   chunk_numel(send_chunk) * elem_size);
+    data_buf->waitSend(timeout);
+    data_buf->waitRecv(timeout);
+  }
+}
+
+void GlooAllReducer::LocalBarrier(uint32_t tag) {
+  const auto& local_ranks = topology_.local_ranks;
+  if (local_ranks.size() == 1) {
+    return;
+  }
+  const auto slot = gloo::Slot::build(kLocalBarrierSlotPrefix, tag);
+  const auto timeout = context_->getTimeout();
+  char token = 0;
+  auto buf = context_->createUnboundBuffer(&token, sizeof(token));
+  if (topology_.local_rank == 0) {
+    for (size_t i = 1; i < local_ranks.size(); ++i) {
+      buf->recv(local_ranks[i], slot);
+      buf->waitRecv(timeout);
+    }
+    for (size_t i = 1; i < local_ranks.size(); ++i) {
+      buf->send(local_ranks[i], slot);
+    }
+    for (size_t i = 1; i < local_ranks.size(); ++i) {
+      buf->waitSend(timeout);
+    }
+  } else {
+    buf->send(local_ranks[0], slot);
+    buf->waitSend(timeout);
+    buf->recv(local_ranks[0], slot);
+    buf->waitRecv(timeout);
+  }
+}
+
+void GlooAllReducer::EnsureShm(size_t bytes) {
+  if (shm_ && shm_->size() >= bytes) {
+    return;
+  }
+  // All local ranks reduce the same sizes in the same order, so they grow
+  // the segment at the same calls and agree on its generation.
+  const size_t page = 4096;
+  size_t size = std::max(bytes, shm_ ? shm_->size() * 2 : page);
+  size = (size + page - 1) / page * page;
+  const std::string name =
+      topology_.shm_prefix + "_" + std::to_string(++shm_generation_);
+
+  shm_.reset();
+  const bool is_creator = topology_.local_rank == 0;
+  if (is_creator) {
+    shm_ = std::make_unique<GlooShmSegment>(name, size, true);
+  }
+  LocalBarrier(0);
+  if (!is_creator) {
+    shm_ = std::make_unique<GlooShmSegment>(name, size, false);
+  }
+  LocalBarrier(0);
+  if (is_creator) {
+    shm_->Unlink();
+  }
+}
+
+void GlooAllReducer::Hierarchical(char* data,
+                                  size_t count,
+                                  size_t elem_size,
+                                  GlooReduceFunc reduce_func,
+                                  uint32_t tag) {
+  const size_t local_size = topology_.local_ranks.size();
+  const size_t local_rank = topology_.local_rank;
+  const size_t bytes = count * elem_size;
+  // keep every slot cache line aligned
+  const size_t stride = (bytes + 63) / 64 * 64;
+  EnsureShm(stride * local_size);
+  char* base = shm_->data();
+
+  std::memcpy(base + local_rank * stride, data, bytes);
+  LocalBarrier(tag);
+
+  // every local rank reduces its share of the elements into slot 0
+  const size_t share = count / local_size;
+  const size_t extra = count % local_size;
+  const size_t begin = local_rank * share + std::min(local_rank, extra);
+  const size_t numel = share + (local_rank < extra ? 1 : 0);
+  if (numel > 0) {
+    char* dst = base + begin * elem_size;
+    for (size_t i = 1; i < local_size; ++i) {
+      reduce_func(dst, dst, base + i * stride + begin * elem_size, numel);
+    }
+  }
+  LocalBarrier(tag);
+
+  if (local_rank == 0 && topology_.num_nodes > 1) {
+    if (bytes <= static_cast<size_t>(FLAGS_gloo_allreduce_small_bytes)) {
+      RecursiveDoubling(
+          topology_.leaders, base, count, elem_size, reduce_func, tag);
+    } else {
+      Ring(topology_.leaders, base, count, elem_size, reduce_func, tag);
+    }
+  }
+  LocalBarrier(tag);
+
+  std::memcpy(data, base, bytes);
+  // slot 0 must not be overwritten by the next call before everyone read it
+  LocalBarrier(tag);
+}
+
+}  // namespace distributed
+}  // namespace phi
@@ -0,0 +1,132 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <gloo/context.h>
+#include <gloo/rendezvous/store.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/common/macros.h"
+
+namespace phi {
+class DenseTensor;
+namespace distributed {
+
+// All-reduce algorithms implemented on top of gloo point-to-point buffers.
+// kGloo keeps the default algorithm of gloo::allreduce.
+enum class GlooAllReduceAlgo {
+  kAuto,
+  kGloo,
+  kRecursiveDoubling,
+  kRing,
+  kHierarchical,
+};
+
+GlooAllReduceAlgo StringToGlooAllReduceAlgo(const std::string& name);
+
+const char* GlooAllReduceAlgoToString(GlooAllReduceAlgo algo);
+
+using GlooReduceFunc = void (*)(void*, const void*, const void*, size_t);
+
+// Ranks that are on the same host as the current rank, and the first rank of
+// every host. Built once when the comm context is created.
+struct GlooTopology {
+  std::vector<int> local_ranks;
+  std::vector<int> leaders;
+  int local_rank{0};
+  int num_nodes{1};
+  // name prefix of the shared memory segments of this host, chosen by the
+  // first local rank
+  std::string shm_prefix;
+};
+
+// Exchange hostnames through the rendezvous store and build the topology.
+GlooTopology BuildGlooTopology(int rank,
+                               int size,
+                               gloo::rendezvous::Store* store);
+
+class GlooShmSegment;
+
+// Size-aware all-reduce for GlooCommContext:
+//  - recursive doubling for small messages, latency is log2(p) steps;
+//  - ring reduce-scatter + all-gather for large messages, every rank sends
+//    2 * (p - 1) / p of the buffer;
+//  - hierarchical: ranks on the same host reduce through a shared memory
+//    segment, only one rank per host takes part in the inter-node exchange.
+class GlooAllReducer {
+ public:
+  GlooAllReducer(std::shared_ptr<gloo::Context> context,
+                 GlooTopology topology);
+  ~GlooAllReducer();
+
+  // Returns kGloo when the caller should fall back to gloo::allreduce.
+  GlooAllReduceAlgo Select(GlooAllReduceAlgo requested,
+                           int reduce_type,
+                           size_t bytes) const;
+
+  void Run(GlooAllReduceAlgo algo,
+           phi::DenseTensor* out_tensor,
+           const phi::DenseTensor& in_tensor,
+           int reduce_type,
+           uint32_t tag);
+
+  const GlooTopology& topology() const { return topology_; }
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(GlooAllReducer);
+
+  template <typename T>
+  void RunImpl(GlooAllReduceAlgo algo,
+               phi::DenseTensor* out_tensor,
+               const phi::DenseTensor& in_tensor,
+               int reduce_type,
+               uint32_t tag);
+
+  void RecursiveDoubling(const std::vector<int>& ranks,
+                         char* data,
+                         size_t count,
+                         size_t elem_size,
+                         GlooReduceFunc reduce_func,
+                         uint32_t tag);
+
+  void Ring(const std::vector<int>& ranks,
+            char* data,
+            size_t count,
+            size_t elem_size,
+            GlooReduceFunc reduce_func,
+            uint32_t tag);
+
+  void Hierarchical(char* data,
+                    size_t count,
+                    size_t elem_size,
+                    GlooReduceFunc reduce_func,
+                    uint32_t tag);
+
+  void LocalBarrier(uint32_t tag);
+  void EnsureShm(size_t bytes);
+  char* Scratch(size_t bytes);
+
+  std::shared_ptr<gloo::Context> context_;
+  GlooTopology topology_;
+  int shm_generation_{0};
+  std::unique_ptr<GlooShmSegment> shm_;
+  std::vector<char> scratch_;
+};
+
+}  // namespace distributed
+}  // namespace phi
@@ -24,11 +24,14 @@
 #include <gloo/scatter.h>
 #include <gloo/types.h>
 
+#include "paddle/common/flags.h"
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/distributed/check/static_check.h"
 #include "paddle/phi/core/enforce.h"
 
+COMMON_DECLARE_string(gloo_allreduce_algo);
+
 namespace phi {
 namespace distributed {
 
@@ -40,6 +43,8 @@ GlooCommContext::GlooCommContext(
     : CommContext(rank, size) {
   gloo_context_ = std::make_shared<gloo::rendezvous::Context>(rank, size);
   gloo_context_->connectFullMesh(*store, device);
+  allreducer_ = std::make_unique<GlooAllReducer>(
+      gloo_context_, BuildGlooTopology(rank, size, store.get()));
 }
 
 void GlooCommContext::Broadcast(phi::DenseTensor* out_tensor,
@@ -81,9 +86,18 @@ void GlooCommContext::AllReduce(phi::DenseTensor* out_tensor,
                                 const phi::DenseTensor& in_tensor,
                                 int reduce_type,
                                 uint32_t tag) {
+  const auto& dtype = in_tensor.dtype();
+  auto algo = allreducer_->Select(
+      StringToGlooAllReduceAlgo(FLAGS_gloo_allreduce_algo),
+      reduce_type,
+      in_tensor.numel() * phi::SizeOf(dtype));
+  if (algo != GlooAllReduceAlgo::kGloo) {
+    allreducer_->Run(algo, out_tensor, in_tensor, reduce_type, tag);
+    return;
+  }
+
   gloo::AllreduceOptions opts(gloo_context_);
   opts.setTag(tag);
-  const auto& dtype = in_tensor.dtype();
   GENERATE_FUNC(dtype, SetInput, &opts, in_tensor);
   GENERATE_FUNC(dtype, SetOutput, &opts, out_tensor);
   GENERATE_FUNC(dtype, SetReduceFunc, &opts, reduce_type);
@@ -21,6 +21,7 @@
 
 #include "paddle/common/macros.h"
 #include "paddle/phi/core/distributed/comm_context.h"
+#include "paddle/phi/core/distributed/gloo_allreduce.h"
 
 namespace phi {
 class DenseTensor;
@@ -74,6 +75,7 @@ class GlooCommContext final : public CommContext {
   DISABLE_COPY_AND_ASSIGN(GlooCommContext);
 
   std::shared_ptr<gloo::rendezvous::Context> gloo_context_;
+  std::unique_ptr<GlooAllReducer> allreducer_;
 };
 
 }  // namespace distributed
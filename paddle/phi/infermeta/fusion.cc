@@ -2836,6 +2836,57 @@ void SqueezeExcitationInferMeta(const MetaTensor& x,
   out->set_dims(DDim(out_shape.data(), static_cast<int>(out_shape.size())));
 }
 
+void FusedEmbeddingBagInferMeta(const MetaTensor& ids,
+                                const MetaTensor& weight,
+                                const MetaTensor& offsets,
+                                const MetaTensor& scale,
+                                const std::string& mode,
+                                int64_t padding_idx,
+                                MetaTensor* out) {
+  const auto& weight_dims = weight.dims();
+  PADDLE_ENFORCE_EQ(
+      weight_dims.size(),
+      2,
+      phi::errors::InvalidArgument(
+          "The Input(weight) of fused_embedding_bag should be a 2-D tensor, "
+          "but received [%s].",
+          weight_dims));
+  PADDLE_ENFORCE_EQ(ids.dims().size(),
+                    1,
+                    phi::errors::InvalidArgument(
+                        "The Input(ids) of fused_embedding_bag should be a "
+                        "1-D tensor, but received [%s].",
+                        ids.dims()));
+  PADDLE_ENFORCE_EQ(offsets.dims().size(),
+                    1,
+                    phi::errors::InvalidArgument(
+                        "The Input(offsets) of fused_embedding_bag should be "
+                        "a 1-D tensor of bags + 1 entries, but received [%s].",
+                        offsets.dims()));
+  PADDLE_ENFORCE_EQ(
+      mode == "SUM" || mode == "MEAN" || mode == "MAX",
+      true,
+      phi::errors::InvalidArgument(
+          "The mode of fused_embedding_bag should be SUM, MEAN or MAX, but "
+          "received %s.",
+          mode));
+  if (scale) {
+    PADDLE_ENFORCE_EQ(scale.dtype(),
+                      phi::DataType::FLOAT32,
+                      phi::errors::InvalidArgument(
+                          "The Input(scale) of fused_embedding_bag should be "
+                          "float32, but received %s.",
+                          scale.dtype()));
+  }
+
+  const int64_t bags = offsets.dims()[0] > 0 ? offsets.dims()[0] - 1 : -1;
+  out->set_dims(common::make_ddim({bags, weight_dims[1]}));
+  // int8 and float16 tables are converted to float32 as they are pooled
+  const bool low_precision = weight.dtype() == phi::DataType::INT8 ||
+                             weight.dtype() == phi::DataType::FLOAT16;
+  out->set_dtype(low_precision ? phi::DataType::FLOAT32 : weight.dtype());
+}
+
 void FusedEmbeddingEltWiseLayerNormInferMeta(
     const std::vector<const MetaTensor*>& ids,
     const std::vector<const MetaTensor*>& embs,
@@ -759,6 +759,14 @@ void SqueezeExcitationInferMeta(const MetaTensor& x,
                                 const std::vector<int>& filter_dims,
                                 MetaTensor* out);
 
+void FusedEmbeddingBagInferMeta(const MetaTensor& ids,
+                                const MetaTensor& weight,
+                                const MetaTensor& offsets,
+                                const MetaTensor& scale,
+                                const std::string& mode,
+                                int64_t padding_idx,
+                                MetaTensor* out);
+
 void FusedEmbeddingEltWiseLayerNormInferMeta(
     const std::vector<const MetaTensor*>& ids,
     const std::vector<const MetaTensor*>& embs,
@@ -16,81 +16,17 @@
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
-#include "paddle/phi/kernels/funcs/eigen/common.h"
-#include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
-#include "paddle/phi/kernels/transpose_kernel.h"
+#include "paddle/phi/kernels/funcs/top_k_function_cpu.h"
 
 namespace phi {
 
-template <typename T, typename Type>
-static void FullSort(Type input_height,
-                     Type input_width,
-                     int input_dim,
-                     const DenseTensor* input,
-                     T* t_out,
-                     Type* t_indices,
-                     bool descending,
-                     bool stable) {
-#ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
-#endif
-  for (Type i = 0; i < input_height; ++i) {
-    std::vector<std::pair<T, Type>> col_vec;
-    col_vec.reserve(input_width);
-    if (input_dim == 1) {
-      auto e_input = EigenVector<T>::Flatten(*input);
-      for (Type j = 0; j < input_width; ++j) {
-        col_vec.push_back(std::pair<T, Type>(e_input(j), j));
-      }
-    } else {
-      auto e_input = EigenMatrix<T>::Reshape(*input, input_dim - 1);
-      for (Type j = 0; j < input_width; ++j) {
-        col_vec.push_back(std::pair<T, Type>(e_input(i, j), j));
-      }
-    }
-    if (stable) {
-      std::stable_sort(
-          col_vec.begin(),
-          col_vec.end(),
-          [&](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-            if (descending)
-              return (std::isnan(static_cast<double>(l.first)) &&
-                      !std::isnan(static_cast<double>(r.first))) ||
-                     (l.first > r.first);
-            else
-              return (!std::isnan(static_cast<double>(l.first)) &&
-                      std::isnan(static_cast<double>(r.first))) ||
-                     (l.first < r.first);
-          });
-    } else {
-      std::sort(col_vec.begin(),
-                col_vec.end(),
-                [&](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-                  if (descending)
-                    return (std::isnan(static_cast<double>(l.first)) &&
-                            !std::isnan(static_cast<double>(r.first))) ||
-                           (l.first > r.first);
-                  else
-                    return (!std::isnan(static_cast<double>(l.first)) &&
-                            std::isnan(static_cast<double>(r.first))) ||
-                           (l.first < r.first);
-                });
-    }
-
-    for (Type j = 0; j < input_width; ++j) {
-      t_out[i * input_width + j] = col_vec[j].first;
-      t_indices[i * input_width + j] = col_vec[j].second;
-    }
-  }
-}
-
 template <typename T, typename Context>
 void ArgsortKernel(const Context& dev_ctx,
                    const DenseTensor& input,
                    int axis,
                    bool descending,
-                   bool stable,
+                   bool stable UNUSED,
                    DenseTensor* output,
                    DenseTensor* indices) {
   auto in_dims = input.dims();
@@ -106,68 +42,15 @@ void ArgsortKernel(const Context& dev_ctx,
     return;
   }
 
-  // Do full sort
-  if (axis == -1 || axis + 1 == in_dims.size()) {
-    const int64_t input_height =
-        common::product(common::slice_ddim(in_dims, 0, in_dims.size() - 1));
-    const int64_t input_width = in_dims[in_dims.size() - 1];
-    int64_t* ids_data = dev_ctx.template Alloc<int64_t>(indices);
-    FullSort<T, int64_t>(input_height,
-                         input_width,
-                         in_dims.size(),
-                         &input,
-                         out_data,
-                         ids_data,
-                         descending,
-                         stable);
-  } else {
-    // If not full sort do transpose
-    std::vector<int> trans;
-    for (int i = 0; i < axis; i++) {
-      trans.push_back(i);
-    }
-    trans.push_back(in_dims.size() - 1);
-    for (int i = axis + 1; i < in_dims.size() - 1; i++) {
-      trans.push_back(i);
-    }
-    trans.push_back(axis);
-    phi::DDim trans_dims(in_dims);
-    for (size_t i = 0; i < trans.size(); i++) {
-      trans_dims[static_cast<int>(i)] = in_dims[trans[i]];
-    }
-
-    DenseTensor trans_inp;
-    trans_inp.Resize(trans_dims);
-    dev_ctx.template Alloc<T>(&trans_inp);
-    // Do transpose
-    TransposeKernel<T, Context>(dev_ctx, input, trans, &trans_inp);
-
-    const int64_t input_height = common::product(
-        common::slice_ddim(trans_dims, 0, trans_dims.size() - 1));
-    const int64_t input_width = trans_dims[trans_dims.size() - 1];
-
-    DenseTensor tmp_out;
-    tmp_out.Resize(trans_dims);
-    T* t_out = dev_ctx.template Alloc<T>(&tmp_out);
-
-    DenseTensor tmp_indices;
-    tmp_indices.Resize(trans_dims);
-    auto* t_ind = dev_ctx.template Alloc<int64_t>(&tmp_indices);
-
-    FullSort<T, int64_t>(input_height,
-                         input_width,
-                         in_dims.size(),
-                         &trans_inp,
-                         t_out,
-                         t_ind,
-                         descending,
-                         stable);
-
-    dev_ctx.template Alloc<int64_t>(indices);
-    TransposeKernel<int64_t, Context>(dev_ctx, tmp_indices, trans, indices);
-    // transpose back
-    TransposeKernel<T, Context>(dev_ctx, tmp_out, trans, output);
-  }
+  // view input as [pre, n, post] around axis, non-last axes are read
+  // strided, the sort is stable whether or not stable is set
+  const int64_t pre = common::product(common::slice_ddim(in_dims, 0, axis));
+  const int64_t n = in_dims[axis];
+  const int64_t post =
+      common::product(common::slice_ddim(in_dims, axis + 1, rank));
+  int64_t* ids_data = dev_ctx.template Alloc<int64_t>(indices);
+  funcs::StridedSort<T, int64_t>(
+      input.data<T>(), pre, n, post, descending, out_data, ids_data);
 }
 
 }  // namespace phi
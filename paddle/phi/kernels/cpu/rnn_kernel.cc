@@ -14,6 +14,7 @@
 
 #include "paddle/phi/kernels/rnn_kernel.h"
 
+#include "paddle/common/flags.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_utils.h"
@@ -27,8 +28,12 @@
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
 #include "paddle/phi/kernels/funcs/gru_compute.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
 #include "paddle/phi/kernels/funcs/lstm_compute.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
+#include "paddle/phi/kernels/funcs/rnn_batched_cpu.h"
+
+COMMON_DECLARE_bool(rnn_cpu_batched_inference);
 
 namespace phi {
 
@@ -815,6 +820,189 @@ struct BidirLayer : public Layer<T, CellType> {
   }
 };
 
+// The GEMMs of funcs::RnnBatchedLayerCPU on blas, the gate activations on
+// the jit kernels.
+template <typename T>
+struct RnnBatchedJitOps {
+  RnnBatchedJitOps(const CPUContext& dev_ctx, int64_t hidden)
+      : blas(phi::funcs::GetBlas<CPUContext, T>(dev_ctx)),
+        lstm_attr(static_cast<int>(hidden),
+                  phi::jit::kVSigmoid,
+                  phi::jit::kVTanh,
+                  phi::jit::kVTanh,
+                  false),
+        lstm_step(phi::jit::KernelFuncs<phi::jit::LSTMCtHtTuple<T>,
+                                        phi::CPUPlace>::Cache()
+                      .At(lstm_attr)),
+        hidden(hidden),
+        // GRU runs sigmoid over 2 * hidden and tanh over hidden
+        act_sigmoid(phi::jit::KernelFuncs<phi::jit::VSigmoidTuple<T>,
+                                          phi::CPUPlace>::Cache()
+                        .At(static_cast<int>(2 * hidden))),
+        act_tanh(phi::jit::KernelFuncs<phi::jit::VTanhTuple<T>,
+                                       phi::CPUPlace>::Cache()
+                     .At(static_cast<int>(hidden))) {}
+
+  void Gemm(int64_t m,
+            int64_t n,
+            int64_t k,
+            const T* a,
+            const T* b,
+            T beta,
+            T* c) const {
+    blas.GEMM(CblasNoTrans,
+              CblasNoTrans,
+              static_cast<int>(m),
+              static_cast<int>(n),
+              static_cast<int>(k),
+              static_cast<T>(1),
+              a,
+              b,
+              beta,
+              c);
+  }
+
+  void Sigmoid(const T* x, T* y, int64_t n) const {
+    PADDLE_ENFORCE_EQ(n,
+                      2 * hidden,
+                      phi::errors::InvalidArgument(
+                          "The batched rnn sigmoid expects %ld values, but "
+                          "got %ld.",
+                          2 * hidden,
+                          n));
+    act_sigmoid(x, y, static_cast<int>(n));
+  }
+
+  void Tanh(const T* x, T* y, int64_t n) const {
+    PADDLE_ENFORCE_EQ(n,
+                      hidden,
+                      phi::errors::InvalidArgument(
+                          "The batched rnn tanh expects %ld values, but got "
+                          "%ld.",
+                          hidden,
+                          n));
+    act_tanh(x, y, static_cast<int>(n));
+  }
+
+  void LstmStep(int64_t hidden UNUSED,
+                T* gates,
+                const T* c_prev,
+                T* c,
+                T* h) const {
+    phi::jit::lstm_t step;
+    step.gates = gates;
+    step.ct_1 = c_prev;
+    step.ct = c;
+    step.ht = h;
+    lstm_step(&step, &lstm_attr);
+  }
+
+  phi::funcs::BlasT<CPUContext, T> blas;
+  phi::jit::lstm_attr_t lstm_attr;
+  typename phi::jit::LSTMCtHtTuple<T>::func_type lstm_step;
+  int64_t hidden;
+  typename phi::jit::VSigmoidTuple<T>::func_type act_sigmoid;
+  typename phi::jit::VTanhTuple<T>::func_type act_tanh;
+};
+
+// LSTM / GRU inference on funcs::RnnBatchedLayerCPU: each sequence only
+// runs its own steps, so padded steps cost nothing and need no mask.
+template <typename T>
+void RnnBatchedInference(const CPUContext& dev_ctx,
+                         const DenseTensor& x,
+                         const std::vector<const DenseTensor*>& pre_state,
+                         const std::vector<const DenseTensor*>& weight_list,
+                         const DenseTensor* sequence_length,
+                         bool is_bidirec,
+                         int num_layers,
+                         int hidden_size,
+                         const std::string& mode,
+                         DenseTensor* out,
+                         std::vector<DenseTensor*> state) {
+  const auto cell = is_lstm(mode) ? funcs::RnnBatchedCell::kLSTM
+                                  : funcs::RnnBatchedCell::kGRU;
+  const int direction_num = is_bidirec ? 2 : 1;
+  const int64_t time_steps = x.dims()[0];
+  const int64_t batch = x.dims()[1];
+  const int64_t hidden = hidden_size;
+  const int64_t out_width = direction_num * hidden;
+  PADDLE_ENFORCE_EQ(pre_state[0]->dims()[0],
+                    num_layers * direction_num,
+                    phi::errors::InvalidArgument(
+                        "The num_layers of in RNN layer must be the same as "
+                        "first dim of init hidden, but received"
+                        " num_layers:%d, dim:%d",
+                        num_layers,
+                        pre_state[0]->dims()[0]));
+
+  std::vector<int> seq_len;
+  if (sequence_length != nullptr) {
+    seq_len = phi::GetVectorFromTensor<int>(sequence_length);
+  }
+  std::vector<std::vector<DenseTensor>> parameter_lists;
+  parameter_lists.reserve(num_layers);
+  ResetParameterVector(weight_list,
+                       num_layers,
+                       funcs::RnnBatchedGateNum(cell),
+                       is_bidirec,
+                       &parameter_lists);
+
+  RnnBatchedJitOps<T> ops(dev_ctx, hidden);
+  funcs::RnnBatchedWeights<T> packed;
+  const T* h0 = pre_state[0]->data<T>();
+  const T* c0 = is_lstm(mode) ? pre_state[1]->data<T>() : nullptr;
+  T* h_last = state[0]->data<T>();
+  T* c_last = is_lstm(mode) ? state[1]->data<T>() : nullptr;
+
+  // layers ping-pong between out and hidden, so the last one ends in out
+  DenseTensor hidden_tensor;
+  if (num_layers > 1) {
+    hidden_tensor = Empty<T>(dev_ctx, {time_steps, batch, out_width});
+  }
+  const T* layer_in = x.data<T>();
+  int64_t layer_in_width = x.dims()[2];
+  for (int i = 0; i < num_layers; ++i) {
+    T* layer_out = (num_layers - 1 - i) % 2 == 0
+                       ? out->data<T>()
+                       : hidden_tensor.data<T>();
+    if (!seq_len.empty()) {
+      // padded steps are 0, as the masked kernel leaves them
+      std::memset(layer_out, 0, time_steps * batch * out_width * sizeof(T));
+    }
+    for (int d = 0; d < direction_num; ++d) {
+      const auto& params = parameter_lists[i];
+      funcs::PackRnnBatchedWeights<T>(cell,
+                                      params[d * 4].data<T>(),
+                                      params[d * 4 + 1].data<T>(),
+                                      params[d * 4 + 2].data<T>(),
+                                      params[d * 4 + 3].data<T>(),
+                                      layer_in_width,
+                                      hidden,
+                                      &packed);
+      const int64_t state_offset = (i * direction_num + d) * batch * hidden;
+      funcs::RnnBatchedLayerCPU<T>(ops,
+                                   cell,
+                                   packed,
+                                   layer_in,
+                                   time_steps,
+                                   batch,
+                                   layer_in_width,
+                                   hidden,
+                                   seq_len.empty() ? nullptr : seq_len.data(),
+                                   d == 1,
+                                   h0 + state_offset,
+                                   c0 ? c0 + state_offset : nullptr,
+                                   layer_out,
+                                   out_width,
+                                   d * hidden,
+                                   h_last + state_offset,
+                                   c_last ? c_last + state_offset : nullptr);
+    }
+    layer_in = layer_out;
+    layer_in_width = out_width;
+  }
+}
+
 template <typename T, typename Context>
 void RnnKernel(const Context& dev_ctx,
                const DenseTensor& x,
@@ -845,6 +1033,22 @@ void RnnKernel(const Context& dev_ctx,
   dev_ctx.template Alloc<T>(out);
   int gate_num = 4;
   dev_ctx.template Alloc<T>(state[0]);
+  if (is_test && FLAGS_rnn_cpu_batched_inference &&
+      (is_lstm(mode) || is_gru(mode))) {
+    if (is_lstm(mode)) dev_ctx.template Alloc<T>(state[1]);
+    RnnBatchedInference<T>(dev_ctx,
+                           x,
+                           pre_state,
+                           weight_list,
+                           sequence_length.get_ptr(),
+                           is_bidirec,
+                           num_layers,
+                           hidden_size,
+                           mode,
+                           out,
+                           state);
+    return;
+  }
   if (is_lstm(mode)) {
     dev_ctx.template Alloc<T>(state[1]);
     RnnFunc<LSTMCell<T>, Layer, SingleLayer, BidirLayer, T>(
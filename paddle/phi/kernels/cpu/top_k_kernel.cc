@@ -16,118 +16,11 @@
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
-#include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
+#include "paddle/phi/kernels/funcs/top_k_function_cpu.h"
 
 namespace phi {
 
-template <typename T, typename Type>
-static void FullTopK(Type input_height,
-                     Type input_width,
-                     int input_dim,
-                     const DenseTensor* input,
-                     T* t_out,
-                     Type* t_indices,
-                     const int& k,
-                     const bool& largest,
-                     const bool& sorted) {
-  PADDLE_ENFORCE_LE(
-      k,
-      input_width,
-      errors::InvalidArgument("The rank (%d) of the input 'k' for "
-                              "topk op must be less than or equal to %d.",
-                              k,
-                              input_width));
-
-  // when the k is small, will the partial sort
-  bool partial_sort_flag = (k * 64) < input_width;
-
-#ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
-#endif
-  for (Type i = 0; i < input_height; ++i) {
-    std::vector<std::pair<T, Type>> col_vec;
-    col_vec.reserve(input_width);
-    if (input_dim == 1) {
-      auto e_input = EigenVector<T>::Flatten(*input);
-      for (Type j = 0; j < input_width; ++j) {
-        col_vec.emplace_back(std::pair<T, Type>(e_input(j), j));
-      }
-    } else {
-      auto e_input = EigenMatrix<T>::Reshape(*input, input_dim - 1);
-      for (Type j = 0; j < input_width; ++j) {
-        col_vec.emplace_back(std::pair<T, Type>(e_input(i, j), j));
-      }
-    }
-    if (partial_sort_flag) {
-      std::partial_sort(
-          col_vec.begin(),
-          col_vec.begin() + k,
-          col_vec.end(),
-          [&largest](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-            if (largest) {
-              return (std::isnan(static_cast<double>(l.first)) &&
-                      !std::isnan(static_cast<double>(r.first))) ||
-                     (l.first > r.first);
-            } else {
-              return (!std::isnan(static_cast<double>(l.first)) &&
-                      std::isnan(static_cast<double>(r.first))) ||
-                     (l.first < r.first);
-            }
-          });
-    } else {
-      // use the nth-element to get the K-larger or K-small element
-      if (largest) {
-        std::nth_element(
-            col_vec.begin(),
-            col_vec.begin() + k - 1,
-            col_vec.end(),
-            [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-              return (std::isnan(static_cast<double>(l.first)) &&
-                      !std::isnan(static_cast<double>(r.first))) ||
-                     (l.first > r.first);
-            });
-        // the nth-element will get the unorder elements, sort the element
-        if (sorted) {
-          std::sort(
-              col_vec.begin(),
-              col_vec.begin() + k - 1,
-              [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-                return (std::isnan(static_cast<double>(l.first)) &&
-                        !std::isnan(static_cast<double>(r.first))) ||
-                       (l.first > r.first);
-              });
-        }
-      } else {
-        std::nth_element(
-            col_vec.begin(),
-            col_vec.begin() + k - 1,
-            col_vec.end(),
-            [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-              return (!std::isnan(static_cast<double>(l.first)) &&
-                      std::isnan(static_cast<double>(r.first))) ||
-                     (l.first < r.first);
-            });
-        // the nth-element will get the unorder elements, sort the element
-        if (sorted) {
-          std::sort(
-              col_vec.begin(),
-              col_vec.begin() + k - 1,
-              [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-                return (!std::isnan(static_cast<double>(l.first)) &&
-                        std::isnan(static_cast<double>(r.first))) ||
-                       (l.first < r.first);
-              });
-        }
-      }
-    }
-    for (Type j = 0; j < k; ++j) {
-      t_out[i * k + j] = col_vec[j].first;
-      t_indices[i * k + j] = col_vec[j].second;
-    }
-  }
-}
-
 template <typename T, typename Context>
 void TopkKernel(const Context& dev_ctx,
                 const DenseTensor& x,
@@ -169,79 +62,27 @@ void TopkKernel(const Context& dev_ctx,
 
   T* out_data = dev_ctx.template Alloc<T>(out);
   int64_t* indices_data = dev_ctx.template Alloc<int64_t>(indices);
-  const auto& out_dims = out->dims();
-  if (axis + 1 == in_dims.size()) {
-    const int64_t& input_height =
-        common::product(common::slice_ddim(in_dims, 0, in_dims.size() - 1));
-    const int64_t& input_width = in_dims[in_dims.size() - 1];
-    FullTopK<T, int64_t>(input_height,
-                         input_width,
-                         in_dims.size(),
-                         input,
-                         out_data,
-                         indices_data,
-                         k,
-                         largest,
-                         sorted);
-  } else {
-    // if the topk dims is not last dim, will transpose and do topk
-    std::vector<int> trans;
-    for (int i = 0; i < axis; i++) {
-      trans.emplace_back(i);
-    }
-    trans.push_back(in_dims.size() - 1);
-    for (int i = axis + 1; i < in_dims.size() - 1; i++) {
-      trans.emplace_back(i);
-    }
-    trans.emplace_back(axis);
-
-    // get the trans input_dims, out_dims
-    phi::DDim trans_dims(in_dims);
-    phi::DDim trans_out_dims(out->dims());
-    for (int i = 0; i < static_cast<int>(trans.size()); i++) {
-      trans_dims[i] = in_dims[trans[i]];
-    }
-    for (int i = 0; i < static_cast<int>(trans.size()); i++) {
-      trans_out_dims[i] = out_dims[trans[i]];
-    }
-
-    DenseTensor trans_inp;
-    trans_inp.Resize(trans_dims);
-    dev_ctx.template Alloc<T>(&trans_inp);
-    int ndims = static_cast<int>(trans.size());
-
-    // transpose the input value
-    funcs::TransCompute<phi::CPUContext, T>(
-        ndims, dev_ctx, *input, &trans_inp, trans);
-
-    const int64_t input_height = common::product(
-        common::slice_ddim(trans_dims, 0, trans_dims.size() - 1));
-    const int64_t input_width = trans_dims[trans_dims.size() - 1];
-
-    // Allocate the temp tensor to the save the topk indices, values
-    DenseTensor tmp_out;
-    DenseTensor tmp_indices;
-    tmp_out.Resize(trans_out_dims);
-    tmp_indices.Resize(trans_out_dims);
-    T* t_out = dev_ctx.template Alloc<T>(&tmp_out);
-    auto* t_ind = dev_ctx.template Alloc<int64_t>(&tmp_indices);
-
-    // get the TopK value
-    FullTopK<T, int64_t>(input_height,
-                         input_width,
-                         in_dims.size(),
-                         &trans_inp,
-                         t_out,
-                         t_ind,
-                         k,
-                         largest,
-                         sorted);
-    // transpose back
-    funcs::TransCompute<phi::CPUContext, int64_t>(
-        ndims, dev_ctx, tmp_indices, indices, trans);
-    funcs::TransCompute<phi::CPUContext, T>(
-        ndims, dev_ctx, tmp_out, out, trans);
-  }
+  // view x as [pre, n, post] around axis, non-last axes are read strided
+  const int64_t pre = common::product(common::slice_ddim(in_dims, 0, axis));
+  const int64_t n = in_dims[axis];
+  const int64_t post = common::product(
+      common::slice_ddim(in_dims, axis + 1, in_dims.size()));
+  PADDLE_ENFORCE_LE(
+      k,
+      n,
+      errors::InvalidArgument("The rank (%d) of the input 'k' for "
+                              "topk op must be less than or equal to %d.",
+                              k,
+                              n));
+  funcs::StridedTopK<T, int64_t>(x.data<T>(),
+                                 pre,
+                                 n,
+                                 post,
+                                 k,
+                                 largest,
+                                 sorted,
+                                 out_data,
+                                 indices_data);
 }
 
 }  // namespace phi
@@ -0,0 +1,437 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/funcs/conv_cpu_direct.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+
+namespace phi {
+namespace funcs {
+
+namespace {
+
+// Winograd needs this many input and output channels to beat im2col.
+constexpr int kWinogradMinChannels = 8;
+// The filter transform costs about as much as the GEMMs over channels / 4
+// tiles, below that (or below kWinogradMinTiles) im2col is faster.
+constexpr int kWinogradMinTiles = 32;
+constexpr int kWinogradTilesPerChannel = 4;
+// Tiles transformed per GEMM, this bounds the scratch to
+// (tile_size + 2)^2 * channels * kWinogradTileBlock values.
+constexpr int kWinogradTileBlock = 128;
+
+// Tiles transformed together, the 1-D transforms below run over them in
+// the innermost loop so they vectorize.
+constexpr int kWinogradLanes = 16;
+// The A x A planes of the transformed filter, input and output are this
+// many values apart beyond their size. Planes a power of two apart would
+// map the same element of every plane to one cache set.
+constexpr int kWinogradPlanePad = 16;
+
+// The 1-D transforms of F(m, 3) from Lavin & Gray, "Fast Algorithms for
+// Convolutional Neural Networks". Each reads element e of lane l at
+// src[e * src_stride + l] and writes to dst alike, a 2-D transform is a
+// pass over the columns followed by a pass over the rows.
+struct WinogradF23 {
+  static constexpr int M = 2;
+  static constexpr int A = 4;
+
+  // G w
+  template <typename T>
+  static void Filter(const T* w, int ws, T* u, int us, int lanes) {
+    for (int l = 0; l < lanes; ++l) {
+      const T w0 = w[l], w1 = w[ws + l], w2 = w[2 * ws + l];
+      u[l] = w0;
+      u[us + l] = static_cast<T>(0.5) * (w0 + w1 + w2);
+      u[2 * us + l] = static_cast<T>(0.5) * (w0 - w1 + w2);
+      u[3 * us + l] = w2;
+    }
+  }
+
+  // B^T d
+  template <typename T>
+  static void Input(const T* d, int ds, T* v, int vs, int lanes) {
+    for (int l = 0; l < lanes; ++l) {
+      const T d0 = d[l], d1 = d[ds + l], d2 = d[2 * ds + l],
+              d3 = d[3 * ds + l];
+      v[l] = d0 - d2;
+      v[vs + l] = d1 + d2;
+      v[2 * vs + l] = d2 - d1;
+      v[3 * vs + l] = d1 - d3;
+    }
+  }
+
+  // A^T m
+  template <typename T>
+  static void Output(const T* m, int ms, T* y, int ys, int lanes) {
+    for (int l = 0; l < lanes; ++l) {
+      const T m0 = m[l], m1 = m[ms + l], m2 = m[2 * ms + l],
+              m3 = m[3 * ms + l];
+      y[l] = m0 + m1 + m2;
+      y[ys + l] = m1 - m2 - m3;
+    }
+  }
+};
+
+struct WinogradF43 {
+  static constexpr int M = 4;
+  static constexpr int A = 6;
+
+  template <typename T>
+  static void Filter(const T* w, int ws, T* u, int us, int lanes) {
+    const T c4 = static_cast<T>(1.0 / 4), c6 = static_cast<T>(1.0 / 6),
+            c12 = static_cast<T>(1.0 / 12), c24 = static_cast<T>(1.0 / 24);
+    for (int l = 0; l < lanes; ++l) {
+      const T w0 = w[l], w1 = w[ws + l], w2 = w[2 * ws + l];
+      u[l] = c4 * w0;
+      u[us + l] = -c6 * (w0 + w1 + w2);
+      u[2 * us + l] = -c6 * (w0 - w1 + w2);
+      u[3 * us + l] = c24 * w0 + c12 * w1 + c6 * w2;
+      u[4 * us + l] = c24 * w0 - c12 * w1 + c6 * w2;
+      u[5 * us + l] = w2;
+    }
+  }
+
+  template <typename T>
+  static void Input(const T* d, int ds, T* v, int vs, int lanes) {
+    for (int l = 0; l < lanes; ++l) {
+      const T d0 = d[l], d1 = d[ds + l], d2 = d[2 * ds + l],
+              d3 = d[3 * ds + l], d4 = d[4 * ds + l], d5 = d[5 * ds + l];
+      v[l] = 4 * d0 - 5 * d2 + d4;
+      v[vs + l] = -4 * (d1 + d2) + d3 + d4;
+      v[2 * vs + l] = 4 * (d1 - d2) - d3 + d4;
+      v[3 * vs + l] = 2 * (d3 - d1) - d2 + d4;
+      v[4 * vs + l] = 2 * (d1 - d3) - d2 + d4;
+      v[5 * vs + l] = 4 * d1 - 5 * d3 + d5;
+    }
+  }
+
+  template <typename T>
+  static void Output(const T* m, int ms, T* y, int ys, int lanes) {
+    for (int l = 0; l < lanes; ++l) {
+      const T m0 = m[l], m1 = m[ms + l], m2 = m[2 * ms + l],
+              m3 = m[3 * ms + l], m4 = m[4 * ms + l], m5 = m[5 * ms + l];
+      const T a = m1 + m2, b = m1 - m2, c = m3 + m4, d = m3 - m4;
+      y[l] = m0 + a + c;
+      y[ys + l] = b + 2 * d;
+      y[2 * ys + l] = a + 4 * c;
+      y[3 * ys + l] = b + 8 * d + m5;
+    }
+  }
+};
+
+template <typename T, typename F>
+void WinogradConv2dImpl(const phi::CPUContext& dev_ctx,
+                        const Conv2dCpuShape& s,
+                        const T* input,
+                        const T* filter,
+                        T* output) {
+  constexpr int M = F::M;
+  constexpr int A = F::A;
+  constexpr int L = kWinogradLanes;
+  const int K = s.out_channels;
+  const int C = s.in_channels;
+  const int64_t KC = static_cast<int64_t>(K) * C;
+
+  // U[xi][k][c] = (G w G^T)[xi], xi runs over the A x A tile elements
+  // the scratch comes from the context allocator like the im2col buffer,
+  // so repeated calls reuse it instead of faulting in fresh pages
+  const int u_plane = static_cast<int>(KC) + kWinogradPlanePad;
+  DenseTensor u_tensor;
+  u_tensor.Resize({static_cast<int64_t>(A * A) * u_plane});
+  T* u = dev_ctx.template Alloc<T>(&u_tensor);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t kc0 = 0; kc0 < KC; kc0 += L) {
+    const int lanes = static_cast<int>(std::min<int64_t>(L, KC - kc0));
+    T w[9 * L], tmp[A * 3 * L];
+    for (int l = 0; l < lanes; ++l) {
+      for (int e = 0; e < 9; ++e) w[e * L + l] = filter[(kc0 + l) * 9 + e];
+    }
+    for (int j = 0; j < 3; ++j) {
+      F::Filter(w + j * L, 3 * L, tmp + j * L, 3 * L, lanes);
+    }
+    for (int i = 0; i < A; ++i) {
+      F::Filter(tmp + i * 3 * L,
+                L,
+                u + static_cast<int64_t>(i * A) * u_plane + kc0,
+                u_plane,
+                lanes);
+    }
+  }
+
+  const int tiles_h = (s.out_h + M - 1) / M;
+  const int tiles_w = (s.out_w + M - 1) / M;
+  const int tiles_per_image = tiles_h * tiles_w;
+  // tiles of all images share the GEMMs, so small feature maps still give
+  // them a reasonable width
+  const int tiles = s.batch * tiles_per_image;
+  const int block = std::min(tiles, kWinogradTileBlock);
+  const int v_plane = C * block + kWinogradPlanePad;
+  const int m_plane = K * block + kWinogradPlanePad;
+  DenseTensor v_tensor, m_tensor;
+  v_tensor.Resize({static_cast<int64_t>(A * A) * v_plane});
+  m_tensor.Resize({static_cast<int64_t>(A * A) * m_plane});
+  T* v = dev_ctx.template Alloc<T>(&v_tensor);
+  T* m = dev_ctx.template Alloc<T>(&m_tensor);
+  auto blas = phi::funcs::GetBlas<phi::CPUContext, T>(dev_ctx);
+  const int64_t in_plane = static_cast<int64_t>(s.in_h) * s.in_w;
+  const int64_t out_plane = static_cast<int64_t>(s.out_h) * s.out_w;
+
+  for (int tb = 0; tb < tiles; tb += block) {
+    const int nb = std::min(block, tiles - tb);
+    const int groups = (nb + L - 1) / L;
+
+    // V[xi][c][t] = (B^T d B)[xi], d is the zero padded input tile
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for collapse(2)
+#endif
+    for (int c = 0; c < C; ++c) {
+      for (int tg = 0; tg < groups; ++tg) {
+        const int t0 = tg * L;
+        const int lanes = std::min(L, nb - t0);
+        T d[A * A * L], tmp[A * A * L];
+        for (int l = 0; l < lanes; ++l) {
+          const int n = (tb + t0 + l) / tiles_per_image;
+          const int tile = (tb + t0 + l) % tiles_per_image;
+          const T* plane = input + (n * C + c) * in_plane;
+          const int y0 = (tile / tiles_w) * M - s.pad_top;
+          const int x0 = (tile % tiles_w) * M - s.pad_left;
+          if (y0 >= 0 && y0 + A <= s.in_h && x0 >= 0 && x0 + A <= s.in_w) {
+            const T* src = plane + y0 * s.in_w + x0;
+            for (int i = 0; i < A; ++i) {
+              for (int j = 0; j < A; ++j) {
+                d[(i * A + j) * L + l] = src[i * s.in_w + j];
+              }
+            }
+          } else {
+            for (int i = 0; i < A; ++i) {
+              const int y = y0 + i;
+              for (int j = 0; j < A; ++j) {
+                const int x = x0 + j;
+                d[(i * A + j) * L + l] =
+                    (y >= 0 && y < s.in_h && x >= 0 && x < s.in_w)
+                        ? plane[y * s.in_w + x]
+                        : static_cast<T>(0);
+              }
+            }
+          }
+        }
+        for (int j = 0; j < A; ++j) {
+          F::Input(d + j * L, A * L, tmp + j * L, A * L, lanes);
+        }
+        for (int i = 0; i < A; ++i) {
+          F::Input(tmp + i * A * L,
+                   L,
+                   v + static_cast<int64_t>(i * A) * v_plane + c * nb +
+                       t0,
+                   v_plane,
+                   lanes);
+        }
+      }
+    }
+
+    // M[xi] = U[xi] * V[xi], [K, C] x [C, nb]
+    for (int xi = 0; xi < A * A; ++xi) {
+      blas.GEMM(CblasNoTrans,
+                CblasNoTrans,
+                K,
+                nb,
+                C,
+                static_cast<T>(1),
+                u + static_cast<int64_t>(xi) * u_plane,
+                v + static_cast<int64_t>(xi) * v_plane,
+                static_cast<T>(0),
+                m + static_cast<int64_t>(xi) * m_plane);
+    }
+
+    // Y = A^T M A, clipped at the bottom and right edges
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for collapse(2)
+#endif
+    for (int k = 0; k < K; ++k) {
+      for (int tg = 0; tg < groups; ++tg) {
+        const int t0 = tg * L;
+        const int lanes = std::min(L, nb - t0);
+        T tmp[M * A * L], y[M * M * L];
+        for (int j = 0; j < A; ++j) {
+          F::Output(m + static_cast<int64_t>(j) * m_plane + k * nb + t0,
+                    A * m_plane,
+                    tmp + j * L,
+                    A * L,
+                    lanes);
+        }
+        for (int i = 0; i < M; ++i) {
+          F::Output(tmp + i * A * L, L, y + i * M * L, L, lanes);
+        }
+        for (int l = 0; l < lanes; ++l) {
+          const int n = (tb + t0 + l) / tiles_per_image;
+          const int tile = (tb + t0 + l) % tiles_per_image;
+          T* plane = output + (n * K + k) * out_plane;
+          const int y0 = (tile / tiles_w) * M;
+          const int x0 = (tile % tiles_w) * M;
+          const int rows = std::min(M, s.out_h - y0);
+          const int cols = std::min(M, s.out_w - x0);
+          for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+              plane[(y0 + i) * s.out_w + x0 + j] = y[(i * M + j) * L + l];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+ConvCpuAlgo SelectConvCpuAlgo(const Conv2dCpuShape& s) {
+  if (s.groups > 1 && s.groups == s.in_channels &&
+      s.out_channels % s.groups == 0) {
+    return ConvCpuAlgo::kDepthwise;
+  }
+  const bool unit_3x3 = s.filter_h == 3 && s.filter_w == 3 &&
+                        s.stride_h == 1 && s.stride_w == 1 &&
+                        s.dilation_h == 1 && s.dilation_w == 1;
+  if (s.groups == 1 && unit_3x3 && s.in_channels >= kWinogradMinChannels &&
+      s.out_channels >= kWinogradMinChannels) {
+    // F(4x4) does 4x fewer multiplies per output than direct, F(2x2) 2.25x,
+    // but F(4x4) has a larger filter transform and fewer tiles to spread
+    // it over
+    const int min_tiles =
+        std::max(kWinogradMinTiles,
+                 std::max(s.in_channels, s.out_channels) /
+                     kWinogradTilesPerChannel);
+    auto tiles = [&s](int m) {
+      return static_cast<int64_t>(s.batch) * ((s.out_h + m - 1) / m) *
+             ((s.out_w + m - 1) / m);
+    };
+    if (tiles(4) >= min_tiles) {
+      return ConvCpuAlgo::kWinogradF43;
+    }
+    if (tiles(2) >= min_tiles) {
+      return ConvCpuAlgo::kWinogradF23;
+    }
+  }
+  return ConvCpuAlgo::kIm2Col;
+}
+
+template <typename T>
+void WinogradConv2d(const phi::CPUContext& dev_ctx,
+                    const Conv2dCpuShape& shape,
+                    int tile_size,
+                    const T* input,
+                    const T* filter,
+                    T* output) {
+  PADDLE_ENFORCE_EQ(
+      shape.filter_h == 3 && shape.filter_w == 3 && shape.groups == 1,
+      true,
+      phi::errors::InvalidArgument(
+          "Winograd convolution needs a 3x3 filter and groups == 1, but got "
+          "a %dx%d filter and groups == %d.",
+          shape.filter_h,
+          shape.filter_w,
+          shape.groups));
+  if (tile_size == 4) {
+    WinogradConv2dImpl<T, WinogradF43>(dev_ctx, shape, input, filter, output);
+  } else if (tile_size == 2) {
+    WinogradConv2dImpl<T, WinogradF23>(dev_ctx, shape, input, filter, output);
+  } else {
+    PADDLE_THROW(phi::errors::InvalidArgument(
+        "Winograd tile size must be 2 or 4, but got %d.", tile_size));
+  }
+}
+
+template <typename T>
+void DepthwiseConv2dDirect(const Conv2dCpuShape& s,
+                           const T* input,
+                           const T* filter,
+                           T* output) {
+  const int multiplier = s.out_channels / s.in_channels;
+  const int64_t in_plane = static_cast<int64_t>(s.in_h) * s.in_w;
+  const int64_t out_plane = static_cast<int64_t>(s.out_h) * s.out_w;
+  const int64_t planes = static_cast<int64_t>(s.batch) * s.out_channels;
+
+  // the output columns [lo, hi) of filter column kw read inside the input
+  std::vector<int> col_lo(s.filter_w), col_hi(s.filter_w);
+  for (int kw = 0; kw < s.filter_w; ++kw) {
+    const int offset = kw * s.dilation_w - s.pad_left;
+    col_lo[kw] = offset >= 0 ? 0 : (-offset + s.stride_w - 1) / s.stride_w;
+    const int last = s.in_w - 1 - offset;
+    col_hi[kw] = last < 0 ? 0 : std::min(s.out_w, last / s.stride_w + 1);
+  }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t p = 0; p < planes; ++p) {
+    const int n = static_cast<int>(p / s.out_channels);
+    const int oc = static_cast<int>(p % s.out_channels);
+    const T* in = input + (n * s.in_channels + oc / multiplier) * in_plane;
+    const T* w = filter + oc * s.filter_h * s.filter_w;
+    T* out = output + p * out_plane;
+    for (int oh = 0; oh < s.out_h; ++oh) {
+      T* out_row = out + oh * s.out_w;
+      std::fill(out_row, out_row + s.out_w, static_cast<T>(0));
+      for (int kh = 0; kh < s.filter_h; ++kh) {
+        const int ih = oh * s.stride_h - s.pad_top + kh * s.dilation_h;
+        if (ih < 0 || ih >= s.in_h) continue;
+        const T* in_row = in + ih * s.in_w;
+        for (int kw = 0; kw < s.filter_w; ++kw) {
+          const T wv = w[kh * s.filter_w + kw];
+          const int offset = kw * s.dilation_w - s.pad_left;
+          if (s.stride_w == 1) {
+            for (int ow = col_lo[kw]; ow < col_hi[kw]; ++ow) {
+              out_row[ow] += wv * in_row[ow + offset];
+            }
+          } else {
+            for (int ow = col_lo[kw]; ow < col_hi[kw]; ++ow) {
+              out_row[ow] += wv * in_row[ow * s.stride_w + offset];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template void WinogradConv2d<float>(const phi::CPUContext&,
+                                    const Conv2dCpuShape&,
+                                    int,
+                                    const float*,
+                                    const float*,
+                                    float*);
+template void WinogradConv2d<double>(const phi::CPUContext&,
+                                     const Conv2dCpuShape&,
+                                     int,
+                                     const double*,
+                                     const double*,
+                                     double*);
+template void DepthwiseConv2dDirect<float>(const Conv2dCpuShape&,
+                                           const float*,
+                                           const float*,
+                                           float*);
+template void DepthwiseConv2dDirect<double>(const Conv2dCpuShape&,
+                                            const double*,
+                                            const double*,
+                                            double*);
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,76 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+/*
+ * \brief CPU algorithms for a 2-D NCHW convolution that avoid the im2col
+ *        column buffer, picked by SelectConvCpuAlgo from the shape.
+ *
+ * kWinogradF23 / kWinogradF43: Winograd F(2x2, 3x3) / F(4x4, 3x3) for
+ *   3x3 stride-1 undilated convolutions with groups == 1. The input is
+ *   transformed one block of tiles at a time, so the scratch is bounded
+ *   and the channel reduction is one GEMM per tile element.
+ * kDepthwise: direct convolution of each channel plane, any filter size,
+ *   stride, padding and dilation, for groups == input channels.
+ * kIm2Col: none of the above, the caller keeps im2col + GEMM.
+ */
+enum class ConvCpuAlgo { kIm2Col = 0, kWinogradF23, kWinogradF43, kDepthwise };
+
+struct Conv2dCpuShape {
+  int batch;
+  int in_channels;
+  int in_h;
+  int in_w;
+  int out_channels;
+  int out_h;
+  int out_w;
+  int filter_h;
+  int filter_w;
+  int stride_h;
+  int stride_w;
+  // the bottom and right padding follow from out_h and out_w
+  int pad_top;
+  int pad_left;
+  int dilation_h;
+  int dilation_w;
+  int groups;
+};
+
+ConvCpuAlgo SelectConvCpuAlgo(const Conv2dCpuShape& shape);
+
+// input [batch, in_channels, in_h, in_w], filter [out_channels,
+// in_channels / groups, filter_h, filter_w], output [batch, out_channels,
+// out_h, out_w], all contiguous.
+template <typename T>
+void WinogradConv2d(const phi::CPUContext& dev_ctx,
+                    const Conv2dCpuShape& shape,
+                    int tile_size,
+                    const T* input,
+                    const T* filter,
+                    T* output);
+
+template <typename T>
+void DepthwiseConv2dDirect(const Conv2dCpuShape& shape,
+                           const T* input,
+                           const T* filter,
+                           T* output);
+
+}  // namespace funcs
+}  // namespace phi
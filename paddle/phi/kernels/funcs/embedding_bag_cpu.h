@@ -0,0 +1,165 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace phi {
+namespace funcs {
+
+enum class EmbeddingBagMode { kSum = 0, kMean, kMax };
+
+// Columns of a bag accumulated at a time, kept in a local array so the
+// compiler holds them in vector registers across the rows of the bag.
+constexpr int kEmbeddingBagDimBlock = 64;
+// How many ids ahead the table rows are prefetched.
+constexpr int kEmbeddingBagPrefetch = 8;
+// Ids per parallel task, bags are split between tasks by id count so one
+// long bag does not hold up a thread with many short ones queued behind it.
+constexpr int64_t kEmbeddingBagIdsPerTask = 4096;
+
+// Tables are float or double, or float16 / int8 converted to float as they
+// are read.
+template <typename T>
+using EmbeddingBagAccType =
+    typename std::conditional<std::is_same<T, double>::value, double, float>::
+        type;
+
+inline void EmbeddingBagPrefetch(const void* ptr, int64_t bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+  const char* p = static_cast<const char*>(ptr);
+  for (int64_t off = 0; off < bytes; off += 64) {
+    __builtin_prefetch(p + off);
+  }
+#endif
+}
+
+// Pools bags [bag_begin, bag_end) of the rows table[ids[i]] into out, one
+// row of dim per bag. Bag b is ids[offsets[b], offsets[b + 1]). Ids equal
+// to padding_idx are skipped and not counted by the mean, empty bags are 0.
+// row_scale, if not null, multiplies every row read from the table, the
+// dequantization scale of int8 tables.
+template <typename T, typename IdT>
+void EmbeddingBagSegments(const T* table,
+                          int64_t dim,
+                          const float* row_scale,
+                          const IdT* ids,
+                          const int64_t* offsets,
+                          int64_t bag_begin,
+                          int64_t bag_end,
+                          EmbeddingBagMode mode,
+                          int64_t padding_idx,
+                          EmbeddingBagAccType<T>* out) {
+  using AccT = EmbeddingBagAccType<T>;
+  AccT acc[kEmbeddingBagDimBlock];
+  for (int64_t bag = bag_begin; bag < bag_end; ++bag) {
+    const int64_t begin = offsets[bag];
+    const int64_t end = offsets[bag + 1];
+    AccT* dst = out + bag * dim;
+    for (int64_t d0 = 0; d0 < dim; d0 += kEmbeddingBagDimBlock) {
+      const int64_t width = std::min<int64_t>(kEmbeddingBagDimBlock, dim - d0);
+      std::fill(acc,
+                acc + width,
+                mode == EmbeddingBagMode::kMax
+                    ? -std::numeric_limits<AccT>::infinity()
+                    : static_cast<AccT>(0));
+      int64_t count = 0;
+      for (int64_t i = begin; i < end; ++i) {
+        if (i + kEmbeddingBagPrefetch < end) {
+          const int64_t ahead = ids[i + kEmbeddingBagPrefetch];
+          EmbeddingBagPrefetch(table + ahead * dim + d0, width * sizeof(T));
+        }
+        const int64_t id = ids[i];
+        if (id == padding_idx) continue;
+        ++count;
+        const T* row = table + id * dim + d0;
+        const AccT scale =
+            row_scale ? static_cast<AccT>(row_scale[id]) : static_cast<AccT>(1);
+        if (mode == EmbeddingBagMode::kMax) {
+          for (int64_t k = 0; k < width; ++k) {
+            acc[k] = std::max(acc[k], static_cast<AccT>(row[k]) * scale);
+          }
+        } else {
+          for (int64_t k = 0; k < width; ++k) {
+            acc[k] += static_cast<AccT>(row[k]) * scale;
+          }
+        }
+      }
+      if (count == 0) {
+        std::fill(dst + d0, dst + d0 + width, static_cast<AccT>(0));
+        continue;
+      }
+      const AccT factor = mode == EmbeddingBagMode::kMean
+                              ? static_cast<AccT>(1) / count
+                              : static_cast<AccT>(1);
+      for (int64_t k = 0; k < width; ++k) {
+        dst[d0 + k] = acc[k] * factor;
+      }
+    }
+  }
+}
+
+/*
+ * \brief Embedding lookup fused with per-bag sum, mean or max pooling, the
+ *        [num_ids, dim] lookup result is never materialized.
+ *
+ * table is [rows, dim] and out [bags, dim]; offsets holds bags + 1
+ * non-decreasing entries from 0 to num_ids. Bags are split into tasks of
+ * about kEmbeddingBagIdsPerTask ids that run in parallel.
+ */
+template <typename T, typename IdT>
+void EmbeddingBagCPU(const T* table,
+                     int64_t dim,
+                     const float* row_scale,
+                     const IdT* ids,
+                     int64_t num_ids,
+                     const int64_t* offsets,
+                     int64_t bags,
+                     EmbeddingBagMode mode,
+                     int64_t padding_idx,
+                     EmbeddingBagAccType<T>* out) {
+  const int64_t tasks = std::max<int64_t>(
+      1,
+      std::min(bags,
+               (num_ids + kEmbeddingBagIdsPerTask - 1) /
+                   kEmbeddingBagIdsPerTask));
+  // the first bag of task t, the one holding id t * num_ids / tasks
+  auto split = [&](int64_t t) -> int64_t {
+    if (t == tasks) return bags;
+    return std::lower_bound(offsets, offsets + bags, t * num_ids / tasks) -
+           offsets;
+  };
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t t = 0; t < tasks; ++t) {
+    EmbeddingBagSegments<T, IdT>(table,
+                                 dim,
+                                 row_scale,
+                                 ids,
+                                 offsets,
+                                 split(t),
+                                 split(t + 1),
+                                 mode,
+                                 padding_idx,
+                                 out);
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -14,8 +14,14 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/funcs/fc_functor.h"
 
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 #include "paddle/phi/backends/all_context.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/int8_gemm_cpu.h"
 #include "paddle/phi/kernels/funcs/jit/kernels.h"
 
 namespace phi {
@@ -100,5 +106,157 @@ void FCFunctor<DeviceContext, T>::operator()(const DeviceContext& context,
 template class FCFunctor<CPUContext, float>;
 template class FCFunctor<CPUContext, double>;
 
+namespace {
+
+// The packed weights of quant_linear by the address of the int8 weights. An
+// entry is reused while it still belongs to the same allocation, so a
+// weight is packed on its first run only; the entries of freed weights are
+// dropped when a new one comes in.
+std::shared_ptr<const Int8GemmPackedB> GetPackedInt8Weights(
+    const DenseTensor& w, int K, int N, int ldw) {
+  struct Entry {
+    std::weak_ptr<phi::Allocation> holder;
+    int k;
+    int n;
+    int ldw;
+    std::shared_ptr<const Int8GemmPackedB> packed;
+  };
+  static std::mutex mutex;
+  static std::unordered_map<const void*, Entry> cache;
+
+  const int8_t* data = w.data<int8_t>();
+  std::lock_guard<std::mutex> guard(mutex);
+  auto it = cache.find(data);
+  if (it != cache.end() && it->second.holder.lock() == w.Holder() &&
+      it->second.k == K && it->second.n == N && it->second.ldw == ldw) {
+    return it->second.packed;
+  }
+  for (auto iter = cache.begin(); iter != cache.end();) {
+    if (iter->second.holder.expired()) {
+      iter = cache.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  auto packed = std::make_shared<Int8GemmPackedB>();
+  PackInt8GemmB(data, K, N, ldw, packed.get());
+  cache[data] = Entry{w.Holder(), K, N, ldw, packed};
+  return packed;
+}
+
+// the quantization of LaunchQuantKernelWithVecSize
+template <typename T>
+inline int8_t QuantizeInt8(const T input,
+                           const float scale,
+                           const int round_type,
+                           const float max_bound,
+                           const float min_bound) {
+  float quant_value = scale * static_cast<float>(input);
+  if (round_type == 0) {
+    quant_value = std::nearbyint(quant_value);
+  } else {
+    quant_value = std::round(quant_value);
+  }
+  quant_value = quant_value > max_bound ? max_bound : quant_value;
+  quant_value = quant_value < min_bound ? min_bound : quant_value;
+  return static_cast<int8_t>(quant_value);
+}
+
+}  // namespace
+
+// The activations are quantized per tensor, multiplied with the int8
+// weights into int32 by the micro-kernels of Int8GemmCPU, and dequantized
+// per output column, as the GPU functor does.
+template <typename DeviceContext, typename T>
+void FCInt8Functor<DeviceContext, T>::operator()(
+    const DeviceContext& context,
+    const int M,
+    const int N,
+    const int K,
+    const T* X,
+    const DenseTensor* w_tensor,
+    T* Y,
+    float scale_in,
+    std::vector<float> scale_weights,
+    int quant_round_type,
+    float quant_max_bound,
+    float quant_min_bound,
+    const T* B,
+    bool relu,
+    bool padding_weights) {
+  PADDLE_ENFORCE_EQ(
+      scale_weights.size(),
+      static_cast<size_t>(N),
+      errors::InvalidArgument("The size of scale_weights (%d) should be the "
+                              "column number of the weight (%d).",
+                              scale_weights.size(),
+                              N));
+  if (B == nullptr) {
+    PADDLE_ENFORCE_EQ(
+        relu,
+        false,
+        errors::PermissionDenied("When bias is NULL, relu can not be true."));
+  }
+  if (M == 0) return;
+
+  auto packed =
+      GetPackedInt8Weights(*w_tensor, K, N, padding_weights ? N + 4 : N);
+  const int k_pad = packed->k_pad;
+  const int n_pad = packed->n_pad;
+  auto isa = Int8GemmBestIsa();
+  if (isa == Int8GemmIsa::kAvx2 &&
+      (quant_min_bound < -127.0f || packed->has_int8_min)) {
+    isa = Int8GemmIsa::kRef;
+  }
+
+  DenseTensor quant_x_tensor, quant_y_tensor;
+  quant_x_tensor.Resize(common::make_ddim({M, k_pad}));
+  quant_y_tensor.Resize(common::make_ddim({M, n_pad}));
+  int8_t* quant_x = context.template Alloc<int8_t>(&quant_x_tensor);
+  int32_t* quant_y = context.template Alloc<int32_t>(&quant_y_tensor);
+  const float in_scale = quant_max_bound * scale_in;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < M; ++i) {
+    const T* x_row = X + static_cast<size_t>(i) * K;
+    int8_t* q_row = quant_x + static_cast<size_t>(i) * k_pad;
+    for (int k = 0; k < K; ++k) {
+      q_row[k] = QuantizeInt8(x_row[k],
+                              in_scale,
+                              quant_round_type,
+                              quant_max_bound,
+                              quant_min_bound);
+    }
+    for (int k = K; k < k_pad; ++k) q_row[k] = 0;
+  }
+
+  Int8GemmCPU(M, quant_x, k_pad, *packed, quant_y, n_pad, isa);
+
+  std::vector<float> out_scale(N);
+  for (int j = 0; j < N; ++j) {
+    out_scale[j] = 1.0f / (quant_max_bound * quant_max_bound * scale_in *
+                           scale_weights[j]);
+  }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < M; ++i) {
+    const int32_t* acc = quant_y + static_cast<size_t>(i) * n_pad;
+    T* y_row = Y + static_cast<size_t>(i) * N;
+    for (int j = 0; j < N; ++j) {
+      T value = static_cast<T>(static_cast<float>(acc[j]) * out_scale[j]);
+      if (B != nullptr) {
+        value += B[j];
+        if (relu && value < static_cast<T>(0)) value = static_cast<T>(0);
+      }
+      y_row[j] = value;
+    }
+  }
+}
+
+template class FCInt8Functor<CPUContext, float>;
+template class FCInt8Functor<CPUContext, double>;
+
 }  // namespace funcs
 }  // namespace phi
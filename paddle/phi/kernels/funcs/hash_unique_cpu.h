@@ -0,0 +1,399 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace phi {
+namespace funcs {
+
+// Keys per partition, so the scatter writes to few enough partitions at a
+// time and a partition's hash table mostly stays in cache.
+constexpr int64_t kHashUniquePartitionSize = 1 << 16;
+constexpr int kHashUniqueMaxPartitionBits = 16;
+// Keys per task of the partitioning and inverse passes.
+constexpr int64_t kHashUniqueChunk = 1 << 16;
+// Initial slots of a partition's table, it doubles at half load.
+constexpr int64_t kHashUniqueInitSlots = 1 << 10;
+// Up to this many unique keys one table over the whole input stays in
+// cache, and a single pass beats partitioning.
+constexpr int64_t kHashUniqueDirectLimit = 1 << 17;
+
+enum class HashUniqueOrder {
+  // partition order, the cheapest
+  kAny = 0,
+  // the order in which the keys first occur, as std::unordered_map based
+  // code produces it
+  kFirstOccurrence,
+  // ascending, as std::set based code produces it
+  kSorted
+};
+
+// The splitmix64 finalizer: partitions take the top bits of the result and
+// table slots the low bits, both need to be well mixed even for feasigns
+// that only differ in a few bits.
+inline uint64_t HashUniqueMix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// Open addressing with linear probing, local ids handed out in insertion
+// order.
+template <typename T>
+class HashUniqueTable {
+ public:
+  void Reset(int64_t capacity) {
+    keys_.resize(capacity);
+    ids_.assign(capacity, -1);
+    mask_ = capacity - 1;
+    size_ = 0;
+  }
+
+  int64_t size() const { return size_; }
+
+  // The local id of key, a new one if key was not in the table.
+  int32_t Insert(T key, bool* inserted) {
+    if (2 * (size_ + 1) > static_cast<int64_t>(ids_.size())) Grow();
+    uint64_t s = HashUniqueMix(static_cast<uint64_t>(key)) & mask_;
+    while (ids_[s] != -1) {
+      if (keys_[s] == key) {
+        *inserted = false;
+        return ids_[s];
+      }
+      s = (s + 1) & mask_;
+    }
+    keys_[s] = key;
+    ids_[s] = static_cast<int32_t>(size_++);
+    *inserted = true;
+    return ids_[s];
+  }
+
+ private:
+  void Grow() {
+    std::vector<T> old_keys;
+    std::vector<int32_t> old_ids;
+    old_keys.swap(keys_);
+    old_ids.swap(ids_);
+    keys_.resize(2 * old_ids.size());
+    ids_.assign(2 * old_ids.size(), -1);
+    mask_ = ids_.size() - 1;
+    for (size_t i = 0; i < old_ids.size(); ++i) {
+      if (old_ids[i] == -1) continue;
+      uint64_t s = HashUniqueMix(static_cast<uint64_t>(old_keys[i])) & mask_;
+      while (ids_[s] != -1) s = (s + 1) & mask_;
+      keys_[s] = old_keys[i];
+      ids_[s] = old_ids[i];
+    }
+  }
+
+  std::vector<T> keys_;
+  std::vector<int32_t> ids_;
+  uint64_t mask_ = 0;
+  int64_t size_ = 0;
+};
+
+// Puts unique in ascending order and remaps the other outputs to it.
+template <typename T, typename IndexT>
+void HashUniqueSort(int64_t n,
+                    std::vector<T>* unique,
+                    IndexT* inverse,
+                    std::vector<IndexT>* first_index,
+                    std::vector<IndexT>* counts) {
+  const int64_t num_unique = static_cast<int64_t>(unique->size());
+  std::vector<int64_t> sort_order(num_unique);
+  std::iota(sort_order.begin(), sort_order.end(), 0);
+  std::sort(sort_order.begin(), sort_order.end(), [&](int64_t a, int64_t b) {
+    return (*unique)[a] < (*unique)[b];
+  });
+  std::vector<IndexT> new_rank(num_unique);
+  std::vector<T> sorted_unique(num_unique);
+  for (int64_t r = 0; r < num_unique; ++r) {
+    new_rank[sort_order[r]] = static_cast<IndexT>(r);
+    sorted_unique[r] = (*unique)[sort_order[r]];
+  }
+  unique->swap(sorted_unique);
+  auto permute = [&](std::vector<IndexT>* values) {
+    std::vector<IndexT> permuted(num_unique);
+    for (int64_t r = 0; r < num_unique; ++r) {
+      permuted[r] = (*values)[sort_order[r]];
+    }
+    values->swap(permuted);
+  };
+  if (first_index) permute(first_index);
+  if (counts) permute(counts);
+  if (inverse) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t i = 0; i < n; ++i) {
+      inverse[i] = new_rank[inverse[i]];
+    }
+  }
+}
+
+// A single table over keys in input order, ids come out in first
+// occurrence order. Gives up, returning false, once there are more than
+// kHashUniqueDirectLimit unique keys.
+template <typename T, typename IndexT>
+bool HashUniqueDirect(const T* keys,
+                      int64_t n,
+                      std::vector<T>* unique,
+                      IndexT* inverse,
+                      std::vector<IndexT>* first_index,
+                      std::vector<IndexT>* counts) {
+  thread_local HashUniqueTable<T> table;
+  table.Reset(kHashUniqueInitSlots);
+  for (int64_t i = 0; i < n; ++i) {
+    bool inserted;
+    const int32_t uid = table.Insert(keys[i], &inserted);
+    if (inserted) {
+      if (table.size() > kHashUniqueDirectLimit) {
+        unique->clear();
+        if (first_index) first_index->clear();
+        if (counts) counts->clear();
+        return false;
+      }
+      unique->push_back(keys[i]);
+      if (first_index) first_index->push_back(static_cast<IndexT>(i));
+      if (counts) counts->push_back(0);
+    }
+    if (inverse) inverse[i] = static_cast<IndexT>(uid);
+    if (counts) ++(*counts)[uid];
+  }
+  return true;
+}
+
+/*
+ * \brief Unique keys of keys[0, n) and, optionally, the inverse index,
+ *        the first occurrence and the count of each unique key.
+ *
+ * Few unique keys are found in one pass over a single open-addressing
+ * table. Otherwise the keys are radix-partitioned by hash into partitions
+ * of about kHashUniquePartitionSize keys, each partition is deduplicated
+ * on its own, and the partitions run in parallel.
+ *
+ * inverse, if not null, has n entries and gets the position in unique of
+ * every key; first_index and counts, if not null, get one entry per unique
+ * key.
+ */
+template <typename T, typename IndexT>
+void HashUniqueCPU(const T* keys,
+                   int64_t n,
+                   HashUniqueOrder order,
+                   std::vector<T>* unique,
+                   IndexT* inverse,
+                   std::vector<IndexT>* first_index,
+                   std::vector<IndexT>* counts) {
+  static_assert(std::is_integral<T>::value,
+                "HashUniqueCPU compares keys by their bits, T must be an "
+                "integral type.");
+  unique->clear();
+  if (first_index) first_index->clear();
+  if (counts) counts->clear();
+  if (n == 0) return;
+  if (HashUniqueDirect(keys, n, unique, inverse, first_index, counts)) {
+    if (order == HashUniqueOrder::kSorted) {
+      HashUniqueSort(n, unique, inverse, first_index, counts);
+    }
+    return;
+  }
+
+  int bits = 0;
+  while (bits < kHashUniqueMaxPartitionBits &&
+         (n >> bits) > kHashUniquePartitionSize) {
+    ++bits;
+  }
+  const int64_t parts = int64_t{1} << bits;
+  const int shift = 64 - bits;
+  auto part_of = [&](T key) -> int64_t {
+    return bits == 0 ? 0
+                     : static_cast<int64_t>(
+                           HashUniqueMix(static_cast<uint64_t>(key)) >> shift);
+  };
+  const bool need_pos =
+      first_index != nullptr || order == HashUniqueOrder::kFirstOccurrence;
+
+  // scatter the keys (and their positions) partition by partition, keeping
+  // the input order within a partition
+  const int64_t chunks = (n + kHashUniqueChunk - 1) / kHashUniqueChunk;
+  std::vector<int64_t> offsets(chunks * parts, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t c = 0; c < chunks; ++c) {
+    int64_t* hist = offsets.data() + c * parts;
+    const int64_t end = std::min(n, (c + 1) * kHashUniqueChunk);
+    for (int64_t i = c * kHashUniqueChunk; i < end; ++i) {
+      ++hist[part_of(keys[i])];
+    }
+  }
+  std::vector<int64_t> part_begin(parts + 1, 0);
+  int64_t running = 0;
+  for (int64_t p = 0; p < parts; ++p) {
+    part_begin[p] = running;
+    for (int64_t c = 0; c < chunks; ++c) {
+      const int64_t size = offsets[c * parts + p];
+      offsets[c * parts + p] = running;
+      running += size;
+    }
+  }
+  part_begin[parts] = n;
+  // every entry of these is written before it is read
+  std::unique_ptr<T[]> part_keys(new T[n]);
+  std::unique_ptr<int64_t[]> part_pos(need_pos ? new int64_t[n] : nullptr);
+  std::vector<int64_t> cursors(offsets);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t c = 0; c < chunks; ++c) {
+    int64_t* next = cursors.data() + c * parts;
+    const int64_t end = std::min(n, (c + 1) * kHashUniqueChunk);
+    for (int64_t i = c * kHashUniqueChunk; i < end; ++i) {
+      const int64_t dst = next[part_of(keys[i])]++;
+      part_keys[dst] = keys[i];
+      if (need_pos) part_pos[dst] = i;
+    }
+  }
+
+  // deduplicate each partition: entry_uid is the local unique id of every
+  // entry, part_uniques the entry of each local unique's first occurrence
+  std::unique_ptr<int32_t[]> entry_uid(new int32_t[n]);
+  std::vector<std::vector<int32_t>> part_uniques(parts);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t p = 0; p < parts; ++p) {
+    const int64_t begin = part_begin[p];
+    const int64_t size = part_begin[p + 1] - begin;
+    thread_local HashUniqueTable<T> table;
+    table.Reset(kHashUniqueInitSlots);
+    auto& uniques = part_uniques[p];
+    for (int64_t j = 0; j < size; ++j) {
+      bool inserted;
+      entry_uid[begin + j] = table.Insert(part_keys[begin + j], &inserted);
+      if (inserted) uniques.push_back(static_cast<int32_t>(j));
+    }
+  }
+
+  // global ids: partition after partition, or by first occurrence
+  std::vector<int64_t> part_base(parts + 1, 0);
+  for (int64_t p = 0; p < parts; ++p) {
+    part_base[p + 1] = part_base[p] + part_uniques[p].size();
+  }
+  const int64_t num_unique = part_base[parts];
+  std::vector<int64_t> global_uid(num_unique);
+  if (order == HashUniqueOrder::kFirstOccurrence) {
+    // the rank of position i is the count of first occurrences before it,
+    // a prefix count per cache line of is_first plus a count in the line
+    constexpr int64_t kLine = 64;
+    std::vector<uint8_t> is_first(n, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t p = 0; p < parts; ++p) {
+      for (int32_t j : part_uniques[p]) {
+        is_first[part_pos[part_begin[p] + j]] = 1;
+      }
+    }
+    const int64_t lines = (n + kLine - 1) / kLine;
+    std::vector<int64_t> line_rank(lines + 1, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t l = 0; l < lines; ++l) {
+      const int64_t end = std::min(n, (l + 1) * kLine);
+      int64_t count = 0;
+      for (int64_t i = l * kLine; i < end; ++i) {
+        count += is_first[i];
+      }
+      line_rank[l + 1] = count;
+    }
+    std::partial_sum(line_rank.begin(), line_rank.end(), line_rank.begin());
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t p = 0; p < parts; ++p) {
+      const auto& uniques = part_uniques[p];
+      for (size_t u = 0; u < uniques.size(); ++u) {
+        const int64_t pos = part_pos[part_begin[p] + uniques[u]];
+        int64_t rank = line_rank[pos / kLine];
+        for (int64_t i = pos / kLine * kLine; i < pos; ++i) {
+          rank += is_first[i];
+        }
+        global_uid[part_base[p] + u] = rank;
+      }
+    }
+  } else {
+    std::iota(global_uid.begin(), global_uid.end(), 0);
+  }
+
+  unique->resize(num_unique);
+  if (first_index) first_index->resize(num_unique);
+  if (counts) counts->assign(num_unique, 0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t p = 0; p < parts; ++p) {
+    const int64_t begin = part_begin[p];
+    const auto& uniques = part_uniques[p];
+    const int64_t* gid = global_uid.data() + part_base[p];
+    for (size_t u = 0; u < uniques.size(); ++u) {
+      (*unique)[gid[u]] = part_keys[begin + uniques[u]];
+      if (first_index) {
+        (*first_index)[gid[u]] =
+            static_cast<IndexT>(part_pos[begin + uniques[u]]);
+      }
+    }
+    if (counts) {
+      const int64_t end = part_begin[p + 1];
+      for (int64_t j = begin; j < end; ++j) {
+        ++(*counts)[gid[entry_uid[j]]];
+      }
+    }
+  }
+
+  // back to input order, reading each partition's run of a chunk in
+  // sequence the way the scatter wrote it
+  if (inverse) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t c = 0; c < chunks; ++c) {
+      int64_t* next = offsets.data() + c * parts;
+      const int64_t end = std::min(n, (c + 1) * kHashUniqueChunk);
+      for (int64_t i = c * kHashUniqueChunk; i < end; ++i) {
+        const int64_t p = part_of(keys[i]);
+        inverse[i] = static_cast<IndexT>(
+            global_uid[part_base[p] + entry_uid[next[p]++]]);
+      }
+    }
+  }
+
+  if (order == HashUniqueOrder::kSorted) {
+    HashUniqueSort(n, unique, inverse, first_index, counts);
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
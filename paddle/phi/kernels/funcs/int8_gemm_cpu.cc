@@ -0,0 +1,164 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/funcs/int8_gemm_cpu.h"
+
+#include <algorithm>
+
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/core/enforce.h"
+
+namespace phi {
+namespace funcs {
+
+namespace {
+
+constexpr int kPanelWidth = 16;
+constexpr int kRowBlock = 4;
+// the panels a task runs through for its rows, 128 columns of weights
+constexpr int kPanelBlock = 8;
+
+void Int8GemmPanelRef(int m,
+                      const int8_t* a,
+                      int lda,
+                      const int8_t* b_panel,
+                      int panels,
+                      int k_pad,
+                      const int32_t* comp,
+                      int32_t* c,
+                      int ldc) {
+  for (int p = 0; p < panels; ++p) {
+    const int8_t* b = b_panel + static_cast<size_t>(p) * k_pad * kPanelWidth;
+    for (int i = 0; i < m; ++i) {
+      int32_t acc[kPanelWidth] = {0};
+      const int8_t* a_row = a + static_cast<size_t>(i) * lda;
+      for (int k = 0; k < k_pad; k += 4) {
+        const int8_t* b_group = b + static_cast<size_t>(k) * kPanelWidth;
+        for (int j = 0; j < kPanelWidth; ++j) {
+          for (int kk = 0; kk < 4; ++kk) {
+            acc[j] += static_cast<int32_t>(a_row[k + kk]) *
+                      static_cast<int32_t>(b_group[j * 4 + kk]);
+          }
+        }
+      }
+      for (int j = 0; j < kPanelWidth; ++j) {
+        c[static_cast<size_t>(i) * ldc + p * kPanelWidth + j] = acc[j];
+      }
+    }
+  }
+}
+
+detail::Int8GemmPanelFunc PanelFunc(Int8GemmIsa isa) {
+  detail::Int8GemmPanelFunc func = nullptr;
+  switch (isa) {
+    case Int8GemmIsa::kAvx512Vnni:
+      func = detail::Int8GemmPanelAvx512Vnni();
+      break;
+    case Int8GemmIsa::kAvx2:
+      func = detail::Int8GemmPanelAvx2();
+      break;
+    case Int8GemmIsa::kRef:
+      func = Int8GemmPanelRef;
+      break;
+  }
+  PADDLE_ENFORCE_NOT_NULL(
+      func,
+      phi::errors::Unavailable(
+          "The int8 gemm micro-kernel %d is not built in.",
+          static_cast<int>(isa)));
+  return func;
+}
+
+}  // namespace
+
+Int8GemmIsa Int8GemmBestIsa() {
+  static const Int8GemmIsa isa = [] {
+    using phi::backends::cpu::MayIUse;
+    if (detail::Int8GemmPanelAvx512Vnni() != nullptr &&
+        MayIUse(phi::backends::cpu::avx512_core_vnni)) {
+      return Int8GemmIsa::kAvx512Vnni;
+    }
+    if (detail::Int8GemmPanelAvx2() != nullptr &&
+        MayIUse(phi::backends::cpu::avx2)) {
+      return Int8GemmIsa::kAvx2;
+    }
+    return Int8GemmIsa::kRef;
+  }();
+  return isa;
+}
+
+void PackInt8GemmB(
+    const int8_t* b, int k, int n, int ldb, Int8GemmPackedB* packed) {
+  packed->k = k;
+  packed->n = n;
+  packed->k_pad = (k + 3) / 4 * 4;
+  packed->n_pad = (n + kPanelWidth - 1) / kPanelWidth * kPanelWidth;
+  packed->data.assign(static_cast<size_t>(packed->k_pad) * packed->n_pad, 0);
+  packed->comp.assign(packed->n_pad, 0);
+  packed->has_int8_min = false;
+  for (int kk = 0; kk < k; ++kk) {
+    for (int j = 0; j < n; ++j) {
+      const int8_t value = b[static_cast<size_t>(kk) * ldb + j];
+      const size_t panel = j / kPanelWidth;
+      packed->data[panel * packed->k_pad * kPanelWidth +
+                   static_cast<size_t>(kk / 4) * kPanelWidth * 4 +
+                   (j % kPanelWidth) * 4 + kk % 4] = value;
+      packed->comp[j] += 128 * static_cast<int32_t>(value);
+      packed->has_int8_min |= value == INT8_MIN;
+    }
+  }
+}
+
+void Int8GemmCPU(int m,
+                 const int8_t* a,
+                 int lda,
+                 const Int8GemmPackedB& packed,
+                 int32_t* c,
+                 int ldc,
+                 Int8GemmIsa isa) {
+  PADDLE_ENFORCE_GE(
+      ldc,
+      packed.n_pad,
+      phi::errors::InvalidArgument(
+          "The row stride of the int8 gemm output (%d) should be at least "
+          "the padded column number %d.",
+          ldc,
+          packed.n_pad));
+  auto func = PanelFunc(isa);
+  const int row_blocks = (m + kRowBlock - 1) / kRowBlock;
+  const int panels = packed.n_pad / kPanelWidth;
+  const int panel_blocks = (panels + kPanelBlock - 1) / kPanelBlock;
+  const size_t panel_size = static_cast<size_t>(packed.k_pad) * kPanelWidth;
+  // consecutive tasks share a block of weights, which stays in cache
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(static)
+#endif
+  for (int task = 0; task < row_blocks * panel_blocks; ++task) {
+    const int row = task % row_blocks * kRowBlock;
+    const int rows = std::min(kRowBlock, m - row);
+    const int panel_begin = task / row_blocks * kPanelBlock;
+    func(rows,
+         a + static_cast<size_t>(row) * lda,
+         lda,
+         packed.data.data() + panel_begin * panel_size,
+         std::min(kPanelBlock, panels - panel_begin),
+         packed.k_pad,
+         packed.comp.data() + panel_begin * kPanelWidth,
+         c + static_cast<size_t>(row) * ldc + panel_begin * kPanelWidth,
+         ldc);
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
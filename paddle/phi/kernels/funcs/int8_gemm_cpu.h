@@ -0,0 +1,94 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace phi {
+namespace funcs {
+
+/*
+ * \brief An int8 x int8 -> int32 GEMM for CPU inference without oneDNN.
+ *
+ * The weights are packed once into panels of 16 columns, each a run of
+ * 16 x 4 byte groups: the 4 consecutive k of a column sit together, the
+ * operand layout of vpdpbusd and pmaddubsw. K is padded to a multiple of
+ * 4 and N to a multiple of 16 with zeros.
+ *
+ * Micro-kernels, picked at run time:
+ * kAvx512Vnni: vpdpbusd. It takes unsigned activations, so a row is
+ *   offset by 128 on the fly and 128 x the column sums of the weights are
+ *   taken off the result.
+ * kAvx2: pmaddubsw on |a| and the weights with the sign of a, which stays
+ *   below the int16 saturation (2 x 127 x 127) when neither operand is
+ *   -128, then pmaddwd into int32.
+ * kRef: plain loops.
+ */
+enum class Int8GemmIsa { kRef = 0, kAvx2, kAvx512Vnni };
+
+struct Int8GemmPackedB {
+  int k{0};
+  int n{0};
+  // k rounded up to 4, n rounded up to 16
+  int k_pad{0};
+  int n_pad{0};
+  std::vector<int8_t> data;
+  // 128 x the column sums, for the vnni offset
+  std::vector<int32_t> comp;
+  // a weight of -128, which kAvx2 cannot take
+  bool has_int8_min{false};
+};
+
+// The best micro-kernel compiled in and supported by this cpu.
+Int8GemmIsa Int8GemmBestIsa();
+
+// b is [k, n] with row stride ldb.
+void PackInt8GemmB(
+    const int8_t* b, int k, int n, int ldb, Int8GemmPackedB* packed);
+
+// c[m, packed.n_pad] = a[m, packed.k_pad] x b, row strides lda and ldc. The
+// activations are padded with zeros to k_pad, and must be in [-127, 127]
+// for kAvx2. Rows and column blocks are spread over the omp threads.
+void Int8GemmCPU(int m,
+                 const int8_t* a,
+                 int lda,
+                 const Int8GemmPackedB& packed,
+                 int32_t* c,
+                 int ldc,
+                 Int8GemmIsa isa = Int8GemmBestIsa());
+
+namespace detail {
+
+// `panels` consecutive panels of 16 columns for rows [0, m), m <= 4, c with
+// row stride ldc
+using Int8GemmPanelFunc = void (*)(int m,
+                                   const int8_t* a,
+                                   int lda,
+                                   const int8_t* b_panel,
+                                   int panels,
+                                   int k_pad,
+                                   const int32_t* comp,
+                                   int32_t* c,
+                                   int ldc);
+
+// nullptr when the file was built without the instruction set
+Int8GemmPanelFunc Int8GemmPanelAvx2();
+Int8GemmPanelFunc Int8GemmPanelAvx512Vnni();
+
+}  // namespace detail
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,113 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Built with the AVX2 flag, called only after the cpu check.
+
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "paddle/phi/kernels/funcs/int8_gemm_cpu.h"
+
+namespace phi {
+namespace funcs {
+namespace detail {
+
+#ifdef __AVX2__
+
+namespace {
+
+// M rows x 16 columns in 8 accumulators, two ymm per row
+template <int M>
+void PanelAvx2(const int8_t* a,
+               int lda,
+               const int8_t* b,
+               int k_pad,
+               int32_t* c,
+               int ldc) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i acc[M][2];
+  for (int i = 0; i < M; ++i) {
+    acc[i][0] = _mm256_setzero_si256();
+    acc[i][1] = _mm256_setzero_si256();
+  }
+  for (int k = 0; k < k_pad; k += 4) {
+    const __m256i b0 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + k * 16));
+    const __m256i b1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + k * 16 + 32));
+    for (int i = 0; i < M; ++i) {
+      int32_t a4;
+      std::memcpy(&a4, a + static_cast<size_t>(i) * lda + k, sizeof(a4));
+      const __m256i av = _mm256_set1_epi32(a4);
+      const __m256i a_abs = _mm256_abs_epi8(av);
+      const __m256i p0 =
+          _mm256_maddubs_epi16(a_abs, _mm256_sign_epi8(b0, av));
+      const __m256i p1 =
+          _mm256_maddubs_epi16(a_abs, _mm256_sign_epi8(b1, av));
+      acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(p0, ones));
+      acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(p1, ones));
+    }
+  }
+  for (int i = 0; i < M; ++i) {
+    int32_t* c_row = c + static_cast<size_t>(i) * ldc;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c_row), acc[i][0]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c_row + 8), acc[i][1]);
+  }
+}
+
+void Int8GemmPanelAvx2Impl(int m,
+                           const int8_t* a,
+                           int lda,
+                           const int8_t* b_panel,
+                           int panels,
+                           int k_pad,
+                           const int32_t* comp,
+                           int32_t* c,
+                           int ldc) {
+  for (int p = 0; p < panels; ++p) {
+    const int8_t* b = b_panel + static_cast<size_t>(p) * k_pad * 16;
+    int32_t* c_panel = c + p * 16;
+    switch (m) {
+      case 4:
+        PanelAvx2<4>(a, lda, b, k_pad, c_panel, ldc);
+        break;
+      case 3:
+        PanelAvx2<3>(a, lda, b, k_pad, c_panel, ldc);
+        break;
+      case 2:
+        PanelAvx2<2>(a, lda, b, k_pad, c_panel, ldc);
+        break;
+      default:
+        PanelAvx2<1>(a, lda, b, k_pad, c_panel, ldc);
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+Int8GemmPanelFunc Int8GemmPanelAvx2() { return Int8GemmPanelAvx2Impl; }
+
+#else
+
+Int8GemmPanelFunc Int8GemmPanelAvx2() { return nullptr; }
+
+#endif
+
+}  // namespace detail
+}  // namespace funcs
+}  // namespace phi
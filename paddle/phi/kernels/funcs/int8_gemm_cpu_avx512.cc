@@ -0,0 +1,143 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Built with the AVX512 VNNI flags, called only after the cpu check.
+
+#include <cstring>
+
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+#include "paddle/phi/kernels/funcs/int8_gemm_cpu.h"
+
+namespace phi {
+namespace funcs {
+namespace detail {
+
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+
+namespace {
+
+// M rows x P panels, one zmm accumulator each. vpdpbusd has a latency of
+// several cycles, two panels keep up to 8 of them in flight.
+template <int M, int P>
+void PanelVnni(const int8_t* a,
+               int lda,
+               const int8_t* b,
+               int k_pad,
+               const int32_t* comp,
+               int32_t* c,
+               int ldc) {
+  const size_t panel_size = static_cast<size_t>(k_pad) * 16;
+  // a + 128 as unsigned, the same bits as a ^ 0x80
+  const __m512i offset = _mm512_set1_epi8(static_cast<char>(0x80));
+  __m512i acc[M][P];
+  for (int i = 0; i < M; ++i) {
+    for (int p = 0; p < P; ++p) acc[i][p] = _mm512_setzero_si512();
+  }
+  for (int k = 0; k < k_pad; k += 4) {
+    __m512i bv[P];
+    for (int p = 0; p < P; ++p) {
+      bv[p] = _mm512_loadu_si512(b + p * panel_size + k * 16);
+    }
+    for (int i = 0; i < M; ++i) {
+      int32_t a4;
+      std::memcpy(&a4, a + static_cast<size_t>(i) * lda + k, sizeof(a4));
+      const __m512i av = _mm512_xor_si512(_mm512_set1_epi32(a4), offset);
+      for (int p = 0; p < P; ++p) {
+        acc[i][p] = _mm512_dpbusd_epi32(acc[i][p], av, bv[p]);
+      }
+    }
+  }
+  for (int p = 0; p < P; ++p) {
+    const __m512i cv = _mm512_loadu_si512(comp + p * 16);
+    for (int i = 0; i < M; ++i) {
+      _mm512_storeu_si512(c + static_cast<size_t>(i) * ldc + p * 16,
+                          _mm512_sub_epi32(acc[i][p], cv));
+    }
+  }
+}
+
+template <int P>
+void PanelVnniRows(int m,
+                   const int8_t* a,
+                   int lda,
+                   const int8_t* b,
+                   int k_pad,
+                   const int32_t* comp,
+                   int32_t* c,
+                   int ldc) {
+  switch (m) {
+    case 4:
+      PanelVnni<4, P>(a, lda, b, k_pad, comp, c, ldc);
+      break;
+    case 3:
+      PanelVnni<3, P>(a, lda, b, k_pad, comp, c, ldc);
+      break;
+    case 2:
+      PanelVnni<2, P>(a, lda, b, k_pad, comp, c, ldc);
+      break;
+    default:
+      PanelVnni<1, P>(a, lda, b, k_pad, comp, c, ldc);
+      break;
+  }
+}
+
+void Int8GemmPanelVnniImpl(int m,
+                           const int8_t* a,
+                           int lda,
+                           const int8_t* b_panel,
+                           int panels,
+                           int k_pad,
+                           const int32_t* comp,
+                           int32_t* c,
+                           int ldc) {
+  const size_t panel_size = static_cast<size_t>(k_pad) * 16;
+  int p = 0;
+  for (; p + 2 <= panels; p += 2) {
+    PanelVnniRows<2>(m,
+                     a,
+                     lda,
+                     b_panel + p * panel_size,
+                     k_pad,
+                     comp + p * 16,
+                     c + p * 16,
+                     ldc);
+  }
+  if (p < panels) {
+    PanelVnniRows<1>(m,
+                     a,
+                     lda,
+                     b_panel + p * panel_size,
+                     k_pad,
+                     comp + p * 16,
+                     c + p * 16,
+                     ldc);
+  }
+}
+
+}  // namespace
+
+Int8GemmPanelFunc Int8GemmPanelAvx512Vnni() { return Int8GemmPanelVnniImpl; }
+
+#else
+
+Int8GemmPanelFunc Int8GemmPanelAvx512Vnni() { return nullptr; }
+
+#endif
+
+}  // namespace detail
+}  // namespace funcs
+}  // namespace phi
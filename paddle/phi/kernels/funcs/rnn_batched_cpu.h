@@ -0,0 +1,311 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace phi {
+namespace funcs {
+
+enum class RnnBatchedCell { kLSTM = 0, kGRU };
+
+inline int RnnBatchedGateNum(RnnBatchedCell cell) {
+  return cell == RnnBatchedCell::kLSTM ? 4 : 3;
+}
+
+// The weights of one direction of one layer, transposed so the gates of a
+// row come out of a row-major GEMM next to each other.
+//
+// LSTM gates are stored as {c~, i, f, o}, the layout the jit LSTMCtHt
+// kernel works on, while the rnn op holds them as {i, f, c~, o}. GRU gates
+// keep the rnn op order {r, z, c~}.
+template <typename T>
+struct RnnBatchedWeights {
+  // [input_size, gates * hidden]
+  std::vector<T> w_ih;
+  // [hidden, gates * hidden]
+  std::vector<T> w_hh;
+  // bias_ih + bias_hh, but GRU's candidate only gets bias_ih here: its
+  // bias_hh is applied before the reset gate, see bias_hc
+  std::vector<T> bias;
+  // GRU only, bias_hh of the candidate gate
+  std::vector<T> bias_hc;
+};
+
+// The source gate of destination gate g.
+inline int RnnBatchedSrcGate(RnnBatchedCell cell, int g) {
+  if (cell == RnnBatchedCell::kLSTM) {
+    static const int kLSTMSrc[4] = {2, 0, 1, 3};
+    return kLSTMSrc[g];
+  }
+  return g;
+}
+
+/*
+ * \brief Packs the rnn op weights of one direction of a layer,
+ *        w_ih [gates * hidden, input_size], w_hh [gates * hidden, hidden],
+ *        b_ih and b_hh [gates * hidden].
+ */
+template <typename T>
+void PackRnnBatchedWeights(RnnBatchedCell cell,
+                           const T* w_ih,
+                           const T* w_hh,
+                           const T* b_ih,
+                           const T* b_hh,
+                           int64_t input_size,
+                           int64_t hidden,
+                           RnnBatchedWeights<T>* packed) {
+  const int gates = RnnBatchedGateNum(cell);
+  const int64_t width = gates * hidden;
+  packed->w_ih.resize(input_size * width);
+  packed->w_hh.resize(hidden * width);
+  packed->bias.resize(width);
+  packed->bias_hc.clear();
+  for (int g = 0; g < gates; ++g) {
+    const int64_t src = RnnBatchedSrcGate(cell, g) * hidden;
+    const int64_t dst = g * hidden;
+    for (int64_t j = 0; j < hidden; ++j) {
+      for (int64_t k = 0; k < input_size; ++k) {
+        packed->w_ih[k * width + dst + j] = w_ih[(src + j) * input_size + k];
+      }
+      for (int64_t k = 0; k < hidden; ++k) {
+        packed->w_hh[k * width + dst + j] = w_hh[(src + j) * hidden + k];
+      }
+      packed->bias[dst + j] = b_ih[src + j] + b_hh[src + j];
+    }
+  }
+  if (cell == RnnBatchedCell::kGRU) {
+    packed->bias_hc.assign(b_hh + 2 * hidden, b_hh + 3 * hidden);
+    for (int64_t j = 0; j < hidden; ++j) {
+      packed->bias[2 * hidden + j] = b_ih[2 * hidden + j];
+    }
+  }
+}
+
+// Plain loops for what RnnBatchedLayerCPU needs from its Ops, the kernel
+// uses blas and the jit kernels instead.
+template <typename T>
+struct RnnBatchedRefOps {
+  // c[m, n] = a[m, k] * b[k, n] + beta * c, all row-major
+  void Gemm(int64_t m,
+            int64_t n,
+            int64_t k,
+            const T* a,
+            const T* b,
+            T beta,
+            T* c) const {
+    for (int64_t i = 0; i < m; ++i) {
+      T* row = c + i * n;
+      for (int64_t j = 0; j < n; ++j) row[j] *= beta;
+      for (int64_t p = 0; p < k; ++p) {
+        const T v = a[i * k + p];
+        const T* b_row = b + p * n;
+        for (int64_t j = 0; j < n; ++j) row[j] += v * b_row[j];
+      }
+    }
+  }
+
+  void Sigmoid(const T* x, T* y, int64_t n) const {
+    for (int64_t i = 0; i < n; ++i) {
+      y[i] = static_cast<T>(1) / (static_cast<T>(1) + std::exp(-x[i]));
+    }
+  }
+
+  void Tanh(const T* x, T* y, int64_t n) const {
+    for (int64_t i = 0; i < n; ++i) y[i] = std::tanh(x[i]);
+  }
+
+  // gates {c~, i, f, o} of one row, they may be overwritten
+  void LstmStep(int64_t hidden, T* gates, const T* c_prev, T* c, T* h) const {
+    Tanh(gates, gates, hidden);
+    Sigmoid(gates + hidden, gates + hidden, 3 * hidden);
+    for (int64_t j = 0; j < hidden; ++j) {
+      c[j] = gates[j] * gates[hidden + j] + c_prev[j] * gates[2 * hidden + j];
+      h[j] = std::tanh(c[j]) * gates[3 * hidden + j];
+    }
+  }
+};
+
+/*
+ * \brief Inference of one direction of an LSTM or GRU layer over a padded,
+ *        time-major batch x [time_steps, batch, input_size].
+ *
+ * Sequences are sorted by length and laid out step after step, as
+ * LoDTensor2BatchFunctor does, so step s only computes the sequences that
+ * are longer than s, and the input projection of all valid steps is one
+ * GEMM. A reverse layer runs each sequence from its last valid step.
+ *
+ * y gets hidden values at column offset y_offset of rows y_stride wide,
+ * padded steps are left untouched. h0 / c0 are [batch, hidden], as are
+ * h_last / c_last; c0 and c_last are for LSTM only. seq_len may be null
+ * when every sequence is time_steps long.
+ */
+template <typename T, typename Ops>
+void RnnBatchedLayerCPU(const Ops& ops,
+                        RnnBatchedCell cell,
+                        const RnnBatchedWeights<T>& w,
+                        const T* x,
+                        int64_t time_steps,
+                        int64_t batch,
+                        int64_t input_size,
+                        int64_t hidden,
+                        const int* seq_len,
+                        bool reverse,
+                        const T* h0,
+                        const T* c0,
+                        T* y,
+                        int64_t y_stride,
+                        int64_t y_offset,
+                        T* h_last,
+                        T* c_last) {
+  const int gates = RnnBatchedGateNum(cell);
+  const int64_t width = gates * hidden;
+  std::vector<int64_t> lengths(batch, time_steps);
+  if (seq_len) {
+    for (int64_t b = 0; b < batch; ++b) {
+      lengths[b] = std::min<int64_t>(std::max(seq_len[b], 0), time_steps);
+    }
+  }
+  std::vector<int64_t> order(batch);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+    return lengths[a] > lengths[b];
+  });
+  const int64_t max_len = batch > 0 ? lengths[order[0]] : 0;
+
+  // step_begin[s]: the first batched row of step s, the rows of step s are
+  // the step_begin[s + 1] - step_begin[s] longest sequences
+  std::vector<int64_t> step_begin(max_len + 1, 0);
+  int64_t active = batch;
+  for (int64_t s = 0; s < max_len; ++s) {
+    while (active > 0 && lengths[order[active - 1]] <= s) --active;
+    step_begin[s + 1] = step_begin[s] + active;
+  }
+  auto time_of = [&](int64_t r, int64_t s) -> int64_t {
+    return reverse ? lengths[order[r]] - 1 - s : s;
+  };
+
+  // the input projection of every valid step, in batched order
+  const int64_t rows = step_begin[max_len];
+  std::vector<T> batched_x(rows * input_size);
+  std::vector<T> proj(rows * width);
+  for (int64_t s = 0; s < max_len; ++s) {
+    const int64_t n = step_begin[s + 1] - step_begin[s];
+    for (int64_t r = 0; r < n; ++r) {
+      const T* src = x + (time_of(r, s) * batch + order[r]) * input_size;
+      std::memcpy(batched_x.data() + (step_begin[s] + r) * input_size,
+                  src,
+                  input_size * sizeof(T));
+    }
+  }
+  for (int64_t r = 0; r < rows; ++r) {
+    std::memcpy(proj.data() + r * width, w.bias.data(), width * sizeof(T));
+  }
+  if (rows > 0) {
+    ops.Gemm(rows,
+             width,
+             input_size,
+             batched_x.data(),
+             w.w_ih.data(),
+             static_cast<T>(1),
+             proj.data());
+  }
+
+  // states of the sorted sequences, a finished sequence keeps its last
+  std::vector<T> h(batch * hidden), c;
+  for (int64_t r = 0; r < batch; ++r) {
+    std::memcpy(h.data() + r * hidden,
+                h0 + order[r] * hidden,
+                hidden * sizeof(T));
+  }
+  if (cell == RnnBatchedCell::kLSTM) {
+    c.resize(batch * hidden);
+    for (int64_t r = 0; r < batch; ++r) {
+      std::memcpy(c.data() + r * hidden,
+                  c0 + order[r] * hidden,
+                  hidden * sizeof(T));
+    }
+  }
+  std::vector<T> hh;
+  if (cell == RnnBatchedCell::kGRU) hh.resize(batch * width);
+
+  for (int64_t s = 0; s < max_len; ++s) {
+    const int64_t n = step_begin[s + 1] - step_begin[s];
+    T* step_gates = proj.data() + step_begin[s] * width;
+    if (cell == RnnBatchedCell::kLSTM) {
+      ops.Gemm(n,
+               width,
+               hidden,
+               h.data(),
+               w.w_hh.data(),
+               static_cast<T>(1),
+               step_gates);
+      for (int64_t r = 0; r < n; ++r) {
+        T* hr = h.data() + r * hidden;
+        T* cr = c.data() + r * hidden;
+        ops.LstmStep(hidden, step_gates + r * width, cr, cr, hr);
+      }
+    } else {
+      // the candidate needs r * (W_hc * h + b_hc), so the hidden GEMM does
+      // not accumulate into the projection
+      ops.Gemm(n,
+               width,
+               hidden,
+               h.data(),
+               w.w_hh.data(),
+               static_cast<T>(0),
+               hh.data());
+      for (int64_t r = 0; r < n; ++r) {
+        T* g = step_gates + r * width;
+        const T* hg = hh.data() + r * width;
+        T* hr = h.data() + r * hidden;
+        for (int64_t j = 0; j < 2 * hidden; ++j) g[j] += hg[j];
+        ops.Sigmoid(g, g, 2 * hidden);
+        T* cand = g + 2 * hidden;
+        for (int64_t j = 0; j < hidden; ++j) {
+          cand[j] += g[j] * (hg[2 * hidden + j] + w.bias_hc[j]);
+        }
+        ops.Tanh(cand, cand, hidden);
+        const T* z = g + hidden;
+        for (int64_t j = 0; j < hidden; ++j) {
+          hr[j] = z[j] * hr[j] + (static_cast<T>(1) - z[j]) * cand[j];
+        }
+      }
+    }
+    for (int64_t r = 0; r < n; ++r) {
+      T* dst = y + (time_of(r, s) * batch + order[r]) * y_stride + y_offset;
+      std::memcpy(dst, h.data() + r * hidden, hidden * sizeof(T));
+    }
+  }
+
+  for (int64_t r = 0; r < batch; ++r) {
+    std::memcpy(h_last + order[r] * hidden,
+                h.data() + r * hidden,
+                hidden * sizeof(T));
+    if (c_last) {
+      std::memcpy(c_last + order[r] * hidden,
+                  c.data() + r * hidden,
+                  hidden * sizeof(T));
+    }
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -21,6 +21,7 @@ limitations under the License. */
 
 #include "paddle/common/ddim.h"
 #include "paddle/phi/core/mixed_vector.h"
+#include "paddle/phi/kernels/funcs/hash_unique_cpu.h"
 
 #ifdef PADDLE_WITH_XPU
 #include "paddle/phi/backends/xpu/enforce_xpu.h"
@@ -438,13 +439,15 @@ typename std::enable_if<std::is_integral<T>::value>::type elementwise_add_to(
 template <typename T, typename DeviceContext>
 typename std::enable_if<std::is_same<T, phi::dtype::bfloat16>::value>::type
 add_sparse_inputs(const std::vector<const phi::SelectedRows*>& inputs,
-                  const std::unordered_map<int64_t, size_t>& rows_to_id,
+                  const std::vector<int64_t>& row_ids,
                   int64_t input_width,
                   const DeviceContext& context,
                   T* out_data) {
 #ifndef PADDLE_WITH_DNNL
   auto blas = phi::funcs::GetBlas<DeviceContext, T>(context);
 #endif
+  // row_ids holds the output row of every input row, input after input
+  const int64_t* out_ids = row_ids.data();
   for (auto* input : inputs) {
     if (input->rows().empty()) {
       continue;
@@ -457,18 +460,20 @@ add_sparse_inputs(const std::vector<const phi::SelectedRows*>& inputs,
     funcs::OneDNNAXPYHandler<T> axpy_handler(
         input_width, T(1.f), onednn_context.GetEngine());
     for (size_t i = 0; i < input_rows.size(); i++) {
-      size_t out_i = rows_to_id.at(input_rows[i]);
+      size_t out_i = out_ids[i];
       axpy_handler(&input_data[i * input_width],
                    &out_data[out_i * input_width]);
     }
+    out_ids += input_rows.size();
 #else
     for (size_t i = 0; i < input_rows.size(); i++) {
-      size_t out_i = rows_to_id.at(input_rows[i]);
+      size_t out_i = out_ids[i];
       elementwise_add_to<T, DeviceContext>(&blas,
                                            static_cast<size_t>(input_width),
                                            &input_data[i * input_width],
                                            &out_data[out_i * input_width]);
     }
+    out_ids += input_rows.size();
 #endif
   }
 }
@@ -476,12 +481,13 @@ add_sparse_inputs(const std::vector<const phi::SelectedRows*>& inputs,
 template <typename T, typename DeviceContext>
 typename std::enable_if<!std::is_same<T, phi::dtype::bfloat16>::value>::type
 add_sparse_inputs(const std::vector<const phi::SelectedRows*>& inputs,
-                  const std::unordered_map<int64_t, size_t>& rows_to_id,
+                  const std::vector<int64_t>& row_ids,
                   int64_t input_width,
                   const DeviceContext& context,
                   T* out_data) {
   VLOG(4) << "[CPU] add_sparse_inputs <" << typeid(T).name();
   auto blas = phi::funcs::GetBlas<DeviceContext, T>(context);
+  const int64_t* out_ids = row_ids.data();
   for (auto* input : inputs) {
     if (input->rows().empty()) {
       continue;
@@ -490,12 +496,13 @@ add_sparse_inputs(const std::vector<const phi::SelectedRows*>& inputs,
     auto& input_rows = input->rows();
 
     for (size_t i = 0; i < input_rows.size(); i++) {
-      size_t out_i = rows_to_id.at(input_rows[i]);
+      size_t out_i = out_ids[i];
       elementwise_add_to<T, DeviceContext>(&blas,
                                            static_cast<size_t>(input_width),
                                            &input_data[i * input_width],
                                            &out_data[out_i * input_width]);
     }
+    out_ids += input_rows.size();
   }
 }
 
@@ -540,7 +547,7 @@ struct MergeAddImpl {
     auto input_width = has_value_input->value().dims()[1];
     auto input_height = has_value_input->height();
     phi::SelectedRows& out = *output;
-    std::set<int64_t> merged_row_set;
+    std::vector<int64_t> input_rows;
     size_t row_num = 0;
     for (auto* input : inputs) {
       if (input->rows().empty()) {
@@ -556,25 +563,29 @@ struct MergeAddImpl {
           input->height(),
           phi::errors::InvalidArgument("All inputs should have same height."));
       row_num += input->rows().size();
-      merged_row_set.insert(input->rows().begin(), input->rows().end());
-    }
+      input_rows.insert(
+          input_rows.end(), input->rows().begin(), input->rows().end());
+    }
+    // the merged rows ascending, and the merged row of every input row
+    std::vector<int64_t> merge_rows;
+    std::vector<int64_t> row_ids(row_num);
+    HashUniqueCPU<int64_t, int64_t>(input_rows.data(),
+                                    static_cast<int64_t>(row_num),
+                                    HashUniqueOrder::kSorted,
+                                    &merge_rows,
+                                    row_ids.data(),
+                                    nullptr,
+                                    nullptr);
 
     out.set_height(input_height);
     DenseTensor* out_tensor = out.mutable_value();
     out_tensor->Resize(common::make_ddim(
-        {static_cast<int64_t>(merged_row_set.size()), input_width}));
+        {static_cast<int64_t>(merge_rows.size()), input_width}));
     auto* out_data = context.template Alloc<T>(out_tensor);
 
-    if (merged_row_set.size() == row_num && !sorted_result) {
+    if (merge_rows.size() == row_num && !sorted_result) {
       // no duplicated ids, just concat the result together
-      std::vector<int64_t> merge_rows;
-      merge_rows.reserve(row_num);
-      // concat rows
-      for (auto* in : inputs) {
-        merge_rows.insert(
-            merge_rows.end(), in->rows().begin(), in->rows().end());
-      }
-      out.set_rows(merge_rows);
+      out.set_rows(input_rows);
       auto in_place = inputs[0]->place();
       auto out_place = out.place();
       int64_t copied_numel = 0;
@@ -589,25 +600,13 @@ struct MergeAddImpl {
         copied_numel += static_cast<int64_t>(in_numel);
       }
     } else {
-      std::vector<int64_t> merge_rows(merged_row_set.begin(),
-                                      merged_row_set.end());
-
-      if (sorted_result) {
-        std::sort(merge_rows.begin(), merge_rows.end());
-      }
-
       out.set_rows(merge_rows);
 
       phi::funcs::SetConstant<DeviceContext, T> constant_functor;
       constant_functor(context, out.mutable_value(), static_cast<T>(0.f));
 
-      std::unordered_map<int64_t, size_t> rows_to_id;
-      for (size_t i = 0; i < merge_rows.size(); ++i) {
-        rows_to_id[merge_rows[i]] = i;
-      }
-
       add_sparse_inputs<T, DeviceContext>(
-          inputs, rows_to_id, input_width, context, out_data);
+          inputs, row_ids, input_width, context, out_data);
     }
   }
 };
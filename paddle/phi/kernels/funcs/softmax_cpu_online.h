@@ -0,0 +1,324 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace phi {
+namespace funcs {
+
+// exp() arguments are clipped to this, like ValueClip in softmax_impl.h, so
+// the result is never denormal.
+constexpr float kSoftmaxExpClip = -64.0f;
+// Elements per block of the online pass, the running max is updated once a
+// block.
+constexpr int kSoftmaxBlock = 64;
+// Lanes per task of the strided (axis != -1) pass.
+constexpr int64_t kSoftmaxLaneChunk = 512;
+
+template <typename T>
+struct StdExp {
+  T operator()(T x) const { return std::exp(x); }
+};
+
+// exp(x) for x in [-64, 0]: x = n ln2 + r with |r| <= ln2 / 2, exp(r) from
+// its Taylor polynomial of the given degree, 2^n put into the exponent
+// bits. Degree 7 is within about an ulp of std::exp, each degree less
+// loses roughly a decimal digit. Written without branches or libm calls so
+// loops over it vectorize.
+template <int Degree>
+struct PolyExp {
+  float operator()(float x) const {
+    constexpr float kLog2e = 1.44269504088896341f;
+    constexpr float kLn2Hi = 0.693359375f;
+    constexpr float kLn2Lo = -2.12194440e-4f;
+    // adding and removing 1.5 * 2^23 rounds to the nearest integer
+    constexpr float kRound = 12582912.0f;
+    const float n = (x * kLog2e + kRound) - kRound;
+    const float r = (x - n * kLn2Hi) - n * kLn2Lo;
+    const float p = Horner<0>(r);
+    const int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+  }
+
+  // unrolled at compile time, a loop here keeps the callers from
+  // vectorizing below -O3
+  template <int K>
+  static float Horner(float r) {
+    if constexpr (K == Degree) {
+      return kCoef[K];
+    } else {
+      return Horner<K + 1>(r) * r + kCoef[K];
+    }
+  }
+
+  static constexpr float kCoef[8] = {1.0f,
+                                     1.0f,
+                                     1.0f / 2,
+                                     1.0f / 6,
+                                     1.0f / 24,
+                                     1.0f / 120,
+                                     1.0f / 720,
+                                     1.0f / 5040};
+};
+
+// Independent accumulators per block, plain float reductions do not
+// vectorize without them.
+constexpr int kSoftmaxLanes = 16;
+
+// Softmax or log-softmax of one contiguous row in two passes.
+//
+// The first pass reads x once and keeps a running max m and a running sum
+// s of exp(x - m): the max of each block is taken first, s is rescaled by
+// exp(m_old - m_new) when it grows, then the block's exp(x - m) is added
+// to s (and for softmax stored to y). The second pass writes the result:
+// softmax rescales the stored blocks whose m was stale and divides by s,
+// log-softmax writes x - m - log(s).
+template <typename T, typename Exp>
+void OnlineSoftmaxRow(const T* x,
+                      int64_t n,
+                      bool log_softmax,
+                      const Exp& exp_fn,
+                      std::vector<T>* block_max,
+                      T* y) {
+  constexpr int L = kSoftmaxLanes;
+  const T clip = static_cast<T>(kSoftmaxExpClip);
+  const int64_t blocks = (n + kSoftmaxBlock - 1) / kSoftmaxBlock;
+  block_max->resize(blocks);
+  T m = -std::numeric_limits<T>::infinity();
+  T s = 0;
+  T acc[L];
+  for (int64_t b = 0; b < blocks; ++b) {
+    const int64_t begin = b * kSoftmaxBlock;
+    const int64_t end = std::min(n, begin + kSoftmaxBlock);
+    const int64_t body = begin + (end - begin) / L * L;
+
+    std::fill(acc, acc + L, m);
+    for (int64_t j = begin; j < body; j += L) {
+      for (int l = 0; l < L; ++l) {
+        acc[l] = acc[l] < x[j + l] ? x[j + l] : acc[l];
+      }
+    }
+    T bm = *std::max_element(acc, acc + L);
+    for (int64_t j = body; j < end; ++j) {
+      bm = std::max(bm, x[j]);
+    }
+    if (bm > m) {
+      s *= exp_fn(std::max(m - bm, clip));
+      m = bm;
+    }
+    (*block_max)[b] = m;
+    if (m == -std::numeric_limits<T>::infinity()) {
+      // a leading run of -inf, x - m would be nan
+      if (!log_softmax) std::fill(y + begin, y + end, static_cast<T>(0));
+      continue;
+    }
+
+    std::fill(acc, acc + L, static_cast<T>(0));
+    if (log_softmax) {
+      for (int64_t j = begin; j < body; j += L) {
+        for (int l = 0; l < L; ++l) {
+          acc[l] += exp_fn(std::max(x[j + l] - m, clip));
+        }
+      }
+    } else {
+      for (int64_t j = begin; j < body; j += L) {
+        for (int l = 0; l < L; ++l) {
+          const T e = exp_fn(std::max(x[j + l] - m, clip));
+          y[j + l] = e;
+          acc[l] += e;
+        }
+      }
+    }
+    for (int64_t j = body; j < end; ++j) {
+      const T e = exp_fn(std::max(x[j] - m, clip));
+      if (!log_softmax) y[j] = e;
+      acc[0] += e;
+    }
+    for (int l = 0; l < L; ++l) {
+      s += acc[l];
+    }
+  }
+
+  if (log_softmax) {
+    const T log_sum = std::log(s);
+    for (int64_t j = 0; j < n; ++j) {
+      y[j] = std::max(x[j] - m, clip) - log_sum;
+    }
+    return;
+  }
+  const T inv = static_cast<T>(1) / s;
+  for (int64_t b = 0; b < blocks; ++b) {
+    const int64_t begin = b * kSoftmaxBlock;
+    const int64_t end = std::min(n, begin + kSoftmaxBlock);
+    const T scale = (*block_max)[b] == m
+                        ? inv
+                        : exp_fn(std::max((*block_max)[b] - m, clip)) * inv;
+    for (int64_t j = begin; j < end; ++j) {
+      y[j] *= scale;
+    }
+  }
+}
+
+// Softmax or log-softmax along the middle axis of [batch, axis_dim, remain]
+// for remain lanes [lane_begin, lane_end) of one batch. Strided rows are
+// vectorized across lanes instead: a max pass, an exp and sum pass, and a
+// write pass.
+template <typename T, typename Exp>
+void StridedSoftmaxLanes(const T* x,
+                         int axis_dim,
+                         int64_t remain,
+                         int64_t lane_begin,
+                         int64_t lane_end,
+                         bool log_softmax,
+                         const Exp& exp_fn,
+                         std::vector<T>* buffer,
+                         T* y) {
+  const T clip = static_cast<T>(kSoftmaxExpClip);
+  const int64_t lanes = lane_end - lane_begin;
+  buffer->resize(2 * lanes);
+  T* m = buffer->data();
+  T* s = m + lanes;
+  x += lane_begin;
+  y += lane_begin;
+  std::copy(x, x + lanes, m);
+  for (int a = 1; a < axis_dim; ++a) {
+    const T* row = x + a * remain;
+    for (int64_t l = 0; l < lanes; ++l) {
+      m[l] = std::max(m[l], row[l]);
+    }
+  }
+  std::fill(s, s + lanes, static_cast<T>(0));
+  for (int a = 0; a < axis_dim; ++a) {
+    const T* row = x + a * remain;
+    T* out = y + a * remain;
+    if (log_softmax) {
+      for (int64_t l = 0; l < lanes; ++l) {
+        s[l] += exp_fn(std::max(row[l] - m[l], clip));
+      }
+    } else {
+      for (int64_t l = 0; l < lanes; ++l) {
+        const T e = exp_fn(std::max(row[l] - m[l], clip));
+        out[l] = e;
+        s[l] += e;
+      }
+    }
+  }
+  for (int64_t l = 0; l < lanes; ++l) {
+    s[l] = log_softmax ? std::log(s[l]) : static_cast<T>(1) / s[l];
+  }
+  for (int a = 0; a < axis_dim; ++a) {
+    const T* row = x + a * remain;
+    T* out = y + a * remain;
+    if (log_softmax) {
+      for (int64_t l = 0; l < lanes; ++l) {
+        out[l] = std::max(row[l] - m[l], clip) - s[l];
+      }
+    } else {
+      for (int64_t l = 0; l < lanes; ++l) {
+        out[l] *= s[l];
+      }
+    }
+  }
+}
+
+template <typename T, typename Exp>
+void OnlineSoftmaxImpl(const T* x,
+                       int64_t batch,
+                       int axis_dim,
+                       int64_t remain,
+                       bool log_softmax,
+                       const Exp& exp_fn,
+                       T* y) {
+  const int64_t row = axis_dim * remain;
+  if (remain == 1) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t b = 0; b < batch; ++b) {
+      thread_local std::vector<T> block_max;
+      OnlineSoftmaxRow<T>(
+          x + b * row, axis_dim, log_softmax, exp_fn, &block_max, y + b * row);
+    }
+    return;
+  }
+  const int64_t chunks = (remain + kSoftmaxLaneChunk - 1) / kSoftmaxLaneChunk;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t task = 0; task < batch * chunks; ++task) {
+    thread_local std::vector<T> buffer;
+    const int64_t b = task / chunks;
+    const int64_t lane_begin = (task % chunks) * kSoftmaxLaneChunk;
+    StridedSoftmaxLanes<T>(x + b * row,
+                           axis_dim,
+                           remain,
+                           lane_begin,
+                           std::min(remain, lane_begin + kSoftmaxLaneChunk),
+                           log_softmax,
+                           exp_fn,
+                           &buffer,
+                           y + b * row);
+  }
+}
+
+/*
+ * \brief Softmax or log-softmax of x viewed as [batch, axis_dim, remain]
+ *        along axis_dim, on the CPU, rows in parallel.
+ *
+ * exp_degree picks the exp of float inputs: 0 is std::exp, 1 to 7 the
+ * PolyExp of that degree. Doubles always use std::exp.
+ */
+template <typename T>
+void OnlineSoftmaxCPU(const T* x,
+                      int64_t batch,
+                      int axis_dim,
+                      int64_t remain,
+                      bool log_softmax,
+                      int exp_degree,
+                      T* y) {
+  if constexpr (std::is_same<T, float>::value) {
+    switch (std::min(exp_degree, 7)) {
+#define PADDLE_SOFTMAX_POLY_EXP_CASE(degree)                                  \
+  case degree:                                                                \
+    OnlineSoftmaxImpl<T>(                                                     \
+        x, batch, axis_dim, remain, log_softmax, PolyExp<degree>(), y);       \
+    return;
+      PADDLE_SOFTMAX_POLY_EXP_CASE(1)
+      PADDLE_SOFTMAX_POLY_EXP_CASE(2)
+      PADDLE_SOFTMAX_POLY_EXP_CASE(3)
+      PADDLE_SOFTMAX_POLY_EXP_CASE(4)
+      PADDLE_SOFTMAX_POLY_EXP_CASE(5)
+      PADDLE_SOFTMAX_POLY_EXP_CASE(6)
+      PADDLE_SOFTMAX_POLY_EXP_CASE(7)
+#undef PADDLE_SOFTMAX_POLY_EXP_CASE
+      default:
+        break;
+    }
+  }
+  OnlineSoftmaxImpl<T>(
+      x, batch, axis_dim, remain, log_softmax, StdExp<T>(), y);
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,226 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace phi {
+namespace funcs {
+
+// Orders (value, index) pairs for topk and argsort: NaN is the largest
+// value, equal values keep the smaller index first. The index tie-break
+// makes every ordering total, so std::sort is already stable.
+template <typename T, typename Type>
+struct TopKCompare {
+  bool largest;
+
+  bool Better(const T& a, const T& b) const {
+    if (largest) {
+      return (std::isnan(static_cast<double>(a)) &&
+              !std::isnan(static_cast<double>(b))) ||
+             (a > b);
+    }
+    return (!std::isnan(static_cast<double>(a)) &&
+            std::isnan(static_cast<double>(b))) ||
+           (a < b);
+  }
+
+  bool operator()(const std::pair<T, Type>& l,
+                  const std::pair<T, Type>& r) const {
+    if (Better(l.first, r.first)) return true;
+    if (Better(r.first, l.first)) return false;
+    return l.second < r.second;
+  }
+};
+
+// Values are scanned in blocks of this size, a block is skipped when no
+// value in it can enter the heap.
+constexpr int kTopKFilterBlock = 16;
+
+// Heap top-k of a contiguous row, used when k is small against the row.
+// Every value is first tested against the current k-th value with a plain
+// comparison the compiler vectorizes, the exact ordering is only evaluated
+// for the few candidates that pass.
+template <typename T, typename Type>
+void HeapTopK(const T* in,
+              Type n,
+              int k,
+              const TopKCompare<T, Type>& cmp,
+              std::vector<std::pair<T, Type>>* heap) {
+  heap->clear();
+  Type j = 0;
+  for (; j < n && static_cast<int>(heap->size()) < k; ++j) {
+    heap->emplace_back(in[j], j);
+  }
+  // the top of the heap is the worst of the kept values
+  std::make_heap(heap->begin(), heap->end(), cmp);
+  auto offer = [&](Type idx) {
+    std::pair<T, Type> item(in[idx], idx);
+    if (cmp(item, heap->front())) {
+      std::pop_heap(heap->begin(), heap->end(), cmp);
+      heap->back() = item;
+      std::push_heap(heap->begin(), heap->end(), cmp);
+    }
+  };
+  for (; j + kTopKFilterBlock <= n; j += kTopKFilterBlock) {
+    const T threshold = heap->front().first;
+    bool candidate = false;
+    // NaN passes both tests, the exact check below sorts it out
+    if (cmp.largest) {
+      for (int t = 0; t < kTopKFilterBlock; ++t) {
+        candidate |= !(in[j + t] <= threshold);
+      }
+    } else {
+      for (int t = 0; t < kTopKFilterBlock; ++t) {
+        candidate |= !(in[j + t] >= threshold);
+      }
+    }
+    if (candidate) {
+      for (int t = 0; t < kTopKFilterBlock; ++t) {
+        offer(j + t);
+      }
+    }
+  }
+  for (; j < n; ++j) {
+    offer(j);
+  }
+  std::sort_heap(heap->begin(), heap->end(), cmp);
+}
+
+// Top-k of a contiguous row into out[j * out_stride], indices alike.
+template <typename T, typename Type>
+void TopKRow(const T* in,
+             Type n,
+             int k,
+             bool largest,
+             bool sorted,
+             T* out,
+             Type* indices,
+             int64_t out_stride,
+             std::vector<std::pair<T, Type>>* buffer) {
+  if (k <= 0) {
+    return;
+  }
+  TopKCompare<T, Type> cmp{largest};
+  if (static_cast<int64_t>(k) * 16 <= n) {
+    HeapTopK<T, Type>(in, n, k, cmp, buffer);
+  } else {
+    buffer->resize(n);
+    for (Type j = 0; j < n; ++j) {
+      (*buffer)[j] = std::pair<T, Type>(in[j], j);
+    }
+    std::nth_element(
+        buffer->begin(), buffer->begin() + k - 1, buffer->end(), cmp);
+    if (sorted) {
+      std::sort(buffer->begin(), buffer->begin() + k - 1, cmp);
+    }
+  }
+  for (int j = 0; j < k; ++j) {
+    out[j * out_stride] = (*buffer)[j].first;
+    indices[j * out_stride] = (*buffer)[j].second;
+  }
+}
+
+// Runs row_fn(row, out_offset) over the rows of a tensor viewed as
+// [pre, n, post] along its middle axis, in parallel. A row along a non-last
+// axis is gathered with stride post into a contiguous scratch row and the
+// output is written with the same stride, so nothing is transposed.
+template <typename T, typename RowFn>
+void ForEachAxisRow(const T* in,
+                    int64_t pre,
+                    int64_t n,
+                    int64_t post,
+                    int64_t out_n,
+                    const RowFn& row_fn) {
+  const int64_t rows = pre * post;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel
+#endif
+  {
+    std::vector<T> scratch;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp for schedule(static)
+#endif
+    for (int64_t r = 0; r < rows; ++r) {
+      const int64_t p = r / post;
+      const int64_t q = r % post;
+      const T* row = in + p * n * post + q;
+      if (post > 1) {
+        scratch.resize(n);
+        for (int64_t j = 0; j < n; ++j) {
+          scratch[j] = row[j * post];
+        }
+        row = scratch.data();
+      }
+      row_fn(row, p * out_n * post + q);
+    }
+  }
+}
+
+// Top-k along the middle axis of a [pre, n, post] tensor.
+template <typename T, typename Type>
+void StridedTopK(const T* in,
+                 int64_t pre,
+                 int64_t n,
+                 int64_t post,
+                 int k,
+                 bool largest,
+                 bool sorted,
+                 T* out,
+                 Type* indices) {
+  ForEachAxisRow<T>(in, pre, n, post, k, [&](const T* row, int64_t offset) {
+    thread_local std::vector<std::pair<T, Type>> buffer;
+    TopKRow<T, Type>(row,
+                     static_cast<Type>(n),
+                     k,
+                     largest,
+                     sorted,
+                     out + offset,
+                     indices + offset,
+                     post,
+                     &buffer);
+  });
+}
+
+// Full sort along the middle axis of a [pre, n, post] tensor. The index
+// tie-break of TopKCompare keeps equal values in input order, so the
+// result is the stable one either way.
+template <typename T, typename Type>
+void StridedSort(const T* in,
+                 int64_t pre,
+                 int64_t n,
+                 int64_t post,
+                 bool descending,
+                 T* out,
+                 Type* indices) {
+  ForEachAxisRow<T>(in, pre, n, post, n, [&](const T* row, int64_t offset) {
+    thread_local std::vector<std::pair<T, Type>> buffer;
+    buffer.resize(n);
+    for (int64_t j = 0; j < n; ++j) {
+      buffer[j] = std::pair<T, Type>(row[j], static_cast<Type>(j));
+    }
+    std::sort(buffer.begin(), buffer.end(), TopKCompare<T, Type>{descending});
+    for (int64_t j = 0; j < n; ++j) {
+      out[offset + j * post] = buffer[j].first;
+      indices[offset + j * post] = buffer[j].second;
+    }
+  });
+}
+
+}  // namespace funcs
+}  // namespace phi
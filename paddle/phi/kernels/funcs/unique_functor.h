@@ -18,6 +18,7 @@
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/utils/data_type.h"
 #include "paddle/phi/kernels/funcs/concat_and_split_functor.h"
+#include "paddle/phi/kernels/funcs/hash_unique_cpu.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
 namespace phi {
@@ -45,7 +46,6 @@ struct UniqueOpFunctor {
 
     int64_t j = 0;
 
-    // TODO(fangzeyang): Should optimize performance here.
     std::unordered_map<InT, int64_t> dict;
     std::vector<InT> uniq;
 
@@ -57,6 +57,26 @@ struct UniqueOpFunctor {
             "but received num is %d.",
             in_->numel()));
 
+    if constexpr (std::is_integral<InT>::value) {
+      std::vector<IndexT> counts;
+      HashUniqueCPU<InT, IndexT>(in_data,
+                                 in_->numel(),
+                                 HashUniqueOrder::kFirstOccurrence,
+                                 &uniq,
+                                 index_data,
+                                 nullptr,
+                                 count_ != nullptr ? &counts : nullptr);
+      if (count_ != nullptr) {
+        count_->Resize(common::make_ddim({static_cast<int64_t>(uniq.size())}));
+        IndexT* count_data = context_.template Alloc<IndexT>(count_);
+        std::copy(counts.begin(), counts.end(), count_data);
+      }
+      out_->Resize(common::make_ddim({static_cast<int64_t>(uniq.size())}));
+      auto* out_data = context_.template Alloc<InT>(out_);
+      std::memcpy(out_data, uniq.data(), uniq.size() * sizeof(InT));
+      return;
+    }
+
     for (auto i = 0; i < in_->numel(); i++) {
       auto it = dict.find(in_data[i]);
       if (it == dict.end()) {
@@ -140,6 +160,37 @@ static void UniqueFlattendTensor(const Context& context,
                                  bool return_inverse,
                                  bool return_counts) {
   const InT* in_data = in.data<InT>();
+  if constexpr (std::is_integral<InT>::value) {
+    std::vector<InT> unique;
+    std::vector<IndexT> first_index, counts;
+    IndexT* inverse_data = nullptr;
+    if (return_inverse) {
+      index->Resize(common::make_ddim({in.numel()}));
+      inverse_data = context.template Alloc<IndexT>(index);
+    }
+    HashUniqueCPU<InT, IndexT>(in_data,
+                               in.numel(),
+                               HashUniqueOrder::kSorted,
+                               &unique,
+                               inverse_data,
+                               return_index ? &first_index : nullptr,
+                               return_counts ? &counts : nullptr);
+    out->Resize(common::make_ddim({static_cast<int64_t>(unique.size())}));
+    auto* out_data = context.template Alloc<InT>(out);
+    std::copy(unique.begin(), unique.end(), out_data);
+    if (return_index) {
+      indices->Resize(common::make_ddim({out->numel()}));
+      auto indices_data = context.template Alloc<IndexT>(indices);
+      std::copy(first_index.begin(), first_index.end(), indices_data);
+    }
+    if (return_counts) {
+      count->Resize(common::make_ddim({out->numel()}));
+      auto count_data = context.template Alloc<IndexT>(count);
+      std::copy(counts.begin(), counts.end(), count_data);
+    }
+    return;
+  }
+
   std::set<InT> unique(in_data, in_data + in.numel());
   out->Resize(common::make_ddim({static_cast<int64_t>(unique.size())}));
   auto* out_data = context.template Alloc<InT>(out);
@@ -0,0 +1,158 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/embedding_bag_cpu.h"
+#include "paddle/phi/kernels/funcs/embedding_util.h"
+
+namespace phi {
+namespace fusion {
+
+template <typename T, typename IdT>
+void FusedEmbeddingBagCompute(const CPUContext& dev_ctx,
+                              const DenseTensor& ids,
+                              const DenseTensor& weight,
+                              const DenseTensor& offsets,
+                              const float* row_scale,
+                              funcs::EmbeddingBagMode mode,
+                              int64_t padding_idx,
+                              DenseTensor* out) {
+  using AccT = funcs::EmbeddingBagAccType<T>;
+  const int64_t rows = weight.dims()[0];
+  const int64_t dim = weight.dims()[1];
+  const int64_t num_ids = ids.numel();
+  const int64_t bags = offsets.numel() - 1;
+  const IdT* ids_data = ids.data<IdT>();
+  const int64_t* offsets_data = offsets.data<int64_t>();
+
+  PADDLE_ENFORCE_GE(bags,
+                    0,
+                    phi::errors::InvalidArgument(
+                        "Input(offsets) of fused_embedding_bag should hold "
+                        "at least one entry, but got none."));
+  PADDLE_ENFORCE_EQ(
+      offsets_data[0] == 0 && offsets_data[bags] == num_ids,
+      true,
+      phi::errors::InvalidArgument(
+          "Input(offsets) of fused_embedding_bag should start at 0 and end "
+          "at the number of ids %ld, but got [%ld, ..., %ld].",
+          num_ids,
+          offsets_data[0],
+          offsets_data[bags]));
+  for (int64_t b = 0; b < bags; ++b) {
+    PADDLE_ENFORCE_LE(offsets_data[b],
+                      offsets_data[b + 1],
+                      phi::errors::InvalidArgument(
+                          "Input(offsets) of fused_embedding_bag should be "
+                          "non-decreasing, but offsets[%ld] = %ld is greater "
+                          "than offsets[%ld] = %ld.",
+                          b,
+                          offsets_data[b],
+                          b + 1,
+                          offsets_data[b + 1]));
+  }
+  for (int64_t i = 0; i < num_ids; ++i) {
+    const int64_t id = ids_data[i];
+    if (id == padding_idx) continue;
+    PADDLE_ENFORCE_EQ(
+        id >= 0 && id < rows,
+        true,
+        phi::errors::InvalidArgument(
+            "Variable value (ids) of OP(fused_embedding_bag) expected >= 0 "
+            "and < %ld, but got %ld. Please check input value.",
+            rows,
+            id));
+  }
+
+  out->Resize({bags, dim});
+  AccT* out_data = dev_ctx.template Alloc<AccT>(out);
+  funcs::EmbeddingBagCPU<T, IdT>(weight.data<T>(),
+                                 dim,
+                                 row_scale,
+                                 ids_data,
+                                 num_ids,
+                                 offsets_data,
+                                 bags,
+                                 mode,
+                                 padding_idx,
+                                 out_data);
+}
+
+template <typename T, typename Context>
+void FusedEmbeddingBagKernel(const Context& dev_ctx,
+                             const DenseTensor& ids,
+                             const DenseTensor& weight,
+                             const DenseTensor& offsets,
+                             const paddle::optional<DenseTensor>& scale,
+                             const std::string& mode,
+                             int64_t padding_idx,
+                             DenseTensor* out) {
+  funcs::EmbeddingBagMode bag_mode = funcs::EmbeddingBagMode::kSum;
+  if (mode == "MEAN") {
+    bag_mode = funcs::EmbeddingBagMode::kMean;
+  } else if (mode == "MAX") {
+    bag_mode = funcs::EmbeddingBagMode::kMax;
+  } else if (mode != "SUM") {
+    PADDLE_THROW(phi::errors::InvalidArgument(
+        "The mode of fused_embedding_bag should be SUM, MEAN or MAX, but "
+        "got %s.",
+        mode));
+  }
+
+  const float* row_scale = nullptr;
+  if (scale) {
+    PADDLE_ENFORCE_EQ(scale->numel(),
+                      weight.dims()[0],
+                      phi::errors::InvalidArgument(
+                          "Input(scale) of fused_embedding_bag should hold "
+                          "one entry per row of Input(weight) %ld, but got "
+                          "%ld.",
+                          weight.dims()[0],
+                          scale->numel()));
+    row_scale = scale->data<float>();
+  }
+
+  if (ids.dtype() == phi::DataType::INT32) {
+    FusedEmbeddingBagCompute<T, int>(
+        dev_ctx, ids, weight, offsets, row_scale, bag_mode, padding_idx, out);
+  } else if (ids.dtype() == phi::DataType::INT64) {
+    FusedEmbeddingBagCompute<T, int64_t>(
+        dev_ctx, ids, weight, offsets, row_scale, bag_mode, padding_idx, out);
+  } else {
+    PADDLE_THROW(phi::errors::Unimplemented(
+        "fused_embedding_bag ids only support int32 and int64, but got %s.",
+        ids.dtype()));
+  }
+}
+
+}  // namespace fusion
+}  // namespace phi
+
+PD_REGISTER_KERNEL(fused_embedding_bag,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::fusion::FusedEmbeddingBagKernel,
+                   float,
+                   double,
+                   int8_t,
+                   phi::dtype::float16) {
+  if (kernel_key.dtype() == phi::DataType::INT8 ||
+      kernel_key.dtype() == phi::DataType::FLOAT16) {
+    kernel->OutputAt(0).SetDataType(phi::DataType::FLOAT32);
+  }
+}
@@ -14,16 +14,93 @@
 
 #pragma once
 
+#include "paddle/common/flags.h"
 #include "paddle/phi/kernels/conv_kernel.h"
 #include "paddle/phi/kernels/cpu/conv_util.h"
 #include "paddle/phi/kernels/funcs/batch_norm_utils.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/conv_cpu_direct.h"
 #include "paddle/phi/kernels/funcs/im2col.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 #include "paddle/phi/kernels/funcs/vol2col.h"
 
+COMMON_DECLARE_bool(conv_cpu_native_algo);
+
 namespace phi {
 
+template <typename T, typename Context>
+typename std::enable_if<!std::is_same<Context, phi::CPUContext>::value,
+                        bool>::type
+RunNativeCpuConv(const Context& dev_ctx UNUSED,
+                 const DenseTensor& input UNUSED,
+                 const DenseTensor& filter UNUSED,
+                 const std::vector<int>& strides UNUSED,
+                 const std::vector<int>& paddings UNUSED,
+                 const std::vector<int>& dilations UNUSED,
+                 int groups UNUSED,
+                 DenseTensor* output UNUSED) {
+  return false;
+}
+
+// Runs a 2-D NCHW convolution with the Winograd or direct CPU kernel the
+// shape calls for, returns false if it should stay on im2col + GEMM.
+template <typename T, typename Context>
+typename std::enable_if<std::is_same<Context, phi::CPUContext>::value,
+                        bool>::type
+RunNativeCpuConv(const Context& dev_ctx,
+                 const DenseTensor& input,
+                 const DenseTensor& filter,
+                 const std::vector<int>& strides,
+                 const std::vector<int>& paddings,
+                 const std::vector<int>& dilations,
+                 int groups,
+                 DenseTensor* output) {
+  if (!FLAGS_conv_cpu_native_algo || input.dims().size() != 4 ||
+      !(std::is_same<T, float>::value || std::is_same<T, double>::value)) {
+    return false;
+  }
+  const auto& in_dims = input.dims();
+  const auto& filter_dims = filter.dims();
+  const auto& out_dims = output->dims();
+  funcs::Conv2dCpuShape shape;
+  shape.batch = static_cast<int>(in_dims[0]);
+  shape.in_channels = static_cast<int>(in_dims[1]);
+  shape.in_h = static_cast<int>(in_dims[2]);
+  shape.in_w = static_cast<int>(in_dims[3]);
+  shape.out_channels = static_cast<int>(out_dims[1]);
+  shape.out_h = static_cast<int>(out_dims[2]);
+  shape.out_w = static_cast<int>(out_dims[3]);
+  shape.filter_h = static_cast<int>(filter_dims[2]);
+  shape.filter_w = static_cast<int>(filter_dims[3]);
+  shape.stride_h = strides[0];
+  shape.stride_w = strides[1];
+  // paddings are {top, bottom, left, right}
+  shape.pad_top = paddings[0];
+  shape.pad_left = paddings[2];
+  shape.dilation_h = dilations[0];
+  shape.dilation_w = dilations[1];
+  shape.groups = groups;
+
+  const T* in_data = input.data<T>();
+  const T* filter_data = filter.data<T>();
+  T* out_data = output->data<T>();
+  switch (funcs::SelectConvCpuAlgo(shape)) {
+    case funcs::ConvCpuAlgo::kWinogradF23:
+      funcs::WinogradConv2d<T>(
+          dev_ctx, shape, 2, in_data, filter_data, out_data);
+      return true;
+    case funcs::ConvCpuAlgo::kWinogradF43:
+      funcs::WinogradConv2d<T>(
+          dev_ctx, shape, 4, in_data, filter_data, out_data);
+      return true;
+    case funcs::ConvCpuAlgo::kDepthwise:
+      funcs::DepthwiseConv2dDirect<T>(shape, in_data, filter_data, out_data);
+      return true;
+    default:
+      return false;
+  }
+}
+
 template <typename T, typename Context>
 void ConvKernelImpl(const Context& dev_ctx,
                     const DenseTensor& input,
@@ -70,6 +147,20 @@ void ConvKernelImpl(const Context& dev_ctx,
   UpdatePaddingAndDilation(
       &paddings, &dilations, padding_algorithm, in_data_dims, strides, ksize);
 
+  if (RunNativeCpuConv<T>(dev_ctx,
+                          transformed_input,
+                          filter,
+                          strides,
+                          paddings,
+                          dilations,
+                          groups,
+                          &transformed_output)) {
+    if (channel_last) {
+      TransToChannelLast<Context, T>(dev_ctx, &transformed_output, output);
+    }
+    return;
+  }
+
   const int batch_size = static_cast<int>(transformed_input.dims()[0]);
 
   // filter_shape_vec:
@@ -14,7 +14,8 @@ limitations under the License. */
 
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <vector>
 
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -28,9 +29,61 @@ namespace sparse {
 
 using Dims4D = phi::funcs::sparse::Dims4D;
 
+// Open addressing map from a linear coordinate index to a nonnegative
+// value, replaces the std::set lookups in rulebook construction.
+template <typename IntT>
+class SparseCoordHashMap {
+ public:
+  explicit SparseCoordHashMap(int64_t num) {
+    size_t capacity = 16;
+    while (capacity < static_cast<size_t>(num) * 2) {
+      capacity <<= 1;
+    }
+    mask_ = capacity - 1;
+    keys_.assign(capacity, kEmpty);
+    values_.resize(capacity);
+  }
+
+  // Keeps the first value of a duplicated key.
+  void Insert(IntT key, IntT value) {
+    size_t pos = Hash(key);
+    while (keys_[pos] != kEmpty) {
+      if (keys_[pos] == key) {
+        return;
+      }
+      pos = (pos + 1) & mask_;
+    }
+    keys_[pos] = key;
+    values_[pos] = value;
+  }
+
+  // Returns -1 if key is absent.
+  IntT Find(IntT key) const {
+    size_t pos = Hash(key);
+    while (keys_[pos] != kEmpty) {
+      if (keys_[pos] == key) {
+        return values_[pos];
+      }
+      pos = (pos + 1) & mask_;
+    }
+    return -1;
+  }
+
+ private:
+  static constexpr IntT kEmpty = -1;
+
+  size_t Hash(IntT key) const {
+    uint64_t h = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(h >> 32) & mask_;
+  }
+
+  size_t mask_;
+  std::vector<IntT> keys_;
+  std::vector<IntT> values_;
+};
+
 // such as: kernel(3, 3, 3), kernel_size = 27
 // counter_per_weight: (kernel_size)
-// TODO(zhangkaihuo): optimize performance with multithreading
 template <typename T, typename Context, typename IntT = int>
 void ProductRuleBook(const Context& dev_ctx,
                      const SparseCooTensor& x,
@@ -50,8 +103,6 @@ void ProductRuleBook(const Context& dev_ctx,
                          : kernel_sizes[0] * kernel_sizes[1] * kernel_sizes[2];
   memset(counter_per_kernel, 0, kernel_size * sizeof(int));
 
-  int rulebook_len = 0;
-  // calc the rulebook_len
   const auto& x_dims = x.dims();
 
   int xdim0, xdim1, xdim2, xdim3;
@@ -98,9 +149,9 @@ void ProductRuleBook(const Context& dev_ctx,
   const Dims4D c_strides(sdim0, sdim1, sdim2, sdim3);
   const Dims4D c_dilations(ddim0, ddim1, ddim2, ddim3);
 
-  std::set<IntT> hash_in;
+  SparseCoordHashMap<IntT> hash_in(subm ? non_zero_num : 0);
   if (subm) {
-    for (int i = 0; i < non_zero_num; i++) {
+    for (int64_t i = 0; i < non_zero_num; i++) {
       IntT batch = indices_ptr[i];
       IntT in_z = is2D ? 0 : indices_ptr[i + non_zero_num];
       IntT in_y = is2D ? indices_ptr[i + non_zero_num]
@@ -109,79 +160,85 @@ void ProductRuleBook(const Context& dev_ctx,
                        : indices_ptr[i + 3 * non_zero_num];
       IntT index = phi::funcs::sparse::PointToIndex<Dims4D>(
           batch, in_x, in_y, in_z, c_x_dims);
-      hash_in.insert(index);
+      hash_in.Insert(index, static_cast<IntT>(i));
     }
   }
 
-  auto f_calc_rulebook = [&](IntT* rulebook_ptr) {
-    int kernel_index = 0, rulebook_index = 0;
-    int zceil = is2D ? 1 : kernel_sizes[0];
-    int yceil = is2D ? kernel_sizes[0] : kernel_sizes[1];
-    int xceil = is2D ? kernel_sizes[1] : kernel_sizes[2];
-    for (int kz = 0; kz < zceil; kz++) {
-      for (int ky = 0; ky < yceil; ky++) {
-        for (int kx = 0; kx < xceil; kx++) {
-          ++kernel_index;
-          for (int64_t i = 0; i < non_zero_num; i++) {
-            IntT batch = indices_ptr[i];
-            IntT in_z = is2D ? 0 : indices_ptr[i + non_zero_num];
-            IntT in_y = is2D ? indices_ptr[i + non_zero_num]
-                             : indices_ptr[i + 2 * non_zero_num];
-            IntT in_x = is2D ? indices_ptr[i + 2 * non_zero_num]
-                             : indices_ptr[i + 3 * non_zero_num];
-
-            IntT out_z =
-                is2D ? 0
-                     : (in_z + paddings[0] - kz * dilations[0]) / strides[0];
-            IntT out_y =
-                (in_y + c_paddings[2] - ky * c_dilations[2]) / c_strides[2];
-            IntT out_x =
-                (in_x + c_paddings[3] - kx * c_dilations[3]) / c_strides[3];
-            if (phi::funcs::sparse::Check(c_x_dims,
-                                          c_kernel_dims,
-                                          c_paddings,
-                                          c_dilations,
-                                          c_strides,
-                                          in_x,
-                                          in_y,
-                                          in_z,
-                                          kx,
-                                          ky,
-                                          kz)) {
-              if (subm) {
-                IntT out_index = phi::funcs::sparse::PointToIndex<Dims4D>(
-                    batch, out_x, out_y, out_z, c_out_dims);
-                if (hash_in.find(out_index) == hash_in.end()) {
-                  continue;
-                }
-              }
-
-              if (rulebook_ptr == nullptr) {
-                counter_per_kernel[kernel_index - 1] += 1;
-                ++rulebook_len;
-              } else {
-                rulebook_ptr[rulebook_index] = kernel_index - 1;
-                rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
-                rulebook_ptr[rulebook_index + rulebook_len * 2] =
-                    phi::funcs::sparse::PointToIndex<Dims4D>(
-                        batch, out_x, out_y, out_z, c_out_dims);  // out_index
-                ++rulebook_index;
-              }
-            }
-          }
-        }
+  // The kernel offsets are independent, each one collects its (in, out)
+  // pairs in nonzero order, so the rulebook is the same for any thread count.
+  const int yceil = is2D ? kernel_sizes[0] : kernel_sizes[1];
+  const int xceil = is2D ? kernel_sizes[1] : kernel_sizes[2];
+  std::vector<std::vector<IntT>> pairs(kernel_size);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int kernel_index = 0; kernel_index < kernel_size; kernel_index++) {
+    const int kz = kernel_index / (yceil * xceil);
+    const int ky = kernel_index / xceil % yceil;
+    const int kx = kernel_index % xceil;
+    std::vector<IntT>& kernel_pairs = pairs[kernel_index];
+    for (int64_t i = 0; i < non_zero_num; i++) {
+      IntT batch = indices_ptr[i];
+      IntT in_z = is2D ? 0 : indices_ptr[i + non_zero_num];
+      IntT in_y = is2D ? indices_ptr[i + non_zero_num]
+                       : indices_ptr[i + 2 * non_zero_num];
+      IntT in_x = is2D ? indices_ptr[i + 2 * non_zero_num]
+                       : indices_ptr[i + 3 * non_zero_num];
+      if (!phi::funcs::sparse::Check(c_x_dims,
+                                     c_kernel_dims,
+                                     c_paddings,
+                                     c_dilations,
+                                     c_strides,
+                                     in_x,
+                                     in_y,
+                                     in_z,
+                                     kx,
+                                     ky,
+                                     kz)) {
+        continue;
+      }
+      IntT out_z =
+          is2D ? 0 : (in_z + paddings[0] - kz * dilations[0]) / strides[0];
+      IntT out_y = (in_y + c_paddings[2] - ky * c_dilations[2]) / c_strides[2];
+      IntT out_x = (in_x + c_paddings[3] - kx * c_dilations[3]) / c_strides[3];
+      IntT out_index = phi::funcs::sparse::PointToIndex<Dims4D>(
+          batch, out_x, out_y, out_z, c_out_dims);
+      if (subm && hash_in.Find(out_index) < 0) {
+        continue;
       }
+      kernel_pairs.push_back(static_cast<IntT>(i));
+      kernel_pairs.push_back(out_index);
     }
-  };
+    counter_per_kernel[kernel_index] =
+        static_cast<int>(kernel_pairs.size() / 2);
+  }
 
-  f_calc_rulebook(nullptr);
+  int rulebook_len = 0;
+  for (int i = 0; i < kernel_size; i++) {
+    rulebook_len += counter_per_kernel[i];
+  }
   // alloc the rulebook
   *rulebook = phi::Empty(dev_ctx,
                          DenseTensorMeta(phi::CppTypeToDataType<IntT>::Type(),
                                          {3, rulebook_len},
                                          DataLayout::NCHW));
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  f_calc_rulebook(rulebook_ptr);
+  std::vector<int> offsets(kernel_size, 0);
+  for (int i = 1; i < kernel_size; i++) {
+    offsets[i] = offsets[i - 1] + counter_per_kernel[i - 1];
+  }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int kernel_index = 0; kernel_index < kernel_size; kernel_index++) {
+    const std::vector<IntT>& kernel_pairs = pairs[kernel_index];
+    IntT* ptr = rulebook_ptr + offsets[kernel_index];
+    for (int j = 0; j < counter_per_kernel[kernel_index]; j++) {
+      ptr[j] = kernel_index;
+      ptr[j + rulebook_len] = kernel_pairs[2 * j];           // in_i
+      ptr[j + rulebook_len * 2] = kernel_pairs[2 * j + 1];  // out_index
+    }
+  }
 }
 
 template <typename T, typename Context, typename IntT = int>
@@ -194,12 +251,12 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                SparseCooTensor* out) {
   const bool is2D = out_dims.size() == 4 ? true : false;
 
-  std::set<IntT> out_indexs;
   int n = rulebook->dims()[1];
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  for (int i = 0; i < n; i++) {
-    out_indexs.insert(rulebook_ptr[i + n * 2]);
-  }
+  std::vector<IntT> out_indexs(rulebook_ptr + n * 2, rulebook_ptr + n * 3);
+  std::sort(out_indexs.begin(), out_indexs.end());
+  out_indexs.erase(std::unique(out_indexs.begin(), out_indexs.end()),
+                   out_indexs.end());
 
   int out_non_zero_num = out_indexs.size();
   const int64_t sparse_dim = is2D ? 3 : 4;
@@ -220,8 +277,11 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
   odim3 = is2D ? 1 : out_dims[1];
   const Dims4D c_out_dims(odim0, odim1, odim2, odim3);
 
-  for (auto it = out_indexs.begin(); it != out_indexs.end(); it++, i++) {
-    const IntT index = *it;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (i = 0; i < out_non_zero_num; i++) {
+    const IntT index = out_indexs[i];
     IntT batch, x, y, z;
     phi::funcs::sparse::IndexToPoint<Dims4D>(
         index, c_out_dims, &batch, &x, &y, &z);
@@ -235,10 +295,16 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
       out_indices_ptr[i + out_non_zero_num * 3] = x;
     }
   }
+  // out_index -> its rank in out_indexs
+  SparseCoordHashMap<IntT> out_rank(out_non_zero_num);
+  for (i = 0; i < out_non_zero_num; i++) {
+    out_rank.Insert(out_indexs[i], static_cast<IntT>(i));
+  }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
   for (i = 0; i < n; i++) {
-    IntT out_index = rulebook_ptr[i + n * 2];
-    rulebook_ptr[i + n * 2] =
-        std::distance(out_indexs.begin(), out_indexs.find(out_index));
+    rulebook_ptr[i + n * 2] = out_rank.Find(rulebook_ptr[i + n * 2]);
   }
 
   out->SetMember(out_indices, out_values, out_dims, true);
@@ -247,6 +313,9 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
 template <typename T, typename IntT = int>
 void Gather(
     const T* x, const IntT* indexs, const int n, const int channels, T* out) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
   for (int i = 0; i < n; i++) {
     IntT real_i = indexs[i];
     memcpy(out + i * channels, x + real_i * channels, channels * sizeof(T));
@@ -256,12 +325,43 @@ void Gather(
 template <typename T, typename IntT = int>
 void Scatter(
     const T* x, const IntT* indexs, const int n, const int channels, T* out) {
+#ifdef PADDLE_WITH_MKLML
+  // Group the rows by destination so that each destination is summed by one
+  // thread, in the same order as the serial loop.
+  IntT out_rows = 0;
+  for (int i = 0; i < n; i++) {
+    out_rows = std::max(out_rows, static_cast<IntT>(indexs[i] + 1));
+  }
+  std::vector<int> row_offsets(out_rows + 1, 0);
+  for (int i = 0; i < n; i++) {
+    row_offsets[indexs[i] + 1]++;
+  }
+  for (IntT r = 0; r < out_rows; r++) {
+    row_offsets[r + 1] += row_offsets[r];
+  }
+  std::vector<int> rows(n);
+  std::vector<int> fill(row_offsets.begin(), row_offsets.end() - 1);
+  for (int i = 0; i < n; i++) {
+    rows[fill[indexs[i]]++] = i;
+  }
+#pragma omp parallel for
+  for (IntT r = 0; r < out_rows; r++) {
+    T* out_row = out + r * channels;
+    for (int k = row_offsets[r]; k < row_offsets[r + 1]; k++) {
+      const T* x_row = x + static_cast<int64_t>(rows[k]) * channels;
+      for (int j = 0; j < channels; j++) {
+        out_row[j] += x_row[j];
+      }
+    }
+  }
+#else
   for (int i = 0; i < n; i++) {
     IntT real_i = indexs[i];
     for (int j = 0; j < channels; j++) {
       out[real_i * channels + j] += x[i * channels + j];
     }
   }
+#endif
 }
 
 }  // namespace sparse
@@ -15,6 +15,8 @@
 #include "paddle/pir/include/core/ir_context.h"
 
 #include <glog/logging.h>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 
 #include "paddle/pir/include/core/attribute_base.h"
@@ -56,7 +58,7 @@ class IrContextImpl {
   }
 
   void RegisterAbstractType(pir::TypeId type_id, AbstractType *abstract_type) {
-    std::lock_guard<pir::SpinLock> guard(registed_abstract_types_lock_);
+    std::unique_lock<std::shared_mutex> guard(registed_abstract_types_lock_);
     VLOG(10) << "Register an abstract_type of: [TypeId_hash="
              << std::hash<pir::TypeId>()(type_id)
              << ", AbstractType_ptr=" << abstract_type << "].";
@@ -64,7 +66,7 @@ class IrContextImpl {
   }
 
   AbstractType *GetAbstractType(pir::TypeId type_id) {
-    std::lock_guard<pir::SpinLock> guard(registed_abstract_types_lock_);
+    std::shared_lock<std::shared_mutex> guard(registed_abstract_types_lock_);
     auto iter = registed_abstract_types_.find(type_id);
     if (iter != registed_abstract_types_.end()) {
       VLOG(10) << "Found a cached abstract_type of: [TypeId_hash="
@@ -79,7 +81,8 @@ class IrContextImpl {
 
   void RegisterAbstractAttribute(pir::TypeId type_id,
                                  AbstractAttribute *abstract_attribute) {
-    std::lock_guard<pir::SpinLock> guard(registed_abstract_attributes_lock_);
+    std::unique_lock<std::shared_mutex> guard(
+        registed_abstract_attributes_lock_);
     VLOG(10) << "Register an abstract_attribute of: [TypeId_hash="
              << std::hash<pir::TypeId>()(type_id)
              << ", AbstractAttribute_ptr=" << abstract_attribute << "].";
@@ -87,7 +90,8 @@ class IrContextImpl {
   }
 
   AbstractAttribute *GetAbstractAttribute(pir::TypeId type_id) {
-    std::lock_guard<pir::SpinLock> guard(registed_abstract_attributes_lock_);
+    std::shared_lock<std::shared_mutex> guard(
+        registed_abstract_attributes_lock_);
     auto iter = registed_abstract_attributes_.find(type_id);
     if (iter != registed_abstract_attributes_.end()) {
       VLOG(10) << "Found a cached abstract_attribute of: [TypeId_hash="
@@ -105,14 +109,14 @@ class IrContextImpl {
   }
 
   void RegisterOpInfo(const std::string &name, OpInfo info) {
-    std::lock_guard<pir::SpinLock> guard(registed_op_infos_lock_);
+    std::unique_lock<std::shared_mutex> guard(registed_op_infos_lock_);
     VLOG(10) << "Register an operation of: [Name=" << name
              << ", OpInfo ptr=" << info << "].";
     registed_op_infos_.emplace(name, info);
   }
 
   OpInfo GetOpInfo(const std::string &name) {
-    std::lock_guard<pir::SpinLock> guard(registed_op_infos_lock_);
+    std::shared_lock<std::shared_mutex> guard(registed_op_infos_lock_);
     auto iter = registed_op_infos_.find(name);
     if (iter != registed_op_infos_.end()) {
       VLOG(8) << "Found a cached OpInfo of: [name=" << name
@@ -125,7 +129,7 @@ class IrContextImpl {
   const OpInfoMap &registered_op_info_map() { return registed_op_infos_; }
 
   void RegisterDialect(std::string name, Dialect *dialect) {
-    std::lock_guard<pir::SpinLock> guard(registed_dialect_lock_);
+    std::unique_lock<std::shared_mutex> guard(registed_dialect_lock_);
     VLOG(8) << "Register a dialect of: [name=" << name
             << ", dialect_ptr=" << dialect << "].";
     registed_dialect_.emplace(name, dialect);
@@ -136,7 +140,7 @@ class IrContextImpl {
   }
 
   Dialect *GetDialect(const std::string &name) {
-    std::lock_guard<pir::SpinLock> guard(registed_dialect_lock_);
+    std::shared_lock<std::shared_mutex> guard(registed_dialect_lock_);
     auto iter = registed_dialect_.find(name);
     if (iter != registed_dialect_.end()) {
       VLOG(8) << "Found a cached dialect of: [name=" << name
@@ -147,9 +151,11 @@ class IrContextImpl {
     return nullptr;
   }
 
-  // Cached AbstractType instances.
+  // Cached AbstractType instances. The registries are written when a dialect
+  // is loaded and read on every type, attribute and op construction, so
+  // lookups share the lock.
   std::unordered_map<TypeId, AbstractType *> registed_abstract_types_;
-  pir::SpinLock registed_abstract_types_lock_;
+  std::shared_mutex registed_abstract_types_lock_;
   // TypeStorage uniquer and cache instances.
   StorageManager registed_type_storage_manager_;
   // Cache some built-in type objects.
@@ -169,17 +175,17 @@ class IrContextImpl {
 
   // Cached AbstractAttribute instances.
   std::unordered_map<TypeId, AbstractAttribute *> registed_abstract_attributes_;
-  pir::SpinLock registed_abstract_attributes_lock_;
+  std::shared_mutex registed_abstract_attributes_lock_;
   // AttributeStorage uniquer and cache instances.
   StorageManager registed_attribute_storage_manager_;
 
   // The dialect registered in the context.
   std::unordered_map<std::string, Dialect *> registed_dialect_;
-  pir::SpinLock registed_dialect_lock_;
+  std::shared_mutex registed_dialect_lock_;
 
   // The Op registered in the context.
   OpInfoMap registed_op_infos_;
-  pir::SpinLock registed_op_infos_lock_;
+  std::shared_mutex registed_op_infos_lock_;
 
   pir::SpinLock destructor_lock_;
 };
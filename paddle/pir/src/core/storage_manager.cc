@@ -15,25 +15,41 @@
 #include "paddle/pir/include/core/storage_manager.h"
 
 #include <glog/logging.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "paddle/common/enforce.h"
 
 namespace pir {
 // This is a structure for creating, caching, and looking up Storage of
 // parametric types.
+//
+// Storages are never erased before the manager is destroyed, so the cache is
+// an insert-only chained hash table: lookups walk the buckets without taking
+// any lock, only a miss takes the lock to construct and publish the storage.
+// When the table grows, the entries are copied into a new bucket array and
+// the old one is retired rather than freed, since readers may still be
+// walking it; a reader that misses on a retired table simply retries under
+// the lock. Retired tables together are smaller than the live one.
 struct ParametricStorageManager {
   using StorageBase = StorageManager::StorageBase;
 
   explicit ParametricStorageManager(std::function<void(StorageBase *)> destroy)
-      : destroy_(destroy) {}
+      : destroy_(destroy) {
+    tables_.emplace_back(std::make_unique<Table>(kInitialBuckets));
+    table_.store(tables_.back().get(), std::memory_order_release);
+  }
 
   ~ParametricStorageManager() {  // NOLINT
-    for (const auto &instance : parametric_instances_) {
-      destroy_(instance.second);
+    Table *table = table_.load(std::memory_order_acquire);
+    for (const auto &node : table->nodes) {
+      destroy_(node->storage);
     }
-    parametric_instances_.clear();
+    tables_.clear();
   }
 
   // Get the storage of parametric type, if not in the cache, create and
@@ -41,20 +57,27 @@ struct ParametricStorageManager {
   StorageBase *GetOrCreate(std::size_t hash_value,
                            std::function<bool(StorageBase *)> equal_func,
                            std::function<StorageBase *()> constructor) {
-    if (parametric_instances_.count(hash_value) != 0) {
-      auto pr = parametric_instances_.equal_range(hash_value);
-      while (pr.first != pr.second) {
-        if (equal_func(pr.first->second)) {
-          VLOG(10) << "Found a cached parametric storage of: [param_hash="
-                   << hash_value << ", storage_ptr=" << pr.first->second
-                   << "].";
-          return pr.first->second;
-        }
-        ++pr.first;
-      }
+    StorageBase *storage = Find(
+        table_.load(std::memory_order_acquire), hash_value, equal_func);
+    if (storage != nullptr) {
+      VLOG(10) << "Found a cached parametric storage of: [param_hash="
+               << hash_value << ", storage_ptr=" << storage << "].";
+      return storage;
+    }
+
+    std::lock_guard<pir::SpinLock> guard(lock_);
+    // another thread may have inserted it, or grown the table, since the
+    // lock-free lookup
+    Table *table = table_.load(std::memory_order_relaxed);
+    storage = Find(table, hash_value, equal_func);
+    if (storage != nullptr) {
+      return storage;
+    }
+    storage = constructor();
+    if (table->nodes.size() + 1 > table->buckets_size * kMaxLoadFactor) {
+      table = Grow(table);
     }
-    StorageBase *storage = constructor();
-    parametric_instances_.emplace(hash_value, storage);
+    Insert(table, hash_value, storage);
     VLOG(10) << "No cache found, construct and cache a new parametric storage "
                 "of: [param_hash="
              << hash_value << ", storage_ptr=" << storage << "].";
@@ -62,9 +85,70 @@ struct ParametricStorageManager {
   }
 
  private:
-  // In order to prevent hash conflicts, the unordered_multimap data structure
-  // is used for storage.
-  std::unordered_multimap<size_t, StorageBase *> parametric_instances_;
+  static constexpr std::size_t kInitialBuckets = 64;
+  static constexpr std::size_t kMaxLoadFactor = 2;
+
+  struct Node {
+    std::size_t hash_value;
+    StorageBase *storage;
+    // immutable once the node is published
+    Node *next;
+  };
+
+  struct Table {
+    explicit Table(std::size_t size)
+        : buckets_size(size), buckets(new std::atomic<Node *>[size]) {
+      for (std::size_t i = 0; i < size; ++i) {
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+    std::size_t buckets_size;
+    std::unique_ptr<std::atomic<Node *>[]> buckets;
+    // owned nodes, in insertion order
+    std::vector<std::unique_ptr<Node>> nodes;
+  };
+
+  static StorageBase *Find(
+      const Table *table,
+      std::size_t hash_value,
+      const std::function<bool(StorageBase *)> &equal_func) {
+    const Node *node =
+        table->buckets[hash_value & (table->buckets_size - 1)].load(
+            std::memory_order_acquire);
+    for (; node != nullptr; node = node->next) {
+      if (node->hash_value == hash_value && equal_func(node->storage)) {
+        return node->storage;
+      }
+    }
+    return nullptr;
+  }
+
+  static void Insert(Table *table,
+                     std::size_t hash_value,
+                     StorageBase *storage) {
+    auto &bucket = table->buckets[hash_value & (table->buckets_size - 1)];
+    table->nodes.emplace_back(std::make_unique<Node>(
+        Node{hash_value, storage, bucket.load(std::memory_order_relaxed)}));
+    bucket.store(table->nodes.back().get(), std::memory_order_release);
+  }
+
+  // Must hold lock_.
+  Table *Grow(Table *old_table) {
+    tables_.emplace_back(
+        std::make_unique<Table>(old_table->buckets_size * 2));
+    Table *table = tables_.back().get();
+    for (const auto &node : old_table->nodes) {
+      Insert(table, node->hash_value, node->storage);
+    }
+    table_.store(table, std::memory_order_release);
+    // the nodes of the old table are only needed by in-flight readers
+    return table;
+  }
+
+  std::atomic<Table *> table_{nullptr};
+  // the live table and the retired ones, guarded by lock_
+  std::vector<std::unique_ptr<Table>> tables_;
+  pir::SpinLock lock_;
   std::function<void(StorageBase *)> destroy_;
 };
 
@@ -77,31 +161,36 @@ StorageManager::StorageBase *StorageManager::GetParametricStorageImpl(
     std::size_t hash_value,
     std::function<bool(const StorageBase *)> equal_func,
     std::function<StorageBase *()> constructor) {
-  std::lock_guard<pir::SpinLock> guard(parametric_instance_lock_);
   VLOG(10) << "Try to get a parametric storage of: [TypeId_hash="
            << std::hash<pir::TypeId>()(type_id) << ", param_hash=" << hash_value
            << "].";
-  if (parametric_instance_.find(type_id) == parametric_instance_.end()) {
-    IR_THROW("The input data pointer is null.");
+  ParametricStorageManager *parametric_storage = nullptr;
+  {
+    // the registered storage classes only change when a dialect is loaded
+    std::shared_lock<std::shared_mutex> guard(parametric_instance_lock_);
+    auto iter = parametric_instance_.find(type_id);
+    if (iter == parametric_instance_.end()) {
+      IR_THROW("The input data pointer is null.");
+    }
+    parametric_storage = iter->second.get();
   }
-  ParametricStorageManager &parametric_storage = *parametric_instance_[type_id];
-  return parametric_storage.GetOrCreate(hash_value, equal_func, constructor);
+  return parametric_storage->GetOrCreate(hash_value, equal_func, constructor);
 }
 
 StorageManager::StorageBase *StorageManager::GetParameterlessStorageImpl(
     TypeId type_id) {
-  std::lock_guard<pir::SpinLock> guard(parameterless_instance_lock_);
+  std::shared_lock<std::shared_mutex> guard(parameterless_instance_lock_);
   VLOG(10) << "Try to get a parameterless storage of: [TypeId_hash="
            << std::hash<pir::TypeId>()(type_id) << "].";
-  if (parameterless_instance_.find(type_id) == parameterless_instance_.end())
+  auto iter = parameterless_instance_.find(type_id);
+  if (iter == parameterless_instance_.end())
     IR_THROW("TypeId not found in IrContext.");
-  StorageBase *parameterless_instance = parameterless_instance_[type_id];
-  return parameterless_instance;
+  return iter->second;
 }
 
 void StorageManager::RegisterParametricStorageImpl(
     TypeId type_id, std::function<void(StorageBase *)> destroy) {
-  std::lock_guard<pir::SpinLock> guard(parametric_instance_lock_);
+  std::unique_lock<std::shared_mutex> guard(parametric_instance_lock_);
   VLOG(10) << "Register a parametric storage of: [TypeId_hash="
            << std::hash<pir::TypeId>()(type_id) << "].";
   parametric_instance_.emplace(
@@ -110,7 +199,7 @@ void StorageManager::RegisterParametricStorageImpl(
 
 void StorageManager::RegisterParameterlessStorageImpl(
     TypeId type_id, std::function<StorageBase *()> constructor) {
-  std::lock_guard<pir::SpinLock> guard(parameterless_instance_lock_);
+  std::unique_lock<std::shared_mutex> guard(parameterless_instance_lock_);
   VLOG(10) << "Register a parameterless storage of: [TypeId_hash="
            << std::hash<pir::TypeId>()(type_id) << "].";
   if (parameterless_instance_.find(type_id) != parameterless_instance_.end())
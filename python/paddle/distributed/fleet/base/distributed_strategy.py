@@ -616,6 +616,9 @@ class DistributedStrategy:
             'sparse_enable_cache',
             'sparse_cache_rate',
             'sparse_cache_file_num',
+            'sparse_wire_delta_keys',
+            'sparse_wire_pull_value_codec',
+            'sparse_wire_compress_threshold',
             'sparse_beta1_decay_rate',
             'sparse_beta2_decay_rate',
             'sparse_ada_epsilon',
@@ -797,6 +800,15 @@ class DistributedStrategy:
             table_data.sparse_table_cache_file_num = config.get(
                 'sparse_cache_file_num', 16
             )
+            table_data.sparse_wire_param.delta_keys = config.get(
+                'sparse_wire_delta_keys', False
+            )
+            table_data.sparse_wire_param.pull_value_codec = config.get(
+                'sparse_wire_pull_value_codec', 'fp32'
+            )
+            table_data.sparse_wire_param.compress_threshold = config.get(
+                'sparse_wire_compress_threshold', 0
+            )
 
             accessor_class = config.get(
                 "sparse_accessor_class", "DownpourCtrAccessor"
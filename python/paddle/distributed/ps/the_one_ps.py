@@ -759,6 +759,10 @@ class SparseTable(Table):
             table_proto.enable_revert = usr_table_proto.enable_revert
         if usr_table_proto.HasField("shard_merge_rate"):
             table_proto.shard_merge_rate = usr_table_proto.shard_merge_rate
+        if usr_table_proto.HasField("sparse_wire_param"):
+            table_proto.sparse_wire_param.ParseFromString(
+                usr_table_proto.sparse_wire_param.SerializeToString()
+            )
 
         if usr_table_proto.accessor.ByteSize() == 0:
             warnings.warn(
@@ -85,6 +85,7 @@ def _nodename2opname(name):
     op_name = name.replace(' compute', '')
     op_name = op_name.replace(' dygraph', '')
     op_name = op_name.replace(' pybind_imperative_func', '')
+    op_name = op_name.replace('pd_op.', '')
     return op_name
 
 
@@ -520,6 +521,10 @@ class EventSummary:
             self.min_general_gpu_time = float('inf')
             self.max_general_gpu_time = 0
             self._flops = 0
+            self.bytes = 0
+            self.cycles = 0
+            self.instructions = 0
+            self.cache_misses = 0
 
         @property
         def flops(self):
@@ -564,6 +569,12 @@ class EventSummary:
         def add_flops(self, flops):
             self._flops += flops
 
+        def add_kernel_cost(self, node):
+            self.bytes += getattr(node, 'bytes', 0)
+            self.cycles += getattr(node, 'cycles', 0)
+            self.instructions += getattr(node, 'instructions', 0)
+            self.cache_misses += getattr(node, 'cache_misses', 0)
+
         def add_item(self, node):
             raise NotImplementedError
 
@@ -579,6 +590,7 @@ class EventSummary:
             self.add_gpu_time(node.gpu_time)
             self.add_general_gpu_time(node.general_gpu_time)
             self.add_flops(node.flops)
+            self.add_kernel_cost(node)
             for child in node.children_node:
                 if child.type != TracerEventType.Operator:
                     if child.name not in self.operator_inners:
@@ -1597,6 +1609,75 @@ def _build_table(
             append('')
             append('')
 
+        # ----- Print Operator Roofline Summary Report ----- #
+        # only ops recorded with their kernel cost, see record_shapes and
+        # FLAGS_enable_kernel_perf_counters
+        roofline_items = [
+            (name, item)
+            for name, item in statistic_data.event_summary.items.items()
+            if item.bytes > 0
+        ]
+        if roofline_items:
+            roofline_items.sort(key=lambda x: x[1].cpu_time, reverse=True)
+            all_row_values = []
+            name_column_width = 52
+            for name, item in roofline_items:
+                if len(name) > name_column_width:
+                    name = name[: name_column_width - 3] + '...'
+                # FLOPs and bytes per ns are GFLOP/s and GB/s
+                cpu_time = max(item.cpu_time, 1)
+                row_values = [
+                    name,
+                    item.call,
+                    format_time(item.avg_cpu_time, unit=time_unit),
+                    _format_large_number(item.flops),
+                    _format_large_number(item.bytes),
+                    f'{item.flops / cpu_time:.2f}',
+                    f'{item.bytes / cpu_time:.2f}',
+                    f'{item.flops / item.bytes:.2f}',
+                    f'{item.instructions / item.cycles:.2f}'
+                    if item.cycles > 0
+                    else '-',
+                    _format_large_number(item.cache_misses * 64)
+                    if item.cycles > 0
+                    else '-',
+                ]
+                all_row_values.append(row_values)
+            headers = [
+                'Name',
+                'Calls',
+                'CPU Avg',
+                'FLOPs',
+                'Bytes',
+                'GFLOP/s',
+                'GB/s',
+                'FLOP/Byte',
+                'IPC',
+                'Miss Bytes',
+            ]
+            row_format_list = [""]
+            header_sep_list = [""]
+            line_length_list = [-SPACING_SIZE]
+            add_column(name_column_width)
+            add_column(6)
+            for _ in range(len(headers) - 2):
+                add_column(11)
+
+            row_format = row_format_list[0]
+            header_sep = header_sep_list[0]
+            line_length = line_length_list[0]
+
+            append(add_title(line_length, "Operator Roofline Summary"))
+            append(f'Time unit: {time_unit}')
+            append(header_sep)
+            append(row_format.format(*headers))
+            append(header_sep)
+            for row_values in all_row_values:
+                append(row_format.format(*row_values))
+            append(header_sep)
+            append('')
+            append('')
+
     if views is None or SummaryView.KernelView in views:
         # ----- Print Kernel Summary Report ----- #
         if statistic_data.event_summary.kernel_items:
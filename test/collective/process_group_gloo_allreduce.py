@@ -0,0 +1,70 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+
+import numpy as np
+
+import paddle
+from paddle.base import core
+
+
+class TestProcessGroupGlooAllReduce(unittest.TestCase):
+    def setUp(self):
+        self.nranks = paddle.distributed.ParallelEnv().nranks
+        self.rank = paddle.distributed.ParallelEnv().local_rank
+        # odd numel exercises uneven ring chunks, the large one goes beyond
+        # FLAGS_gloo_allreduce_small_bytes
+        self.numels = [1, 7, 1000, 100003]
+        self.dtypes = ["float32", "float64", "int64"]
+
+    def rank_data(self, rank, numel, dtype):
+        rng = np.random.RandomState(2024 + rank)
+        return (rng.random_sample(numel) * 100).astype(dtype)
+
+    def test_allreduce_algorithms(self):
+        store = core.TCPStore(
+            "127.0.0.1", 6273, self.rank == 0, self.nranks, 30
+        )
+        pg = core.ProcessGroupGloo.create(store, self.rank, self.nranks)
+        paddle.device.set_device('cpu')
+
+        for dtype in self.dtypes:
+            for numel in self.numels:
+                all_data = [
+                    self.rank_data(r, numel, dtype) for r in range(self.nranks)
+                ]
+
+                tensor = paddle.to_tensor(all_data[self.rank])
+                pg.allreduce(tensor).wait()
+                np.testing.assert_allclose(
+                    tensor.numpy(), np.sum(all_data, axis=0), rtol=1e-6
+                )
+
+                tensor = paddle.to_tensor(all_data[self.rank])
+                pg.allreduce(tensor, core.ReduceOp.MAX).wait()
+                np.testing.assert_array_equal(
+                    tensor.numpy(), np.max(all_data, axis=0)
+                )
+
+                tensor = paddle.to_tensor(all_data[self.rank])
+                pg.allreduce(tensor, core.ReduceOp.MIN).wait()
+                np.testing.assert_array_equal(
+                    tensor.numpy(), np.min(all_data, axis=0)
+                )
+        print("test gloo allreduce algorithms ok")
+
+
+if __name__ == "__main__":
+    unittest.main()
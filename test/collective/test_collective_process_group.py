@@ -26,6 +26,19 @@ class TestProcessGroup(TestMultipleAccelerators):
     def test_process_group_gloo(self):
         self.run_mnist_2accelerators('process_group_gloo.py')
 
+    def test_process_group_gloo_allreduce_algo(self):
+        for algo in [
+            "gloo",
+            "recursive_doubling",
+            "ring",
+            "hierarchical",
+            "auto",
+        ]:
+            self.run_mnist_2accelerators(
+                'process_group_gloo_allreduce.py',
+                need_envs={"FLAGS_gloo_allreduce_algo": algo},
+            )
+
     def test_init_process_group(self):
         self.run_mnist_2accelerators('init_process_group.py')
 
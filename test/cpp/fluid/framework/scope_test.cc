@@ -14,6 +14,8 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/scope.h"
 
+#include <thread>
+
 #include "gtest/gtest.h"
 
 namespace paddle {
@@ -23,6 +25,7 @@ class Variable;
 }  // namespace paddle
 
 using paddle::framework::Scope;
+using paddle::framework::VarNameId;
 using paddle::framework::Variable;
 
 TEST(Scope, VarsShadowing) {
@@ -77,3 +80,77 @@ TEST(Scope, GetAllNames) {
 
   EXPECT_STREQ("a", str.c_str());
 }
+
+TEST(Scope, FindVarByNameId) {
+  VarNameId a = Scope::InternVarName("scope_test_id_a");
+  VarNameId b = Scope::InternVarName("scope_test_id_b");
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, Scope::InternVarName("scope_test_id_a"));
+  EXPECT_EQ("scope_test_id_b", Scope::VarName(b));
+
+  Scope s;
+  Scope& ss = s.NewScope();
+  Variable* va = s.Var("scope_test_id_a");
+  EXPECT_EQ(va, ss.FindVar(a));
+  EXPECT_EQ(nullptr, ss.FindVar(b));
+
+  // the vars created, shadowed, renamed and erased after a lookup
+  Variable* vb = s.Var("scope_test_id_b");
+  EXPECT_EQ(vb, ss.FindVar(b));
+  Variable* va1 = ss.Var("scope_test_id_a");
+  EXPECT_EQ(va1, ss.FindVar(a));
+  ss.Rename("scope_test_id_a", "scope_test_id_c");
+  EXPECT_EQ(va, ss.FindVar(a));
+  EXPECT_EQ(va1, ss.FindVar(Scope::InternVarName("scope_test_id_c")));
+  s.EraseVars({"scope_test_id_a"});
+  EXPECT_EQ(nullptr, ss.FindVar(a));
+  EXPECT_EQ(nullptr, s.FindVar("scope_test_id_a"));
+}
+
+TEST(Scope, FindVarByNameIdConcurrently) {
+  Scope s;
+  std::vector<VarNameId> ids;
+  std::vector<Variable*> vars;
+  for (int i = 0; i < 200; ++i) {
+    std::string name = "scope_test_concurrent_" + std::to_string(i);
+    ids.push_back(Scope::InternVarName(name));
+    vars.push_back(s.Var(name));
+  }
+  std::vector<Scope*> kids;
+  for (int t = 0; t < 4; ++t) kids.push_back(&s.NewScope());
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(kids.size(), 0);
+  for (size_t t = 0; t < kids.size(); ++t) {
+    threads.emplace_back([&, t]() {
+      for (int round = 0; round < 50; ++round) {
+        for (size_t i = 0; i < ids.size(); ++i) {
+          if (kids[t]->FindVar(ids[i]) != vars[i]) ++mismatches[t];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int mismatch : mismatches) EXPECT_EQ(0, mismatch);
+}
+
+// Names past the first chunks of the name table, looked up in scopes that
+// only record the ids they see.
+TEST(Scope, FindVarByLargeNameId) {
+  std::vector<VarNameId> ids;
+  for (int i = 0; i < 5000; ++i) {
+    ids.push_back(
+        Scope::InternVarName("scope_test_large_" + std::to_string(i)));
+  }
+  for (int i = 0; i < 5000; ++i) {
+    EXPECT_EQ("scope_test_large_" + std::to_string(i), Scope::VarName(ids[i]));
+  }
+  Scope s;
+  Variable* last = s.Var("scope_test_large_4999");
+  for (int i = 0; i < 10; ++i) {
+    Scope& local = s.NewScope();
+    EXPECT_EQ(last, local.FindVar(ids.back()));
+    EXPECT_EQ(nullptr, local.FindVar(ids.front()));
+    Variable* first = local.Var("scope_test_large_0");
+    EXPECT_EQ(first, local.FindVar(ids.front()));
+  }
+}
@@ -0,0 +1,175 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/inference/analysis/helper.h"
+#include "paddle/fluid/inference/api/analysis_predictor.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+namespace paddle {
+
+constexpr int kBatch = 2;
+using Lod = std::vector<std::vector<size_t>>;
+
+// y = scale(relu(x), 2), x is [batch, length] with both axes dynamic.
+std::string SaveModel() {
+  framework::ProgramDesc program;
+  auto *block = program.MutableBlock(0);
+  auto *feed = block->Var("feed");
+  feed->SetType(framework::proto::VarType::FEED_MINIBATCH);
+  feed->SetPersistable(true);
+  auto *fetch = block->Var("fetch");
+  fetch->SetType(framework::proto::VarType::FETCH_LIST);
+  fetch->SetPersistable(true);
+  for (auto *name : {"x", "r", "y"}) {
+    auto *var = block->Var(name);
+    var->SetType(framework::proto::VarType::LOD_TENSOR);
+    var->SetDataType(framework::proto::VarType::FP32);
+    var->SetShape({-1, -1});
+  }
+
+  auto *op = block->AppendOp();
+  op->SetType("feed");
+  op->SetInput("X", {"feed"});
+  op->SetOutput("Out", {"x"});
+  op->SetAttr("col", 0);
+  op = block->AppendOp();
+  op->SetType("relu");
+  op->SetInput("X", {"x"});
+  op->SetOutput("Out", {"r"});
+  op = block->AppendOp();
+  op->SetType("scale");
+  op->SetInput("X", {"r"});
+  op->SetOutput("Out", {"y"});
+  op->SetAttr("scale", 2.0f);
+  op->SetAttr("bias", 0.0f);
+  op->SetAttr("bias_after_scale", true);
+  op = block->AppendOp();
+  op->SetType("fetch");
+  op->SetInput("X", {"y"});
+  op->SetOutput("Out", {"fetch"});
+  op->SetAttr("col", 0);
+
+  const std::string dir = "./shape_bucket_model_" + std::to_string(::getpid());
+  inference::analysis::MakeDirIfNotExists(dir);
+  std::ofstream model(dir + "/__model__", std::ios::binary);
+  model << program.Proto()->SerializeAsString();
+  return dir;
+}
+
+std::unique_ptr<PaddlePredictor> CreatePredictor(const std::string &dir,
+                                                 bool shape_bucket) {
+  AnalysisConfig config;
+  config.SetModel(dir);
+  config.DisableGpu();
+  config.SwitchIrOptim(false);
+  config.EnableNewExecutor(true);
+  config.EnableNewIR(false);
+  if (shape_bucket) config.EnableShapeBucket({4, 8}, 1, 4);
+  config.DisableGlogInfo();
+  return CreatePaddlePredictor<AnalysisConfig>(config);
+}
+
+struct Output {
+  std::vector<int> shape;
+  std::vector<float> data;
+  Lod lod;
+};
+
+Output Run(PaddlePredictor *predictor,
+           const std::vector<float> &x,
+           const Lod &lod = {}) {
+  auto input = predictor->GetInputTensor("x");
+  input->Reshape({kBatch, static_cast<int>(x.size()) / kBatch});
+  input->copy_from_cpu(x.data());
+  input->SetLoD(lod);
+  EXPECT_TRUE(predictor->ZeroCopyRun());
+  auto output = predictor->GetOutputTensor("y");
+  Output result;
+  result.shape = output->shape();
+  result.data.resize(result.shape[0] * result.shape[1]);
+  output->copy_to_cpu(result.data.data());
+  result.lod = output->lod();
+  return result;
+}
+
+std::vector<float> Input(int length) {
+  std::vector<float> x(kBatch * length);
+  for (size_t i = 0; i < x.size(); ++i) {
+    x[i] = (i % 2 ? 1.0f : -1.0f) * static_cast<float>(i) + 0.5f;
+  }
+  return x;
+}
+
+TEST(AnalysisPredictor, ShapeBucketMatchesUnbucketed) {
+  const std::string dir = SaveModel();
+  auto reference = CreatePredictor(dir, false);
+  auto bucketed = CreatePredictor(dir, true);
+  for (int length : {3, 6, 4, 3}) {
+    auto x = Input(length);
+    Output expected = Run(reference.get(), x);
+    Output padded = Run(bucketed.get(), x);
+    const int bucket = length <= 4 ? 4 : 8;
+    ASSERT_EQ(padded.shape, (std::vector<int>{kBatch, bucket}));
+    for (int b = 0; b < kBatch; ++b) {
+      for (int t = 0; t < length; ++t) {
+        EXPECT_EQ(padded.data[b * bucket + t], expected.data[b * length + t])
+            << "length " << length << " at " << b << ", " << t;
+      }
+    }
+  }
+}
+
+TEST(AnalysisPredictor, ShapeBucketKeepsLoD) {
+  const std::string dir = SaveModel();
+  auto bucketed = CreatePredictor(dir, true);
+  const Lod lod{{0, 1, 2}};
+  Output padded = Run(bucketed.get(), Input(3), lod);
+  EXPECT_EQ(padded.lod, lod);
+  // the prepared bucket of the previous run gets the new LoD
+  padded = Run(bucketed.get(), Input(3));
+  EXPECT_TRUE(padded.lod.empty());
+}
+
+TEST(AnalysisPredictor, ShapeBucketRunsHooks) {
+  const std::string dir = SaveModel();
+  auto bucketed = CreatePredictor(dir, true);
+  // the bucket is prepared before the hooks are registered
+  Run(bucketed.get(), Input(3));
+  int relu_inputs = 0, scale_outputs = 0;
+  auto *predictor = static_cast<AnalysisPredictor *>(bucketed.get());
+  predictor->RegisterInputHook(
+      [&](const std::string &op_type, const std::string &, const Tensor &) {
+        if (op_type == "relu") ++relu_inputs;
+      });
+  predictor->RegisterOutputHook(
+      [&](const std::string &op_type, const std::string &, const Tensor &) {
+        if (op_type == "scale") ++scale_outputs;
+      });
+  Run(bucketed.get(), Input(3));
+  EXPECT_EQ(relu_inputs, 1);
+  EXPECT_EQ(scale_outputs, 1);
+  Run(bucketed.get(), Input(6));
+  EXPECT_EQ(relu_inputs, 2);
+  EXPECT_EQ(scale_outputs, 2);
+}
+
+}  // namespace paddle
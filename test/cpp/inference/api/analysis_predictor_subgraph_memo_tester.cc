@@ -0,0 +1,187 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/inference/analysis/helper.h"
+#include "paddle/fluid/inference/api/analysis_predictor.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+namespace paddle {
+
+constexpr int kNumel = 4;
+
+void AddVar(framework::BlockDesc *block,
+            const std::string &name,
+            bool persistable = false) {
+  auto *var = block->Var(name);
+  var->SetType(framework::proto::VarType::LOD_TENSOR);
+  var->SetDataType(framework::proto::VarType::FP32);
+  var->SetShape({kNumel});
+  var->SetPersistable(persistable);
+}
+
+framework::OpDesc *AddOp(framework::BlockDesc *block,
+                         const std::string &type,
+                         const framework::VariableNameMap &inputs,
+                         const std::string &out) {
+  auto *op = block->AppendOp();
+  op->SetType(type);
+  for (auto &input : inputs) op->SetInput(input.first, input.second);
+  op->SetOutput("Out", {out});
+  if (type != "relu") op->SetAttr("axis", -1);
+  return op;
+}
+
+// d = relu(x * w) + x * w + y, where the memoized subgraph computes
+// b = relu(a), a = x * w, and the rest of the program reads a as well.
+std::string SaveModel() {
+  framework::ProgramDesc program;
+  auto *block = program.MutableBlock(0);
+  auto *feed = block->Var("feed");
+  feed->SetType(framework::proto::VarType::FEED_MINIBATCH);
+  feed->SetPersistable(true);
+  auto *fetch = block->Var("fetch");
+  fetch->SetType(framework::proto::VarType::FETCH_LIST);
+  fetch->SetPersistable(true);
+  AddVar(block, "w", true);
+  for (auto *name : {"x", "y", "a", "b", "c", "d"}) AddVar(block, name);
+
+  int col = 0;
+  for (auto *name : {"x", "y"}) {
+    auto *op = block->AppendOp();
+    op->SetType("feed");
+    op->SetInput("X", {"feed"});
+    op->SetOutput("Out", {name});
+    op->SetAttr("col", col++);
+  }
+  AddOp(block, "elementwise_mul", {{"X", {"x"}}, {"Y", {"w"}}}, "a");
+  AddOp(block, "relu", {{"X", {"a"}}}, "b");
+  AddOp(block, "elementwise_add", {{"X", {"b"}}, {"Y", {"a"}}}, "c");
+  AddOp(block, "elementwise_add", {{"X", {"c"}}, {"Y", {"y"}}}, "d");
+  auto *op = block->AppendOp();
+  op->SetType("fetch");
+  op->SetInput("X", {"d"});
+  op->SetOutput("Out", {"fetch"});
+  op->SetAttr("col", 0);
+
+  const std::string dir =
+      "./subgraph_memo_model_" + std::to_string(::getpid());
+  inference::analysis::MakeDirIfNotExists(dir);
+  std::ofstream model(dir + "/__model__", std::ios::binary);
+  model << program.Proto()->SerializeAsString();
+  phi::DenseTensor w;
+  w.Resize({kNumel});
+  float *data = w.mutable_data<float>(phi::CPUPlace());
+  for (int i = 0; i < kNumel; ++i) data[i] = 1.0f;
+  std::ofstream params(dir + "/w", std::ios::binary);
+  framework::SerializeToStream(params, w);
+  return dir;
+}
+
+std::vector<float> Expected(const std::vector<float> &x,
+                            float w,
+                            const std::vector<float> &y) {
+  std::vector<float> d(kNumel);
+  for (int i = 0; i < kNumel; ++i) {
+    float a = x[i] * w;
+    d[i] = std::max(a, 0.0f) + a + y[i];
+  }
+  return d;
+}
+
+class SubgraphMemoTest : public ::testing::Test {
+ protected:
+  void Create(int64_t ttl_ms = 0) {
+    AnalysisConfig config;
+    config.SetModel(SaveModel());
+    config.DisableGpu();
+    config.SwitchIrOptim(false);
+    config.EnableNewExecutor(true);
+    config.EnableNewIR(false);
+    config.EnableSubgraphMemoization({"b"}, 4, ttl_ms);
+    config.DisableGlogInfo();
+    predictor_ = CreatePaddlePredictor<AnalysisConfig>(config);
+  }
+
+  std::vector<float> Run(const std::vector<float> &x,
+                         const std::vector<float> &y) {
+    for (auto &input : {std::make_pair("x", &x), std::make_pair("y", &y)}) {
+      auto tensor = predictor_->GetInputTensor(input.first);
+      tensor->Reshape({kNumel});
+      tensor->copy_from_cpu(input.second->data());
+    }
+    EXPECT_TRUE(predictor_->ZeroCopyRun());
+    std::vector<float> out(kNumel);
+    predictor_->GetOutputTensor("d")->copy_to_cpu(out.data());
+    return out;
+  }
+
+  // writes the weight behind the predictor's back, only a recomputed
+  // subgraph sees it
+  void SetWeightInPlace(float value) {
+    auto *scope = static_cast<AnalysisPredictor *>(predictor_.get())->scope();
+    auto *w = scope->FindVar("w")->GetMutable<phi::DenseTensor>();
+    for (int i = 0; i < kNumel; ++i) w->data<float>()[i] = value;
+  }
+
+  std::unique_ptr<PaddlePredictor> predictor_;
+  const std::vector<float> x_{-1, 2, -3, 4};
+  const std::vector<float> y_{10, 20, 30, 40};
+};
+
+TEST_F(SubgraphMemoTest, HitAndMiss) {
+  Create();
+  EXPECT_EQ(Run(x_, y_), Expected(x_, 1, y_));
+  SetWeightInPlace(2);
+  // a hit reuses the results of w = 1, and the rest still reads the new y
+  EXPECT_EQ(Run(x_, y_), Expected(x_, 1, y_));
+  const std::vector<float> y{1, 1, 1, 1};
+  EXPECT_EQ(Run(x_, y), Expected(x_, 1, y));
+  // other inputs of the subgraph miss
+  const std::vector<float> x{5, -6, 7, -8};
+  EXPECT_EQ(Run(x, y_), Expected(x, 2, y_));
+  EXPECT_EQ(Run(x_, y_), Expected(x_, 1, y_));
+}
+
+TEST_F(SubgraphMemoTest, TtlExpires) {
+  Create(500);
+  EXPECT_EQ(Run(x_, y_), Expected(x_, 1, y_));
+  SetWeightInPlace(2);
+  EXPECT_EQ(Run(x_, y_), Expected(x_, 1, y_));
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  EXPECT_EQ(Run(x_, y_), Expected(x_, 2, y_));
+}
+
+TEST_F(SubgraphMemoTest, WeightHandleDropsResults) {
+  Create();
+  EXPECT_EQ(Run(x_, y_), Expected(x_, 1, y_));
+  std::vector<float> w(kNumel, 3);
+  auto tensor = predictor_->GetInputTensor("w");
+  tensor->Reshape({kNumel});
+  tensor->copy_from_cpu(w.data());
+  EXPECT_EQ(Run(x_, y_), Expected(x_, 3, y_));
+}
+
+}  // namespace paddle
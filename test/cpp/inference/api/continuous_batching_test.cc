@@ -0,0 +1,323 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/inference/api/paddle_continuous_batching.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/inference/api/details/continuous_batching.h"
+
+namespace paddle_infer {
+
+// A model whose next token depends on the whole history of a sequence, kept
+// in its KV cache slot, so a wrong slot or position changes the output.
+class ToyModel {
+ public:
+  explicit ToyModel(int slots) : cache_(slots) {}
+
+  void Step(const DecodeBatch& batch, std::vector<int64_t>* next_tokens) {
+    ASSERT_EQ(batch.token_offsets.size(), batch.rows() + 1);
+    ASSERT_EQ(batch.positions.size(), batch.rows());
+    max_rows_ = std::max(max_rows_, batch.rows());
+    max_tokens_ = std::max(max_tokens_, batch.token_ids.size());
+    next_tokens->resize(batch.rows());
+    for (size_t i = 0; i < batch.rows(); ++i) {
+      auto& cache = cache_.at(batch.cache_slots[i]);
+      if (batch.positions[i] == 0) cache.clear();
+      ASSERT_EQ(batch.positions[i], static_cast<int64_t>(cache.size()));
+      cache.insert(cache.end(),
+                   batch.token_ids.begin() + batch.token_offsets[i],
+                   batch.token_ids.begin() + batch.token_offsets[i + 1]);
+      (*next_tokens)[i] = Next(cache);
+    }
+  }
+
+  static int64_t Next(const std::vector<int64_t>& history) {
+    int64_t h = 7;
+    for (int64_t t : history) h = (h * 31 + t) % 1000;
+    return h;
+  }
+
+  size_t max_rows_{0};
+  size_t max_tokens_{0};
+
+ private:
+  std::vector<std::vector<int64_t>> cache_;
+};
+
+std::vector<int64_t> Generate(const GenerationRequest& request) {
+  std::vector<int64_t> history = request.prompt, tokens;
+  while (static_cast<int>(tokens.size()) < request.max_new_tokens) {
+    tokens.push_back(ToyModel::Next(history));
+    history.push_back(tokens.back());
+    if (tokens.back() == request.eos_token_id) break;
+  }
+  return tokens;
+}
+
+GenerationRequest MakeRequest(int id, int prompt_len, int max_new_tokens) {
+  GenerationRequest request;
+  for (int i = 0; i < prompt_len; ++i) request.prompt.push_back(id * 10 + i);
+  request.max_new_tokens = max_new_tokens;
+  return request;
+}
+
+DecodeStepFunc StepOf(ToyModel* model) {
+  return [model](const DecodeBatch& batch, std::vector<int64_t>* next) {
+    model->Step(batch, next);
+  };
+}
+
+TEST(ContinuousBatching, SameTokensAsAlone) {
+  ContinuousBatchingConfig config;
+  config.max_batch_size = 3;
+  config.max_step_tokens = 12;
+  ToyModel model(config.max_batch_size);
+  ContinuousBatchingScheduler scheduler(config, StepOf(&model));
+
+  std::vector<GenerationRequest> requests;
+  for (int i = 0; i < 10; ++i) {
+    requests.push_back(MakeRequest(i, 1 + i % 6, 1 + (i * 7) % 9));
+  }
+  requests[4].eos_token_id = Generate(requests[4])[1];
+  std::vector<std::future<GenerationResult>> futures;
+  for (const auto& request : requests) {
+    futures.push_back(scheduler.Submit(request));
+  }
+  while (scheduler.Step()) {
+  }
+  EXPECT_EQ(scheduler.NumActive(), 0UL);
+  EXPECT_EQ(scheduler.NumWaiting(), 0UL);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto result = futures[i].get();
+    EXPECT_EQ(result.tokens, Generate(requests[i])) << "request " << i;
+    EXPECT_LE(result.time_to_first_token_ms, result.latency_ms);
+  }
+  EXPECT_LE(model.max_rows_, 3UL);
+  EXPECT_LE(model.max_tokens_, 12UL);
+
+  auto stats = scheduler.GetStats();
+  EXPECT_EQ(stats.finished_requests, requests.size());
+  uint64_t generated = 0;
+  for (const auto& request : requests) generated += Generate(request).size();
+  EXPECT_EQ(stats.generated_tokens, generated);
+  EXPECT_GT(stats.mean_batch_size, 1.0);
+  EXPECT_LE(stats.mean_batch_size, 3.0);
+}
+
+// A short request admitted next to a long one retires first and hands its
+// slot to the next one.
+TEST(ContinuousBatching, RetiresBetweenSteps) {
+  ContinuousBatchingConfig config;
+  config.max_batch_size = 2;
+  ToyModel model(config.max_batch_size);
+  ContinuousBatchingScheduler scheduler(config, StepOf(&model));
+  auto long_request = scheduler.Submit(MakeRequest(0, 4, 20));
+  auto short_request = scheduler.Submit(MakeRequest(1, 2, 2));
+  auto third_request = scheduler.Submit(MakeRequest(2, 3, 2));
+  ASSERT_TRUE(scheduler.Step());
+  EXPECT_EQ(scheduler.NumActive(), 2UL);
+  EXPECT_EQ(scheduler.NumWaiting(), 1UL);
+  ASSERT_TRUE(scheduler.Step());
+  EXPECT_EQ(short_request.wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  EXPECT_EQ(scheduler.NumActive(), 1UL);
+  ASSERT_TRUE(scheduler.Step());
+  EXPECT_EQ(scheduler.NumWaiting(), 0UL);
+  EXPECT_EQ(scheduler.NumActive(), 2UL);
+  while (scheduler.Step()) {
+  }
+  EXPECT_EQ(long_request.get().tokens.size(), 20UL);
+  EXPECT_EQ(third_request.get().tokens.size(), 2UL);
+}
+
+TEST(ContinuousBatching, Loop) {
+  ContinuousBatchingConfig config;
+  config.max_batch_size = 4;
+  config.max_seq_len = 16;
+  ToyModel model(config.max_batch_size);
+  ContinuousBatchingScheduler scheduler(config, StepOf(&model));
+  scheduler.Start();
+  std::map<int, std::future<GenerationResult>> futures;
+  std::mutex mutex;
+  std::vector<std::thread> clients;
+  for (int c = 0; c < 4; ++c) {
+    clients.emplace_back([&, c] {
+      for (int i = c * 8; i < c * 8 + 8; ++i) {
+        auto future = scheduler.Submit(MakeRequest(i, 1 + i % 5, 20));
+        std::lock_guard<std::mutex> guard(mutex);
+        futures[i] = std::move(future);
+      }
+    });
+  }
+  for (auto& client : clients) client.join();
+  for (auto& [i, future] : futures) {
+    auto request = MakeRequest(i, 1 + i % 5, 20);
+    // cut by max_seq_len
+    request.max_new_tokens = 16 - static_cast<int>(request.prompt.size());
+    EXPECT_EQ(future.get().tokens, Generate(request)) << "request " << i;
+  }
+  scheduler.Stop();
+
+  auto stats = scheduler.GetStats();
+  EXPECT_EQ(stats.finished_requests, 32UL);
+  EXPECT_GT(stats.tokens_per_second, 0);
+  EXPECT_GT(stats.step_tokens_per_second, 0);
+  EXPECT_GE(stats.max_time_to_first_token_ms,
+            stats.mean_time_to_first_token_ms);
+}
+
+TEST(ContinuousBatching, InvalidRequest) {
+  ContinuousBatchingConfig config;
+  config.max_step_tokens = 8;
+  ToyModel model(config.max_batch_size);
+  ContinuousBatchingScheduler scheduler(config, StepOf(&model));
+  EXPECT_ANY_THROW(scheduler.Submit(MakeRequest(0, 0, 4)));
+  EXPECT_ANY_THROW(scheduler.Submit(MakeRequest(0, 9, 4)));
+  EXPECT_ANY_THROW(scheduler.Submit(MakeRequest(0, 4, 0)));
+  EXPECT_EQ(scheduler.NumWaiting(), 0UL);
+}
+
+// The requests of a failed step get its exception, the later ones still run.
+TEST(ContinuousBatching, StepError) {
+  ContinuousBatchingConfig config;
+  config.max_batch_size = 1;
+  ToyModel model(config.max_batch_size);
+  int steps = 0;
+  ContinuousBatchingScheduler scheduler(
+      config, [&](const DecodeBatch& batch, std::vector<int64_t>* next) {
+        if (++steps == 2) throw std::runtime_error("step failed");
+        model.Step(batch, next);
+      });
+  auto failed = scheduler.Submit(MakeRequest(0, 3, 4));
+  auto request = MakeRequest(1, 3, 4);
+  auto succeeded = scheduler.Submit(request);
+  while (scheduler.Step()) {
+  }
+  EXPECT_THROW(failed.get(), std::runtime_error);
+  EXPECT_EQ(succeeded.get().tokens, Generate(request));
+}
+
+TEST(ContinuousBatching, DestroyedBeforeFinished) {
+  ContinuousBatchingConfig config;
+  config.max_batch_size = 1;
+  ToyModel model(config.max_batch_size);
+  std::future<GenerationResult> active, waiting;
+  {
+    ContinuousBatchingScheduler scheduler(config, StepOf(&model));
+    active = scheduler.Submit(MakeRequest(0, 3, 4));
+    waiting = scheduler.Submit(MakeRequest(1, 3, 4));
+    scheduler.Step();
+  }
+  EXPECT_THROW(active.get(), std::runtime_error);
+  EXPECT_THROW(waiting.get(), std::runtime_error);
+}
+
+// A decoding output, in place of the output handle of a predictor.
+struct FakeOutput {
+  DataType type() const { return dtype; }
+  std::vector<int> shape() const { return dims; }
+  void CopyToCpu(int64_t* data) const {
+    std::copy(next_tokens.begin(), next_tokens.end(), data);
+  }
+  void CopyToCpu(float* data) const {
+    std::copy(logits.begin(), logits.end(), data);
+  }
+
+  DataType dtype{DataType::FLOAT32};
+  std::vector<int> dims;
+  std::vector<int64_t> next_tokens;
+  std::vector<float> logits;
+};
+
+// Two rows in decode and a prompt of 3 tokens, in 5 tokens.
+DecodeBatch MixedBatch() {
+  DecodeBatch batch;
+  batch.token_ids = {11, 22, 30, 31, 32};
+  batch.token_offsets = {0, 1, 2, 5};
+  batch.positions = {7, 4, 0};
+  batch.cache_slots = {2, 0, 1};
+  return batch;
+}
+
+// Logits whose greedy token is `tokens[i]` at row i.
+std::vector<float> OneHot(const std::vector<int64_t>& tokens, int vocab) {
+  std::vector<float> logits(tokens.size() * vocab, 0.0f);
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    logits[i * vocab + tokens[i]] = 1.0f;
+  }
+  return logits;
+}
+
+TEST(PredictorDecodeStep, PositionIds) {
+  EXPECT_EQ(details::DecodePositionIds(MixedBatch()),
+            (std::vector<int64_t>{7, 4, 0, 1, 2}));
+}
+
+TEST(PredictorDecodeStep, NextTokens) {
+  const DecodeBatch batch = MixedBatch();
+  FakeOutput output;
+  output.dtype = DataType::INT64;
+  output.dims = {3};
+  output.next_tokens = {5, 6, 7};
+  std::vector<int64_t> next;
+  details::ReadNextTokens(batch, "next_tokens", &output, &next);
+  EXPECT_EQ(next, output.next_tokens);
+
+  output.dims = {5};
+  EXPECT_ANY_THROW(
+      details::ReadNextTokens(batch, "next_tokens", &output, &next));
+}
+
+TEST(PredictorDecodeStep, RowLogits) {
+  FakeOutput output;
+  output.dims = {3, 4};
+  output.logits = OneHot({3, 0, 2}, 4);
+  std::vector<int64_t> next;
+  details::ReadNextTokens(MixedBatch(), "logits", &output, &next);
+  EXPECT_EQ(next, (std::vector<int64_t>{3, 0, 2}));
+}
+
+// Only the last token of each row is decoded.
+TEST(PredictorDecodeStep, TokenLogits) {
+  FakeOutput output;
+  output.dims = {5, 4};
+  output.logits = OneHot({3, 0, 1, 1, 2}, 4);
+  std::vector<int64_t> next;
+  details::ReadNextTokens(MixedBatch(), "logits", &output, &next);
+  EXPECT_EQ(next, (std::vector<int64_t>{3, 0, 2}));
+}
+
+TEST(PredictorDecodeStep, InvalidOutput) {
+  FakeOutput output;
+  output.dims = {4, 4};
+  output.logits = OneHot({0, 1, 2, 3}, 4);
+  std::vector<int64_t> next;
+  EXPECT_ANY_THROW(
+      details::ReadNextTokens(MixedBatch(), "logits", &output, &next));
+  output.dtype = DataType::INT32;
+  output.dims = {3};
+  EXPECT_ANY_THROW(
+      details::ReadNextTokens(MixedBatch(), "logits", &output, &next));
+}
+
+}  // namespace paddle_infer
@@ -0,0 +1,66 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/inference/api/shared_weight_store.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "paddle/phi/common/place.h"
+
+namespace paddle {
+
+std::unique_ptr<phi::DenseTensor> MakeWeight(float value, int64_t numel) {
+  auto tensor = std::make_unique<phi::DenseTensor>();
+  tensor->Resize({numel});
+  float* data = tensor->mutable_data<float>(phi::CPUPlace());
+  for (int64_t i = 0; i < numel; ++i) data[i] = value + i;
+  return tensor;
+}
+
+TEST(SharedWeightStore, deduplicate) {
+  SharedWeightStore store;
+  auto a = MakeWeight(1.0f, 256);
+  auto b = MakeWeight(1.0f, 256);
+  auto c = MakeWeight(2.0f, 256);
+  auto d = MakeWeight(1.0f, 128);
+
+  EXPECT_FALSE(store.Deduplicate(a.get()));
+  EXPECT_TRUE(store.Deduplicate(b.get()));
+  EXPECT_EQ(a->data<float>(), b->data<float>());
+  EXPECT_FALSE(store.Deduplicate(c.get()));
+  EXPECT_FALSE(store.Deduplicate(d.get()));
+  // a tensor already in the store is not shared with itself
+  EXPECT_FALSE(store.Deduplicate(a.get()));
+
+  auto stats = store.GetStats();
+  EXPECT_EQ(stats.tensors, 3UL);
+  EXPECT_EQ(stats.bytes, (256 + 256 + 128) * sizeof(float));
+  EXPECT_EQ(stats.shared_tensors, 1UL);
+  EXPECT_EQ(stats.saved_bytes, 256 * sizeof(float));
+
+  // the shared weight lives until the last of its holders
+  a.reset();
+  stats = store.GetStats();
+  EXPECT_EQ(stats.tensors, 3UL);
+  EXPECT_EQ(stats.shared_tensors, 0UL);
+  EXPECT_EQ(b->data<float>()[1], 2.0f);
+  b.reset();
+  c.reset();
+  stats = store.GetStats();
+  EXPECT_EQ(stats.tensors, 1UL);
+  EXPECT_EQ(stats.bytes, 128 * sizeof(float));
+}
+
+}  // namespace paddle
@@ -17,10 +17,12 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <memory>
 #include <string>
 
+#include "paddle/fluid/framework/new_executor/interpreter/build_cache.h"
 #include "paddle/fluid/framework/new_executor/interpreter/plan.h"
 #include "paddle/phi/core/kernel_registry.h"
 
@@ -103,6 +105,8 @@ PD_DECLARE_KERNEL(cross_entropy_with_softmax_grad, GPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sqrt, GPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(add_n, GPU, ALL_LAYOUT);
 
+PD_DECLARE_bool(new_executor_cpu_replay);
+
 namespace paddle {
 namespace framework {
 
@@ -301,5 +305,144 @@ TEST(InterpreterCore, workqueue_multiplexing) {
       program, {"a", "b"}, {tensor_a, tensor_b}, {"c"}, {0.0, 1.1, 2.2, 3.3});
 }
 
+// Sets FLAGS_new_executor_cpu_replay for a scope, and restores it when an
+// assertion leaves the test early as well.
+class CpuReplayFlagGuard {
+ public:
+  explicit CpuReplayFlagGuard(bool value)
+      : old_value_(FLAGS_new_executor_cpu_replay) {
+    FLAGS_new_executor_cpu_replay = value;
+  }
+  ~CpuReplayFlagGuard() { FLAGS_new_executor_cpu_replay = old_value_; }
+
+ private:
+  bool old_value_;
+};
+
+TEST(InterpreterCore, cpu_replay) {
+  ProgramDesc program;
+  BlockDesc* main_block = program.MutableBlock(0);
+  for (auto* name : {"a", "b", "c", "d"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+
+  OpDesc* add = main_block->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"a"});
+  add->SetInput("Y", {"b"});
+  add->SetOutput("Out", {"c"});
+  OpDesc* mul = main_block->AppendOp();
+  mul->SetType("elementwise_mul");
+  mul->SetInput("X", {"c"});
+  mul->SetInput("Y", {"b"});
+  mul->SetOutput("Out", {"d"});
+
+  CpuReplayFlagGuard cpu_replay_guard(true);
+  const platform::CPUPlace place = platform::CPUPlace();
+  Scope scope;
+  interpreter::ExecutionConfig execution_config;
+  execution_config.used_for_inference = true;
+  execution_config.skip_gc_vars = {"d"};
+  std::shared_ptr<InterpreterCore> core = std::make_shared<InterpreterCore>(
+      place, program.Block(0), &scope, execution_config);
+
+  // the first run records the replay, the later ones replay it, also with
+  // a new shape
+  for (int64_t rows : {2, 2, 3, 2}) {
+    phi::DDim dims = common::make_ddim({rows, 2});
+    phi::DenseTensor tensor_a, tensor_b;
+    float* data_a = tensor_a.mutable_data<float>(dims, place);
+    float* data_b = tensor_b.mutable_data<float>(dims, place);
+    for (int64_t i = 0; i < rows * 2; ++i) {
+      data_a[i] = static_cast<float>(i + rows);
+      data_b[i] = 0.5f * static_cast<float>(i);
+    }
+    core->Run({"a", "b"}, {tensor_a, tensor_b});
+
+    const Scope* run_scope =
+        scope.kids().empty() ? &scope : scope.kids().back();
+    const auto& d = run_scope->FindVar("d")->Get<phi::DenseTensor>();
+    ASSERT_EQ(d.dims(), dims);
+    for (int64_t i = 0; i < rows * 2; ++i) {
+      ASSERT_FLOAT_EQ(d.data<float>()[i], (data_a[i] + data_b[i]) * data_b[i]);
+    }
+  }
+}
+
+TEST(InterpreterCore, build_cache) {
+  ProgramDesc program;
+  BlockDesc* main_block = program.MutableBlock(0);
+  for (auto* name : {"a", "b", "c", "d"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  OpDesc* add = main_block->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"a"});
+  add->SetInput("Y", {"b"});
+  add->SetOutput("Out", {"c"});
+  OpDesc* mul = main_block->AppendOp();
+  mul->SetType("elementwise_mul");
+  mul->SetInput("X", {"c"});
+  mul->SetInput("Y", {"b"});
+  mul->SetOutput("Out", {"d"});
+
+  const std::string cache_path = "standalone_executor_test.executor_build";
+  std::remove(cache_path.c_str());
+  const platform::CPUPlace place = platform::CPUPlace();
+  phi::DDim dims = common::make_ddim({2, 2});
+  phi::DenseTensor tensor_a, tensor_b;
+  std::array<float, 4> data_a = {0, 1, 2, 3};
+  std::array<float, 4> data_b = {1, 2, 3, 4};
+  std::copy_n(data_a.data(), 4, tensor_a.mutable_data<float>(dims, place));
+  std::copy_n(data_b.data(), 4, tensor_b.mutable_data<float>(dims, place));
+
+  // the first interpreter saves its build results, the second loads them
+  for (int i = 0; i < 2; ++i) {
+    Scope scope;
+    interpreter::ExecutionConfig execution_config;
+    execution_config.skip_gc_vars = {"d"};
+    execution_config.build_cache_path = cache_path;
+    std::shared_ptr<InterpreterCore> core = std::make_shared<InterpreterCore>(
+        place, program.Block(0), &scope, execution_config);
+    core->Run({"a", "b"}, {tensor_a, tensor_b});
+
+    interpreter::ProgramBuildCache build_cache;
+    ASSERT_TRUE(build_cache.Load(cache_path));
+    ASSERT_EQ(build_cache.op_num, 2UL);
+    ASSERT_EQ(build_cache.trace_execute_order.size(), 2UL);
+
+    const Scope* run_scope =
+        scope.kids().empty() ? &scope : scope.kids().back();
+    const auto& d = run_scope->FindVar("d")->Get<phi::DenseTensor>();
+    for (int64_t j = 0; j < 4; ++j) {
+      ASSERT_FLOAT_EQ(d.data<float>()[j], (data_a[j] + data_b[j]) * data_b[j]);
+    }
+  }
+  std::remove(cache_path.c_str());
+}
+
+// An op index equal to op_num is out of range and rejects the file.
+TEST(InterpreterCore, build_cache_index_range) {
+  const std::string cache_path = "standalone_executor_test.index_range";
+  interpreter::ProgramBuildCache build_cache;
+  build_cache.op_num = 2;
+  build_cache.op_happens_before.assign(2, std::vector<bool>(2, false));
+  build_cache.op_downstream_map[0] = {1};
+  build_cache.trace_execute_order = {0, 1};
+  ASSERT_TRUE(build_cache.Save(cache_path));
+  interpreter::ProgramBuildCache loaded;
+  EXPECT_TRUE(loaded.Load(cache_path));
+
+  build_cache.trace_execute_order = {0, 2};
+  ASSERT_TRUE(build_cache.Save(cache_path));
+  EXPECT_FALSE(loaded.Load(cache_path));
+
+  build_cache.trace_execute_order = {0, 1};
+  build_cache.op_downstream_map[0] = {2};
+  ASSERT_TRUE(build_cache.Save(cache_path));
+  EXPECT_FALSE(loaded.Load(cache_path));
+  std::remove(cache_path.c_str());
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,154 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/core/distributed/gloo_allreduce.h"
+
+#include <gloo/rendezvous/context.h>
+#include <gloo/rendezvous/hash_store.h>
+#include <gloo/rendezvous/prefix_store.h>
+#include <gloo/transport/tcp/device.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/phi/common/reduce_type.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "test/cpp/phi/core/allocator.h"
+
+namespace phi {
+namespace tests {
+
+using distributed::GlooAllReduceAlgo;
+using distributed::GlooAllReducer;
+using distributed::GlooTopology;
+
+// hosts[h] lists the ranks of host h, in order
+GlooTopology MakeTopology(int rank,
+                          const std::vector<std::vector<int>>& hosts,
+                          const std::string& shm_prefix) {
+  GlooTopology topology;
+  topology.num_nodes = static_cast<int>(hosts.size());
+  for (size_t h = 0; h < hosts.size(); ++h) {
+    topology.leaders.push_back(hosts[h][0]);
+    auto it = std::find(hosts[h].begin(), hosts[h].end(), rank);
+    if (it != hosts[h].end()) {
+      topology.local_ranks = hosts[h];
+      topology.local_rank = static_cast<int>(it - hosts[h].begin());
+      topology.shm_prefix = shm_prefix + "_" + std::to_string(h);
+    }
+  }
+  return topology;
+}
+
+float RankValue(int rank, size_t i) {
+  return static_cast<float>((rank + 1) * 1000 + i % 997);
+}
+
+// Runs one all-reduce of every size on `nranks` threads, each rank with its
+// own gloo context over loopback, and checks the sum on every rank.
+void CheckAllReduce(GlooAllReduceAlgo algo,
+                    const std::vector<std::vector<int>>& hosts,
+                    const std::string& name) {
+  int nranks = 0;
+  for (const auto& host : hosts) nranks += static_cast<int>(host.size());
+  const std::vector<size_t> numels = {1, 2, 7, 1000, 100003};
+  gloo::rendezvous::HashStore store;
+  gloo::transport::tcp::attr attr;
+  attr.hostname = "127.0.0.1";
+  auto device = gloo::transport::tcp::CreateDevice(attr);
+  const std::string shm_prefix =
+      "/paddle_gloo_test_" + std::to_string(::getpid()) + "_" + name;
+
+  std::vector<std::vector<std::vector<float>>> results(nranks);
+  std::vector<std::thread> threads;
+  for (int rank = 0; rank < nranks; ++rank) {
+    threads.emplace_back([&, rank] {
+      gloo::rendezvous::PrefixStore prefix_store(name, store);
+      auto context =
+          std::make_shared<gloo::rendezvous::Context>(rank, nranks);
+      context->connectFullMesh(prefix_store, device);
+      GlooAllReducer reducer(context, MakeTopology(rank, hosts, shm_prefix));
+      auto allocator = std::make_unique<FancyAllocator>();
+      uint32_t tag = 0;
+      for (size_t numel : numels) {
+        const int64_t dim = static_cast<int64_t>(numel);
+        DenseTensor tensor(
+            allocator.get(),
+            DenseTensorMeta(DataType::FLOAT32, common::make_ddim({dim})));
+        float* data = tensor.data<float>();
+        for (size_t i = 0; i < numel; ++i) data[i] = RankValue(rank, i);
+        reducer.Run(algo,
+                    &tensor,
+                    tensor,
+                    static_cast<int>(ReduceType::kRedSum),
+                    tag++);
+        results[rank].emplace_back(data, data + numel);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (int rank = 0; rank < nranks; ++rank) {
+    for (size_t n = 0; n < numels.size(); ++n) {
+      const auto& result = results[rank][n];
+      ASSERT_EQ(result.size(), numels[n]);
+      for (size_t i = 0; i < numels[n]; ++i) {
+        float expected = 0.0f;
+        for (int r = 0; r < nranks; ++r) expected += RankValue(r, i);
+        ASSERT_EQ(result[i], expected)
+            << name << ": rank " << rank << ", numel " << numels[n]
+            << ", element " << i;
+      }
+    }
+  }
+}
+
+std::vector<std::vector<int>> OneRankPerHost(int nranks) {
+  std::vector<std::vector<int>> hosts;
+  for (int rank = 0; rank < nranks; ++rank) hosts.push_back({rank});
+  return hosts;
+}
+
+// 3 and 5 ranks take the fold and unfold steps of recursive doubling and
+// uneven ring chunks.
+TEST(GlooAllReducer, RecursiveDoubling) {
+  for (int nranks : {2, 3, 4, 5}) {
+    CheckAllReduce(GlooAllReduceAlgo::kRecursiveDoubling,
+                   OneRankPerHost(nranks),
+                   "rd" + std::to_string(nranks));
+  }
+}
+
+TEST(GlooAllReducer, Ring) {
+  for (int nranks : {2, 3, 5}) {
+    CheckAllReduce(GlooAllReduceAlgo::kRing,
+                   OneRankPerHost(nranks),
+                   "ring" + std::to_string(nranks));
+  }
+}
+
+// Hosts of different sizes, so the leaders are 2 and 3 ranks.
+TEST(GlooAllReducer, Hierarchical) {
+  CheckAllReduce(GlooAllReduceAlgo::kHierarchical, {{0, 1}, {2}}, "hier3");
+  CheckAllReduce(
+      GlooAllReduceAlgo::kHierarchical, {{0, 1}, {2, 3}, {4}}, "hier5");
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,240 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/conv_cpu_direct.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/common/flags.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/kernels/conv_kernel.h"
+
+COMMON_DECLARE_bool(conv_cpu_native_algo);
+
+namespace phi {
+namespace tests {
+
+using funcs::Conv2dCpuShape;
+using funcs::ConvCpuAlgo;
+
+Conv2dCpuShape MakeShape(int batch,
+                         int in_c,
+                         int out_c,
+                         int hw,
+                         int k,
+                         int stride,
+                         int pad,
+                         int dilation,
+                         int groups) {
+  Conv2dCpuShape s;
+  s.batch = batch;
+  s.in_channels = in_c;
+  s.in_h = hw;
+  s.in_w = hw + 3;
+  s.out_channels = out_c;
+  s.filter_h = k;
+  s.filter_w = k;
+  s.stride_h = stride;
+  s.stride_w = stride;
+  s.pad_top = pad;
+  s.pad_left = pad;
+  s.dilation_h = dilation;
+  s.dilation_w = dilation;
+  s.groups = groups;
+  const int extent = dilation * (k - 1) + 1;
+  s.out_h = (s.in_h + 2 * pad - extent) / stride + 1;
+  s.out_w = (s.in_w + 2 * pad - extent) / stride + 1;
+  return s;
+}
+
+// Direct convolution in double, the reference for every algorithm.
+std::vector<double> ReferenceConv(const Conv2dCpuShape& s,
+                                  const std::vector<double>& in,
+                                  const std::vector<double>& w) {
+  const int in_step = s.in_channels / s.groups;
+  const int out_step = s.out_channels / s.groups;
+  std::vector<double> out(
+      static_cast<size_t>(s.batch) * s.out_channels * s.out_h * s.out_w, 0);
+  for (int n = 0; n < s.batch; ++n) {
+    for (int oc = 0; oc < s.out_channels; ++oc) {
+      const int g = oc / out_step;
+      for (int oh = 0; oh < s.out_h; ++oh) {
+        for (int ow = 0; ow < s.out_w; ++ow) {
+          double acc = 0;
+          for (int c = 0; c < in_step; ++c) {
+            const int ic = g * in_step + c;
+            for (int kh = 0; kh < s.filter_h; ++kh) {
+              const int ih = oh * s.stride_h - s.pad_top + kh * s.dilation_h;
+              if (ih < 0 || ih >= s.in_h) continue;
+              for (int kw = 0; kw < s.filter_w; ++kw) {
+                const int iw =
+                    ow * s.stride_w - s.pad_left + kw * s.dilation_w;
+                if (iw < 0 || iw >= s.in_w) continue;
+                acc += in[((n * s.in_channels + ic) * s.in_h + ih) * s.in_w +
+                          iw] *
+                       w[((oc * in_step + c) * s.filter_h + kh) * s.filter_w +
+                         kw];
+              }
+            }
+          }
+          out[((n * s.out_channels + oc) * s.out_h + oh) * s.out_w + ow] =
+              acc;
+        }
+      }
+    }
+  }
+  return out;
+}
+
+template <typename T>
+void CheckAlgo(const Conv2dCpuShape& s, ConvCpuAlgo algo, double tol) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> in(static_cast<size_t>(s.batch) * s.in_channels *
+                         s.in_h * s.in_w);
+  std::vector<double> w(static_cast<size_t>(s.out_channels) *
+                        (s.in_channels / s.groups) * s.filter_h * s.filter_w);
+  for (auto& v : in) v = dist(rng);
+  for (auto& v : w) v = dist(rng);
+  std::vector<T> in_t(in.begin(), in.end());
+  std::vector<T> w_t(w.begin(), w.end());
+  std::vector<T> out(
+      static_cast<size_t>(s.batch) * s.out_channels * s.out_h * s.out_w);
+
+  ASSERT_EQ(funcs::SelectConvCpuAlgo(s), algo);
+  auto* dev_ctx = static_cast<phi::CPUContext*>(
+      phi::DeviceContextPool::Instance().Get(phi::CPUPlace()));
+  if (algo == ConvCpuAlgo::kDepthwise) {
+    funcs::DepthwiseConv2dDirect<T>(s, in_t.data(), w_t.data(), out.data());
+  } else {
+    funcs::WinogradConv2d<T>(*dev_ctx,
+                             s,
+                             algo == ConvCpuAlgo::kWinogradF43 ? 4 : 2,
+                             in_t.data(),
+                             w_t.data(),
+                             out.data());
+  }
+  auto ref = ReferenceConv(s, in, w);
+  for (size_t i = 0; i < ref.size(); ++i) {
+    ASSERT_NEAR(out[i], ref[i], tol) << "at " << i;
+  }
+}
+
+TEST(ConvCpuDirect, Winograd) {
+  // output sizes that are not a multiple of the tile, with padding
+  CheckAlgo<double>(
+      MakeShape(2, 8, 12, 7, 3, 1, 1, 1, 1), ConvCpuAlgo::kWinogradF23, 1e-10);
+  CheckAlgo<double>(MakeShape(1, 16, 8, 25, 3, 1, 0, 1, 1),
+                    ConvCpuAlgo::kWinogradF43,
+                    1e-10);
+  CheckAlgo<float>(MakeShape(2, 32, 16, 30, 3, 1, 1, 1, 1),
+                   ConvCpuAlgo::kWinogradF43,
+                   1e-3);
+  // more tiles than one block
+  CheckAlgo<float>(MakeShape(1, 8, 8, 70, 3, 1, 1, 1, 1),
+                   ConvCpuAlgo::kWinogradF43,
+                   1e-3);
+}
+
+TEST(ConvCpuDirect, Depthwise) {
+  CheckAlgo<double>(
+      MakeShape(2, 6, 6, 11, 3, 1, 1, 1, 6), ConvCpuAlgo::kDepthwise, 1e-10);
+  CheckAlgo<double>(
+      MakeShape(1, 4, 8, 17, 5, 2, 2, 1, 4), ConvCpuAlgo::kDepthwise, 1e-10);
+  CheckAlgo<float>(
+      MakeShape(2, 5, 5, 16, 3, 2, 3, 2, 5), ConvCpuAlgo::kDepthwise, 1e-5);
+}
+
+TEST(ConvCpuDirect, Fallback) {
+  EXPECT_EQ(funcs::SelectConvCpuAlgo(MakeShape(1, 3, 16, 32, 3, 1, 1, 1, 1)),
+            ConvCpuAlgo::kIm2Col);
+  // too few tiles to pay for the filter transform
+  EXPECT_EQ(
+      funcs::SelectConvCpuAlgo(MakeShape(1, 256, 256, 14, 3, 1, 1, 1, 1)),
+      ConvCpuAlgo::kIm2Col);
+  EXPECT_EQ(funcs::SelectConvCpuAlgo(MakeShape(1, 16, 16, 32, 3, 2, 1, 1, 1)),
+            ConvCpuAlgo::kIm2Col);
+  EXPECT_EQ(funcs::SelectConvCpuAlgo(MakeShape(1, 16, 16, 32, 1, 1, 0, 1, 1)),
+            ConvCpuAlgo::kIm2Col);
+  EXPECT_EQ(funcs::SelectConvCpuAlgo(MakeShape(1, 16, 16, 32, 3, 1, 1, 1, 2)),
+            ConvCpuAlgo::kIm2Col);
+}
+
+// conv2d with the native algorithms against im2col + GEMM, the timings are
+// logged rather than asserted on. Disabled in CI, run it with
+// --gtest_also_run_disabled_tests.
+TEST(ConvCpuDirect, DISABLED_Benchmark) {
+  auto* dev_ctx = static_cast<phi::CPUContext*>(
+      phi::DeviceContextPool::Instance().Get(phi::CPUPlace()));
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  struct Case {
+    int in_c, out_c, hw, k, stride, groups;
+  };
+  for (const Case& c : {Case{64, 64, 56, 3, 1, 1},
+                        Case{128, 128, 28, 3, 1, 1},
+                        Case{32, 32, 112, 3, 1, 32},
+                        Case{256, 256, 14, 3, 2, 256}}) {
+    DenseTensor x, w;
+    x.Resize({1, c.in_c, c.hw, c.hw});
+    w.Resize({c.out_c, c.in_c / c.groups, c.k, c.k});
+    float* x_data = dev_ctx->Alloc<float>(&x);
+    float* w_data = dev_ctx->Alloc<float>(&w);
+    for (int64_t i = 0; i < x.numel(); ++i) x_data[i] = dist(rng);
+    for (int64_t i = 0; i < w.numel(); ++i) w_data[i] = dist(rng);
+    const int out_hw = (c.hw + 2 - c.k) / c.stride + 1;
+
+    int64_t us[2];
+    DenseTensor out[2];
+    for (int native = 0; native < 2; ++native) {
+      FLAGS_conv_cpu_native_algo = native;
+      out[native].Resize({1, c.out_c, out_hw, out_hw});
+      auto run = [&] {
+        ConvKernel<float, phi::CPUContext>(*dev_ctx,
+                                           x,
+                                           w,
+                                           {c.stride, c.stride},
+                                           {1, 1},
+                                           "EXPLICIT",
+                                           {1, 1},
+                                           c.groups,
+                                           "NCHW",
+                                           &out[native]);
+      };
+      run();
+      auto start = std::chrono::steady_clock::now();
+      const int repeat = 5;
+      for (int r = 0; r < repeat; ++r) run();
+      us[native] = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count() /
+                   repeat;
+    }
+    FLAGS_conv_cpu_native_algo = true;
+    for (int64_t i = 0; i < out[0].numel(); ++i) {
+      ASSERT_NEAR(out[0].data<float>()[i], out[1].data<float>()[i], 1e-3);
+    }
+    LOG(INFO) << "conv " << c.in_c << "->" << c.out_c << " " << c.hw << "x"
+              << c.hw << " k" << c.k << " s" << c.stride << " g" << c.groups
+              << ": im2col " << us[0] << " us, native " << us[1] << " us";
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
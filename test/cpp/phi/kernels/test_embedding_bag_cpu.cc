@@ -0,0 +1,222 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/embedding_bag_cpu.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/phi/common/float16.h"
+
+namespace phi {
+namespace tests {
+
+using funcs::EmbeddingBagMode;
+
+// Random bags of 0 to 2 * mean_len ids over rows, with padding_idx
+// sprinkled in unless it is negative.
+void MakeBags(int64_t bags,
+              int64_t rows,
+              int mean_len,
+              int64_t padding_idx,
+              std::mt19937* rng,
+              std::vector<int64_t>* ids,
+              std::vector<int64_t>* offsets) {
+  std::uniform_int_distribution<int> len_dist(0, 2 * mean_len);
+  std::uniform_int_distribution<int64_t> id_dist(0, rows - 1);
+  offsets->assign(1, 0);
+  ids->clear();
+  for (int64_t b = 0; b < bags; ++b) {
+    const int len = len_dist(*rng);
+    for (int i = 0; i < len; ++i) {
+      const bool pad = padding_idx >= 0 && i % 7 == 3;
+      ids->push_back(pad ? padding_idx : id_dist(*rng));
+    }
+    offsets->push_back(static_cast<int64_t>(ids->size()));
+  }
+}
+
+// Gathers then pools in double.
+std::vector<double> ReferenceBag(const std::vector<double>& table,
+                                 int64_t dim,
+                                 const std::vector<int64_t>& ids,
+                                 const std::vector<int64_t>& offsets,
+                                 EmbeddingBagMode mode,
+                                 int64_t padding_idx) {
+  const int64_t bags = static_cast<int64_t>(offsets.size()) - 1;
+  std::vector<double> out(bags * dim, 0.0);
+  for (int64_t b = 0; b < bags; ++b) {
+    int64_t count = 0;
+    for (int64_t i = offsets[b]; i < offsets[b + 1]; ++i) {
+      if (ids[i] == padding_idx) continue;
+      for (int64_t k = 0; k < dim; ++k) {
+        const double v = table[ids[i] * dim + k];
+        double& o = out[b * dim + k];
+        o = mode == EmbeddingBagMode::kMax
+                ? (count == 0 ? v : std::max(o, v))
+                : o + v;
+      }
+      ++count;
+    }
+    if (mode == EmbeddingBagMode::kMean && count > 0) {
+      for (int64_t k = 0; k < dim; ++k) out[b * dim + k] /= count;
+    }
+  }
+  return out;
+}
+
+// table_values holds the value of each table entry after conversion, so
+// the reference sees the same rounding as the kernel.
+template <typename T>
+void CheckBag(int64_t rows,
+              int64_t dim,
+              int64_t bags,
+              int mean_len,
+              bool with_scale,
+              double tol) {
+  std::mt19937 rng(rows + dim + bags);
+  std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+  std::vector<T> table(rows * dim);
+  std::vector<double> table_values(rows * dim);
+  std::vector<float> scale(rows);
+  for (auto& s : scale) s = with_scale ? dist(rng) : 1.0f;
+  for (int64_t i = 0; i < rows * dim; ++i) {
+    if (std::is_same<T, int8_t>::value) {
+      table[i] = static_cast<T>(static_cast<int>(dist(rng) * 60));
+    } else {
+      table[i] = static_cast<T>(dist(rng));
+    }
+    table_values[i] = static_cast<double>(static_cast<float>(table[i])) *
+                      scale[i / dim];
+  }
+  const int64_t padding_idx = rows / 2;
+  std::vector<int64_t> ids, offsets;
+  MakeBags(bags, rows, mean_len, padding_idx, &rng, &ids, &offsets);
+
+  std::vector<funcs::EmbeddingBagAccType<T>> out(bags * dim);
+  for (auto mode : {EmbeddingBagMode::kSum,
+                    EmbeddingBagMode::kMean,
+                    EmbeddingBagMode::kMax}) {
+    funcs::EmbeddingBagCPU<T, int64_t>(table.data(),
+                                       dim,
+                                       with_scale ? scale.data() : nullptr,
+                                       ids.data(),
+                                       static_cast<int64_t>(ids.size()),
+                                       offsets.data(),
+                                       bags,
+                                       mode,
+                                       padding_idx,
+                                       out.data());
+    auto ref = ReferenceBag(table_values, dim, ids, offsets, mode, padding_idx);
+    for (size_t i = 0; i < ref.size(); ++i) {
+      ASSERT_NEAR(out[i], ref[i], tol)
+          << "at " << i << " mode " << static_cast<int>(mode);
+    }
+  }
+}
+
+TEST(EmbeddingBagCPU, Float) {
+  // dim 100 spans two column blocks, 3000 bags of ~20 ids several tasks
+  CheckBag<float>(1000, 100, 50, 5, false, 1e-4);
+  CheckBag<float>(5000, 16, 3000, 20, false, 1e-4);
+  CheckBag<double>(300, 70, 40, 10, false, 1e-10);
+}
+
+TEST(EmbeddingBagCPU, LowPrecision) {
+  CheckBag<int8_t>(1000, 32, 200, 10, true, 1e-3);
+  CheckBag<phi::dtype::float16>(1000, 40, 200, 10, false, 1e-3);
+}
+
+TEST(EmbeddingBagCPU, EmptyBags) {
+  std::vector<float> table = {1, 2, 3, 4};
+  std::vector<int64_t> ids = {1, 0, 1};
+  std::vector<int64_t> offsets = {0, 0, 3, 3};
+  std::vector<float> out(6, -1.0f);
+  funcs::EmbeddingBagCPU<float, int64_t>(table.data(),
+                                         2,
+                                         nullptr,
+                                         ids.data(),
+                                         3,
+                                         offsets.data(),
+                                         3,
+                                         EmbeddingBagMode::kMax,
+                                         -1,
+                                         out.data());
+  EXPECT_EQ(out, (std::vector<float>{0, 0, 3, 4, 0, 0}));
+}
+
+// The fused kernel against a row-by-row lookup followed by a sum pool, the
+// timings are logged rather than asserted on.
+TEST(EmbeddingBagCPU, Benchmark) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  const int64_t rows = 1 << 20;
+  for (int64_t dim : {16, 64}) {
+    std::vector<float> table(rows * dim);
+    for (auto& v : table) v = dist(rng);
+    std::vector<int64_t> ids, offsets;
+    MakeBags(4096, rows, 50, -1, &rng, &ids, &offsets);
+    const int64_t num_ids = static_cast<int64_t>(ids.size());
+    const int64_t bags = static_cast<int64_t>(offsets.size()) - 1;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<float> lookup(num_ids * dim);
+    for (int64_t i = 0; i < num_ids; ++i) {
+      std::memcpy(lookup.data() + i * dim,
+                  table.data() + ids[i] * dim,
+                  dim * sizeof(float));
+    }
+    std::vector<float> pooled(bags * dim, 0.0f);
+    for (int64_t b = 0; b < bags; ++b) {
+      for (int64_t i = offsets[b]; i < offsets[b + 1]; ++i) {
+        for (int64_t k = 0; k < dim; ++k) {
+          pooled[b * dim + k] += lookup[i * dim + k];
+        }
+      }
+    }
+    auto unfused_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+
+    std::vector<float> out(bags * dim);
+    start = std::chrono::steady_clock::now();
+    funcs::EmbeddingBagCPU<float, int64_t>(table.data(),
+                                           dim,
+                                           nullptr,
+                                           ids.data(),
+                                           num_ids,
+                                           offsets.data(),
+                                           bags,
+                                           EmbeddingBagMode::kSum,
+                                           -1,
+                                           out.data());
+    auto fused_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    for (size_t i = 0; i < out.size(); ++i) {
+      ASSERT_NEAR(out[i], pooled[i], 1e-3);
+    }
+    LOG(INFO) << "embedding bag " << num_ids << " ids dim " << dim
+              << ": lookup + pool " << unfused_us << " us, fused " << fused_us
+              << " us";
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
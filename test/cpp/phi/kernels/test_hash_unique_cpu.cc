@@ -0,0 +1,194 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/hash_unique_cpu.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace phi {
+namespace tests {
+
+using funcs::HashUniqueOrder;
+
+template <typename T>
+std::vector<T> MakeKeys(int64_t n, int64_t distinct, std::mt19937_64* rng) {
+  std::uniform_int_distribution<int64_t> dist(0, distinct - 1);
+  std::vector<T> keys(n);
+  for (auto& k : keys) {
+    // spread out, negative for signed types
+    k = static_cast<T>(dist(*rng) * 2654435761LL - distinct);
+  }
+  return keys;
+}
+
+template <typename T, typename IndexT>
+void CheckUnique(int64_t n, int64_t distinct, HashUniqueOrder order) {
+  std::mt19937_64 rng(n + distinct);
+  auto keys = MakeKeys<T>(n, distinct, &rng);
+
+  // the reference: first occurrence order from a hash map
+  std::vector<T> ref_unique;
+  std::vector<IndexT> ref_first, ref_counts, ref_inverse(n);
+  std::unordered_map<T, IndexT> ids;
+  for (int64_t i = 0; i < n; ++i) {
+    auto it = ids.find(keys[i]);
+    if (it == ids.end()) {
+      it = ids.emplace(keys[i], static_cast<IndexT>(ref_unique.size())).first;
+      ref_unique.push_back(keys[i]);
+      ref_first.push_back(static_cast<IndexT>(i));
+      ref_counts.push_back(0);
+    }
+    ref_inverse[i] = it->second;
+    ++ref_counts[it->second];
+  }
+  if (order == HashUniqueOrder::kSorted) {
+    std::vector<int64_t> perm(ref_unique.size());
+    std::iota(perm.begin(), perm.end(), 0);
+    std::sort(perm.begin(), perm.end(), [&](int64_t a, int64_t b) {
+      return ref_unique[a] < ref_unique[b];
+    });
+    std::vector<IndexT> rank(perm.size());
+    std::vector<T> u(perm.size());
+    std::vector<IndexT> f(perm.size()), c(perm.size());
+    for (size_t r = 0; r < perm.size(); ++r) {
+      rank[perm[r]] = static_cast<IndexT>(r);
+      u[r] = ref_unique[perm[r]];
+      f[r] = ref_first[perm[r]];
+      c[r] = ref_counts[perm[r]];
+    }
+    for (auto& v : ref_inverse) v = rank[v];
+    ref_unique.swap(u);
+    ref_first.swap(f);
+    ref_counts.swap(c);
+  }
+
+  std::vector<T> unique;
+  std::vector<IndexT> first, counts, inverse(n);
+  funcs::HashUniqueCPU<T, IndexT>(
+      keys.data(), n, order, &unique, inverse.data(), &first, &counts);
+  EXPECT_EQ(unique, ref_unique);
+  EXPECT_EQ(inverse, ref_inverse);
+  EXPECT_EQ(first, ref_first);
+  EXPECT_EQ(counts, ref_counts);
+
+  // without the optional outputs
+  std::vector<T> unique_only;
+  funcs::HashUniqueCPU<T, IndexT>(
+      keys.data(), n, order, &unique_only, nullptr, nullptr, nullptr);
+  EXPECT_EQ(unique_only, ref_unique);
+}
+
+TEST(HashUniqueCPU, FirstOccurrenceOrder) {
+  const auto order = HashUniqueOrder::kFirstOccurrence;
+  CheckUnique<int64_t, int64_t>(0, 1, order);
+  CheckUnique<int64_t, int64_t>(1, 1, order);
+  CheckUnique<int64_t, int64_t>(1000, 100, order);
+  CheckUnique<int32_t, int32_t>(70000, 30, order);
+  // too many unique keys for one table, partitioned
+  CheckUnique<int64_t, int32_t>(400000, 300000, order);
+  CheckUnique<uint64_t, int64_t>(300000, 3000000, order);
+}
+
+// Partition order: the same unique set, with inverse, first_index and
+// counts consistent with it.
+TEST(HashUniqueCPU, AnyOrder) {
+  std::mt19937_64 rng(7);
+  const int64_t n = 600000;
+  auto keys = MakeKeys<int64_t>(n, 400000, &rng);
+  std::vector<int64_t> unique, first, counts, inverse(n);
+  funcs::HashUniqueCPU<int64_t, int64_t>(keys.data(),
+                                         n,
+                                         HashUniqueOrder::kAny,
+                                         &unique,
+                                         inverse.data(),
+                                         &first,
+                                         &counts);
+  std::unordered_set<int64_t> ref(keys.begin(), keys.end());
+  ASSERT_EQ(unique.size(), ref.size());
+  EXPECT_EQ(std::unordered_set<int64_t>(unique.begin(), unique.end()), ref);
+  std::vector<int64_t> seen(unique.size(), 0);
+  for (int64_t i = 0; i < n; ++i) {
+    ASSERT_EQ(unique[inverse[i]], keys[i]);
+    ++seen[inverse[i]];
+  }
+  EXPECT_EQ(seen, counts);
+  for (size_t u = 0; u < unique.size(); ++u) {
+    ASSERT_EQ(keys[first[u]], unique[u]);
+    ASSERT_EQ(inverse[first[u]], static_cast<int64_t>(u));
+  }
+}
+
+TEST(HashUniqueCPU, Sorted) {
+  CheckUnique<int64_t, int64_t>(1000, 100, HashUniqueOrder::kSorted);
+  CheckUnique<int32_t, int64_t>(200000, 50000, HashUniqueOrder::kSorted);
+  CheckUnique<uint64_t, int32_t>(300000, 3000000, HashUniqueOrder::kSorted);
+}
+
+// Deduplication of a 10M key batch against std::unordered_set and sort +
+// unique, the timings are logged rather than asserted on.
+TEST(HashUniqueCPU, Benchmark) {
+  std::mt19937_64 rng(0);
+  const int64_t n = 10000000;
+  for (int64_t distinct : {100000, 5000000}) {
+    auto keys = MakeKeys<uint64_t>(n, distinct, &rng);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> unique;
+    std::vector<int64_t> inverse(n);
+    funcs::HashUniqueCPU<uint64_t, int64_t>(keys.data(),
+                                            n,
+                                            HashUniqueOrder::kAny,
+                                            &unique,
+                                            inverse.data(),
+                                            nullptr,
+                                            nullptr);
+    auto hash_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    start = std::chrono::steady_clock::now();
+    std::unordered_set<uint64_t> set(keys.begin(), keys.end());
+    auto set_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    auto sort_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    EXPECT_EQ(unique.size(), set.size());
+    EXPECT_EQ(unique.size(), sorted.size());
+    LOG(INFO) << "unique of " << n << " keys, " << unique.size()
+              << " distinct: hash partitioned " << hash_us
+              << " us (with inverse), unordered_set " << set_us
+              << " us, sort " << sort_us << " us";
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,266 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/int8_gemm_cpu.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/kernels/funcs/fc_functor.h"
+#include "paddle/phi/kernels/impl/quant_linear_kernel_impl.h"
+
+namespace phi {
+namespace tests {
+
+using funcs::Int8GemmIsa;
+
+std::vector<Int8GemmIsa> SupportedIsas() {
+  std::vector<Int8GemmIsa> isas = {Int8GemmIsa::kRef};
+  if (funcs::detail::Int8GemmPanelAvx2() != nullptr &&
+      backends::cpu::MayIUse(backends::cpu::avx2)) {
+    isas.push_back(Int8GemmIsa::kAvx2);
+  }
+  if (funcs::detail::Int8GemmPanelAvx512Vnni() != nullptr &&
+      backends::cpu::MayIUse(backends::cpu::avx512_core_vnni)) {
+    isas.push_back(Int8GemmIsa::kAvx512Vnni);
+  }
+  return isas;
+}
+
+void CheckGemm(Int8GemmIsa isa, int m, int k, int n, int low) {
+  std::mt19937 rng(m * 131 + k * 17 + n);
+  std::uniform_int_distribution<int> dist(low, 127);
+  std::vector<int8_t> b(k * n);
+  for (auto& e : b) e = static_cast<int8_t>(dist(rng));
+  funcs::Int8GemmPackedB packed;
+  funcs::PackInt8GemmB(b.data(), k, n, n, &packed);
+  ASSERT_EQ(packed.k_pad % 4, 0);
+  ASSERT_EQ(packed.n_pad % 16, 0);
+
+  std::vector<int8_t> a(m * packed.k_pad, 0);
+  for (int i = 0; i < m; ++i) {
+    for (int kk = 0; kk < k; ++kk) {
+      a[i * packed.k_pad + kk] = static_cast<int8_t>(dist(rng));
+    }
+  }
+  std::vector<int32_t> c(m * packed.n_pad, -1);
+  funcs::Int8GemmCPU(
+      m, a.data(), packed.k_pad, packed, c.data(), packed.n_pad, isa);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      int32_t ref = 0;
+      for (int kk = 0; kk < k; ++kk) {
+        ref += a[i * packed.k_pad + kk] * b[kk * n + j];
+      }
+      ASSERT_EQ(c[i * packed.n_pad + j], ref)
+          << "isa " << static_cast<int>(isa) << " m " << m << " k " << k
+          << " n " << n << " at " << i << ", " << j;
+    }
+  }
+}
+
+TEST(Int8GemmCPU, MicroKernels) {
+  for (auto isa : SupportedIsas()) {
+    for (int m : {1, 3, 4, 9}) {
+      for (int k : {1, 6, 64, 131}) {
+        for (int n : {1, 16, 33, 200}) {
+          CheckGemm(isa, m, k, n, -127);
+        }
+      }
+    }
+    // -128 is left to the kernels that take the full range
+    if (isa != Int8GemmIsa::kAvx2) {
+      CheckGemm(isa, 5, 37, 150, -128);
+    }
+  }
+}
+
+// Per column symmetric int8 weights and a per tensor input scale, in the
+// form quant_linear_fuse_pass leaves them.
+struct QuantLinearCase {
+  std::vector<float> x, w, bias;
+  std::vector<int8_t> w_int8;
+  float scale_in;
+  std::vector<float> scale_weights;
+};
+
+QuantLinearCase MakeCase(int m, int k, int n, std::mt19937* rng) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  QuantLinearCase c;
+  c.x.resize(m * k);
+  c.w.resize(k * n);
+  c.bias.resize(n);
+  for (auto* v : {&c.x, &c.w, &c.bias}) {
+    for (auto& e : *v) e = dist(*rng);
+  }
+  float x_max = 0.0f;
+  for (float e : c.x) x_max = std::max(x_max, std::abs(e));
+  c.scale_in = 1.0f / x_max;
+  c.w_int8.resize(k * n);
+  c.scale_weights.resize(n);
+  for (int j = 0; j < n; ++j) {
+    float w_max = 0.0f;
+    for (int kk = 0; kk < k; ++kk) {
+      w_max = std::max(w_max, std::abs(c.w[kk * n + j]));
+    }
+    for (int kk = 0; kk < k; ++kk) {
+      c.w_int8[kk * n + j] =
+          static_cast<int8_t>(std::round(c.w[kk * n + j] * 127.0f / w_max));
+    }
+    c.scale_weights[j] = 1.0f / w_max;
+  }
+  return c;
+}
+
+// The weights stay in one tensor across runs, so they are packed once.
+struct QuantLinearInputs {
+  QuantLinearInputs(const phi::CPUContext& dev_ctx,
+                    const QuantLinearCase& c,
+                    int m,
+                    int k,
+                    int n) {
+    x.Resize({m, k});
+    w.Resize({k, n});
+    bias.Resize({n});
+    std::copy(c.x.begin(), c.x.end(), dev_ctx.Alloc<float>(&x));
+    std::copy(c.w_int8.begin(), c.w_int8.end(), dev_ctx.Alloc<int8_t>(&w));
+    std::copy(c.bias.begin(), c.bias.end(), dev_ctx.Alloc<float>(&bias));
+  }
+
+  DenseTensor x, w, bias;
+};
+
+void RunQuantLinear(const phi::CPUContext& dev_ctx,
+                    const QuantLinearCase& c,
+                    const QuantLinearInputs& inputs,
+                    bool relu,
+                    DenseTensor* out) {
+  QuantLinearKernel<float, phi::CPUContext>(dev_ctx,
+                                            inputs.x,
+                                            inputs.w,
+                                            inputs.bias,
+                                            1,
+                                            relu ? "relu" : "",
+                                            false,
+                                            c.scale_in,
+                                            c.scale_weights,
+                                            1,
+                                            127.0f,
+                                            -127.0f,
+                                            out);
+}
+
+// The kernel against the same quantization done in plain loops, and its
+// error against the fp32 matmul.
+TEST(Int8GemmCPU, QuantLinear) {
+  auto* dev_ctx = static_cast<phi::CPUContext*>(
+      phi::DeviceContextPool::Instance().Get(phi::CPUPlace()));
+  std::mt19937 rng(0);
+  for (bool relu : {false, true}) {
+    const int m = 7, k = 70, n = 45;
+    auto c = MakeCase(m, k, n, &rng);
+    QuantLinearInputs inputs(*dev_ctx, c, m, k, n);
+    DenseTensor out;
+    RunQuantLinear(*dev_ctx, c, inputs, relu, &out);
+    ASSERT_EQ(out.dims(), common::make_ddim({m, n}));
+    const float* y = out.data<float>();
+    float max_err = 0.0f, max_ref = 0.0f;
+    for (int i = 0; i < m; ++i) {
+      for (int j = 0; j < n; ++j) {
+        int32_t acc = 0;
+        double fp32 = c.bias[j];
+        for (int kk = 0; kk < k; ++kk) {
+          const float q = std::round(127.0f * c.scale_in * c.x[i * k + kk]);
+          acc += static_cast<int32_t>(q) * c.w_int8[kk * n + j];
+          fp32 += c.x[i * k + kk] * c.w[kk * n + j];
+        }
+        float ref = acc / (127.0f * 127.0f * c.scale_in * c.scale_weights[j]) +
+                    c.bias[j];
+        if (relu) {
+          ref = std::max(ref, 0.0f);
+          fp32 = std::max(fp32, 0.0);
+        }
+        ASSERT_NEAR(y[i * n + j], ref, 1e-4f * (1.0f + std::abs(ref)));
+        const float fp32_ref = static_cast<float>(fp32);
+        max_err = std::max(max_err, std::abs(y[i * n + j] - fp32_ref));
+        max_ref = std::max(max_ref, std::abs(fp32_ref));
+      }
+    }
+    EXPECT_LT(max_err, 0.02f * max_ref);
+  }
+}
+
+// quant_linear on int8 against the fp32 fc it replaces, the timings are
+// logged rather than asserted on. Disabled in CI, run it with
+// --gtest_also_run_disabled_tests.
+TEST(Int8GemmCPU, DISABLED_Benchmark) {
+  auto* dev_ctx = static_cast<phi::CPUContext*>(
+      phi::DeviceContextPool::Instance().Get(phi::CPUPlace()));
+  std::mt19937 rng(0);
+  const int k = 1024, n = 1024;
+  for (int m : {1, 32, 128}) {
+    auto c = MakeCase(m, k, n, &rng);
+    std::vector<float> fp32(m * n);
+    QuantLinearInputs inputs(*dev_ctx, c, m, k, n);
+    DenseTensor out;
+    RunQuantLinear(*dev_ctx, c, inputs, false, &out);
+    funcs::FCFunctor<phi::CPUContext, float> fc;
+    fc(*dev_ctx, m, n, k, c.x.data(), c.w.data(), fp32.data(), c.bias.data());
+
+    const int repeat = 10;
+    int64_t us[2];
+    for (int int8 = 0; int8 < 2; ++int8) {
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < repeat; ++r) {
+        if (int8) {
+          RunQuantLinear(*dev_ctx, c, inputs, false, &out);
+        } else {
+          fc(*dev_ctx,
+             m,
+             n,
+             k,
+             c.x.data(),
+             c.w.data(),
+             fp32.data(),
+             c.bias.data());
+        }
+      }
+      us[int8] = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count() /
+                 repeat;
+    }
+    float max_err = 0.0f, max_ref = 0.0f;
+    for (int i = 0; i < m * n; ++i) {
+      max_err = std::max(max_err, std::abs(out.data<float>()[i] - fp32[i]));
+      max_ref = std::max(max_ref, std::abs(fp32[i]));
+    }
+    EXPECT_LT(max_err, 0.02f * max_ref);
+    LOG(INFO) << "fc " << m << " x " << k << " x " << n << ": fp32 " << us[0]
+              << " us, int8 (isa " << static_cast<int>(funcs::Int8GemmBestIsa())
+              << ") " << us[1] << " us, max error " << max_err << " of "
+              << max_ref;
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,272 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/rnn_batched_cpu.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace phi {
+namespace tests {
+
+using funcs::RnnBatchedCell;
+
+double Sigmoid(double x) { return 1.0 / (1.0 + std::exp(-x)); }
+
+// One sequence at a time in the rnn op gate order, LSTM {i, f, c~, o} and
+// GRU {r, z, c~}, from the unpacked weights.
+void ReferenceLayer(RnnBatchedCell cell,
+                    const std::vector<float>& w_ih,
+                    const std::vector<float>& w_hh,
+                    const std::vector<float>& b_ih,
+                    const std::vector<float>& b_hh,
+                    const std::vector<float>& x,
+                    int64_t time_steps,
+                    int64_t batch,
+                    int64_t input_size,
+                    int64_t hidden,
+                    const std::vector<int>& seq_len,
+                    bool reverse,
+                    const std::vector<float>& h0,
+                    const std::vector<float>& c0,
+                    std::vector<float>* y,
+                    std::vector<float>* h_last,
+                    std::vector<float>* c_last) {
+  const int gates = funcs::RnnBatchedGateNum(cell);
+  y->assign(time_steps * batch * hidden, 0.0f);
+  h_last->assign(batch * hidden, 0.0f);
+  c_last->assign(batch * hidden, 0.0f);
+  for (int64_t b = 0; b < batch; ++b) {
+    std::vector<double> h(h0.begin() + b * hidden,
+                          h0.begin() + (b + 1) * hidden);
+    std::vector<double> c(hidden, 0.0);
+    if (cell == RnnBatchedCell::kLSTM) {
+      c.assign(c0.begin() + b * hidden, c0.begin() + (b + 1) * hidden);
+    }
+    for (int64_t s = 0; s < seq_len[b]; ++s) {
+      const int64_t t = reverse ? seq_len[b] - 1 - s : s;
+      const float* xt = x.data() + (t * batch + b) * input_size;
+      std::vector<double> gx(gates * hidden), gh(gates * hidden);
+      for (int64_t j = 0; j < gates * hidden; ++j) {
+        gx[j] = b_ih[j];
+        gh[j] = b_hh[j];
+        for (int64_t k = 0; k < input_size; ++k) {
+          gx[j] += w_ih[j * input_size + k] * xt[k];
+        }
+        for (int64_t k = 0; k < hidden; ++k) {
+          gh[j] += w_hh[j * hidden + k] * h[k];
+        }
+      }
+      for (int64_t j = 0; j < hidden; ++j) {
+        if (cell == RnnBatchedCell::kLSTM) {
+          const double i = Sigmoid(gx[j] + gh[j]);
+          const double f = Sigmoid(gx[hidden + j] + gh[hidden + j]);
+          const double g = std::tanh(gx[2 * hidden + j] + gh[2 * hidden + j]);
+          const double o = Sigmoid(gx[3 * hidden + j] + gh[3 * hidden + j]);
+          c[j] = f * c[j] + i * g;
+          gx[j] = o * std::tanh(c[j]);
+        } else {
+          const double r = Sigmoid(gx[j] + gh[j]);
+          const double z = Sigmoid(gx[hidden + j] + gh[hidden + j]);
+          const double n =
+              std::tanh(gx[2 * hidden + j] + r * gh[2 * hidden + j]);
+          gx[j] = (1 - z) * n + z * h[j];
+        }
+      }
+      for (int64_t j = 0; j < hidden; ++j) {
+        h[j] = gx[j];
+        (*y)[(t * batch + b) * hidden + j] = static_cast<float>(h[j]);
+      }
+    }
+    for (int64_t j = 0; j < hidden; ++j) {
+      (*h_last)[b * hidden + j] = static_cast<float>(h[j]);
+      (*c_last)[b * hidden + j] = static_cast<float>(c[j]);
+    }
+  }
+}
+
+void CheckLayer(RnnBatchedCell cell,
+                int64_t time_steps,
+                int64_t batch,
+                int64_t input_size,
+                int64_t hidden,
+                bool with_seq_len,
+                bool reverse) {
+  std::mt19937 rng(time_steps * 131 + batch * 17 + hidden);
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  auto fill = [&](int64_t n) {
+    std::vector<float> v(n);
+    for (auto& e : v) e = dist(rng);
+    return v;
+  };
+  const int gates = funcs::RnnBatchedGateNum(cell);
+  auto w_ih = fill(gates * hidden * input_size);
+  auto w_hh = fill(gates * hidden * hidden);
+  auto b_ih = fill(gates * hidden);
+  auto b_hh = fill(gates * hidden);
+  auto x = fill(time_steps * batch * input_size);
+  auto h0 = fill(batch * hidden);
+  auto c0 = fill(batch * hidden);
+  std::vector<int> seq_len(batch, static_cast<int>(time_steps));
+  if (with_seq_len) {
+    std::uniform_int_distribution<int> len_dist(0, time_steps);
+    for (auto& l : seq_len) l = len_dist(rng);
+    seq_len[0] = static_cast<int>(time_steps);
+  }
+
+  std::vector<float> ref_y, ref_h, ref_c;
+  ReferenceLayer(cell,
+                 w_ih,
+                 w_hh,
+                 b_ih,
+                 b_hh,
+                 x,
+                 time_steps,
+                 batch,
+                 input_size,
+                 hidden,
+                 seq_len,
+                 reverse,
+                 h0,
+                 c0,
+                 &ref_y,
+                 &ref_h,
+                 &ref_c);
+
+  funcs::RnnBatchedWeights<float> packed;
+  funcs::PackRnnBatchedWeights<float>(cell,
+                                      w_ih.data(),
+                                      w_hh.data(),
+                                      b_ih.data(),
+                                      b_hh.data(),
+                                      input_size,
+                                      hidden,
+                                      &packed);
+  // the layer writes the second half of rows 2 * hidden wide
+  std::vector<float> y(time_steps * batch * 2 * hidden, 0.0f);
+  std::vector<float> h_last(batch * hidden), c_last(batch * hidden);
+  const bool lstm = cell == RnnBatchedCell::kLSTM;
+  funcs::RnnBatchedLayerCPU<float>(funcs::RnnBatchedRefOps<float>(),
+                                   cell,
+                                   packed,
+                                   x.data(),
+                                   time_steps,
+                                   batch,
+                                   input_size,
+                                   hidden,
+                                   with_seq_len ? seq_len.data() : nullptr,
+                                   reverse,
+                                   h0.data(),
+                                   lstm ? c0.data() : nullptr,
+                                   y.data(),
+                                   2 * hidden,
+                                   hidden,
+                                   h_last.data(),
+                                   lstm ? c_last.data() : nullptr);
+  for (int64_t r = 0; r < time_steps * batch; ++r) {
+    for (int64_t j = 0; j < hidden; ++j) {
+      ASSERT_EQ(y[r * 2 * hidden + j], 0.0f);
+      ASSERT_NEAR(y[r * 2 * hidden + hidden + j], ref_y[r * hidden + j], 1e-4)
+          << "row " << r << " unit " << j;
+    }
+  }
+  for (int64_t i = 0; i < batch * hidden; ++i) {
+    ASSERT_NEAR(h_last[i], ref_h[i], 1e-4);
+    if (lstm) {
+      ASSERT_NEAR(c_last[i], ref_c[i], 1e-4);
+    }
+  }
+}
+
+TEST(RnnBatchedCPU, LSTM) {
+  CheckLayer(RnnBatchedCell::kLSTM, 7, 5, 6, 8, false, false);
+  CheckLayer(RnnBatchedCell::kLSTM, 7, 5, 6, 8, false, true);
+  CheckLayer(RnnBatchedCell::kLSTM, 9, 11, 4, 16, true, false);
+  CheckLayer(RnnBatchedCell::kLSTM, 9, 11, 4, 16, true, true);
+}
+
+TEST(RnnBatchedCPU, GRU) {
+  CheckLayer(RnnBatchedCell::kGRU, 7, 5, 6, 8, false, false);
+  CheckLayer(RnnBatchedCell::kGRU, 9, 11, 4, 16, true, false);
+  CheckLayer(RnnBatchedCell::kGRU, 9, 11, 4, 16, true, true);
+}
+
+// Skewed lengths, the batched steps against every step on the whole batch
+// as the masked kernel runs them, with the same reference ops. The timings
+// are logged rather than asserted on. Disabled in CI, run it with
+// --gtest_also_run_disabled_tests.
+TEST(RnnBatchedCPU, DISABLED_Benchmark) {
+  const int64_t time_steps = 100, batch = 64, input_size = 128, hidden = 128;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
+  std::vector<float> w_ih(4 * hidden * input_size), w_hh(4 * hidden * hidden);
+  std::vector<float> b(4 * hidden), x(time_steps * batch * input_size);
+  for (auto* v : {&w_ih, &w_hh, &b, &x}) {
+    for (auto& e : *v) e = dist(rng);
+  }
+  std::vector<int> seq_len(batch);
+  std::exponential_distribution<double> len_dist(1.0 / 20);
+  for (auto& l : seq_len) {
+    l = std::min<int>(time_steps, 1 + static_cast<int>(len_dist(rng)));
+  }
+  seq_len[0] = time_steps;
+  funcs::RnnBatchedWeights<float> packed;
+  funcs::PackRnnBatchedWeights<float>(RnnBatchedCell::kLSTM,
+                                      w_ih.data(),
+                                      w_hh.data(),
+                                      b.data(),
+                                      b.data(),
+                                      input_size,
+                                      hidden,
+                                      &packed);
+  std::vector<float> h0(batch * hidden, 0.0f), c0(batch * hidden, 0.0f);
+  std::vector<float> y(time_steps * batch * hidden);
+  std::vector<float> h_last(batch * hidden), c_last(batch * hidden);
+  double us[2];
+  for (int sorted = 0; sorted < 2; ++sorted) {
+    auto start = std::chrono::steady_clock::now();
+    funcs::RnnBatchedLayerCPU<float>(funcs::RnnBatchedRefOps<float>(),
+                                     RnnBatchedCell::kLSTM,
+                                     packed,
+                                     x.data(),
+                                     time_steps,
+                                     batch,
+                                     input_size,
+                                     hidden,
+                                     sorted ? seq_len.data() : nullptr,
+                                     false,
+                                     h0.data(),
+                                     c0.data(),
+                                     y.data(),
+                                     hidden,
+                                     0,
+                                     h_last.data(),
+                                     c_last.data());
+    us[sorted] = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  }
+  LOG(INFO) << "lstm " << time_steps << " x " << batch << " x " << hidden
+            << ": every step on the whole batch " << us[0]
+            << " us, length sorted batches " << us[1] << " us";
+}
+
+}  // namespace tests
+}  // namespace phi
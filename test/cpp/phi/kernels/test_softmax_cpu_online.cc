@@ -0,0 +1,170 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/softmax_cpu_online.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace phi {
+namespace tests {
+
+// Softmax along the middle axis of [batch, axis_dim, remain] in double, with
+// the same clip of x - max as the kernels.
+std::vector<double> ReferenceSoftmax(const std::vector<double>& x,
+                                     int64_t batch,
+                                     int axis_dim,
+                                     int64_t remain,
+                                     bool log_softmax) {
+  std::vector<double> y(x.size());
+  for (int64_t b = 0; b < batch; ++b) {
+    for (int64_t r = 0; r < remain; ++r) {
+      auto at = [&](int a) { return (b * axis_dim + a) * remain + r; };
+      double m = -std::numeric_limits<double>::infinity();
+      for (int a = 0; a < axis_dim; ++a) m = std::max(m, x[at(a)]);
+      double s = 0;
+      for (int a = 0; a < axis_dim; ++a) {
+        s += std::exp(std::max(x[at(a)] - m, -64.0));
+      }
+      for (int a = 0; a < axis_dim; ++a) {
+        const double shifted = std::max(x[at(a)] - m, -64.0);
+        y[at(a)] = log_softmax ? shifted - std::log(s) : std::exp(shifted) / s;
+      }
+    }
+  }
+  return y;
+}
+
+template <typename T>
+void CheckSoftmax(int64_t batch,
+                  int axis_dim,
+                  int64_t remain,
+                  int exp_degree,
+                  double tol) {
+  std::mt19937 rng(batch * 131 + axis_dim * 7 + remain);
+  std::uniform_real_distribution<double> dist(-10.0, 10.0);
+  std::vector<double> x(batch * axis_dim * remain);
+  for (auto& v : x) v = dist(rng);
+  // a row max that only shows up late, so the running sum is rescaled, and
+  // entries far enough below it to hit the clip
+  for (int64_t b = 0; b < batch; ++b) {
+    x[(b * axis_dim + axis_dim - 1) * remain] = 30.0;
+    x[b * axis_dim * remain] = -80.0;
+  }
+  std::vector<T> x_t(x.begin(), x.end());
+  std::vector<T> y(x.size());
+  for (bool log_softmax : {false, true}) {
+    funcs::OnlineSoftmaxCPU<T>(x_t.data(),
+                               batch,
+                               axis_dim,
+                               remain,
+                               log_softmax,
+                               exp_degree,
+                               y.data());
+    auto ref = ReferenceSoftmax(x, batch, axis_dim, remain, log_softmax);
+    for (size_t i = 0; i < ref.size(); ++i) {
+      ASSERT_NEAR(y[i], ref[i], log_softmax ? tol * 10 : tol)
+          << "at " << i << " log_softmax " << log_softmax << " degree "
+          << exp_degree;
+    }
+  }
+}
+
+TEST(SoftmaxCPUOnline, LastAxis) {
+  for (int axis_dim : {1, 5, 64, 100, 1000}) {
+    CheckSoftmax<double>(3, axis_dim, 1, 0, 1e-12);
+    CheckSoftmax<float>(3, axis_dim, 1, 0, 1e-6);
+    CheckSoftmax<float>(3, axis_dim, 1, 7, 1e-6);
+    CheckSoftmax<float>(3, axis_dim, 1, 4, 1e-4);
+  }
+}
+
+TEST(SoftmaxCPUOnline, MiddleAxis) {
+  for (int64_t remain : {2, 17, 600}) {
+    CheckSoftmax<double>(2, 9, remain, 0, 1e-12);
+    CheckSoftmax<float>(2, 9, remain, 7, 1e-6);
+  }
+}
+
+TEST(SoftmaxCPUOnline, NegativeInfinity) {
+  const float inf = std::numeric_limits<float>::infinity();
+  // the first block is all -inf
+  std::vector<float> x(200, -inf);
+  x[150] = 1.0f;
+  x[170] = 1.0f;
+  std::vector<float> y(x.size());
+  funcs::OnlineSoftmaxCPU<float>(x.data(), 1, 200, 1, false, 7, y.data());
+  for (size_t i = 0; i < x.size(); ++i) {
+    EXPECT_NEAR(y[i], (i == 150 || i == 170) ? 0.5f : 0.0f, 1e-6);
+  }
+  funcs::OnlineSoftmaxCPU<float>(x.data(), 1, 200, 1, true, 7, y.data());
+  EXPECT_NEAR(y[150], -std::log(2.0f), 1e-6);
+  EXPECT_NEAR(y[0], -64.0f - std::log(2.0f), 1e-4);
+}
+
+// The online kernel against the max, subtract, exp, sum and scale passes it
+// replaces, the timings are logged rather than asserted on.
+TEST(SoftmaxCPUOnline, Benchmark) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+  for (int64_t cols : {128, 1000, 32000}) {
+    const int64_t rows = (1 << 22) / cols;
+    std::vector<float> x(rows * cols);
+    for (auto& v : x) v = dist(rng);
+    std::vector<float> y(x.size());
+    std::vector<float> y_ref(x.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t r = 0; r < rows; ++r) {
+      const float* in = x.data() + r * cols;
+      float* out = y_ref.data() + r * cols;
+      const float m = *std::max_element(in, in + cols);
+      for (int64_t j = 0; j < cols; ++j) out[j] = std::max(in[j] - m, -64.f);
+      for (int64_t j = 0; j < cols; ++j) out[j] = std::exp(out[j]);
+      float s = 0;
+      for (int64_t j = 0; j < cols; ++j) s += out[j];
+      for (int64_t j = 0; j < cols; ++j) out[j] /= s;
+    }
+    auto multi_pass_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+    int64_t online_us[2];
+    int degrees[2] = {0, 7};
+    for (int k = 0; k < 2; ++k) {
+      start = std::chrono::steady_clock::now();
+      funcs::OnlineSoftmaxCPU<float>(
+          x.data(), rows, cols, 1, false, degrees[k], y.data());
+      online_us[k] = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+      for (size_t i = 0; i < y.size(); ++i) {
+        ASSERT_NEAR(y[i], y_ref[i], 1e-6);
+      }
+    }
+    LOG(INFO) << "softmax " << rows << "x" << cols << ": multi-pass "
+              << multi_pass_us << " us, online std::exp " << online_us[0]
+              << " us, online poly exp " << online_us[1] << " us";
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
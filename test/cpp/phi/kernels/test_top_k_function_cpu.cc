@@ -0,0 +1,183 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/top_k_function_cpu.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace phi {
+namespace tests {
+
+// The reference: a stable sort of one row, NaN counted as the largest.
+template <typename T>
+std::vector<int64_t> ReferenceOrder(const std::vector<T>& row, bool largest) {
+  std::vector<int64_t> order(row.size());
+  for (size_t j = 0; j < row.size(); ++j) {
+    order[j] = static_cast<int64_t>(j);
+  }
+  funcs::TopKCompare<T, int64_t> cmp{largest};
+  std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+    return cmp.Better(row[a], row[b]);
+  });
+  return order;
+}
+
+// A [pre, n, post] tensor with few distinct values, so there are ties, and
+// some NaNs.
+std::vector<float> MakeInput(int64_t numel, std::mt19937* rng) {
+  std::uniform_int_distribution<int> dist(0, 50);
+  std::vector<float> in(numel);
+  for (auto& v : in) {
+    int r = dist(*rng);
+    v = r == 0 ? std::numeric_limits<float>::quiet_NaN() : r * 0.5f;
+  }
+  return in;
+}
+
+void ExpectSameValue(float a, float b) {
+  if (std::isnan(a)) {
+    EXPECT_TRUE(std::isnan(b));
+  } else {
+    EXPECT_EQ(a, b);
+  }
+}
+
+TEST(TopKFunctionCPU, StridedTopK) {
+  std::mt19937 rng(0);
+  const int64_t pre = 3;
+  const int64_t post = 5;
+  for (int64_t n : {1, 7, 100, 1000}) {
+    std::vector<float> in = MakeInput(pre * n * post, &rng);
+    for (int k : {1, 5, 64}) {
+      if (k > n) continue;
+      for (bool largest : {true, false}) {
+        std::vector<float> out(pre * k * post);
+        std::vector<int64_t> indices(pre * k * post);
+        funcs::StridedTopK<float, int64_t>(in.data(),
+                                           pre,
+                                           n,
+                                           post,
+                                           k,
+                                           largest,
+                                           true,
+                                           out.data(),
+                                           indices.data());
+        for (int64_t p = 0; p < pre; ++p) {
+          for (int64_t q = 0; q < post; ++q) {
+            std::vector<float> row(n);
+            for (int64_t j = 0; j < n; ++j) {
+              row[j] = in[(p * n + j) * post + q];
+            }
+            auto order = ReferenceOrder(row, largest);
+            for (int j = 0; j < k; ++j) {
+              int64_t pos = (p * k + j) * post + q;
+              EXPECT_EQ(indices[pos], order[j]);
+              ExpectSameValue(out[pos], row[order[j]]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(TopKFunctionCPU, StridedSort) {
+  std::mt19937 rng(1);
+  for (int64_t post : {1, 4}) {
+    const int64_t pre = 2;
+    const int64_t n = 300;
+    std::vector<float> in = MakeInput(pre * n * post, &rng);
+    for (bool descending : {true, false}) {
+      std::vector<float> out(in.size());
+      std::vector<int64_t> indices(in.size());
+      funcs::StridedSort<float, int64_t>(
+          in.data(), pre, n, post, descending, out.data(), indices.data());
+      for (int64_t p = 0; p < pre; ++p) {
+        for (int64_t q = 0; q < post; ++q) {
+          std::vector<float> row(n);
+          for (int64_t j = 0; j < n; ++j) {
+            row[j] = in[(p * n + j) * post + q];
+          }
+          auto order = ReferenceOrder(row, descending);
+          for (int64_t j = 0; j < n; ++j) {
+            int64_t pos = (p * n + j) * post + q;
+            EXPECT_EQ(indices[pos], order[j]);
+            ExpectSameValue(out[pos], row[order[j]]);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Top-k over a (rows, cols, k) grid against a partial sort of each row,
+// the timings are logged rather than asserted on. Disabled in CI, run it
+// with --gtest_also_run_disabled_tests.
+TEST(TopKFunctionCPU, DISABLED_Benchmark) {
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  for (int64_t rows : {16, 256}) {
+    for (int64_t cols : {1000, 100000}) {
+      std::vector<float> in(rows * cols);
+      for (auto& v : in) {
+        v = dist(rng);
+      }
+      for (int k : {1, 10, 100}) {
+        std::vector<float> out(rows * k);
+        std::vector<int64_t> indices(rows * k);
+        auto start = std::chrono::steady_clock::now();
+        funcs::StridedTopK<float, int64_t>(
+            in.data(), rows, cols, 1, k, true, true, out.data(), indices.data());
+        auto topk_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+        start = std::chrono::steady_clock::now();
+        std::vector<std::pair<float, int64_t>> row(cols);
+        for (int64_t r = 0; r < rows; ++r) {
+          for (int64_t j = 0; j < cols; ++j) {
+            row[j] = std::make_pair(in[r * cols + j], j);
+          }
+          std::partial_sort(
+              row.begin(),
+              row.begin() + k,
+              row.end(),
+              [](const std::pair<float, int64_t>& l,
+                 const std::pair<float, int64_t>& r) {
+                return l.first > r.first;
+              });
+          EXPECT_EQ(out[r * k + k - 1], row[k - 1].first);
+        }
+        auto partial_us =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+        LOG(INFO) << "rows " << rows << " cols " << cols << " k " << k
+                  << ": topk " << topk_us << " us, partial_sort "
+                  << partial_us << " us";
+      }
+    }
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,116 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/pir/include/core/block.h"
+#include "paddle/pir/include/core/builder.h"
+#include "paddle/pir/include/core/builtin_attribute.h"
+#include "paddle/pir/include/core/builtin_op.h"
+#include "paddle/pir/include/core/builtin_type.h"
+#include "paddle/pir/include/core/ir_context.h"
+#include "paddle/pir/include/core/program.h"
+
+namespace {
+
+constexpr int kNumThreads = 8;
+
+template <typename Func>
+void RunConcurrently(int num_threads, Func func) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back(func, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+TEST(storage_manager_test, concurrent_parametric_uniquing) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  // enough distinct storages to grow the hash table several times while the
+  // other threads are reading it
+  constexpr int kNumAttrs = 4096;
+  std::vector<std::vector<pir::Attribute>> str_attrs(kNumThreads);
+  std::vector<std::vector<pir::Attribute>> int_attrs(kNumThreads);
+  std::vector<std::vector<pir::Type>> vec_types(kNumThreads);
+
+  RunConcurrently(kNumThreads, [&](int tid) {
+    for (int i = 0; i < kNumAttrs; ++i) {
+      // every thread walks the keys in a different order
+      int key = (i * (2 * tid + 1)) % kNumAttrs;
+      str_attrs[tid].push_back(
+          pir::StrAttribute::get(ctx, "concurrent_" + std::to_string(key)));
+      int_attrs[tid].push_back(pir::Int64Attribute::get(ctx, key));
+      vec_types[tid].push_back(pir::VectorType::get(
+          ctx,
+          std::vector<pir::Type>(key % 7 + 1, pir::Int32Type::get(ctx))));
+    }
+  });
+
+  for (int tid = 1; tid < kNumThreads; ++tid) {
+    for (int i = 0; i < kNumAttrs; ++i) {
+      int key = (i * (2 * tid + 1)) % kNumAttrs;
+      // index of the same key in thread 0
+      EXPECT_EQ(str_attrs[tid][i], str_attrs[0][key]);
+      EXPECT_EQ(int_attrs[tid][i], int_attrs[0][key]);
+      EXPECT_EQ(vec_types[tid][i], vec_types[0][key]);
+    }
+  }
+  EXPECT_EQ(str_attrs[0][1].dyn_cast<pir::StrAttribute>().AsString(),
+            "concurrent_1");
+  EXPECT_EQ(int_attrs[0][3].dyn_cast<pir::Int64Attribute>().data(), 3);
+}
+
+TEST(storage_manager_test, concurrent_program_construction) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  constexpr int kNumPrograms = 16;
+  constexpr int kNumOps = 512;
+
+  auto build_programs = [&](int tid) {
+    for (int p = 0; p < kNumPrograms; ++p) {
+      pir::Program program(ctx);
+      pir::Builder builder(ctx, program.block());
+      for (int i = 0; i < kNumOps; ++i) {
+        builder.Build<pir::ConstantOp>(pir::Int64Attribute::get(ctx, i),
+                                       pir::Int64Type::get(ctx));
+        builder.Build<pir::ConstantOp>(
+            pir::StrAttribute::get(ctx, "op_" + std::to_string(i % 64)),
+            pir::Float32Type::get(ctx));
+      }
+      EXPECT_EQ(program.block()->size(), static_cast<size_t>(2 * kNumOps));
+    }
+  };
+
+  // the timings are only reported, the test machine load is not controlled
+  for (int num_threads : {1, kNumThreads}) {
+    auto start = std::chrono::steady_clock::now();
+    RunConcurrently(num_threads, build_programs);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    LOG(INFO) << "Built " << num_threads * kNumPrograms << " programs of "
+              << 2 * kNumOps << " ops with " << num_threads << " threads in "
+              << elapsed << " us";
+  }
+}
@@ -13,6 +13,7 @@
 # limitations under the License.
 
 import logging
+import time
 import unittest
 
 import numpy as np
@@ -584,5 +585,73 @@ class TestStatic(unittest.TestCase):
         paddle.disable_static()
 
 
+class TestSparseConvPointCloud(unittest.TestCase):
+    """Sparse conv on CPU over a voxelized point cloud, checked against dense
+    conv3d on the zero-filled grid. The timings are logged for comparison."""
+
+    def voxelize(self, num_points, grid, batch):
+        rng = np.random.default_rng(0)
+        indices = set()
+        for b in range(batch):
+            # points on a sphere surface, like a lidar sweep of an object
+            p = rng.normal(size=(num_points, 3))
+            p /= np.linalg.norm(p, axis=1, keepdims=True)
+            voxels = ((p + 1) * 0.5 * (grid - 1)).round().astype('int32')
+            indices.update((b, z, y, x) for z, y, x in voxels)
+        return np.array(sorted(indices), dtype='int32').T
+
+    def check(self, subm):
+        place = paddle.get_device()
+        paddle.set_device('cpu')
+        batch, grid, in_channels, out_channels = 2, 24, 4, 8
+        indices = self.voxelize(4000, grid, batch)
+        nnz = indices.shape[1]
+        rng = np.random.default_rng(1)
+        values = rng.standard_normal((nnz, in_channels)).astype('float32')
+        weight = rng.standard_normal(
+            (3, 3, 3, in_channels, out_channels)
+        ).astype('float32')
+        shape = [batch, grid, grid, grid, in_channels]
+        sp_x = paddle.sparse.sparse_coo_tensor(
+            paddle.to_tensor(indices), paddle.to_tensor(values), shape
+        )
+        padding = 1 if subm else 0
+        conv = (
+            paddle.sparse.nn.functional.subm_conv3d
+            if subm
+            else paddle.sparse.nn.functional.conv3d
+        )
+        start = time.time()
+        sp_out = conv(sp_x, paddle.to_tensor(weight), padding=padding)
+        elapsed = time.time() - start
+
+        dense_out = paddle.nn.functional.conv3d(
+            sp_x.to_dense(),
+            paddle.to_tensor(weight.transpose(4, 3, 0, 1, 2)),
+            padding=padding,
+            data_format='NDHWC',
+        ).numpy()
+        out = sp_out.to_dense().numpy()
+        if subm:
+            # submanifold outputs exist at the input sites only
+            b, z, y, x = indices
+            np.testing.assert_allclose(
+                out[b, z, y, x], dense_out[b, z, y, x], rtol=1e-4, atol=1e-4
+            )
+        else:
+            np.testing.assert_allclose(out, dense_out, rtol=1e-4, atol=1e-4)
+        logger.info(
+            f"{'subm_conv3d' if subm else 'conv3d'} on {nnz} voxels: "
+            f"{elapsed * 1000:.2f} ms"
+        )
+        paddle.set_device(place)
+
+    def test_subm_conv3d(self):
+        self.check(subm=True)
+
+    def test_conv3d(self):
+        self.check(subm=False)
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -23,11 +23,7 @@ from program_config import OpConfig, ProgramConfig, TensorConfig
 from paddle.base import core
 
 
-@unittest.skipIf(
-    not core.is_compiled_with_cuda(),
-    "QuantLinear only supports cuda kernel.",
-)
-class TestQuantLinearFusePass(PassAutoScanTest):
+class QuantLinearFusePassBase(PassAutoScanTest):
     r"""
         x_var                             y_var(persistable)
           |                                 |
@@ -53,13 +49,6 @@ class TestQuantLinearFusePass(PassAutoScanTest):
                               elementwise_add
     """
 
-    def sample_predictor_configs(self, program_config):
-        # for gpu
-        config = self.create_inference_config(
-            use_gpu=True, passes=["quant_linear_fuse_pass"]
-        )
-        yield config, ["quant_linear"], (0.4, 0.3)
-
     def is_program_valid(self, prog_config):
         input_num_col_dims = len(prog_config.inputs["input_x"].shape) - 1
         add_x_rank = input_num_col_dims + 1
@@ -251,6 +240,34 @@ class TestQuantLinearFusePass(PassAutoScanTest):
         )
         return program_config
 
+
+@unittest.skipIf(
+    not core.is_compiled_with_cuda(),
+    "QuantLinear only supports cuda kernel.",
+)
+class TestQuantLinearFusePass(QuantLinearFusePassBase):
+    def sample_predictor_configs(self, program_config):
+        # for gpu
+        config = self.create_inference_config(
+            use_gpu=True, passes=["quant_linear_fuse_pass"]
+        )
+        yield config, ["quant_linear"], (0.4, 0.3)
+
+    def test(self):
+        self.run_and_statis(
+            quant=False,
+            max_examples=30,
+            passes=["quant_linear_fuse_pass"],
+        )
+
+
+class TestQuantLinearFusePassCPU(QuantLinearFusePassBase):
+    def sample_predictor_configs(self, program_config):
+        # the whole CPU pass list, which runs the fuse pass only when asked
+        config = self.create_inference_config(ir_optim=True)
+        config.enable_cpu_int8_quant_linear()
+        yield config, ["quant_linear"], (0.4, 0.3)
+
     def test(self):
         self.run_and_statis(
             quant=False,
@@ -258,6 +275,32 @@ class TestQuantLinearFusePass(PassAutoScanTest):
             passes=["quant_linear_fuse_pass"],
         )
 
+    def test_off_by_default(self):
+        config = self.create_inference_config(ir_optim=True)
+        self.assertFalse(config.cpu_int8_quant_linear_enabled())
+        self.assertNotIn(
+            "quant_linear_fuse_pass", config.pass_builder().all_passes()
+        )
+        config.enable_cpu_int8_quant_linear()
+        self.assertIn(
+            "quant_linear_fuse_pass", config.pass_builder().all_passes()
+        )
+        config.enable_cpu_int8_quant_linear(False)
+        self.assertNotIn(
+            "quant_linear_fuse_pass", config.pass_builder().all_passes()
+        )
+
+    def test_user_pass_kept(self):
+        # only the pass the option inserted is removed by the updates
+        config = self.create_inference_config(ir_optim=True)
+        config.pass_builder().append_pass("quant_linear_fuse_pass")
+        config.enable_cpu_int8_quant_linear()
+        config.enable_cpu_int8_quant_linear(False)
+        self.assertEqual(
+            config.pass_builder().all_passes().count("quant_linear_fuse_pass"),
+            1,
+        )
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -93,6 +93,59 @@ class TestDistModelRun(unittest.TestCase):
             dist_model_rst, load_inference_model_rst, rtol=1e-05
         )
 
+    def test_dist_model_run_pipeline(self):
+        self.check_micro_batches(num_pipeline_stages=2)
+
+    def test_dist_model_run_micro_batches(self):
+        # the micro batches run one after another through a single stage
+        self.check_micro_batches(num_pipeline_stages=1)
+
+    def check_micro_batches(self, num_pipeline_stages):
+        path_prefix = os.path.join(
+            self.temp_dir.name,
+            f"dist_model_run_pipeline_test_{num_pipeline_stages}/inf",
+        )
+
+        # a model with row wise outputs, so that the micro batches concat
+        main_program = paddle.static.Program()
+        startup_program = paddle.static.Program()
+        with paddle.static.program_guard(main_program, startup_program):
+            x = paddle.static.data(name='x', shape=[-1, 28], dtype='float32')
+            hidden = paddle.static.nn.fc(x, 32, activation='relu')
+            predict = paddle.static.nn.fc(hidden, 10, activation='softmax')
+        exe = paddle.static.Executor(paddle.CPUPlace())
+        exe.run(startup_program)
+        paddle.static.save_inference_model(
+            path_prefix, [x], [predict], exe, program=main_program
+        )
+
+        x_tensor = np.random.randn(30, 28).astype('float32')
+
+        config = core.DistModelConfig()
+        config.model_dir = path_prefix
+        config.place = 'CPU'
+        config.num_micro_batches = 4
+        config.num_pipeline_stages = num_pipeline_stages
+        config.max_in_flight_micro_batches = 1
+        dist = core.DistModel(config)
+        self.assertTrue(dist.init())
+        for _ in range(2):
+            output_rst = dist.run([core.DistModelTensor(x_tensor, 'x')])
+            dist_model_rst = output_rst[0].as_ndarray()
+
+            [
+                inference_program,
+                feed_target_names,
+                fetch_targets,
+            ] = paddle.static.load_inference_model(path_prefix, exe)
+            results = exe.run(
+                inference_program,
+                feed={'x': x_tensor},
+                fetch_list=fetch_targets,
+            )
+            self.assertEqual(list(dist_model_rst.shape), [30, 10])
+            np.testing.assert_allclose(dist_model_rst, results[0], rtol=1e-05)
+
 
 if __name__ == '__main__':
     unittest.main()
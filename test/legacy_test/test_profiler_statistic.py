@@ -1044,6 +1044,62 @@ class TestProfilerStatistic(unittest.TestCase):
                 )
             )
 
+    def test_statistic_roofline(self):
+        root_node = HostPythonNode(
+            'Root Node',
+            profiler.TracerEventType.UserDefined,
+            0,
+            float('inf'),
+            1000,
+            1001,
+        )
+        profilerstep_node = HostPythonNode(
+            'ProfileStep#1',
+            profiler.TracerEventType.ProfileStep,
+            0,
+            4000,
+            1000,
+            1001,
+        )
+        matmul_node = HostPythonNode(
+            'pd_op.matmul',
+            profiler.TracerEventType.Operator,
+            1000,
+            2000,
+            1000,
+            1001,
+        )
+        matmul_node.input_shapes = {'x': [[64, 128]], 'y': [[128, 256]]}
+        matmul_node.attributes = {'transpose_x': False, 'transpose_y': False}
+        matmul_node.bytes = (64 * 128 + 128 * 256 + 64 * 256) * 4
+        matmul_node.cycles = 3000
+        matmul_node.instructions = 6000
+        matmul_node.cache_misses = 10
+        root_node.children_node.append(profilerstep_node)
+        profilerstep_node.children_node.append(matmul_node)
+        thread_tree = {'thread1001': root_node}
+        extra_info = {
+            'Process Cpu Utilization': '1.02',
+            'System Cpu Utilization': '0.68',
+        }
+        statistic_data = profiler.profiler_statistic.StatisticData(
+            thread_tree, extra_info
+        )
+        item = statistic_data.event_summary.items['pd_op.matmul']
+        self.assertEqual(item.flops, 2 * 64 * 128 * 256)
+        self.assertEqual(item.bytes, matmul_node.bytes)
+        self.assertEqual(item.instructions, 6000)
+        table = profiler.profiler_statistic._build_table(
+            statistic_data,
+            sorted_by=profiler.SortedKeys.CPUTotal,
+            op_detail=True,
+            thread_sep=False,
+            time_unit='ms',
+        )
+        self.assertIn('Operator Roofline Summary', table)
+        # 4194304 FLOPs in 1000 ns
+        self.assertIn('4194.30', table)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,153 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import math
+import unittest
+
+import numpy as np
+
+import paddle
+import paddle.distributed as dist
+from paddle import nn
+from paddle.base import core
+
+NRANKS = 2
+STEPS = 4
+IN_FEATURES = 64
+
+
+def rank_input(rank, same_data):
+    rng = np.random.RandomState(0 if same_data else rank + 1)
+    return rng.randn(8, IN_FEATURES).astype('float32')
+
+
+def run_backward(compress_type, topk_ratio=0.01, same_data=False):
+    # The gradient of sum(x @ w) is the column sum of x, the same at every
+    # step since the parameters are not updated.
+    paddle.seed(2024)
+    layer = nn.Linear(IN_FEATURES, 1, bias_attr=False)
+    dp_layer = paddle.DataParallel(layer)
+    options = core.GradCompressOptions()
+    options.type = compress_type
+    options.topk_ratio = topk_ratio
+    dp_layer._reducer.set_grad_compress_options(options)
+
+    x = paddle.to_tensor(rank_input(dist.get_rank(), same_data))
+    grads = []
+    for _ in range(STEPS):
+        loss = dp_layer(x).sum()
+        loss.backward()
+        grads.append(layer.weight.grad.numpy().reshape([-1]).copy())
+        layer.clear_gradients()
+    return grads, dp_layer._reducer.get_group_comm_stats()
+
+
+def mean_grad(same_data):
+    return np.mean(
+        [rank_input(r, same_data).sum(axis=0) for r in range(NRANKS)],
+        axis=0,
+    ).astype('float32')
+
+
+def check_low_precision(compress_type, rtol):
+    dist.init_parallel_env()
+    grads, stats = run_backward(compress_type)
+    expected = mean_grad(same_data=False)
+    for grad in grads:
+        np.testing.assert_allclose(grad, expected, rtol=rtol, atol=rtol)
+    assert len(stats) == 1
+    assert stats[0].wire_bytes * 2 == stats[0].raw_bytes
+    assert stats[0].comm_time > 0
+    assert stats[0].overlap_time >= 0
+
+
+def train_fp16():
+    check_low_precision(core.GradCompressType.FP16, 2e-3)
+
+
+def train_bf16():
+    check_low_precision(core.GradCompressType.BF16, 3e-2)
+
+
+def train_fp16_allocator(stream_safe):
+    # the gradients are split from the fused contents only after the
+    # communication thread reduced them, whatever the allocator
+    paddle.set_flags(
+        {
+            'FLAGS_allocator_strategy': 'auto_growth',
+            'FLAGS_use_stream_safe_cuda_allocator': stream_safe,
+        }
+    )
+    check_low_precision(core.GradCompressType.FP16, 2e-3)
+
+
+def train_fp16_stream_safe():
+    train_fp16_allocator(True)
+
+
+def train_fp16_not_stream_safe():
+    train_fp16_allocator(False)
+
+
+def train_topk():
+    # every rank computes the same gradient, so the sum of the top-k entries
+    # of all ranks is the top-k of the mean gradient, which is replayed
+    # here together with its error feedback
+    dist.init_parallel_env()
+    ratio = 0.25
+    grads, stats = run_backward(
+        core.GradCompressType.TOPK, topk_ratio=ratio, same_data=True
+    )
+    g = mean_grad(same_data=True)
+    k = math.ceil(ratio * IN_FEATURES)
+    residual = np.zeros_like(g)
+    sent = np.zeros_like(g)
+    for grad in grads:
+        compensated = residual + g
+        top = np.argsort(-np.abs(compensated), kind='stable')[:k]
+        expected = np.zeros_like(g)
+        expected[top] = compensated[top]
+        residual = compensated
+        residual[top] = 0
+        np.testing.assert_allclose(grad, expected, rtol=1e-6, atol=1e-6)
+        assert np.count_nonzero(grad) == k
+        sent += grad
+    # error feedback: what was not sent yet is kept, none of it is lost
+    np.testing.assert_allclose(
+        sent + residual, STEPS * g, rtol=1e-5, atol=1e-5
+    )
+    # the small entries were delayed, not dropped
+    assert np.count_nonzero(sent) > k
+    assert stats[0].wire_bytes < stats[0].raw_bytes
+
+
+class TestReducerGradCompressGloo(unittest.TestCase):
+    def test_fp16(self):
+        dist.spawn(train_fp16, backend='gloo', nprocs=NRANKS)
+
+    def test_bf16(self):
+        dist.spawn(train_bf16, backend='gloo', nprocs=NRANKS)
+
+    def test_fp16_stream_safe_allocator(self):
+        dist.spawn(train_fp16_stream_safe, backend='gloo', nprocs=NRANKS)
+
+    def test_fp16_not_stream_safe_allocator(self):
+        dist.spawn(train_fp16_not_stream_safe, backend='gloo', nprocs=NRANKS)
+
+    def test_topk_error_feedback(self):
+        dist.spawn(train_topk, backend='gloo', nprocs=NRANKS)
+
+
+if __name__ == '__main__':
+    unittest.main()